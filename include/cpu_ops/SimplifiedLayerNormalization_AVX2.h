@@ -8,5 +8,6 @@ namespace cpu_ops {
 // scale: [head_dim]
 // output: [num_heads, head_dim]
 // epsilon: scalar
+// Always built for AVX2 + FMA (no runtime dispatch): only call it where cpu_features() reports both.
 void SimplifiedLayerNormalization_AVX2(const float* input, const float* scale, float* output, float epsilon, int num_heads, int head_dim);
 }
@@ -7,6 +7,7 @@
  *
  * Performs layer normalization with skip connection and RMS normalization in a single fused operation.
  * All arrays are expected to be of size H.
+ * Always built for AVX2 + FMA (no runtime dispatch): only call it where cpu_features() reports both.
  *
  * @param input Pointer to input array [H]
  * @param skip Pointer to skip connection array [H]
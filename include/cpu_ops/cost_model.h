@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#include <cpu_ops/thread_pool.h>
+
+// Memory traffic and arithmetic of one item of a parallel range
+struct WorkCost
+{
+    double bytes;
+    double flops;
+};
+
+// How a range is run: on how many threads, in chunks of how many items
+struct ParallelPlan
+{
+    int threads;
+    std::size_t grain;
+};
+
+/*
+CostModel decides per call whether a kernel range is worth fanning out. It is calibrated once
+from what the machine actually does: the latency of an empty ThreadPool dispatch, the read
+bandwidth of one core and of all pool threads together, and one core's FMA throughput.
+
+A range costs items * max(bytes / bandwidth, flops / compute) (roofline), where bandwidth grows
+with the thread count until it reaches the measured aggregate. The plan takes the thread count
+with the lowest predicted time, counting the dispatch latency for anything above one thread,
+so a 2048-float add stays on the calling core while a 6144-wide multi-row norm or a large
+projection spreads out. Chunks aim at four per thread so dynamic claiming can even out load.
+*/
+class CostModel
+{
+public:
+    // Explicit machine figures, e.g. for tests or a remembered calibration
+    CostModel(double dispatch_ns, double core_bytes_per_ns, double total_bytes_per_ns, double core_flops_per_ns,
+              int max_threads);
+
+    // Model calibrated against ThreadPool::instance() on first use (a few tens of milliseconds)
+    static const CostModel &instance();
+
+    // Measures the figures above on pool
+    static CostModel calibrate(ThreadPool &pool);
+
+    ParallelPlan plan(std::size_t items, const WorkCost &cost) const;
+
+    // Predicted wall time of the range on the given number of threads
+    double predict_ns(std::size_t items, const WorkCost &cost, int threads) const;
+
+    double dispatch_ns() const noexcept { return dispatch_ns_; }
+    double core_bytes_per_ns() const noexcept { return core_bytes_per_ns_; }
+    double total_bytes_per_ns() const noexcept { return total_bytes_per_ns_; }
+    double core_flops_per_ns() const noexcept { return core_flops_per_ns_; }
+    int max_threads() const noexcept { return max_threads_; }
+
+private:
+    double dispatch_ns_;
+    double core_bytes_per_ns_;
+    double total_bytes_per_ns_;
+    double core_flops_per_ns_;
+    int max_threads_;
+};
+
+// parallel_for on the calling thread's pool with threads and chunking chosen by the cost model
+template <typename Body>
+inline void parallel_for(std::size_t begin, std::size_t end, const WorkCost &cost, Body &&body)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+    const ParallelPlan plan = CostModel::instance().plan(end - begin, cost);
+    if (plan.threads <= 1)
+    {
+        body(begin, end);
+        return;
+    }
+    ThreadPool::current().parallel_for(begin, end, plan.grain, std::forward<Body>(body), plan.threads);
+}
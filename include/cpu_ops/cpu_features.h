@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+
+// Instruction sets the cpu_ops kernels are compiled for, lowest first
+enum class IsaLevel
+{
+    Scalar, // portable C++ at the build's baseline (SSE4.2 on x86-64)
+    Avx2,   // AVX2 + FMA
+    Avx512  // AVX-512 F/DQ
+};
+
+// What cpuid (and the OS, through XCR0) says this host can run
+struct CpuFeatures
+{
+    bool sse42 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool avx512f = false;
+    bool avx512dq = false;
+    bool avx512bw = false;
+    bool avx512vl = false;
+    std::string vendor;
+    std::string model; // brand string, e.g. "Intel(R) Xeon(R) Gold 6338 CPU @ 2.00GHz"
+};
+
+// Detected once
+const CpuFeatures &cpu_features();
+
+// Highest level the host supports, capped by MINMAX_ISA ("scalar", "avx2" or "avx512") if set
+IsaLevel host_isa();
+
+const char *isa_name(IsaLevel isa);
+
+// Throws std::invalid_argument for anything but "scalar", "avx2" and "avx512"
+IsaLevel parse_isa(const std::string &name);
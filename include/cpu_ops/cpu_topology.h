@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// One logical CPU (hardware thread) and where it sits
+struct LogicalCpu
+{
+    int id;      // OS CPU number, as used by affinity masks
+    int core;    // physical core, unique across packages
+    int package; // socket
+    int node;    // NUMA node
+};
+
+/*
+CpuTopology describes the machine's logical CPUs: which ones are hyperthread siblings of the
+same physical core and which NUMA node they belong to. It is read from
+/sys/devices/system/cpu on Linux and from GetLogicalProcessorInformationEx on Windows (first
+processor group only); elsewhere every CPU is treated as its own core on node 0.
+
+placement() orders CPUs for compute threads. Decode is bandwidth-bound, so two threads sharing
+a core's load ports gain little and make per-token latency noisy; the order therefore puts
+one CPU of every physical core first, alternating between NUMA nodes so a partial pool still
+draws on every memory controller, and lists the remaining hyperthread siblings after them.
+*/
+class CpuTopology
+{
+public:
+    explicit CpuTopology(std::vector<LogicalCpu> cpus);
+
+    // Topology of this machine, detected once
+    static const CpuTopology &instance();
+
+    const std::vector<LogicalCpu> &cpus() const noexcept { return cpus_; }
+
+    // nullptr if the CPU is unknown
+    const LogicalCpu *find(int cpu) const;
+
+    int num_nodes() const;
+
+    // Physical cores among allowed
+    int num_cores(const std::vector<int> &allowed) const;
+
+    // allowed reordered for compute threads: one per physical core first, siblings last
+    std::vector<int> placement(const std::vector<int> &allowed) const;
+
+private:
+    static CpuTopology detect();
+
+    std::vector<LogicalCpu> cpus_;
+};
+
+// CPUs the process may run on, ascending
+std::vector<int> process_cpus();
+
+// Parses a CPU list such as "0-7,16,18-19" (the /sys and taskset format)
+std::vector<int> parse_cpu_list(const std::string &list);
+
+// Restricts the calling thread to one CPU, or to a set of CPUs; false if the OS refused
+bool pin_current_thread(int cpu);
+bool pin_current_thread(const std::vector<int> &cpus);
@@ -9,6 +9,7 @@
 #include <cpu_ops/elemwise_add.h>
 #include <cpu_ops/silu_avx2.h>
 #include <cpu_ops/elemwise_mul.h>
+#include <cpu_ops/task_graph.h>
 #include <vector>
 
 // TODO : Create a separate MLP kernel and class
@@ -30,8 +31,24 @@ private:
     Tensor mlp_gate_proj_wt;
     Tensor mlp_down_proj_wt;
 
+    // Intermediate columns per NUMA domain: rows of gate/up and columns of down; a single range until place_weights()
+    std::vector<size_t> mlp_up_split;
+
+    // down_proj columns [mlp_up_split[d], mlp_up_split[d + 1]) as domain d's own slice, and one
+    // partial output per domain summed into the residual
+    std::vector<Tensor> mlp_down_parts;
+    std::vector<const float *> mlp_down_ptrs;
+    std::vector<float> mlp_partials;
+
     size_t layer_idx = 0;
 
+    // Row RMSNorm compiled for the hidden size (fixed_rmsnorm), picked at construction; nullptr
+    // falls back to the generic one
+    FixedRmsNorm hidden_norm = nullptr;
+
+    // Single-token layer as a DAG of ops, rebuilt by every run()
+    TaskGraph graph;
+
 public:
     Decoder(
         // pre-Attention norm weights
@@ -63,6 +80,15 @@ public:
     // Prepare buffers and prefetch weights
     void prepare();
 
-    // Run attention for a single token
+    // Splits the layer tensor-parallel across pool's NUMA domains (cpu_ops/numa.h): attention heads by
+    // KV group and the MLP by intermediate column, with node-local weight copies. Each domain then
+    // computes its share of a block alone, and the blocks meet once each, after o_proj and after down_proj.
+    void place_weights(ThreadPool &pool);
+
+    // Run the layer for a single token; independent ops (q/k/v, gate/up, attention heads and the
+    // per-domain chains) run concurrently on the shared thread pool
     void run(Tensor &input, size_t token_idx, Tensor &output);
+
+    // Run the layer for M token rows: input/output [M, embed_dim], rows[i] gives row i's KV cache and position
+    void run_batch(Tensor &input, const AttentionRow *rows, size_t M, Tensor &output);
 };
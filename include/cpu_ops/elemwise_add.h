@@ -1,6 +1,6 @@
 #pragma once
 #include <cstddef>
 
-// AVX2- and OpenMP-optimized elementwise addition function
+// Elementwise addition on the host's widest kernel table, spread over the thread pool when the cost model says it pays
 void elemwise_add_avx2_omp(const float* a, const float* b, float* out, int batch_size, int hidden_size);
 
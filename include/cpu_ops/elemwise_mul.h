@@ -3,5 +3,5 @@
 
 
 //TODO : output should be last argument
-// AVX2-optimized elementwise multiplication function
+// Elementwise multiplication on the host's widest kernel table
 void elemwise_mul_avx2(const float* a, const float* b, float* out, int batch_size, int hidden_size);
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+Packed GEMM for linear layers with several input rows: output[M, N] = input[M, K] * weight[N, K]^T,
+with the weight in the [out, in] layout LinearOp and the models use.
+
+The loops follow the usual blocked scheme. For every block of nc output features and kc input
+features, the weight block is copied into panels of gemm_nr features laid out k-major. Every block
+of mc input rows is copied the same way into panels of gemm_mr rows. The register-tile
+micro-kernel of the host's KernelTable (cpu_ops/kernels.h) then walks both panel sets with
+unit-stride loads only. A weight panel stays in L1 while it meets every row panel, and the row
+block stays in L2 for the whole feature block. Panels are zero-padded, so edge tiles run the same
+kernel and only mask their stores.
+
+Compared with one dot product per (row, feature), every weight element loaded is reused for
+gemm_mr rows from registers, so batched prefill and batched decode become compute bound.
+*/
+
+// Cache blocking: rows, output features and input features per packed block, and how many
+// (row block, feature block) pairs gemm_nt aims to give each thread (feature blocks narrow to get there)
+struct GemmBlocking
+{
+    int mc = 96;
+    int nc = 256;
+    int kc = 256;
+    int chunks_per_thread = 4;
+};
+
+// Whole product, parallel over blocks of rows and blocks of output features on the current pool
+void gemm_nt(const float *input, const float *weight, int M, int K, int N, float *output,
+             const GemmBlocking &blocking = GemmBlocking());
+
+// Output features [n_begin, n_end) for all M rows on the calling thread; output keeps its [M, N] stride
+void gemm_nt_range(const float *input, const float *weight, int M, int K, int N, int n_begin, int n_end, float *output,
+                   const GemmBlocking &blocking = GemmBlocking());
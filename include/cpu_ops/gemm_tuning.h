@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cpu_ops/gemm.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// A weight of [N, K]: K input features, N output features
+struct GemmShape
+{
+    int K;
+    int N;
+};
+
+/*
+GemmTuning holds the GemmBlocking to use per weight shape. The defaults in gemm.h are a
+reasonable middle for 32-48 KB L1 and 1-2 MB L2 cores, but the best blocks and the split across
+threads move with cache sizes and core count, so each server type can measure its own.
+
+tune() sweeps one parameter at a time (mc, nc, kc, chunks per thread) over a few candidates,
+keeping the best so far, in two rounds per shape. It runs gemm_nt on the current pool at the
+given row count, so the thread split is tuned for the machine as it will run.
+
+On first use (the Qwen3Model constructor, on the shared pool), MINMAX_GEMM_TUNING=<path> loads
+the file if it was tuned on the same CPU model and instruction set. If it was not, and
+MINMAX_GEMM_AUTOTUNE=1 is also set, model_shapes() are tuned at 128 rows (one full prefill
+chunk) and written there; on a few cores the lm_head shape alone takes a minute or more. Shapes
+without an entry use the defaults.
+*/
+class GemmTuning
+{
+public:
+    using Entries = std::vector<std::pair<GemmShape, GemmBlocking>>;
+
+    GemmTuning(Entries entries, std::string cpu);
+
+    // Tuning for this host, loaded (or tuned, see above) on first use
+    static const GemmTuning &instance();
+
+    // Sweeps the blocking of every shape at `rows` input rows
+    static GemmTuning tune(const std::vector<GemmShape> &shapes, int rows);
+
+    // The projection shapes of the default Qwen3Config: attention (2048 x 2048), MLP gate/up
+    // (2048 x 6144), MLP down (6144 x 2048) and lm_head (2048 x 151936), as K x N
+    static std::vector<GemmShape> model_shapes();
+
+    // Tuning stored at path, if there is one for this host (see kernels_host_key)
+    static bool load(const std::string &path, GemmTuning &out);
+    void save(const std::string &path) const;
+
+    // Tuned blocking for the shape, or the defaults
+    GemmBlocking blocking(int K, int N) const;
+
+    const Entries &entries() const noexcept { return entries_; }
+    const std::string &cpu() const noexcept { return cpu_; }
+
+private:
+    Entries entries_;
+    std::string cpu_;
+};
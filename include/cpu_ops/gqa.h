@@ -1,15 +1,16 @@
 #pragma once
+#include <cstddef>
 #include <vector>
 #include <immintrin.h>
 #include <cmath>
 #include <algorithm>
-#include <cpu_ops/exp_avx2.h>
+#include <cpu_ops/cost_model.h>
+#include <cpu_ops/kernels.h>
 #include <cpu_ops/softmax_avx2.h>
 
 #include <vector>
 #include <cmath>
 #include <immintrin.h>
-#include <omp.h>
 
 void optimized_gqa_forward(
     const float *query, // [A, h] - single token query for all attention heads
@@ -21,5 +22,69 @@ void optimized_gqa_forward(
     int h,              // head dimension
     int N,              // actual sequence length (N <= N_max)
     int N_max,          // max sequence length
-    float scale         // scaling factor
-);
\ No newline at end of file
+    float scale,        // scaling factor
+    const HeadKernels *head_ops = nullptr // head_kernels(h), or nullptr for the generic kernels
+);
+
+/**
+ * @brief optimized_gqa_forward restricted to query heads [head_begin, head_end), so callers
+ * that schedule work themselves (TaskGraph) can split attention into per-head tasks.
+ */
+void gqa_forward_heads(
+    const float *query,
+    const float *key,
+    const float *value,
+    float *output,
+    int A,
+    int G,
+    int h,
+    int N,
+    int N_max,
+    float scale,
+    int head_begin,
+    int head_end,
+    const HeadKernels *head_ops = nullptr);
+
+// Cost of one query head over N cached positions: its keys and values, QK and PV
+inline WorkCost gqa_head_cost(int N, int h)
+{
+    return {8.0 * N * h, 4.0 * N * h};
+}
+
+/**
+ * @brief Decode attention for B sequences with ragged context lengths in one call.
+ *
+ * Work is split into (sequence, KV group, KV chunk) items that threads pick up dynamically,
+ * so a batch mixing a 4k-token and a 10-token context is balanced by tokens rather than by
+ * sequence. Each item computes the partial softmax statistics and weighted values of all
+ * query heads sharing its KV group (keys/values are loaded once per group); partials are
+ * merged per head afterwards (split-K / flash-decoding style).
+ *
+ * @param query Queries [B, A, h], one token per sequence
+ * @param key Per-sequence key bases [B], each pointing at [G, kv_strides[b], h]
+ * @param value Per-sequence value bases [B], each pointing at [G, kv_strides[b], h]
+ * @param output Output [B, A, h]; may alias query
+ * @param seq_lens Valid KV positions per sequence [B]
+ * @param kv_strides Positions between consecutive KV groups per sequence [B] (N_max)
+ * @param B Number of sequences
+ * @param A Number of attention heads
+ * @param G Number of KV groups
+ * @param h Head dimension
+ * @param scale Scaling factor
+ * @param chunk_size KV positions per work item
+ * @param head_ops Kernels compiled for h (head_kernels(h)), or nullptr for the generic ones
+ */
+void ragged_gqa_forward(
+    const float *query,
+    const float *const *key,
+    const float *const *value,
+    float *output,
+    const int *seq_lens,
+    const int *kv_strides,
+    int B,
+    int A,
+    int G,
+    int h,
+    float scale,
+    int chunk_size = 256,
+    const HeadKernels *head_ops = nullptr);
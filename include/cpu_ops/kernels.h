@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <cpu_ops/cpu_features.h>
+
+/*
+KernelTable holds the innermost loops of the cpu_ops operators for one instruction set. Every
+variant lives in its own translation unit built with that ISA's compiler flags (kernels_scalar.cpp
+at the build's baseline, kernels_avx2.cpp with AVX2 + FMA, kernels_avx512.cpp with AVX-512), so
+one binary runs on any host with the SSE4.2 baseline and still uses the widest registers it has.
+
+kernels() picks a table once, on first use, from cpuid (see cpu_features.h); the operators fetch
+it once per call, outside their loops, and go through its function pointers. Threading, blocking
+and bookkeeping stay in the operators: only code that runs at the build's baseline ISA may live
+outside the variant files.
+
+All variants compute the same result up to float rounding; exp_shift_sum and silu use a
+polynomial exp in the vector variants and libm in the scalar one.
+*/
+
+// Row RMSNorm over a length fixed when it was compiled
+using FixedRmsNorm = void (*)(const float *x, const float *weight, float *out, float eps);
+
+struct FixedNorm
+{
+    int n;
+    FixedRmsNorm rmsnorm;
+};
+
+// Attention kernels compiled for one head dimension
+struct HeadKernels
+{
+    int head_dim;
+    FixedRmsNorm rmsnorm; // q/k norm of one head
+    // rotate_half over head_dim / 2 pairs
+    void (*rotate_half)(float *x, const float *sin, const float *cos);
+    float (*dot)(const float *a, const float *b);
+    void (*axpy)(float alpha, const float *x, float *y);
+};
+
+struct KernelTable
+{
+    IsaLevel isa;
+    int lanes; // floats per vector register
+
+    // sum(a[i] * b[i])
+    float (*dot)(const float *a, const float *b, std::size_t n);
+    // out[r] = dot(x, w_r) for four rows, sharing the loads of x
+    void (*dot4)(const float *x, const float *w0, const float *w1, const float *w2, const float *w3, std::size_t n, float *out);
+    // y += alpha * x
+    void (*axpy)(float alpha, const float *x, float *y, std::size_t n);
+    // x *= alpha
+    void (*scale)(float *x, float alpha, std::size_t n);
+    // Largest element; n > 0
+    float (*max)(const float *x, std::size_t n);
+    // x = exp(x - shift) in place; returns the sum of the new values
+    float (*exp_shift_sum)(float *x, float shift, std::size_t n);
+
+    void (*add)(const float *a, const float *b, float *out, std::size_t n);
+    void (*mul)(const float *a, const float *b, float *out, std::size_t n);
+    // out = x * sigmoid(x)
+    void (*silu)(const float *x, float *out, std::size_t n);
+    // One row: out = weight * x / sqrt(mean(x^2) + eps)
+    void (*rmsnorm_row)(const float *x, const float *weight, float *out, std::size_t n, float eps);
+    // Rotates the pairs (x[i], x[i + half]) by the angles whose sines and cosines are given
+    void (*rotate_half)(float *x, const float *sin, const float *cos, std::size_t half);
+
+    // Index of the first largest element, -1 if n <= 0
+    int (*argmax)(const float *x, int n);
+    // First index in [begin, n) with x[index] >= threshold, n if there is none
+    int (*find_at_least)(const float *x, int begin, int n, float threshold);
+
+    // GEMM micro-kernel on packed panels (see cpu_ops/gemm.h): c[i][j] (+)= sum_k a[k][i] * b[k][j]
+    // for i < m <= gemm_mr and j < n <= gemm_nr, with a kc steps of gemm_mr floats and b kc steps
+    // of gemm_nr floats. Rows and columns past m and n only ever see the panels' zero padding and
+    // are not stored; c rows are ldc floats apart
+    int gemm_mr;
+    int gemm_nr;
+    void (*gemm_tile)(std::size_t kc, const float *a, const float *b, float *c, std::size_t ldc, int m, int n, bool accumulate);
+
+    // Calibration probes for CostModel: a streaming sum, and 8 independent FMA chains of
+    // `lanes` floats run for `iterations` steps
+    float (*sum)(const float *x, std::size_t n);
+    float (*fma_chains)(int iterations);
+
+    // The same kernels instantiated for the Qwen3 sizes (head_dim 128; hidden 1024 to 5120):
+    // every length is a template argument, so loops have constant trip counts and no tails, and
+    // the head-sized ones are written out completely. Found through head_kernels() and fixed_rmsnorm()
+    const HeadKernels *heads;
+    int num_head_sizes;
+    const FixedNorm *norms;
+    int num_norm_sizes;
+};
+
+// The table for host_isa(), chosen on first call
+const KernelTable &kernels();
+
+// The table for one ISA, or nullptr if it was not built or the host cannot run it
+const KernelTable *kernels_for(IsaLevel isa);
+
+// Kernels of kernels() for one head dimension or row length, or nullptr when that size was not
+// built. Operators look them up once, when they are constructed for a model, and fall back to the
+// generic entries otherwise
+const HeadKernels *head_kernels(int head_dim);
+FixedRmsNorm fixed_rmsnorm(int n);
+
+// CPU model and the ISA of kernels(), e.g. "Intel(R) Xeon(R) ... / avx512": what measurements of
+// the kernels (linear dispatch, GEMM tuning) must match to be reused
+std::string kernels_host_key();
@@ -1,20 +1,53 @@
 #pragma once
 
 #include <immintrin.h>
-#include <omp.h>
+#include <cpu_ops/cost_model.h>
+#include <cpu_ops/linear_dispatch.h>
+#include <cstddef>
 #include <cstdio>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 class Tensor;
 
 void linear_naive(const float *input, const float *weight, int M, int K, int N, float *output);
+// A given kernel on the current pool, and on the calling thread for output features [n_begin, n_end)
+// (output keeps its [M, N] stride)
+void linear_kernel_omp(LinearKernel kernel, const float *input, const float *weight, int M, int K, int N, float *output);
+void linear_kernel_range(LinearKernel kernel, const float *input, const float *weight, int M, int K, int N, int n_begin,
+                         int n_end, float *output);
+
+// The kernel LinearDispatch::instance() picks for M rows of this shape
 void linear_avx2_omp(const float *input, const float *weight, int M, int K, int N, float *output);
 
+// Output features [n_begin, n_end) of linear_avx2_omp on the calling thread; output keeps its [M, N] stride
+void linear_avx2_range(const float *input, const float *weight, int M, int K, int N, int n_begin, int n_end, float *output);
+
+// linear_avx2_omp where output features [bounds[d], bounds[d + 1]) are computed by the threads of NUMA
+// domain d (see cpu_ops/numa.h); bounds that do not match the pool's domains fall back to linear_avx2_omp
+void linear_avx2_domains(const float *input, const float *weight, int M, int K, int N,
+                         const std::vector<std::size_t> &bounds, float *output);
+
+// Tensor-parallel linear: parts[d] is [N, bounds[d + 1] - bounds[d]], columns [bounds[d], bounds[d + 1])
+// of a [N, K] weight. Domain d multiplies its input columns by its part; the partial outputs are
+// then summed once into output [M, N]. A single part is a plain linear_avx2_omp.
+void linear_avx2_column_split(const float *input, const float *const *parts, int M, int K, int N,
+                              const std::vector<std::size_t> &bounds, float *output);
+
+// Cost of one output feature: its weight row streamed once, 2*M*K flops
+inline WorkCost linear_cost(int M, int K)
+{
+    return {4.0 * K + 4.0 * M, 2.0 * M * K};
+}
+
 enum class MatmulImplType
 {
     NAIVE,
-    AVX2
+    AVX2,  // fastest kernel for the shape (LinearDispatch)
+    GEMV,  // the LinearKernel of the same name, regardless of shape
+    GEMV4,
+    GEMM
 };
 
 class LinearOp
@@ -35,6 +68,9 @@ private:
     // all the validations specific to impl and kernel call will be done in the impl functions
     static void naive_impl(Tensor &input, Tensor &weight, Tensor &output);
     static void avx2_impl(Tensor &input, Tensor &weight, Tensor &output);
+    static void gemv_impl(Tensor &input, Tensor &weight, Tensor &output);
+    static void gemv4_impl(Tensor &input, Tensor &weight, Tensor &output);
+    static void gemm_impl(Tensor &input, Tensor &weight, Tensor &output);
 
     void run_internal(Tensor &input, Tensor &weight, Tensor &output);
     MatmulImplType resolve_impl(Tensor &input, Tensor &weight) const;
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cpu_ops/gemm_tuning.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Ways to compute output[M, N] = input[M, K] * weight[N, K]^T
+enum class LinearKernel
+{
+    Gemv,  // one dot product per (row, feature); each weight row is reused from L1 for every input row
+    Gemv4, // four weight rows per pass (KernelTable::dot4), so each input row is loaded once per four features
+    Gemm   // packed, register-tiled GEMM (cpu_ops/gemm.h)
+};
+
+const char *linear_kernel_name(LinearKernel kernel);
+
+// Throws std::invalid_argument for anything but "gemv", "gemv4" and "gemm"
+LinearKernel parse_linear_kernel(const std::string &name);
+
+/*
+LinearDispatch picks the linear kernel for a shape. Which one wins depends mostly on the number
+of input rows: a single row is bound by the weight stream, a handful of rows by loads of the
+input, and from some row count on packing for the GEMM micro-kernel pays for itself. Where those
+crossovers fall depends on the vector width and the core, so the table is measured rather than
+written down.
+
+The generic table times every kernel on one thread over a [1024, 1024] weight at the top row
+count of each bucket. That weight stays in cache, which is right for small shapes but not for a
+model's projections, which are tens of MB and streamed from DRAM by the whole pool: there the
+weight stream dominates longer, and the crossovers move. So shapes given to configure() before
+first use (Qwen3Model passes its projections) get buckets of their own, timed at their real size
+on the shared pool; select() uses them for exactly that (K, N) and the generic table otherwise.
+
+The generic table takes a fraction of a second, a model's shapes about a second each on one core
+and proportionally less on a full pool. With MINMAX_LINEAR_TABLE=<path> the tables are read from
+that file when they were measured on the same CPU model and instruction set and cover the
+configured shapes, and written there otherwise, so they are paid once per machine.
+
+Weights are float32 [out, in] throughout the tree, so dtype and layout do not need a column yet.
+*/
+class LinearDispatch
+{
+public:
+    // (first row count of the bucket, kernel), sorted by row count and starting at 1
+    using Buckets = std::vector<std::pair<int, LinearKernel>>;
+
+    // Buckets measured for one weight shape
+    using ShapeBuckets = std::vector<std::pair<GemmShape, Buckets>>;
+
+    LinearDispatch(Buckets buckets, std::string cpu, ShapeBuckets shapes = {});
+
+    // Weight shapes instance() measures on the shared pool besides the generic table; false once it
+    // has been created
+    static bool configure(std::vector<GemmShape> shapes);
+
+    // Tables for this host, loaded or measured on first use
+    static const LinearDispatch &instance();
+
+    // Times every kernel for the generic table on the calling thread, then for each shape at its
+    // own size on the current pool
+    static LinearDispatch measure(const std::vector<GemmShape> &shapes = {});
+
+    // Table stored at path, if there is one for this host (see kernels_host_key)
+    static bool load(const std::string &path, LinearDispatch &out);
+    void save(const std::string &path) const;
+
+    // Kernel for M input rows from the generic table
+    LinearKernel select(int M) const;
+
+    // Kernel for M input rows of a [N, K] weight: its own buckets if the shape was measured
+    LinearKernel select(int M, int K, int N) const;
+
+    // Whether the shape has buckets of its own
+    bool has_shape(const GemmShape &shape) const;
+
+    const Buckets &buckets() const noexcept { return buckets_; }
+    const ShapeBuckets &shapes() const noexcept { return shapes_; }
+    const std::string &cpu() const noexcept { return cpu_; }
+
+private:
+    Buckets buckets_;
+    ShapeBuckets shapes_;
+    std::string cpu_;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <immintrin.h>
+#include <cstddef>
+#include <cstdint>
+
+#include <cpu_ops/sampler.h>
+
+/**
+ * @brief lm_head GEMV with a streaming top-k epilogue (batch size 1).
+ *
+ * Computes logit[j] = dot(input, weight[j]) for every row j, but never writes the logits
+ * out: each thread keeps a running top-k of its own row range and the per-thread lists are
+ * merged at the end. With k = 1 this is a fused argmax for greedy decoding.
+ *
+ * @param input Pointer to the normalized hidden state [K]
+ * @param weight Pointer to the lm_head weight [N, K] (row-major, one row per token)
+ * @param K Hidden size
+ * @param N Vocabulary size
+ * @param k Number of candidates to keep
+ * @param out Output buffer [k], sorted by descending logit
+ * @param allowed Optional vocabulary bitmask [ceil(N / 64)] (see VocabMask); rows of
+ *                disallowed tokens are skipped entirely. nullptr allows every row.
+ * @return Number of candidates written to out (min(k, number of allowed rows))
+ */
+int lm_head_topk_avx2_omp(const float *input, const float *weight, int K, int N, int k, TokenCandidate *out,
+                          const uint64_t *allowed = nullptr);
+
+/**
+ * @brief lm_head GEMV that only computes the rows of allowed tokens.
+ *
+ * Disallowed logits are set to -inf, so the weight traffic shrinks to the allowed rows.
+ *
+ * @param input Pointer to the normalized hidden state [K]
+ * @param weight Pointer to the lm_head weight [N, K]
+ * @param K Hidden size
+ * @param N Vocabulary size
+ * @param allowed Vocabulary bitmask [ceil(N / 64)]
+ * @param output Pointer to the logits [N]
+ */
+void lm_head_masked_avx2_omp(const float *input, const float *weight, int K, int N, const uint64_t *allowed, float *output);
@@ -10,6 +10,7 @@ void naiveMatMul(float *A, float *B, float *C, int M, int N, int K);
  * @brief Performs a highly optimized matrix multiplication (C = A x B) for float matrices.
  *
  * Uses AVX2 and memory alignment for maximum performance. All matrices are in row-major order.
+ * Always built for AVX2 + FMA (no runtime dispatch): only call it where cpu_features() reports both.
  *
  * @param A Pointer to matrix A (MxK)
  * @param B Pointer to matrix B (KxN)
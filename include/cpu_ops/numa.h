@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <cpu_ops/thread_pool.h>
+#include <tensor/tensor.h>
+
+/*
+NUMA weight placement. A projection's output rows are split across the pool's NUMA domains in
+proportion to their threads; each domain's slice of the weight is copied by that domain's own
+(pinned) threads, so first-touch backs it with pages on the domain's node. Kernels then run the
+slice with parallel_for_domains() or a domain-split TaskGraph node, and every weight byte is read
+from local memory. Mmapped weights would otherwise sit on whichever node faulted them in first.
+
+Row slices alone still make every domain wait for every other after each op. The decoder is
+therefore split tensor-parallel: a projection that consumes a domain-local slice of its input
+(o_proj after that domain's heads, down_proj after its MLP columns) takes a column slice of the
+weight instead, each domain produces a partial output, and the partials are summed once per block.
+*/
+
+// Bounds of [0, rows) per domain of pool, in proportion to its threads and rounded to align rows.
+// {0, rows} when the pool has a single domain.
+std::vector<std::size_t> numa_split(std::size_t rows, const ThreadPool &pool = ThreadPool::instance(), std::size_t align = 8);
+
+// Copy of a [rows, cols] weight whose rows [bounds[d], bounds[d + 1]) were first written by domain d
+Tensor numa_place_rows(const Tensor &weight, const std::vector<std::size_t> &bounds, ThreadPool &pool = ThreadPool::instance());
+
+// Bounds for num_domains domains that give all of [begin, end) to domain and nothing to the others
+std::vector<std::size_t> numa_domain_bounds(int domain, std::size_t begin, std::size_t end, int num_domains);
+
+// Columns [col_begin, col_end) of a [rows, cols] weight as a contiguous [rows, col_end - col_begin]
+// copy, written by the threads of domain
+Tensor numa_place_columns(const Tensor &weight, std::size_t col_begin, std::size_t col_end, int domain,
+                          ThreadPool &pool = ThreadPool::instance());
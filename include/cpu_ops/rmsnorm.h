@@ -1,5 +1,11 @@
 #pragma once
 #include <cstddef>
+#include <cpu_ops/kernels.h>
 
-// AVX2-optimized RMSNorm function
+// RMSNorm over batch_size rows, on the host's widest kernel table (cpu_ops/kernels.h)
 void rmsnorm_avx2(const float* input, const float* weight, float* output, int batch_size, int hidden_size, float eps);
+
+// The same with a row kernel compiled for exactly hidden_size floats (fixed_rmsnorm); nullptr
+// takes the generic one
+void rmsnorm_avx2(const float* input, const float* weight, float* output, int batch_size, int hidden_size, float eps,
+                  FixedRmsNorm fixed_row);
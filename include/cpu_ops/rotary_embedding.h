@@ -4,11 +4,13 @@
 #include <memory>
 #include <vector>
 
+#include <cpu_ops/kernels.h>
+
 // TODO : Add base(theta) as a class member
 
 /**
  * @class RotaryEmbeddingAVX2
- * @brief Efficient rotary positional embedding with AVX2 optimizations.
+ * @brief Efficient rotary positional embedding dispatched to the host's widest kernel table (cpu_ops/kernels.h).
  *
  * Supports precomputed sine/cosine caches for fast rotary embedding application in transformer models.
  */
@@ -26,6 +28,7 @@ private:
     };
     std::unique_ptr<RotationCache> cache_;
     int rotary_dim_;
+    const HeadKernels* head_ops_; ///< Kernels compiled for rotary_dim_, or nullptr (generic path)
 
 public:
     /**
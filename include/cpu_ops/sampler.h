@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+struct SamplerConfig
+{
+    float temperature = 0.0f;        // <= 0 selects greedy argmax
+    int top_k = 0;                   // 0 disables top-k filtering
+    float top_p = 1.0f;              // nucleus mass, 1 disables
+    float min_p = 0.0f;              // min probability relative to the best token, 0 disables
+    float repetition_penalty = 1.0f; // CTRL-style divisor for logits of seen tokens, 1 disables
+    float frequency_penalty = 0.0f;  // subtracted once per occurrence of a seen token
+    float presence_penalty = 0.0f;   // subtracted once for every seen token
+    int penalty_last_n = 64;         // history window for penalties, 0 uses the whole history
+    std::uint64_t seed = 0;
+};
+
+struct TokenCandidate
+{
+    int id;
+    float logit;
+};
+
+/**
+ * @brief Index of the largest element on the host's widest kernel table (first index wins on ties,
+ * like std::max_element).
+ */
+int argmax_avx2(const float *arr, int size);
+
+/**
+ * @brief Selects the k largest elements that are >= floor using vectorized threshold pruning.
+ *
+ * Whole vectors are compared against the running k-th best value, so only the few
+ * elements that can still enter the result are pushed into a small min-heap.
+ *
+ * @param arr Input values [size]
+ * @param size Number of values
+ * @param k Maximum number of candidates to keep
+ * @param floor Values below floor are never selected
+ * @param out Output buffer [k], sorted by descending logit
+ * @return Number of candidates written to out
+ */
+int select_topk_avx2(const float *arr, int size, int k, float floor, TokenCandidate *out);
+
+/*
+Sampler turns lm_head logits into a token id.
+
+Only tokens that survive top-k / min-p / a fixed logit window below the maximum are
+exponentiated, so the full-vocabulary softmax pass is never needed.
+*/
+class Sampler
+{
+public:
+    explicit Sampler(const SamplerConfig &config = SamplerConfig());
+
+    void set_config(const SamplerConfig &config);
+    const SamplerConfig &config() const noexcept { return config_; }
+
+    bool is_greedy() const noexcept;
+    bool has_penalties() const noexcept;
+
+    // Applies penalties to logits in-place and returns the sampled token id
+    int sample(float *logits, int vocab_size, const int *history, std::size_t history_len);
+
+    // Samples from a candidate list sorted by descending logit (e.g. produced by a fused lm_head)
+    int sample_candidates(const TokenCandidate *candidates, int count);
+
+    // Writes the filtered sampling distribution over the whole vocabulary to probs [vocab_size]
+    // (one-hot on the argmax when greedy). Penalties are not applied.
+    void probabilities(const float *logits, int vocab_size, float *probs);
+
+    // Draws a token from non-negative weights [vocab_size] (they need not sum to 1)
+    int sample_probabilities(const float *probs, int vocab_size);
+
+    // Uniform draw in [0, 1) from the sampler's generator
+    float uniform();
+
+private:
+    // Fills weights_ for the leading candidates that survive the floor and top-p; returns their sum
+    float candidate_weights(const TokenCandidate *candidates, int &count);
+
+    void apply_penalties(float *logits, int vocab_size, const int *history, std::size_t history_len);
+    float candidate_floor(float max_logit) const;
+
+    SamplerConfig config_;
+    std::mt19937_64 rng_;
+    std::vector<TokenCandidate> candidates_;
+    std::vector<float> weights_;
+    std::unordered_map<int, int> counts_;
+};
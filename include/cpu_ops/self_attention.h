@@ -7,8 +7,16 @@
 #include <cpu_ops/gqa.h>
 #include <cpu_ops/linear.h>
 #include <cpu_ops/rmsnorm.h>
+#include <cpu_ops/task_graph.h>
 #include <vector>
 
+// One row of a batched attention call: the KV cache of the row's sequence and its position
+struct AttentionRow
+{
+    KVCache *kvcache;
+    size_t token_idx;
+};
+
 /*
 SelfAttention class for Qwen3-style attention that processes one token at a time.
 
@@ -39,10 +47,27 @@ private:
     Tensor q_norm_wt;
     Tensor k_norm_wt;
 
+    // KV groups per NUMA domain and the q/k/v output rows they own; a single range until place_weights()
+    std::vector<size_t> group_split;
+    std::vector<size_t> q_split;
+    std::vector<size_t> kv_split;
+
+    // o_proj columns [q_split[d], q_split[d + 1]) as domain d's own [embed_dim, width] slice,
+    // and one partial output per domain summed after o_proj
+    std::vector<Tensor> o_proj_parts;
+    std::vector<const float *> o_parts;
+    std::vector<float> o_partials;
+
     // Instance-level buffers to avoid thread safety issues with static members
     std::vector<float> query; // Intermediate buffer for query projections
     std::vector<float> key;    // Intermediate buffer for key projections
     std::vector<float> value;  // Intermediate buffer for value projections
+
+    // Per-row KV descriptors for the ragged attention call in run_batch
+    std::vector<const float *> row_keys;
+    std::vector<const float *> row_values;
+    std::vector<int> row_lens;
+    std::vector<int> row_strides;
     
     size_t embed_dim = 0;
     size_t num_heads = 0;
@@ -54,6 +79,11 @@ private:
     KVCache *kvcache = nullptr;
     RotaryEmbeddingAVX2 *rope;
 
+    // Kernels compiled for head_dim (128 for Qwen3), picked at construction; nullptr falls back
+    // to the generic ones
+    const HeadKernels *head_ops = nullptr;
+    FixedRmsNorm head_norm = nullptr;
+
 public:
     SelfAttention(
         Tensor &_q_proj_wt,
@@ -72,6 +102,21 @@ public:
     // Prepare buffers and prefetch weights
     void prepare();
 
+    // Tensor-parallel split across pool's NUMA domains (cpu_ops/numa.h): each domain owns whole KV
+    // groups with their query heads, gets node-local copies of its q/k/v rows and o_proj columns,
+    // and runs projection, attention and its share of o_proj without touching another node. The
+    // per-domain o_proj partials are the only cross-node traffic.
+    void place_weights(ThreadPool &pool);
+
     // Run attention for a single token
     void run(Tensor &input, size_t token_idx, Tensor &output);
+
+    // Adds run() for one token to graph as q/k/v projection, per-head attention and o_proj nodes,
+    // one chain per NUMA domain, all after node dep. input and output must stay valid until the
+    // graph has run. Returns the node that completes output.
+    int add_to_graph(TaskGraph &graph, const float *input, size_t token_idx, float *output, int dep);
+
+    // Run attention for M token rows [M, embed_dim] in one pass; projections are shared M-row matmuls.
+    // Rows may belong to the same sequence (consecutive positions) or to different sequences.
+    void run_batch(Tensor &input, const AttentionRow *rows, size_t M, Tensor &output);
 };
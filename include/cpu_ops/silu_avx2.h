@@ -2,10 +2,10 @@
 #include <cstddef>
 
 /**
- * @brief Computes the SiLU (Sigmoid Linear Unit) activation using AVX2.
+ * @brief Computes the SiLU (Sigmoid Linear Unit) activation.
  *
- * Calculates out[i] = sigmoid(x[i]) * x[i] for i in [0, n), using AVX2 for maximum performance.
- * Input and output arrays must be 32-byte aligned.
+ * Calculates out[i] = sigmoid(x[i]) * x[i] for i in [0, n) with the host's widest kernel
+ * table (see cpu_ops/kernels.h). No alignment is required.
  *
  * @param x Pointer to input array
  * @param out Pointer to output array
@@ -3,7 +3,7 @@
 #include <cstddef>
 
 /**
- * @brief Computes the softmax of a float array using AVX2 vectorization.
+ * @brief Computes the softmax of a float array with the host's widest kernel table.
  *
  * This function normalizes the input array in-place so that the output values
  * sum to 1, using numerically stable softmax (subtracting max before exp).
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+
+/*
+SpscQueue is a bounded lock-free ring between exactly one producer thread and one consumer
+thread. Each side owns one index on its own cache line and only reads the other's, so a
+hand-off is one release store and one acquire load with no shared writes.
+
+push() and pop() yield while the ring is full or empty; they are meant for hand-offs between
+threads that are busy anyway (pipeline stages within a batch), not for parking idle threads.
+*/
+template <typename T>
+class SpscQueue
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscQueue(std::size_t capacity)
+    {
+        std::size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        items_.reset(new T[size]);
+        mask_ = size - 1;
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+    // Producer only; false if the ring is full
+    bool try_push(const T &value)
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_)
+        {
+            return false;
+        }
+        items_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only; false if the ring is empty
+    bool try_pop(T &value)
+    {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        value = items_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    void push(const T &value)
+    {
+        while (!try_push(value))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    T pop()
+    {
+        T value;
+        while (!try_pop(value))
+        {
+            std::this_thread::yield();
+        }
+        return value;
+    }
+
+private:
+    std::unique_ptr<T[]> items_;
+    std::size_t mask_ = 0;
+
+    // Next slot to read, written by the consumer
+    alignas(64) std::atomic<std::size_t> head_{0};
+    // Next slot to write, written by the producer
+    alignas(64) std::atomic<std::size_t> tail_{0};
+};
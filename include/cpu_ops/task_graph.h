@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <cpu_ops/cost_model.h>
+#include <cpu_ops/thread_pool.h>
+
+/*
+TaskGraph runs a small DAG of ops on the ThreadPool. Each node covers a range [0, size) that is
+cut into chunks of grain; a node's chunks become runnable once every node it depends on has
+finished, so independent ops (q/k/v projections, gate/up, attention heads) are in flight at the
+same time instead of each waiting for the slowest thread of the previous parallel loop.
+
+Every thread owns a Chase-Lev deque. It pushes the chunks of nodes it makes ready and pops them
+LIFO (the inputs are still in its cache); idle threads steal FIFO from the others, so the
+imbalance of small batch-1 ops is absorbed by whoever is free.
+
+A node may instead be split by NUMA domain: range d of its bounds is only run by the pool threads
+of domain d (ThreadPool::thread_domain), so the weight rows each domain placed in its own memory
+are never streamed across the interconnect. Those chunks go to a per-domain ready list rather than
+a deque. If the node was split for a different number of domains than the pool has, or the run
+cannot use every thread, its chunks are scheduled like any other.
+
+Nodes can only depend on nodes added before them, which keeps the graph acyclic. A graph may be
+cleared and rebuilt for every call; its buffers are reused. Bodies run on pool threads (nested
+parallel_for calls inside them run inline) and must not throw.
+*/
+class TaskGraph
+{
+public:
+    using Body = std::function<void(std::size_t begin, std::size_t end)>;
+
+    TaskGraph() = default;
+    TaskGraph(const TaskGraph &) = delete;
+    TaskGraph &operator=(const TaskGraph &) = delete;
+
+    // Adds body over [0, size) in chunks of grain, runnable after deps; returns the node id
+    int add(std::size_t size, std::size_t grain, Body body, const std::vector<int> &deps = {});
+
+    // Chunked as CostModel would chunk the range on its own; cheap ranges stay a single chunk
+    int add(std::size_t size, const WorkCost &cost, Body body, const std::vector<int> &deps = {});
+
+    // Single-chunk node
+    int add(std::function<void()> body, const std::vector<int> &deps = {});
+
+    // Body over [bounds[0], bounds.back()) in chunks of grain; [bounds[d], bounds[d + 1]) runs on domain d
+    int add(const std::vector<std::size_t> &bounds, std::size_t grain, Body body, const std::vector<int> &deps = {});
+    int add(const std::vector<std::size_t> &bounds, const WorkCost &cost, Body body, const std::vector<int> &deps = {});
+
+    std::size_t size() const noexcept { return nodes_.size(); }
+
+    // Removes every node, keeping allocations
+    void clear();
+
+    // Runs every node once and returns when all have finished
+    void run(ThreadPool &pool = ThreadPool::current());
+
+private:
+    struct Node
+    {
+        Body body;
+        int first_chunk;
+        int num_chunks;
+        int num_deps;
+        std::vector<int> successors;
+        std::vector<int> domain_chunks; // chunk offsets of each domain's range; empty if not split
+    };
+
+    // Fixed-capacity Chase-Lev deque of chunk ids: the owner pushes and takes at the bottom,
+    // thieves steal from the top. Capacity covers every chunk of a run, so it never wraps.
+    struct alignas(64) WorkDeque
+    {
+        alignas(64) std::atomic<long> top{0};
+        alignas(64) std::atomic<long> bottom{0};
+        std::unique_ptr<std::atomic<int>[]> buffer;
+        long capacity = 0;
+
+        void reset(long new_capacity);
+        void push(int chunk);
+        int take();
+        int steal();
+    };
+
+    int add_node(Node node, const std::vector<int> &deps);
+    void add_chunks(std::size_t begin, std::size_t end, std::size_t grain);
+    void worker(int thread_index, int num_threads);
+    void make_ready(int node, WorkDeque &deque);
+    void execute(int chunk, WorkDeque &deque);
+    int claim_domain_chunk(int domain, int &cursor);
+
+    std::vector<Node> nodes_;
+    std::vector<int> chunk_node_;
+    std::vector<std::size_t> chunk_begin_;
+    std::vector<std::size_t> chunk_end_;
+
+    // Per-run state
+    std::unique_ptr<WorkDeque[]> deques_;
+    int num_deques_ = 0;
+    std::unique_ptr<std::atomic<int>[]> pending_deps_;
+    std::unique_ptr<std::atomic<int>[]> pending_chunks_;
+    std::size_t state_capacity_ = 0;
+
+    // Per-run state of domain-split nodes; num_domains_ is 0 when they are scheduled normally
+    int num_domains_ = 0;
+    int pool_threads_ = 0;
+    std::vector<int> thread_domain_;
+    std::unique_ptr<std::atomic<int>[]> domain_ready_; // [domain][i]: node ids, -1 until published
+    std::unique_ptr<std::atomic<int>[]> domain_count_;
+    std::unique_ptr<std::atomic<int>[]> domain_next_;  // [node][domain]: next chunk to claim
+    std::size_t domain_capacity_ = 0;
+    alignas(64) std::atomic<int> nodes_left_{0};
+};
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// How the shared pool is sized and placed; see ThreadPool::configure
+struct ThreadPoolConfig
+{
+    int num_threads = 0;   // counts the calling thread; <= 0 is one per physical core of cpus
+    bool pin_threads = true;
+    bool use_smt = false;  // with num_threads <= 0, also one per hyperthread sibling
+    std::string cpus;      // CPU list such as "0-15,32-47"; empty is the process affinity mask.
+                           // "0-7;8-15" makes each ';' group a NUMA domain of its own (emulation)
+    int spin_us = 50;
+};
+
+/*
+ThreadPool is the set of persistent workers behind every parallel cpu_ops kernel. It replaces
+per-op OpenMP regions, whose fork/join cost is comparable to the work of a 2048-wide decode op.
+
+Workers are started once and pinned to distinct CPUs in CpuTopology::placement() order: one per
+physical core first, so by default a pool never puts two compute threads on hyperthread siblings.
+The first CPU is reserved for the calling thread, which pins itself there with pin_caller() (the
+model does so on the thread that runs it). Each worker waits on its own cache line: it spins for
+spin_us after its last task, then parks on a futex (WaitOnAddress on Windows), so back-to-back
+kernels of one token are handed over without a syscall and idle pools cost nothing. A dispatch writes one task
+pointer, bumps the slots of the workers it needs and waits for them on a shared counter.
+
+The calling thread always takes part as thread 0. Calls made from inside a task, or while
+another thread is using the pool, run inline on the caller with a single thread.
+
+Pinned threads are grouped into NUMA domains (the nodes of their CPUs, numbered densely in
+placement order). parallel_for_domains() keeps each domain's threads on its own part of a range,
+which is how node-local weight slices (cpu_ops/numa.h) are only ever read from their own node.
+
+Kernels run on current(): the shared pool, unless the calling thread has bound a pool of its own
+with a Scope. Pipeline stages (models/layer_pipeline.h) use this to keep every kernel of their
+layers on their own core group.
+*/
+class ThreadPool
+{
+public:
+    using Task = void (*)(void *context, int thread_index, int num_threads);
+
+    // Throws std::invalid_argument if config.cpus is malformed or names no CPU the process may use
+    explicit ThreadPool(const ThreadPoolConfig &config);
+
+    // num_threads counts the calling thread; <= 0 uses every CPU the process may run on
+    explicit ThreadPool(int num_threads = 0, bool pin_threads = true, int spin_us = 50);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /*
+    Shared pool, started on first use from the configure() settings. The environment overrides
+    them: MINMAX_NUM_THREADS (or OMP_NUM_THREADS), MINMAX_PIN_THREADS=0, MINMAX_USE_SMT=1 and
+    MINMAX_CPUS (a CPU list).
+    */
+    static ThreadPool &instance();
+
+    // Settings for the shared pool; false (and ignored) once it has started
+    static bool configure(const ThreadPoolConfig &config);
+
+    // Pool that kernels called on this thread run on: the innermost Scope's, else instance()
+    static ThreadPool &current();
+
+    // Binds pool to the calling thread for the Scope's lifetime
+    class Scope
+    {
+    public:
+        explicit Scope(ThreadPool &pool);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        ThreadPool *previous_;
+    };
+
+    int num_threads() const noexcept { return static_cast<int>(workers_.size()) + 1; }
+
+    // CPUs the threads are pinned to, the calling thread's slot first; empty if unpinned
+    const std::vector<int> &cpus() const noexcept { return cpus_; }
+
+    // CPUs of the process that no pool thread is pinned to, for helper threads; empty if unpinned
+    std::vector<int> spare_cpus() const;
+
+    // Pins the calling thread to the CPU reserved for thread 0, once per thread; false if the pool
+    // is unpinned or pinning failed. Threads it creates afterwards inherit that CPU on Linux.
+    bool pin_caller() const;
+
+    // NUMA domains spanned by the threads; 1 if unpinned
+    int num_domains() const noexcept { return num_domains_; }
+    int thread_domain(int thread_index) const noexcept { return domains_[thread_index]; }
+    int domain_threads(int domain) const noexcept { return domain_threads_[domain]; }
+
+    // Runs task(context, t, n) for t in [0, n), n = min(max_threads, num_threads()), and returns
+    // once every call has finished. An exception from any call is rethrown here, the calling
+    // thread's own first, otherwise the first a worker caught
+    void run(Task task, void *context, int max_threads = 0);
+
+    // body(t, n) on n threads
+    template <typename Body>
+    void parallel_run(Body &&body, int max_threads = 0)
+    {
+        using Fn = typename std::remove_reference<Body>::type;
+        run([](void *context, int t, int n) { (*static_cast<Fn *>(context))(t, n); }, &body, max_threads);
+    }
+
+    /*
+    body(chunk_begin, chunk_end) over [begin, end) in chunks of grain, on at most max_threads
+    threads. Chunks are claimed from a shared counter so uneven chunks balance out; a range of
+    one chunk runs inline without any dispatch, which is what keeps small ops cheap.
+    */
+    template <typename Body>
+    void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, Body &&body, int max_threads = 0)
+    {
+        if (end <= begin)
+        {
+            return;
+        }
+        grain = grain > 0 ? grain : 1;
+        const std::size_t chunks = (end - begin + grain - 1) / grain;
+        if (chunks == 1)
+        {
+            body(begin, end);
+            return;
+        }
+
+        std::atomic<std::size_t> next(0);
+        auto worker = [&](int, int)
+        {
+            for (std::size_t chunk = next.fetch_add(1, std::memory_order_relaxed); chunk < chunks;
+                 chunk = next.fetch_add(1, std::memory_order_relaxed))
+            {
+                const std::size_t chunk_begin = begin + chunk * grain;
+                body(chunk_begin, chunk_begin + grain < end ? chunk_begin + grain : end);
+            }
+        };
+        if (max_threads <= 0 || max_threads > num_threads())
+        {
+            max_threads = num_threads();
+        }
+        parallel_run(worker, chunks < static_cast<std::size_t>(max_threads) ? static_cast<int>(chunks) : max_threads);
+    }
+
+    /*
+    body(chunk_begin, chunk_end) over [bounds[0], bounds.back()), where [bounds[d], bounds[d + 1])
+    is only run by the threads of domain d. When the call cannot use every thread (nested or
+    concurrent calls) or bounds does not have one range per domain, any thread takes any chunk.
+    */
+    template <typename Body>
+    void parallel_for_domains(const std::vector<std::size_t> &bounds, std::size_t grain, Body &&body)
+    {
+        const int domains = static_cast<int>(bounds.size()) - 1;
+        if (domains < 1)
+        {
+            return;
+        }
+        grain = grain > 0 ? grain : 1;
+
+        std::vector<std::atomic<std::size_t>> next(domains);
+        for (int d = 0; d < domains; ++d)
+        {
+            next[d].store(bounds[d], std::memory_order_relaxed);
+        }
+        auto claim = [&](int d)
+        {
+            for (std::size_t begin = next[d].fetch_add(grain, std::memory_order_relaxed); begin < bounds[d + 1];
+                 begin = next[d].fetch_add(grain, std::memory_order_relaxed))
+            {
+                body(begin, begin + grain < bounds[d + 1] ? begin + grain : bounds[d + 1]);
+            }
+        };
+        auto worker = [&](int t, int n)
+        {
+            if (n == num_threads() && domains == num_domains_)
+            {
+                claim(domains_[t]);
+                return;
+            }
+            for (int i = 0; i < domains; ++i)
+            {
+                claim((t + i) % domains);
+            }
+        };
+        parallel_run(worker);
+    }
+
+private:
+    // One per worker, on its own cache line so waiting never shares a line with dispatch
+    struct alignas(64) Slot
+    {
+        std::atomic<std::uint32_t> sequence{0};
+        std::atomic<std::uint32_t> sleeping{0};
+    };
+
+    void worker_loop(int index, int cpu);
+
+    std::vector<std::thread> workers_;
+    std::unique_ptr<Slot[]> slots_;
+    std::vector<int> cpus_;
+    std::vector<int> domains_;
+    std::vector<int> domain_threads_;
+    int num_domains_;
+    int spin_us_;
+
+    std::mutex owner_;
+    alignas(64) std::atomic<int> remaining_;
+    std::atomic<bool> stop_;
+    Task task_;
+    void *context_;
+    int active_;
+
+    // First exception of the current run() on a worker
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+};
+
+// parallel_for on the calling thread's pool
+template <typename Body>
+inline void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, Body &&body)
+{
+    ThreadPool::current().parallel_for(begin, end, grain, std::forward<Body>(body));
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// unroll<Count>(body) calls body(0), body(1), ..., body(Count - 1) as straight-line code, so a
+// loop over a compile-time length is written out on every compiler instead of at the
+// optimizer's discretion. Used by the fixed-size kernels in the kernels_<isa>.cpp files; body
+// is a lambda local to the caller, so every instantiation stays within its translation unit.
+template <int Count, int I = 0, typename Body>
+inline void unroll(Body &body)
+{
+    if constexpr (I < Count)
+    {
+        body(I);
+        unroll<Count, I + 1>(body);
+    }
+}
+
+// body(v, slot) for each of the N / Lanes vectors of a row, with slot = v % 4 as a constant so
+// four accumulators can stay in registers. Rows of up to 16 vectors (a head) are written out
+// completely; longer ones (a hidden state) run a constant-trip loop of four-vector steps.
+template <int N, int Lanes, typename Body>
+inline void for_each_vector(Body &body)
+{
+    static_assert(N % (4 * Lanes) == 0, "fixed-size rows are whole groups of four vectors");
+    constexpr int vectors = N / Lanes;
+    if constexpr (vectors <= 16)
+    {
+        auto step = [&](int v) { body(v, v % 4); };
+        unroll<vectors>(step);
+    }
+    else
+    {
+        for (int v = 0; v < vectors; v += 4)
+        {
+            auto step = [&](int slot) { body(v + slot, slot); };
+            unroll<4>(step);
+        }
+    }
+}
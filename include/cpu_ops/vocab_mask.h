@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+VocabMask is a bitset over the vocabulary marking which tokens may be generated next.
+
+Bit (id % 64) of words()[id / 64] is set when token id is allowed. It is filled by a
+constrained-decoding frontend (e.g. a compiled grammar / regex token automaton) and handed
+to the lm_head kernels, which skip the rows of disallowed tokens entirely.
+*/
+class VocabMask
+{
+public:
+    VocabMask() = default;
+    explicit VocabMask(int vocab_size, bool allow_all = false) { resize(vocab_size, allow_all); }
+
+    void resize(int vocab_size, bool allow_all = false)
+    {
+        if (vocab_size < 0)
+        {
+            throw std::invalid_argument("vocab_size must be non-negative");
+        }
+        vocab_size_ = vocab_size;
+        words_.assign((static_cast<std::size_t>(vocab_size) + 63) / 64, 0);
+        if (allow_all)
+        {
+            set_all();
+        }
+    }
+
+    void set_all()
+    {
+        for (auto &word : words_)
+            word = ~std::uint64_t(0);
+        // keep the bits past vocab_size clear so count() stays exact
+        const int tail = vocab_size_ % 64;
+        if (tail != 0)
+            words_.back() = (std::uint64_t(1) << tail) - 1;
+    }
+
+    void clear()
+    {
+        for (auto &word : words_)
+            word = 0;
+    }
+
+    void allow(int id)
+    {
+        check_id(id);
+        words_[id >> 6] |= std::uint64_t(1) << (id & 63);
+    }
+
+    void disallow(int id)
+    {
+        check_id(id);
+        words_[id >> 6] &= ~(std::uint64_t(1) << (id & 63));
+    }
+
+    bool allowed(int id) const noexcept
+    {
+        return id >= 0 && id < vocab_size_ && ((words_[id >> 6] >> (id & 63)) & 1);
+    }
+
+    std::size_t count() const noexcept
+    {
+        std::size_t total = 0;
+        for (std::uint64_t word : words_)
+        {
+#if defined(_MSC_VER)
+            total += static_cast<std::size_t>(__popcnt64(word));
+#else
+            total += static_cast<std::size_t>(__builtin_popcountll(word));
+#endif
+        }
+        return total;
+    }
+
+    int vocab_size() const noexcept { return vocab_size_; }
+    const std::uint64_t *words() const noexcept { return words_.data(); }
+
+private:
+    void check_id(int id) const
+    {
+        if (id < 0 || id >= vocab_size_)
+        {
+            throw std::out_of_range("Token id out of vocabulary mask range");
+        }
+    }
+
+    std::vector<std::uint64_t> words_;
+    int vocab_size_ = 0;
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "qwen3model.h"
+#include "../cpu_ops/self_attention.h"
+#include "../tensor/kvcache.h"
+#include "../tensor/kv_swap.h"
+
+struct GenerationRequest
+{
+    std::vector<int> prompt;
+    std::size_t max_new_tokens = 0;
+    SamplerConfig sampler;
+    int priority = 0; // higher is served first and may preempt lower-priority sequences
+};
+
+/*
+Scheduling knobs. max_tokens_per_step bounds the rows of one forward and therefore the latency
+every in-flight sequence sees per token (TPOT); prompt slices fill whatever the decode rows leave.
+Larger budgets and chunks push prompts through faster (lower TTFT) at the cost of slower steps.
+
+max_kv_tokens caps the KV rows held by active sequences. With a swap_path, sequences are admitted
+against their current length and the lowest-priority ones are preempted to the swap file when
+the cap (or a higher-priority arrival) needs room; they resume later without recomputation.
+Without one, admission reserves each sequence's worst-case length up front.
+*/
+struct BatchEngineConfig
+{
+    std::size_t max_batch_size = 8;        // sequences decoding or prefilling at once
+    std::size_t max_sequence_length = 4096; // prompt + generated tokens per sequence (KV cache rows)
+    std::size_t max_tokens_per_step = 256; // decode + prefill rows per forward
+    std::size_t max_prefill_chunk = 128;   // largest prompt slice of one sequence per step
+    std::size_t max_kv_tokens = 0;         // KV rows across active sequences, 0 = unlimited
+    std::string swap_path;                 // swap file for preempted sequences, empty disables preemption
+};
+
+// One token produced by a step of the engine
+struct StepToken
+{
+    int sequence_id;
+    int token;
+    bool finished;
+};
+
+struct BatchEngineStats
+{
+    std::size_t steps = 0;
+    std::size_t prompt_tokens = 0;
+    std::size_t generated_tokens = 0;
+    std::size_t decode_rows = 0;      // sum of decode rows over all steps
+    std::size_t prefill_rows = 0;     // sum of prompt rows over all steps
+    std::size_t first_tokens = 0;     // sequences that produced their first token
+    double time_to_first_token_ms = 0.0; // summed over those sequences, from submit()
+    double max_step_ms = 0.0;
+    std::size_t preemptions = 0;
+    std::size_t resumptions = 0;
+
+    double mean_batch_size() const noexcept
+    {
+        return steps > 0 ? static_cast<double>(decode_rows) / static_cast<double>(steps) : 0.0;
+    }
+
+    double mean_time_to_first_token_ms() const noexcept
+    {
+        return first_tokens > 0 ? time_to_first_token_ms / static_cast<double>(first_tokens) : 0.0;
+    }
+};
+
+/*
+BatchEngine decodes many sequences with one Qwen3Model (continuous batching).
+
+Every active sequence owns a KV cache; the model's weights and decoders are shared. Each step
+builds one batched forward: a row for the pending token of every decoding sequence, then slices
+of waiting prompts (chunked prefill) up to the step's token budget. Projections and lm_head
+become M-row GEMMs that stream the weights once per step, while attention runs per row against
+that row's own cache. A prompt's final slice also yields its first token. Queued requests join
+as soon as a slot is free and finished sequences leave at the end of the step.
+*/
+class BatchEngine
+{
+public:
+    BatchEngine(Qwen3Model &model, const BatchEngineConfig &config = BatchEngineConfig());
+
+    // Queues a request and returns its sequence id
+    int submit(const GenerationRequest &request);
+
+    // Admits waiting requests (highest priority first, resuming swapped sequences before new ones),
+    // preempts to stay within max_kv_tokens, then runs one forward over the decode rows and
+    // prompt slices scheduled for this step. Returns the tokens produced by this step.
+    std::vector<StepToken> step();
+
+    // Drops a queued, swapped or active sequence; returns false if the id is unknown or finished
+    bool cancel(int sequence_id);
+
+    bool has_work() const noexcept { return !active_.empty() || !queue_.empty() || !swapped_.empty(); }
+    std::size_t active_count() const noexcept { return active_.size(); }
+    std::size_t queued_count() const noexcept { return queue_.size(); }
+    std::size_t swapped_count() const noexcept { return swapped_.size(); }
+    std::size_t kv_tokens_in_use() const noexcept;
+    const BatchEngineConfig &config() const noexcept { return config_; }
+    const BatchEngineStats &stats() const noexcept { return stats_; }
+    // Swap-out / swap-in counts, bytes, latency and bandwidth (all zero without a swap file)
+    KVSwapStats swap_stats() const { return swap_ ? swap_->stats() : KVSwapStats(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Sequence
+    {
+        int id = 0;
+        GenerationRequest request;
+        std::unique_ptr<KVCache> cache;
+        Sampler sampler;
+        std::vector<int> history; // prompt + generated, for penalties
+        std::size_t prefilled = 0; // prompt tokens already in the cache
+        std::size_t generated = 0;
+        int pending = 0;           // last sampled token, not yet in the cache
+        Clock::time_point submitted;
+        KVSwapSlot swap_slot;      // valid while the sequence is swapped out
+
+        bool decoding() const noexcept { return prefilled == request.prompt.size(); }
+    };
+
+    // Rows of one sequence in the current step
+    struct Slice
+    {
+        std::size_t sequence;
+        std::size_t rows;
+        bool sample; // the slice's last row produces a token
+    };
+
+    void admit();
+    bool next_waiting(bool &from_swap, std::size_t &index) const;
+    std::size_t lowest_priority_active() const;
+    std::size_t reserved_tokens(const Sequence &sequence) const;
+    bool fits_kv_budget(const Sequence &candidate) const;
+    void enforce_kv_budget();
+    void preempt(std::size_t index);
+    void schedule();
+    std::unique_ptr<KVCache> acquire_cache();
+    void release(Sequence &sequence);
+
+    Qwen3Model &model_;
+    BatchEngineConfig config_;
+    int next_id_;
+
+    std::deque<Sequence> queue_;
+    std::vector<Sequence> swapped_;
+    std::vector<Sequence> active_;
+    std::unique_ptr<KVSwapFile> swap_;
+    std::vector<std::unique_ptr<KVCache>> free_caches_;
+    BatchEngineStats stats_;
+
+    std::vector<Slice> slices_;
+    std::vector<int> step_tokens_;
+    std::vector<AttentionRow> step_rows_;
+    std::vector<std::size_t> logit_rows_;
+    std::vector<float> row_logits_;
+};
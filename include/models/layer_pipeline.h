@@ -0,0 +1,96 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../cpu_ops/spsc_queue.h"
+#include "../cpu_ops/thread_pool.h"
+#include "../tensor/tensor.h"
+
+class Decoder;
+struct AttentionRow;
+
+/*
+LayerPipeline runs a batch through the decoder stack pipeline-parallel. The layers are cut into
+contiguous stages and every stage gets its own ThreadPool on a disjoint group of the shared
+pool's cores, taken NUMA domain by domain, so a stage's weights stay in its group's caches and
+(placed with place_weights on stage_pool()) on its node. A batch is split into micro-batches of
+rows that move from stage to stage through SpscQueues: while stage s runs micro-batch m, stage
+s - 1 already runs m + 1.
+
+Each stage handles micro-batches in order, so rows of one sequence split over several
+micro-batches still find the keys and values of their earlier positions in the KV cache.
+
+This trades latency for throughput: a single micro-batch only ever has one stage's cores, but
+with enough micro-batches every core group is busy and none waits on another group's memory.
+*/
+class LayerPipeline
+{
+public:
+    // num_stages is clamped to [1, num_layers]; stage pools split the cores of shared
+    LayerPipeline(std::size_t num_layers, int num_stages, const ThreadPool &shared = ThreadPool::instance());
+    ~LayerPipeline();
+
+    LayerPipeline(const LayerPipeline &) = delete;
+    LayerPipeline &operator=(const LayerPipeline &) = delete;
+
+    int num_stages() const noexcept { return static_cast<int>(pools_.size()); }
+
+    // Layers [stage_begin(s), stage_begin(s + 1)) belong to stage s
+    std::size_t stage_begin(int stage) const noexcept { return layer_bounds_[stage]; }
+    int layer_stage(std::size_t layer) const;
+
+    ThreadPool &stage_pool(int stage) { return *pools_[stage]; }
+
+    /*
+    Runs count rows through decoders[0 .. num_layers) in micro-batches of micro_batch rows (0 picks
+    two per stage). input and output are [count, hidden] and must not alias; rows[i] gives row i's
+    KV cache and position as in Decoder::run_batch. Rethrows the first exception of any stage.
+    */
+    void run(Decoder *const *decoders, Tensor &input, const AttentionRow *rows, std::size_t count,
+             std::size_t micro_batch, Tensor &output);
+
+private:
+    struct Job
+    {
+        Decoder *const *decoders = nullptr;
+        float *input = nullptr;
+        float *output = nullptr;
+        const AttentionRow *rows = nullptr;
+        std::size_t count = 0;
+        std::size_t hidden = 0;
+        std::size_t micro_batch = 0;
+        std::size_t num_micro_batches = 0;
+    };
+
+    void stage_loop(int stage);
+    void run_micro_batch(int stage, std::size_t index);
+
+    std::vector<std::size_t> layer_bounds_;
+    std::vector<std::unique_ptr<ThreadPool>> pools_;
+
+    // queues_[s] carries micro-batch indices from stage s to stage s + 1
+    std::vector<std::unique_ptr<SpscQueue<std::size_t>>> queues_;
+    std::vector<std::thread> threads_;
+
+    // Ping-pong buffers for every row of the current job
+    std::vector<float> scratch_;
+
+    // Stage threads park on wake_ between jobs; run() parks on done_ until the last stage has
+    // finished the job's generation
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    Job job_;
+    std::size_t generation_ = 0;
+    std::size_t finished_ = 0;
+    bool stop_ = false;
+
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+};
@@ -6,10 +6,16 @@
 #include <vector>
 
 #include "../tensor/tensor.h"
+#include "../cpu_ops/kernels.h"
+#include "../cpu_ops/sampler.h"
+#include "../cpu_ops/thread_pool.h"
+#include "../cpu_ops/vocab_mask.h"
 
 class Safetensor;
 class KVCache;
 class Decoder;
+class LayerPipeline;
+struct AttentionRow;
 
 struct Qwen3Config
 {
@@ -20,11 +26,25 @@ struct Qwen3Config
     int num_attention_heads = 16;
     int num_hidden_layers = 28;
     int num_key_value_heads = 8;
+    int head_dim = 128; // <= 0 derives hidden_size / num_attention_heads
     float rms_norm_eps = 1e-6f;
     float rope_theta = 1000000.0f;
     int vocab_size = 151936;
     int bos_token_id = 151643;
     int eos_token_id = 151645;
+
+    // Compute thread count and placement; applied if no model has started the shared pool yet
+    ThreadPoolConfig threading;
+
+    // Split every decoder projection across the pool's NUMA domains, each slice copied into
+    // node-local memory (MINMAX_NUMA overrides). Costs a resident copy of the decoder weights.
+    bool numa = false;
+
+    // Layer-pipelined batches (models/layer_pipeline.h): the decoders are cut into this many stages,
+    // each run on its own group of the pool's cores (MINMAX_PIPELINE_STAGES overrides). <= 1 runs
+    // every layer on the whole pool. Only multi-row forwards are pipelined.
+    int pipeline_stages = 1;
+    std::size_t pipeline_micro_batch = 0; // rows per micro-batch, 0 picks two per stage
 };
 
 enum class TokenPhase
@@ -43,22 +63,81 @@ public:
 
     void reset_cache();
 
+    // Discards the last `tokens` processed tokens so generation resumes from an earlier position
+    void rewind(std::size_t tokens);
+
     void process_prompt_token(int token_id);
-    const std::vector<float> &predict_next_token(int token_id);
+
+    // Returns the raw (un-normalized) lm_head logits for the token following token_id.
+    // With a mask only allowed rows of the lm_head are computed; the rest are -inf.
+    const std::vector<float> &predict_next_token(int token_id, const VocabMask *mask = nullptr);
+
+    // Runs the forward pass for token_id and returns the sampled next token id,
+    // restricted to the tokens allowed by mask when one is given
+    int sample_next_token(int token_id, const VocabMask *mask = nullptr);
+
+    // Batched prefill: runs count consecutive tokens through the decoder stack in one pass
+    void process_prompt_tokens(const int *token_ids, std::size_t count);
+
+    // Batched forward of count consecutive tokens; returns logits [count, vocab_size] where
+    // row i predicts the token following token_ids[i]. Weights are streamed once for all rows.
+    const std::vector<float> &predict_tokens(const int *token_ids, std::size_t count);
+
+    // Decoder layers (ascending indices) run by predict_next_token_draft for self-speculation
+    void set_draft_layers(const std::vector<std::size_t> &layers);
+    const std::vector<std::size_t> &draft_layers() const noexcept { return draft_layers_; }
+
+    // predict_next_token through the draft layers only. Shares the KV cache with the full stack,
+    // so drafted positions must be rewound and re-run through every layer before they are kept.
+    const std::vector<float> &predict_next_token_draft(int token_id);
+
+    // Creates an empty KV cache shaped for this model with room for max_tokens positions
+    std::unique_ptr<KVCache> create_kv_cache(std::size_t max_tokens) const;
+
+    // Runs count token rows through the decoder stack in one pass without touching the model's own
+    // sequence state. rows[i] names the KV cache and position of token_ids[i]; rows may mix sequences,
+    // and callers advance their caches afterwards. Returns logits [num_logit_rows, vocab_size] for
+    // the rows listed in logit_rows (nullptr with num_logit_rows == count selects every row).
+    const std::vector<float> &forward_rows(const int *token_ids, const AttentionRow *rows, std::size_t count,
+                                           const std::size_t *logit_rows, std::size_t num_logit_rows);
+
+    void set_sampler_config(const SamplerConfig &sampler_config);
+    const SamplerConfig &sampler_config() const noexcept { return sampler_.config(); }
 
     const Qwen3Config &config() const noexcept { return config_; }
     std::size_t tokens_processed() const noexcept { return tokens_processed_; }
+    // Number of tokens that can still be appended before the KV cache is full
+    std::size_t remaining_positions() const noexcept
+    {
+        const auto limit = static_cast<std::size_t>(config_.max_position_embeddings) - 1;
+        return limit > tokens_processed_ ? limit - tokens_processed_ : 0;
+    }
+    const std::vector<int> &token_history() const noexcept { return token_history_; }
 
 private:
+    // Largest top-k served by the fused lm_head epilogue; larger k falls back to full logits
+    static constexpr int kMaxFusedTopK = 256;
+
     void ensure_weights_loaded() const;
     void ensure_cache_initialized();
     void check_token_valid(int token_id) const;
     void ensure_position_capacity() const;
 
+    int fused_top_k() const noexcept;
+    void run_token(int token_id, const std::vector<std::size_t> *layers = nullptr);
+    void commit_token(int token_id);
+    Tensor &run_token_batch(const int *token_ids, std::size_t count);
+    void commit_tokens(const int *token_ids, std::size_t count);
+    void ensure_batch_capacity(std::size_t count);
+    void embed_tokens(const int *token_ids, std::size_t count);
+    void compute_row_logits(const Tensor &hidden, const std::size_t *rows, std::size_t count);
+
     void embed_token(int token_id);
-    void run_decoder_stack(std::size_t token_index);
+    void run_decoder_stack(std::size_t token_index, const std::vector<std::size_t> *layers);
+    Tensor &run_decoder_stack_batch(const AttentionRow *rows, std::size_t count);
     void apply_final_norm();
-    void run_lm_head();
+    void check_mask_valid(const VocabMask *mask) const;
+    void run_lm_head(const VocabMask *mask);
 
     Qwen3Config config_;
     int head_dim_;
@@ -67,9 +146,13 @@ private:
     std::unique_ptr<Safetensor> weights_;
     std::unique_ptr<KVCache> kv_cache_;
     std::vector<std::unique_ptr<Decoder>> decoders_;
+    std::vector<std::size_t> draft_layers_;
+    std::unique_ptr<LayerPipeline> pipeline_;
+    std::vector<Decoder *> pipeline_layers_;
 
     Tensor embedding_weight_;
     Tensor final_norm_weight_;
+    FixedRmsNorm final_norm_row_ = nullptr; // compiled for hidden_size, or nullptr (generic)
     Tensor sin_cache_;
     Tensor cos_cache_;
 
@@ -77,6 +160,16 @@ private:
     Tensor decoder_output_;
     Tensor norm_output_;
 
+    // [batch, hidden] buffers for the multi-token paths, grown on demand
+    Tensor batch_hidden_;
+    Tensor batch_output_;
+    Tensor batch_norm_;
+    std::vector<AttentionRow> batch_rows_;
+
     std::vector<float> logits_buffer_;
+    std::vector<float> batch_logits_;
+    std::vector<TokenCandidate> candidate_buffer_;
+    std::vector<int> token_history_;
+    Sampler sampler_;
 };
 
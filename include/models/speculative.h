@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "qwen3model.h"
+
+struct SpeculativeStats
+{
+    std::size_t rounds = 0;
+    std::size_t drafted_tokens = 0;
+    std::size_t accepted_tokens = 0;
+    std::size_t generated_tokens = 0;
+
+    double acceptance_rate() const noexcept
+    {
+        return drafted_tokens > 0 ? static_cast<double>(accepted_tokens) / static_cast<double>(drafted_tokens) : 0.0;
+    }
+
+    // Tokens produced per target forward pass
+    double tokens_per_round() const noexcept
+    {
+        return rounds > 0 ? static_cast<double>(generated_tokens) / static_cast<double>(rounds) : 0.0;
+    }
+};
+
+/*
+Drafter proposes tokens that SpeculativeDecoder verifies with a single batched forward of
+the target model. A drafter keeps its own view of the context and must not touch the target.
+*/
+class Drafter
+{
+public:
+    virtual ~Drafter() = default;
+
+    // Starts a new sequence; context holds the prompt tokens the target has already processed
+    virtual void begin(const std::vector<int> &context) = 0;
+
+    // Appends up to max_tokens proposals following context + pending to tokens and returns how
+    // many were added. Stochastic drafters also append the [vocab_size] distribution each token
+    // was drawn from to probs; deterministic drafters leave probs empty.
+    virtual std::size_t propose(int pending, std::size_t max_tokens, std::vector<int> &tokens, std::vector<float> &probs) = 0;
+
+    // pending and the first `accepted` of the `proposed` tokens are now part of the context
+    virtual void accept(int pending, const int *tokens, std::size_t proposed, std::size_t accepted) = 0;
+};
+
+/*
+DraftModelDrafter runs a smaller Qwen3 model (e.g. Qwen3-0.6B for a 1.7B target) one token
+at a time and samples with the same settings as the target. Rejected tokens are rolled back
+with Qwen3Model::rewind.
+*/
+class DraftModelDrafter : public Drafter
+{
+public:
+    DraftModelDrafter(Qwen3Model &draft, const SamplerConfig &sampler_config);
+
+    void begin(const std::vector<int> &context) override;
+    std::size_t propose(int pending, std::size_t max_tokens, std::vector<int> &tokens, std::vector<float> &probs) override;
+    void accept(int pending, const int *tokens, std::size_t proposed, std::size_t accepted) override;
+
+private:
+    Qwen3Model &draft_;
+    Sampler sampler_;
+};
+
+/*
+SelfSpeculativeDrafter drafts with a subset of the target's own decoder layers (e.g. every
+other layer, or the first K), so no second set of weights or KV cache is needed. Drafted
+positions are rewound before verification and rewritten by the full stack.
+*/
+class SelfSpeculativeDrafter : public Drafter
+{
+public:
+    SelfSpeculativeDrafter(Qwen3Model &model, const std::vector<std::size_t> &draft_layers, const SamplerConfig &sampler_config);
+
+    void begin(const std::vector<int> &context) override;
+    std::size_t propose(int pending, std::size_t max_tokens, std::vector<int> &tokens, std::vector<float> &probs) override;
+    void accept(int pending, const int *tokens, std::size_t proposed, std::size_t accepted) override;
+
+    // Layers 0, stride, 2 * stride, ...
+    static std::vector<std::size_t> strided_layers(int num_layers, int stride);
+    // Layers 0 .. count - 1
+    static std::vector<std::size_t> leading_layers(int num_layers, int count);
+
+private:
+    Qwen3Model &model_;
+    Sampler sampler_;
+};
+
+/*
+PromptLookupDrafter needs no draft model. It finds the most recent earlier occurrence of the
+trailing n-gram in the prompt + generated context (longest n first) and proposes the tokens
+that followed it. This pays off when the output copies spans of the input (summaries, code edits).
+*/
+class PromptLookupDrafter : public Drafter
+{
+public:
+    explicit PromptLookupDrafter(std::size_t max_ngram = 3, std::size_t min_ngram = 1);
+
+    void begin(const std::vector<int> &context) override;
+    std::size_t propose(int pending, std::size_t max_tokens, std::vector<int> &tokens, std::vector<float> &probs) override;
+    void accept(int pending, const int *tokens, std::size_t proposed, std::size_t accepted) override;
+
+private:
+    std::size_t max_ngram_;
+    std::size_t min_ngram_;
+    std::vector<int> context_;
+};
+
+/*
+SpeculativeDecoder generates with a target model and a Drafter.
+
+Each round the target verifies [pending, d1..dk] in one batched forward (weights are streamed
+once for all k + 1 rows). Draft token d_i is accepted with probability min(1, p(d_i) / q(d_i));
+the first rejection is replaced by a sample from the residual max(0, p - q), and if every
+draft is accepted a bonus token is drawn from the last row. The output distribution matches
+sampling from the target alone; with greedy settings the output is identical.
+*/
+class SpeculativeDecoder
+{
+public:
+    SpeculativeDecoder(Qwen3Model &target, Drafter &drafter, std::size_t num_draft_tokens = 4,
+                       const SamplerConfig &sampler_config = SamplerConfig());
+
+    // Resets the target, prefills the prompt and generates up to max_new_tokens tokens
+    // (stopping after eos_token_id). The prompt must not be empty.
+    std::vector<int> generate(const std::vector<int> &prompt, std::size_t max_new_tokens);
+
+    const SpeculativeStats &stats() const noexcept { return stats_; }
+
+private:
+    // Returns the number of accepted draft tokens and stores the corrected / bonus token in next_token
+    std::size_t verify(std::size_t proposed, const float *target_logits, int &next_token);
+
+    Qwen3Model &target_;
+    Drafter &drafter_;
+    std::size_t num_draft_tokens_;
+    Sampler sampler_;
+    SpeculativeStats stats_;
+
+    std::vector<int> draft_tokens_;
+    std::vector<float> draft_probs_;
+    std::vector<int> verify_tokens_;
+    std::vector<float> target_probs_;
+};
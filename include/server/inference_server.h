@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../models/batch_engine.h"
+#include "../tokenizer/bpe_tokenizer.h"
+
+struct InferenceServerConfig
+{
+    // "host:port" for HTTP over TCP (port 0 picks a free one) or "unix:/path/to.sock"
+    std::string listen = "127.0.0.1:8080";
+    std::size_t max_connections = 64;
+    BatchEngineConfig engine;
+};
+
+/*
+InferenceServer keeps one loaded Qwen3Model behind a small HTTP/1.1 endpoint so requests skip
+process startup and weight loading. All connections feed a single BatchEngine, stepped by one
+engine thread; each connection thread parses its request, submits it and streams the tokens back
+as they are produced.
+
+  POST /generate  {"prompt": [ids...], "max_new_tokens": n, "temperature": t, "top_k": k,
+                   "top_p": p, "min_p": m, "repetition_penalty": r, "seed": s, "priority": q}
+      -> 200, chunked application/x-ndjson: {"token": id} per token, then
+         {"done": true, "generated": n, "time_to_first_token_ms": x, "total_ms": y}
+  GET /health     -> {"status": "ok", "active": a, "queued": q, "swapped": s, "connections": c}
+
+With a tokenizer, "text": "..." may replace "prompt" and every token line also carries the
+"text" it completes (UTF-8 safe, so a line may carry "" while a character is still partial).
+
+Request bodies are flat JSON objects; unknown keys are ignored. A client that disconnects
+mid-stream has its sequence cancelled. Unix sockets speak the same protocol
+(curl --unix-socket). Nothing here authenticates callers, so bind to loopback or a private socket.
+*/
+class InferenceServer
+{
+public:
+    InferenceServer(Qwen3Model &model, const InferenceServerConfig &config = InferenceServerConfig(),
+                    const BpeTokenizer *tokenizer = nullptr);
+    ~InferenceServer();
+
+    InferenceServer(const InferenceServer &) = delete;
+    InferenceServer &operator=(const InferenceServer &) = delete;
+
+    // Binds the listener and starts the accept and engine threads
+    void start();
+
+    // Stops accepting, ends open streams with an error and joins every thread
+    void stop();
+
+    bool running() const noexcept { return running_; }
+
+    // Bound address in the same form as the config, with the actual port for TCP
+    const std::string &endpoint() const noexcept { return endpoint_; }
+
+private:
+    // Tokens handed from the engine thread to one connection
+    struct Stream
+    {
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::deque<int> tokens;
+        bool finished = false;
+        std::string error;
+        std::atomic<bool> cancelled{false};
+    };
+
+    struct Submission
+    {
+        GenerationRequest request;
+        std::shared_ptr<Stream> stream;
+    };
+
+    struct Connection
+    {
+        std::intptr_t socket;
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    void accept_loop();
+    void engine_loop();
+    void serve(Connection &connection);
+    void handle_generate(std::intptr_t socket, const std::string &body);
+    void handle_health(std::intptr_t socket);
+    void reap_connections(bool all);
+    void fail_streams(const std::string &error);
+
+    Qwen3Model &model_;
+    InferenceServerConfig config_;
+    const BpeTokenizer *tokenizer_;
+    std::string endpoint_;
+    std::string unix_path_;
+    std::intptr_t listener_;
+
+    std::atomic<bool> running_;
+    std::thread accept_thread_;
+    std::thread engine_thread_;
+
+    std::mutex connections_mutex_;
+    std::list<Connection> connections_;
+
+    // Guarded by submit_mutex_, handed to the engine thread
+    std::mutex submit_mutex_;
+    std::condition_variable submit_ready_;
+    std::vector<Submission> submissions_;
+
+    // Owned by the engine thread
+    std::unique_ptr<BatchEngine> engine_;
+    std::unordered_map<int, std::shared_ptr<Stream>> streams_;
+
+    // Engine occupancy published for /health
+    std::atomic<std::size_t> active_;
+    std::atomic<std::size_t> queued_;
+    std::atomic<std::size_t> swapped_;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+Just enough JSON for flat request objects: a key's value is located by scanning for the quoted
+key followed by ':'. Nested objects and strings containing quoted keys are not supported.
+Malformed values throw std::invalid_argument naming the key, which the server returns as a 400.
+*/
+
+// text with quotes, backslashes and control characters escaped for a JSON string literal
+std::string json_escape(const std::string &text);
+
+// Finds the value of key; pos is left on its first character
+bool json_value(const std::string &body, const char *key, std::size_t &pos);
+
+// Stores the number under key in out, or leaves out unchanged when the key is absent
+template <typename T>
+void json_number(const std::string &body, const char *key, T &out)
+{
+    std::size_t pos = 0;
+    if (!json_value(body, key, pos))
+    {
+        return;
+    }
+
+    const char *begin = body.c_str() + pos;
+    char *end = nullptr;
+    const double value = std::strtod(begin, &end);
+    if (end == begin || (std::is_unsigned<T>::value && value < 0.0))
+    {
+        throw std::invalid_argument(std::string("Expected a number for \"") + key + "\"");
+    }
+    out = static_cast<T>(value);
+}
+
+// The string under key, with escapes (surrogate pairs included) decoded to UTF-8
+std::string json_string(const std::string &body, const char *key);
+
+// The array of integers under key
+std::vector<int> json_int_array(const std::string &body, const char *key);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "kvcache.h"
+
+// Location of one swapped-out sequence in the swap file
+struct KVSwapSlot
+{
+    std::uint64_t offset = 0;
+    std::uint64_t bytes = 0;
+    std::size_t tokens = 0;
+};
+
+struct KVSwapStats
+{
+    std::size_t swap_outs = 0;
+    std::size_t swap_ins = 0;
+    std::uint64_t bytes_out = 0;
+    std::uint64_t bytes_in = 0;
+    double swap_out_ms = 0.0;
+    double swap_in_ms = 0.0;
+
+    double swap_out_mb_per_s() const noexcept { return swap_out_ms > 0.0 ? bytes_out / (1024.0 * 1024.0) / (swap_out_ms / 1000.0) : 0.0; }
+    double swap_in_mb_per_s() const noexcept { return swap_in_ms > 0.0 ? bytes_in / (1024.0 * 1024.0) / (swap_in_ms / 1000.0) : 0.0; }
+    double mean_swap_out_ms() const noexcept { return swap_outs > 0 ? swap_out_ms / swap_outs : 0.0; }
+    double mean_swap_in_ms() const noexcept { return swap_ins > 0 ? swap_in_ms / swap_ins : 0.0; }
+};
+
+/*
+KVSwapFile parks the filled rows of a KVCache in a local file so the cache can be reused by
+another sequence. Only the first get_current_token_idx() rows of every (layer, group) are
+written, as [layer][group] { keys [tokens, head_dim], values [tokens, head_dim] }, with
+positional writes (pwrite / overlapped WriteFile). Freed extents are reused first-fit.
+The file is temporary and removed when the object is destroyed.
+*/
+class KVSwapFile
+{
+public:
+    explicit KVSwapFile(const std::string &path);
+    ~KVSwapFile();
+
+    KVSwapFile(const KVSwapFile &) = delete;
+    KVSwapFile &operator=(const KVSwapFile &) = delete;
+
+    // Writes the cache's filled rows and returns where they went; the cache itself is untouched
+    KVSwapSlot swap_out(const KVCache &cache);
+
+    // Restores a slot into cache (same shape, at least slot.tokens + 1 rows) and frees the slot
+    void swap_in(const KVSwapSlot &slot, KVCache &cache);
+
+    // Frees a slot without reading it back
+    void release(const KVSwapSlot &slot);
+
+    const KVSwapStats &stats() const noexcept { return stats_; }
+    std::uint64_t file_size() const noexcept { return file_end_; }
+
+private:
+    std::uint64_t allocate(std::uint64_t bytes);
+    void write_at(const void *data, std::size_t bytes, std::uint64_t offset);
+    void read_at(void *data, std::size_t bytes, std::uint64_t offset);
+
+    std::string path_;
+#if defined(_WIN32)
+    void *handle_;
+#else
+    int fd_;
+#endif
+    std::uint64_t file_end_;
+    std::map<std::uint64_t, std::uint64_t> free_extents_; // offset -> bytes
+    KVSwapStats stats_;
+};
@@ -44,6 +44,10 @@ public:
     // Get const value pointer for full value memory of specific layer and group
     const float *get_value_memory_ptr(size_t layer, size_t group=0) const;
 
+    // Mutable views of the same memory, used to restore swapped-out rows
+    float *get_key_memory_ptr(size_t layer, size_t group=0);
+    float *get_value_memory_ptr(size_t layer, size_t group=0);
+
     // Get const key pointer for entire key cache
     const float *get_full_key_cache_ptr() const;
 
@@ -70,8 +74,12 @@ public:
 
     // Sequence management
     void advance();
+    void advance(size_t count);
     void reset();
 
+    // Roll back to the first token_count tokens; later rows are left in place and overwritten on reuse
+    void truncate(size_t token_count);
+
     // Getters
     size_t get_current_token_idx() const;
     size_t get_max_sequence_length() const;
@@ -23,6 +23,9 @@ struct PrefetchManager
     void enqueue(void *ptr, size_t bytes);
     void stop();
 
+    // Restricts the prefetch thread to cpus (e.g. ones without compute threads); empty leaves it as is
+    void set_affinity(const std::vector<int> &cpus);
+
 private:
     PrefetchManager();
     ~PrefetchManager();
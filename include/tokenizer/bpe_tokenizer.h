@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+BpeTokenizer implements the byte-level BPE of Qwen's tokenizer.json (HF "tokenizers" format).
+
+Vocabulary entries are stored as raw bytes: the GPT-2 byte-to-unicode mapping is undone once at
+load time, so encoding works directly on UTF-8 input bytes and decoding is a concatenation of
+token bytes. Merges become (left id, right id) -> (rank, merged id) in a hash map, and a word
+is merged lowest rank first.
+
+Encoding splits out added tokens (<|im_start|>, ...) first, then pre-tokenizes with a
+hand-written equivalent of Qwen2's split regex
+
+    (?i:'s|'t|'re|'ve|'m|'ll|'d)|[^\r\n\p{L}\p{N}]?\p{L}+|\p{N}| ?[^\s\p{L}\p{N}]+[\r\n]*|\s*[\r\n]+|\s+(?!\S)|\s+
+
+Letter/number classes are exact for ASCII and Latin-1 and approximate above (most non-ASCII
+code points outside known punctuation, symbol and digit blocks count as letters). The NFC
+normalizer is not applied; callers passing decomposed text get slightly different splits.
+*/
+class BpeTokenizer
+{
+public:
+    BpeTokenizer() = default;
+
+    void load(const std::string &tokenizer_json_path);
+    void load_from_string(const std::string &tokenizer_json);
+
+    // With parse_special, special added tokens in the text map to their ids; otherwise they are
+    // encoded as plain text. Non-special added tokens are always matched.
+    std::vector<int> encode(const std::string &text, bool parse_special = true) const;
+
+    // Invalid or truncated UTF-8 in the token bytes becomes U+FFFD
+    std::string decode(const int *ids, std::size_t count, bool skip_special = false) const;
+    std::string decode(const std::vector<int> &ids, bool skip_special = false) const
+    {
+        return decode(ids.data(), ids.size(), skip_special);
+    }
+
+    // Raw bytes of a token (may be a partial UTF-8 sequence)
+    const std::string &token_bytes(int id) const;
+
+    // Id of a vocabulary or added token given as text, -1 if unknown
+    int token_to_id(const std::string &token) const;
+
+    bool is_special(int id) const;
+    std::size_t vocab_size() const noexcept { return id_to_bytes_.size(); }
+
+    // The pre-tokenizer's split of text into words, exposed for inspection and tests
+    static std::vector<std::string> pre_tokenize(const std::string &text);
+
+private:
+    struct AddedToken
+    {
+        int id;
+        std::string content;
+        bool special;
+    };
+
+    struct Merge
+    {
+        int rank;
+        int merged;
+    };
+
+    void encode_word(const std::string &word, std::vector<int> &ids) const;
+
+    std::vector<std::string> id_to_bytes_;
+    std::vector<bool> special_;
+    std::unordered_map<std::string, int> bytes_to_id_;
+    std::unordered_map<std::uint64_t, Merge> merges_; // (left << 32 | right) -> merge
+    int byte_ids_[256] = {};
+    std::vector<AddedToken> added_tokens_; // longest first, so prefixes never shadow longer tokens
+};
+
+/*
+StreamingDetokenizer turns a token stream into text without splitting UTF-8 sequences: bytes of
+an incomplete character are held back until the token that completes it arrives.
+*/
+class StreamingDetokenizer
+{
+public:
+    explicit StreamingDetokenizer(const BpeTokenizer &tokenizer, bool skip_special = false);
+
+    // Text completed by this token, possibly empty
+    std::string push(int id);
+
+    // Whatever is still held back, with an unfinished sequence replaced by U+FFFD
+    std::string flush();
+
+    void reset() { pending_.clear(); }
+
+private:
+    const BpeTokenizer &tokenizer_;
+    bool skip_special_;
+    std::string pending_;
+};
@@ -16,7 +16,24 @@ $testExecutables = @(
     'test_silu_avx2.exe',
     'test_SimplifiedLayerNormalization_AVX2.exe',
     'test_SkipSimplifiedLayerNormalization_AVX2.exe',
-    'test_softmax_avx2.exe'
+    'test_softmax_avx2.exe',
+    'test_sampler.exe',
+    'test_lm_head.exe',
+    'test_thread_pool.exe',
+    'test_task_graph.exe',
+    'test_cost_model.exe',
+    'test_cpu_topology.exe',
+    'test_numa.exe',
+    'test_spsc_queue.exe',
+    'test_kernels.exe',
+    'test_gemm.exe',
+    'test_linear_dispatch.exe',
+    'test_prompt_lookup.exe',
+    'test_kv_swap.exe',
+    'test_inference_server.exe',
+    'test_bpe_tokenizer.exe',
+    'test_decoder_numa.exe',
+    'test_layer_pipeline.exe'
 )
 
 $failed = $false
@@ -0,0 +1,159 @@
+#include <cpu_ops/cost_model.h>
+#include <cpu_ops/kernels.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ns(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+volatile float calibration_sink;
+
+CostModel default_model()
+{
+    // MINMAX_COST_MODEL="dispatch_ns,core_GBps,total_GBps,core_GFLOPs" skips calibration
+    if (const char *fixed = std::getenv("MINMAX_COST_MODEL"))
+    {
+        double dispatch = 0.0, core_bw = 0.0, total_bw = 0.0, flops = 0.0;
+        if (std::sscanf(fixed, "%lf,%lf,%lf,%lf", &dispatch, &core_bw, &total_bw, &flops) == 4)
+        {
+            return CostModel(dispatch, core_bw, total_bw, flops, ThreadPool::instance().num_threads());
+        }
+    }
+    return CostModel::calibrate(ThreadPool::instance());
+}
+} // namespace
+
+CostModel::CostModel(double dispatch_ns, double core_bytes_per_ns, double total_bytes_per_ns, double core_flops_per_ns,
+                     int max_threads)
+    : dispatch_ns_(std::max(0.0, dispatch_ns)),
+      core_bytes_per_ns_(std::max(1e-3, core_bytes_per_ns)),
+      total_bytes_per_ns_(std::max(core_bytes_per_ns_, total_bytes_per_ns)),
+      core_flops_per_ns_(std::max(1e-3, core_flops_per_ns)),
+      max_threads_(std::max(1, max_threads))
+{
+}
+
+const CostModel &CostModel::instance()
+{
+    static const CostModel model = default_model();
+    return model;
+}
+
+CostModel CostModel::calibrate(ThreadPool &pool)
+{
+    const int threads = pool.num_threads();
+    const KernelTable &ops = kernels();
+
+    // Dispatch: back-to-back empty tasks on every thread
+    double dispatch = 0.0;
+    if (threads > 1)
+    {
+        for (int i = 0; i < 200; ++i)
+            pool.run([](void *, int, int) {}, nullptr);
+        const int reps = 2000;
+        const auto start = Clock::now();
+        for (int i = 0; i < reps; ++i)
+            pool.run([](void *, int, int) {}, nullptr);
+        dispatch = elapsed_ns(start) / reps;
+    }
+
+    // Bandwidth: a buffer well past the last-level cache, read by one thread, then by all
+    const std::size_t count = std::size_t(16) << 20; // 64 MB
+    std::vector<float> buffer(count, 1.0f);
+    const double bytes = static_cast<double>(count) * sizeof(float);
+
+    double core_ns = 1e30;
+    for (int pass = 0; pass < 3; ++pass)
+    {
+        const auto start = Clock::now();
+        calibration_sink = ops.sum(buffer.data(), count);
+        core_ns = std::min(core_ns, elapsed_ns(start));
+    }
+
+    double total_ns = core_ns;
+    if (threads > 1)
+    {
+        for (int pass = 0; pass < 3; ++pass)
+        {
+            const auto start = Clock::now();
+            pool.parallel_run([&](int t, int n)
+            {
+                const std::size_t begin = count * t / n;
+                const std::size_t end = count * (t + 1) / n;
+                calibration_sink = ops.sum(buffer.data() + begin, end - begin);
+            });
+            total_ns = std::min(total_ns, elapsed_ns(start));
+        }
+    }
+
+    // Compute: one core's FMA rate at the vector width the kernels run with
+    const int iterations = 100000;
+    double fma_ns = 1e30;
+    for (int pass = 0; pass < 3; ++pass)
+    {
+        const auto start = Clock::now();
+        calibration_sink = ops.fma_chains(iterations);
+        fma_ns = std::min(fma_ns, elapsed_ns(start));
+    }
+    const double flops = static_cast<double>(iterations) * 8 * ops.lanes * 2;
+
+    return CostModel(dispatch, bytes / core_ns, bytes / total_ns, flops / fma_ns, threads);
+}
+
+double CostModel::predict_ns(std::size_t items, const WorkCost &cost, int threads) const
+{
+    const double t = static_cast<double>(std::max(1, threads));
+    const double bandwidth = std::min(t * core_bytes_per_ns_, total_bytes_per_ns_);
+    const double memory_ns = static_cast<double>(items) * cost.bytes / bandwidth;
+    const double compute_ns = static_cast<double>(items) * cost.flops / (t * core_flops_per_ns_);
+    return std::max(memory_ns, compute_ns) + (threads > 1 ? dispatch_ns_ : 0.0);
+}
+
+ParallelPlan CostModel::plan(std::size_t items, const WorkCost &cost) const
+{
+    ParallelPlan best{1, std::max<std::size_t>(items, 1)};
+    const int limit = static_cast<int>(std::min<std::size_t>(static_cast<std::size_t>(max_threads_), items));
+    if (limit < 2)
+    {
+        return best;
+    }
+
+    // Candidates: powers of two, where memory bandwidth saturates, and every thread
+    const int saturated = static_cast<int>(total_bytes_per_ns_ / core_bytes_per_ns_ + 0.999);
+    int candidates[40];
+    int num_candidates = 0;
+    for (int t = 2; t < limit; t *= 2)
+        candidates[num_candidates++] = t;
+    if (saturated > 1 && saturated < limit)
+        candidates[num_candidates++] = saturated;
+    candidates[num_candidates++] = limit;
+
+    // More threads must win by a margin: they also take cores from anything else running
+    double best_ns = predict_ns(items, cost, 1);
+    for (int i = 0; i < num_candidates; ++i)
+    {
+        const double ns = predict_ns(items, cost, candidates[i]);
+        if (ns < best_ns * 0.95)
+        {
+            best_ns = ns;
+            best.threads = candidates[i];
+        }
+    }
+
+    if (best.threads > 1)
+    {
+        const std::size_t chunks = static_cast<std::size_t>(best.threads) * 4;
+        best.grain = std::max<std::size_t>(1, (items + chunks - 1) / chunks);
+    }
+    return best;
+}
@@ -0,0 +1,168 @@
+#include <cpu_ops/cpu_features.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+struct CpuidRegisters
+{
+    std::uint32_t eax = 0;
+    std::uint32_t ebx = 0;
+    std::uint32_t ecx = 0;
+    std::uint32_t edx = 0;
+};
+
+CpuidRegisters cpuid(std::uint32_t leaf, std::uint32_t subleaf = 0)
+{
+    CpuidRegisters r;
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+    r.eax = static_cast<std::uint32_t>(regs[0]);
+    r.ebx = static_cast<std::uint32_t>(regs[1]);
+    r.ecx = static_cast<std::uint32_t>(regs[2]);
+    r.edx = static_cast<std::uint32_t>(regs[3]);
+#elif defined(__x86_64__) || defined(__i386__)
+    __cpuid_count(leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx);
+#else
+    (void)leaf;
+    (void)subleaf;
+#endif
+    return r;
+}
+
+// Register state the OS saves on context switches (XCR0)
+std::uint64_t os_saved_state()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#elif defined(__x86_64__) || defined(__i386__)
+    std::uint32_t eax = 0;
+    std::uint32_t edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<std::uint64_t>(edx) << 32) | eax;
+#else
+    return 0;
+#endif
+}
+
+bool bit(std::uint32_t value, int index)
+{
+    return (value >> index) & 1u;
+}
+
+CpuFeatures detect()
+{
+    CpuFeatures features;
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    const CpuidRegisters leaf0 = cpuid(0);
+    char vendor[13] = {};
+    std::memcpy(vendor, &leaf0.ebx, 4);
+    std::memcpy(vendor + 4, &leaf0.edx, 4);
+    std::memcpy(vendor + 8, &leaf0.ecx, 4);
+    features.vendor = vendor;
+
+    if (cpuid(0x80000000).eax >= 0x80000004)
+    {
+        char brand[49] = {};
+        for (std::uint32_t i = 0; i < 3; ++i)
+        {
+            const CpuidRegisters r = cpuid(0x80000002 + i);
+            std::memcpy(brand + 16 * i, &r, 16);
+        }
+        features.model = brand;
+        const std::size_t first = features.model.find_first_not_of(' ');
+        const std::size_t last = features.model.find_last_not_of(' ');
+        features.model = first == std::string::npos ? std::string() : features.model.substr(first, last - first + 1);
+    }
+
+    if (leaf0.eax < 1)
+    {
+        return features;
+    }
+    const CpuidRegisters leaf1 = cpuid(1);
+    features.sse42 = bit(leaf1.ecx, 20);
+
+    // AVX state must be enabled by the OS, not just present in the core
+    const bool osxsave = bit(leaf1.ecx, 27);
+    const std::uint64_t xcr0 = osxsave ? os_saved_state() : 0;
+    const bool ymm_saved = (xcr0 & 0x6) == 0x6;
+    const bool zmm_saved = (xcr0 & 0xe6) == 0xe6;
+
+    features.avx = bit(leaf1.ecx, 28) && ymm_saved;
+    features.fma = bit(leaf1.ecx, 12) && ymm_saved;
+    if (leaf0.eax >= 7)
+    {
+        const CpuidRegisters leaf7 = cpuid(7, 0);
+        features.avx2 = bit(leaf7.ebx, 5) && ymm_saved;
+        features.avx512f = bit(leaf7.ebx, 16) && zmm_saved;
+        features.avx512dq = bit(leaf7.ebx, 17) && zmm_saved;
+        features.avx512bw = bit(leaf7.ebx, 30) && zmm_saved;
+        features.avx512vl = bit(leaf7.ebx, 31) && zmm_saved;
+    }
+#endif
+    return features;
+}
+} // namespace
+
+const CpuFeatures &cpu_features()
+{
+    static const CpuFeatures features = detect();
+    return features;
+}
+
+IsaLevel host_isa()
+{
+    const CpuFeatures &features = cpu_features();
+    IsaLevel isa = IsaLevel::Scalar;
+    if (features.avx2 && features.fma)
+    {
+        isa = IsaLevel::Avx2;
+        if (features.avx512f && features.avx512dq)
+        {
+            isa = IsaLevel::Avx512;
+        }
+    }
+
+    const char *cap = std::getenv("MINMAX_ISA");
+    if (cap != nullptr && *cap != '\0')
+    {
+        const IsaLevel requested = parse_isa(cap);
+        isa = requested < isa ? requested : isa;
+    }
+    return isa;
+}
+
+const char *isa_name(IsaLevel isa)
+{
+    switch (isa)
+    {
+    case IsaLevel::Avx2:
+        return "avx2";
+    case IsaLevel::Avx512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+IsaLevel parse_isa(const std::string &name)
+{
+    if (name == "scalar")
+        return IsaLevel::Scalar;
+    if (name == "avx2")
+        return IsaLevel::Avx2;
+    if (name == "avx512")
+        return IsaLevel::Avx512;
+    throw std::invalid_argument("Unknown instruction set '" + name + "' (expected scalar, avx2 or avx512)");
+}
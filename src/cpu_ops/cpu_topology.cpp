@@ -0,0 +1,380 @@
+#include <cpu_ops/cpu_topology.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace
+{
+#if defined(__linux__)
+int read_sys_int(const std::string &path, int fallback)
+{
+    std::ifstream file(path);
+    int value = fallback;
+    if (file >> value)
+    {
+        return value;
+    }
+    return fallback;
+}
+
+std::string read_sys_line(const std::string &path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// cpuN links its node as a "nodeK" entry in its sysfs directory
+int sys_cpu_node(const std::string &cpu_dir)
+{
+    int node = 0;
+    if (DIR *dir = opendir(cpu_dir.c_str()))
+    {
+        while (dirent *entry = readdir(dir))
+        {
+            const std::string name = entry->d_name;
+            if (name.size() > 4 && name.compare(0, 4, "node") == 0 && std::isdigit(static_cast<unsigned char>(name[4])))
+            {
+                node = std::atoi(name.c_str() + 4);
+                break;
+            }
+        }
+        closedir(dir);
+    }
+    return node;
+}
+#endif
+
+// Every CPU its own core on node 0
+std::vector<LogicalCpu> flat_topology()
+{
+    std::vector<LogicalCpu> cpus;
+    const unsigned count = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < count; ++i)
+    {
+        const int id = static_cast<int>(i);
+        cpus.push_back({id, id, 0, 0});
+    }
+    return cpus;
+}
+} // namespace
+
+CpuTopology::CpuTopology(std::vector<LogicalCpu> cpus) : cpus_(std::move(cpus))
+{
+    std::sort(cpus_.begin(), cpus_.end(), [](const LogicalCpu &a, const LogicalCpu &b) { return a.id < b.id; });
+}
+
+const CpuTopology &CpuTopology::instance()
+{
+    static const CpuTopology topology = detect();
+    return topology;
+}
+
+CpuTopology CpuTopology::detect()
+{
+    std::vector<LogicalCpu> cpus;
+
+#if defined(__linux__)
+    std::vector<int> online;
+    try
+    {
+        online = parse_cpu_list(read_sys_line("/sys/devices/system/cpu/online"));
+    }
+    catch (const std::invalid_argument &)
+    {
+    }
+
+    // core_id is only unique within a package
+    std::map<std::pair<int, int>, int> core_index;
+    for (int id : online)
+    {
+        const std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(id);
+        const int package = read_sys_int(dir + "/topology/physical_package_id", 0);
+        const int core_id = read_sys_int(dir + "/topology/core_id", id);
+        const auto key = std::make_pair(package, core_id);
+        if (core_index.find(key) == core_index.end())
+        {
+            const int next = static_cast<int>(core_index.size());
+            core_index[key] = next;
+        }
+        cpus.push_back({id, core_index[key], package, sys_cpu_node(dir)});
+    }
+#elif defined(_WIN32)
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+    std::vector<char> buffer(length);
+    if (length > 0 && GetLogicalProcessorInformationEx(
+                          RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length))
+    {
+        // Processor group 0 only: affinity masks below are single-group
+        const int max_cpus = static_cast<int>(sizeof(KAFFINITY) * 8);
+        std::vector<int> core(max_cpus, -1), package(max_cpus, 0), node(max_cpus, 0);
+        int num_cores = 0;
+        int num_packages = 0;
+
+        for (DWORD offset = 0; offset < length;)
+        {
+            const auto *info = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(buffer.data() + offset);
+            if (info->Relationship == RelationProcessorCore || info->Relationship == RelationProcessorPackage)
+            {
+                const int index = info->Relationship == RelationProcessorCore ? num_cores++ : num_packages++;
+                for (WORD g = 0; g < info->Processor.GroupCount; ++g)
+                {
+                    const GROUP_AFFINITY &group = info->Processor.GroupMask[g];
+                    for (int bit = 0; group.Group == 0 && bit < max_cpus; ++bit)
+                    {
+                        if (group.Mask & (static_cast<KAFFINITY>(1) << bit))
+                        {
+                            (info->Relationship == RelationProcessorCore ? core : package)[bit] = index;
+                        }
+                    }
+                }
+            }
+            else if (info->Relationship == RelationNumaNode)
+            {
+                const GROUP_AFFINITY &group = info->NumaNode.GroupMask;
+                for (int bit = 0; group.Group == 0 && bit < max_cpus; ++bit)
+                {
+                    if (group.Mask & (static_cast<KAFFINITY>(1) << bit))
+                    {
+                        node[bit] = static_cast<int>(info->NumaNode.NodeNumber);
+                    }
+                }
+            }
+            offset += info->Size;
+        }
+
+        for (int id = 0; id < max_cpus; ++id)
+        {
+            if (core[id] >= 0)
+            {
+                cpus.push_back({id, core[id], package[id], node[id]});
+            }
+        }
+    }
+#endif
+
+    if (cpus.empty())
+    {
+        cpus = flat_topology();
+    }
+    return CpuTopology(std::move(cpus));
+}
+
+const LogicalCpu *CpuTopology::find(int cpu) const
+{
+    auto it = std::lower_bound(cpus_.begin(), cpus_.end(), cpu, [](const LogicalCpu &a, int id) { return a.id < id; });
+    return it != cpus_.end() && it->id == cpu ? &*it : nullptr;
+}
+
+int CpuTopology::num_nodes() const
+{
+    std::set<int> nodes;
+    for (const LogicalCpu &cpu : cpus_)
+    {
+        nodes.insert(cpu.node);
+    }
+    return std::max<int>(1, static_cast<int>(nodes.size()));
+}
+
+int CpuTopology::num_cores(const std::vector<int> &allowed) const
+{
+    std::set<int> cores;
+    for (int id : allowed)
+    {
+        const LogicalCpu *cpu = find(id);
+        // CPUs missing from the topology count as cores of their own
+        cores.insert(cpu ? cpu->core : -1 - id);
+    }
+    return static_cast<int>(cores.size());
+}
+
+std::vector<int> CpuTopology::placement(const std::vector<int> &allowed) const
+{
+    std::vector<int> sorted(allowed);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    // The lowest allowed CPU of every core is its primary, grouped by NUMA node
+    std::set<int> seen_cores;
+    std::map<int, std::vector<int>> primaries_by_node;
+    std::vector<int> siblings;
+    for (int id : sorted)
+    {
+        const LogicalCpu *cpu = find(id);
+        const int core = cpu ? cpu->core : -1 - id;
+        if (seen_cores.insert(core).second)
+        {
+            primaries_by_node[cpu ? cpu->node : 0].push_back(id);
+        }
+        else
+        {
+            siblings.push_back(id);
+        }
+    }
+
+    std::vector<int> order;
+    order.reserve(sorted.size());
+    for (std::size_t i = 0; order.size() + siblings.size() < sorted.size(); ++i)
+    {
+        for (const auto &node : primaries_by_node)
+        {
+            if (i < node.second.size())
+            {
+                order.push_back(node.second[i]);
+            }
+        }
+    }
+    order.insert(order.end(), siblings.begin(), siblings.end());
+    return order;
+}
+
+std::vector<int> process_cpus()
+{
+    std::vector<int> cpus;
+#if defined(_WIN32)
+    DWORD_PTR process_mask = 0;
+    DWORD_PTR system_mask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask))
+    {
+        for (int cpu = 0; cpu < static_cast<int>(sizeof(DWORD_PTR) * 8); ++cpu)
+        {
+            if (process_mask & (static_cast<DWORD_PTR>(1) << cpu))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (cpus.empty())
+    {
+        for (const LogicalCpu &cpu : flat_topology())
+        {
+            cpus.push_back(cpu.id);
+        }
+    }
+    return cpus;
+}
+
+std::vector<int> parse_cpu_list(const std::string &list)
+{
+    std::vector<int> cpus;
+    std::size_t pos = 0;
+    auto fail = [&list]() { throw std::invalid_argument("Invalid CPU list: '" + list + "'"); };
+    auto read_number = [&]()
+    {
+        while (pos < list.size() && std::isspace(static_cast<unsigned char>(list[pos])))
+            ++pos;
+        if (pos >= list.size() || !std::isdigit(static_cast<unsigned char>(list[pos])))
+            fail();
+        int value = 0;
+        while (pos < list.size() && std::isdigit(static_cast<unsigned char>(list[pos])))
+        {
+            value = value * 10 + (list[pos++] - '0');
+            if (value > 65535)
+                fail();
+        }
+        while (pos < list.size() && std::isspace(static_cast<unsigned char>(list[pos])))
+            ++pos;
+        return value;
+    };
+
+    while (pos < list.size())
+    {
+        const int first = read_number();
+        int last = first;
+        if (pos < list.size() && list[pos] == '-')
+        {
+            ++pos;
+            last = read_number();
+            if (last < first)
+                fail();
+        }
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+        if (pos < list.size())
+        {
+            if (list[pos] != ',')
+                fail();
+            ++pos;
+            if (pos == list.size())
+                fail();
+        }
+    }
+    if (cpus.empty())
+    {
+        fail();
+    }
+
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+bool pin_current_thread(int cpu)
+{
+    return pin_current_thread(std::vector<int>{cpu});
+}
+
+bool pin_current_thread(const std::vector<int> &cpus)
+{
+    if (cpus.empty())
+    {
+        return false;
+    }
+#if defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8))
+        {
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+        }
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
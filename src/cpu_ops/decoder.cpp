@@ -1,4 +1,5 @@
 #include <cpu_ops/decoder.h>
+#include <cpu_ops/numa.h>
 #include <cstddef>
 
 Decoder::Decoder(
@@ -32,6 +33,10 @@ Decoder::Decoder(
         mlp_up_proj_wt = std::move(_mlp_up_proj_wt);
         mlp_gate_proj_wt = std::move(_mlp_gate_proj_wt);
         mlp_down_proj_wt = std::move(_mlp_down_proj_wt);
+
+        mlp_up_split = {0, mlp_up_proj_wt.shape()[0]};
+        mlp_down_ptrs = {mlp_down_proj_wt.data<float>()};
+        hidden_norm = fixed_rmsnorm(static_cast<int>(input_norm_wt.shape()[0]));
     };
 
 Decoder::~Decoder(){
@@ -52,37 +57,162 @@ void Decoder::prepare(){
     mlp_down_proj_wt.prefetch_async();
 }
 
+void Decoder::place_weights(ThreadPool &pool){
+    self_attn->place_weights(pool);
+
+    mlp_up_split = numa_split(mlp_up_proj_wt.shape()[0], pool);
+    const size_t domains = mlp_up_split.size() - 1;
+
+    mlp_gate_proj_wt = numa_place_rows(mlp_gate_proj_wt, mlp_up_split, pool);
+    mlp_up_proj_wt = numa_place_rows(mlp_up_proj_wt, mlp_up_split, pool);
+
+    mlp_down_parts.clear();
+    mlp_down_ptrs.clear();
+    for (size_t d = 0; d < domains; ++d)
+    {
+        mlp_down_parts.push_back(numa_place_columns(mlp_down_proj_wt, mlp_up_split[d], mlp_up_split[d + 1], static_cast<int>(d), pool));
+        mlp_down_ptrs.push_back(mlp_down_parts.back().data<float>());
+    }
+    mlp_partials.assign(domains * mlp_down_proj_wt.shape()[0], 0.0f);
+    mlp_down_proj_wt = Tensor();
+}
+
 void Decoder::run(Tensor &input, size_t token_idx, Tensor &output){
 
+    const size_t embed_dim = input.shape()[0];
+    size_t up_dim = mlp_up_proj_wt.shape()[0];
+
     // temp tensor for intermediate computation
-    Tensor intermediate1(DataType::F32, {input.shape()[0]});
-    Tensor intermediate2(DataType::F32, {input.shape()[0]});
+    Tensor intermediate1(DataType::F32, {embed_dim});
+    Tensor intermediate2(DataType::F32, {embed_dim});
+    Tensor intermediate3(DataType::F32, {up_dim});
+    Tensor intermediate4(DataType::F32, {up_dim});
+
+    const float *x = input.data<float>();
+    float *h1 = intermediate1.data<float>();
+    float *h2 = intermediate2.data<float>();
+    float *h3 = intermediate3.data<float>();
+    float *h4 = intermediate4.data<float>();
+    float *out = output.data<float>();
+    float *partials = mlp_partials.data();
+    const float *input_norm = input_norm_wt.data<float>();
+    const float *post_attn_norm = post_attn_norm_wt.data<float>();
+    const FixedRmsNorm norm_row = hidden_norm;
+    const float *gate_wt = mlp_gate_proj_wt.data<float>();
+    const float *up_wt = mlp_up_proj_wt.data<float>();
+    const int E = static_cast<int>(embed_dim);
+    const int U = static_cast<int>(up_dim);
+    const int D = static_cast<int>(mlp_up_split.size()) - 1;
+
+    graph.clear();
 
     // pre attention norm
-    rmsnorm_avx2(input.data<float>(), input_norm_wt.data<float>(), intermediate1.data<float>(), 1, input.shape()[0], 0.000001);
+    const int norm = graph.add([=] { rmsnorm_avx2(x, input_norm, h1, 1, E, 0.000001, norm_row); });
 
     // self attention
-    self_attn->run(intermediate1, token_idx, intermediate2);
+    const int attn = self_attn->add_to_graph(graph, h1, token_idx, h2, norm);
+
+    // skip connection self attention, post attention norm
+    const int residual = graph.add([=]
+    {
+        elemwise_add_avx2_omp(x, h2, h1, 1, E);
+        rmsnorm_avx2(h1, post_attn_norm, h2, 1, E, 0.000001, norm_row);
+    }, {attn});
+
+    int active = 0;
+    for (int d = 0; d < D; ++d)
+    {
+        active += mlp_up_split[d + 1] > mlp_up_split[d] ? 1 : 0;
+    }
+
+    // mlp, one chain per domain over its intermediate columns: gate and up are independent,
+    // silu * up runs per chunk once both are done, and down yields a partial of every output
+    std::vector<int> down_nodes;
+    for (int d = 0; d < D; ++d)
+    {
+        const size_t u0 = mlp_up_split[d];
+        const size_t u1 = mlp_up_split[d + 1];
+        if (u0 == u1)
+        {
+            continue;
+        }
+        const int width = static_cast<int>(u1 - u0);
+        const float *down_wt = mlp_down_ptrs[d];
+        float *target = active > 1 ? partials + d * embed_dim : h2;
+
+        const int gate = graph.add(numa_domain_bounds(d, u0, u1, D), linear_cost(1, E), [=](size_t begin, size_t end)
+        {
+            linear_avx2_range(h2, gate_wt, 1, E, U, static_cast<int>(begin), static_cast<int>(end), h3);
+        }, {residual});
+        const int up = graph.add(numa_domain_bounds(d, u0, u1, D), linear_cost(1, E), [=](size_t begin, size_t end)
+        {
+            linear_avx2_range(h2, up_wt, 1, E, U, static_cast<int>(begin), static_cast<int>(end), h4);
+        }, {residual});
+        const int act = graph.add(numa_domain_bounds(d, u0, u1, D), WorkCost{12.0, 20.0}, [=](size_t begin, size_t end)
+        {
+            silu_avx2(h3 + begin, h3 + begin, end - begin);
+            elemwise_mul_avx2(h3 + begin, h4 + begin, h3 + begin, 1, static_cast<int>(end - begin));
+        }, {gate, up});
+        down_nodes.push_back(graph.add(numa_domain_bounds(d, 0, embed_dim, D), linear_cost(1, width), [=](size_t begin, size_t end)
+        {
+            linear_avx2_range(h3 + u0, down_wt, 1, width, E, static_cast<int>(begin), static_cast<int>(end), target);
+        }, {act}));
+    }
+
+    // skip connection mlp, summing the domains' partials on the way
+    if (active == 1)
+    {
+        graph.add([=] { elemwise_add_avx2_omp(h1, h2, out, 1, E); }, down_nodes);
+    }
+    else
+    {
+        graph.add(embed_dim, WorkCost{4.0 * (D + 2), static_cast<double>(D)}, [=](size_t begin, size_t end)
+        {
+            for (size_t j = begin; j < end; ++j)
+            {
+                float sum = h1[j];
+                for (int d = 0; d < D; ++d)
+                    sum += partials[d * E + j];
+                out[j] = sum;
+            }
+        }, down_nodes);
+    }
+
+    graph.run();
+}
+
+void Decoder::run_batch(Tensor &input, const AttentionRow *rows, size_t M, Tensor &output){
+
+    const size_t embed_dim = input.shape().back();
+
+    // temp tensor for intermediate computation
+    Tensor intermediate1(DataType::F32, {M, embed_dim});
+    Tensor intermediate2(DataType::F32, {M, embed_dim});
+
+    // pre attention norm
+    rmsnorm_avx2(input.data<float>(), input_norm_wt.data<float>(), intermediate1.data<float>(), M, embed_dim, 0.000001, hidden_norm);
+
+    // self attention
+    self_attn->run_batch(intermediate1, rows, M, intermediate2);
 
     // skip connection self attention
-    elemwise_add_avx2_omp(input.data<float>(), intermediate2.data<float>(), intermediate1.data<float>(), 1, input.shape()[0]);
+    elemwise_add_avx2_omp(input.data<float>(), intermediate2.data<float>(), intermediate1.data<float>(), M, embed_dim);
 
     // post attention norm
-    rmsnorm_avx2(intermediate1.data<float>(), post_attn_norm_wt.data<float>(), intermediate2.data<float>(), 1, input.shape()[0], 0.000001);
+    rmsnorm_avx2(intermediate1.data<float>(), post_attn_norm_wt.data<float>(), intermediate2.data<float>(), M, embed_dim, 0.000001, hidden_norm);
 
     // mlp
     size_t up_dim = mlp_up_proj_wt.shape()[0];
-    size_t down_dim = mlp_down_proj_wt.shape()[0];
 
-    Tensor intermediate3(DataType::F32, {up_dim});
-    Tensor intermediate4(DataType::F32, {up_dim});
-    
-    linear_avx2_omp(intermediate2.data<float>(), mlp_gate_proj_wt.data<float>(), 1, down_dim, up_dim, intermediate3.data<float>());
-    silu_avx2(intermediate3.data<float>(), intermediate3.data<float>(), up_dim);
-    linear_avx2_omp(intermediate2.data<float>(), mlp_up_proj_wt.data<float>(), 1, down_dim, up_dim, intermediate4.data<float>());
-    elemwise_mul_avx2(intermediate3.data<float>(), intermediate4.data<float>(), intermediate3.data<float>(), 1, up_dim);
-    linear_avx2_omp(intermediate3.data<float>(), mlp_down_proj_wt.data<float>(), 1, up_dim, down_dim, intermediate2.data<float>());
+    Tensor intermediate3(DataType::F32, {M, up_dim});
+    Tensor intermediate4(DataType::F32, {M, up_dim});
+
+    linear_avx2_domains(intermediate2.data<float>(), mlp_gate_proj_wt.data<float>(), M, embed_dim, up_dim, mlp_up_split, intermediate3.data<float>());
+    silu_avx2(intermediate3.data<float>(), intermediate3.data<float>(), M * up_dim);
+    linear_avx2_domains(intermediate2.data<float>(), mlp_up_proj_wt.data<float>(), M, embed_dim, up_dim, mlp_up_split, intermediate4.data<float>());
+    elemwise_mul_avx2(intermediate3.data<float>(), intermediate4.data<float>(), intermediate3.data<float>(), M, up_dim);
+    linear_avx2_column_split(intermediate3.data<float>(), mlp_down_ptrs.data(), M, up_dim, embed_dim, mlp_up_split, intermediate2.data<float>());
 
     // skip connection mlp
-    elemwise_add_avx2_omp(intermediate1.data<float>(), intermediate2.data<float>(), output.data<float>(), 1, input.shape()[0]);    
+    elemwise_add_avx2_omp(intermediate1.data<float>(), intermediate2.data<float>(), output.data<float>(), M, embed_dim);
 }
\ No newline at end of file
@@ -1,27 +1,18 @@
 #include <cpu_ops/elemwise_add.h>
-#include <immintrin.h>
-#include <omp.h>
+#include <cpu_ops/cost_model.h>
+#include <cpu_ops/kernels.h>
+#include <algorithm>
 
 void elemwise_add_avx2_omp(const float* a, const float* b, float* out, int batch_size, int hidden_size) {
-    int total = batch_size * hidden_size;
-    int simd_length = total / 8;
-    int simd_end = simd_length * 8;
+    const std::size_t total = static_cast<std::size_t>(batch_size) * hidden_size;
+    const std::size_t blocks = (total + 7) / 8;
+    const KernelTable& ops = kernels();
 
-#pragma omp parallel
-    {
-#pragma omp for schedule(static)
-        for (int block = 0; block < simd_length; ++block) {
-            int idx = block * 8;
-            __m256 va = _mm256_loadu_ps(a + idx);
-            __m256 vb = _mm256_loadu_ps(b + idx);
-            __m256 vout = _mm256_add_ps(va, vb);
-            _mm256_storeu_ps(out + idx, vout);
-        }
-
-#pragma omp for schedule(static)
-        for (int idx = simd_end; idx < total; ++idx) {
-            out[idx] = a[idx] + b[idx];
-        }
-    }
+    // Per block of 8 floats: two loads and a store; a single hidden row stays on the calling thread
+    parallel_for(0, blocks, WorkCost{96.0, 8.0}, [&](std::size_t chunk_begin, std::size_t chunk_end) {
+        const std::size_t begin = chunk_begin * 8;
+        const std::size_t end = std::min(chunk_end * 8, total);
+        ops.add(a + begin, b + begin, out + begin, end - begin);
+    });
 }
 
@@ -1,16 +1,17 @@
 #include <cpu_ops/elemwise_mul.h>
-#include <immintrin.h>
+#include <cpu_ops/cost_model.h>
+#include <cpu_ops/kernels.h>
+#include <algorithm>
 
 void elemwise_mul_avx2(const float* a, const float* b, float* out, int batch_size, int hidden_size) {
-    int total = batch_size * hidden_size;
-    int i = 0;
-    for (; i + 8 <= total; i += 8) {
-        __m256 va = _mm256_loadu_ps(a + i);
-        __m256 vb = _mm256_loadu_ps(b + i);
-        __m256 vout = _mm256_mul_ps(va, vb);
-        _mm256_storeu_ps(out + i, vout);
-    }
-    for (; i < total; ++i) {
-        out[i] = a[i] * b[i];
-    }
+    const std::size_t total = static_cast<std::size_t>(batch_size) * hidden_size;
+    const std::size_t blocks = (total + 7) / 8;
+    const KernelTable& ops = kernels();
+
+    // Same traffic as elemwise_add: large multi-row products fan out, single rows stay serial
+    parallel_for(0, blocks, WorkCost{96.0, 8.0}, [&](std::size_t chunk_begin, std::size_t chunk_end) {
+        const std::size_t begin = chunk_begin * 8;
+        const std::size_t end = std::min(chunk_end * 8, total);
+        ops.mul(a + begin, b + begin, out + begin, end - begin);
+    });
 }
@@ -0,0 +1,128 @@
+#include <cpu_ops/gemm.h>
+#include <cpu_ops/cost_model.h>
+#include <cpu_ops/kernels.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+int round_up(int value, int multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// rows [row_begin, row_begin + rows) x columns [col_begin, col_begin + depth) of a row-major
+// [*, ld] matrix into panels of `width` rows, each stored k-major: panel[k * width + r]
+void pack_panels(const float *src, std::size_t ld, int row_begin, int rows, int col_begin, int depth, int width, float *dst)
+{
+    for (int p = 0; p < rows; p += width)
+    {
+        const int valid = std::min(width, rows - p);
+        for (int r = 0; r < valid; ++r)
+        {
+            const float *row = src + static_cast<std::size_t>(row_begin + p + r) * ld + col_begin;
+            for (int k = 0; k < depth; ++k)
+                dst[static_cast<std::size_t>(k) * width + r] = row[k];
+        }
+        for (int r = valid; r < width; ++r)
+        {
+            for (int k = 0; k < depth; ++k)
+                dst[static_cast<std::size_t>(k) * width + r] = 0.0f;
+        }
+        dst += static_cast<std::size_t>(depth) * width;
+    }
+}
+
+// One block of rows [m_begin, m_end) x features [n_begin, n_end) on the calling thread
+void gemm_block(const KernelTable &ops, const float *input, const float *weight, int K, int N, int m_begin, int m_end,
+                int n_begin, int n_end, float *output, const GemmBlocking &blocking)
+{
+    if (K <= 0)
+    {
+        for (int i = m_begin; i < m_end; ++i)
+            std::fill(output + static_cast<std::size_t>(i) * N + n_begin, output + static_cast<std::size_t>(i) * N + n_end, 0.0f);
+        return;
+    }
+
+    const int mr = ops.gemm_mr;
+    const int nr = ops.gemm_nr;
+    const int mc = round_up(std::max(1, blocking.mc), mr);
+    const int nc = round_up(std::max(1, blocking.nc), nr);
+    const int kc = std::max(1, blocking.kc);
+
+    // Reused across calls on the same thread; packing is cheap next to the tile work it feeds
+    thread_local std::vector<float> packed_a;
+    thread_local std::vector<float> packed_b;
+    packed_a.resize(static_cast<std::size_t>(mc) * kc);
+    packed_b.resize(static_cast<std::size_t>(nc) * kc);
+
+    for (int jc = n_begin; jc < n_end; jc += nc)
+    {
+        const int nb = std::min(nc, n_end - jc);
+        for (int pc = 0; pc < K; pc += kc)
+        {
+            const int kb = std::min(kc, K - pc);
+            pack_panels(weight, K, jc, nb, pc, kb, nr, packed_b.data());
+
+            for (int ic = m_begin; ic < m_end; ic += mc)
+            {
+                const int mb = std::min(mc, m_end - ic);
+                pack_panels(input, K, ic, mb, pc, kb, mr, packed_a.data());
+
+                for (int jr = 0; jr < nb; jr += nr)
+                {
+                    const float *b_panel = packed_b.data() + static_cast<std::size_t>(jr) * kb;
+                    for (int ir = 0; ir < mb; ir += mr)
+                    {
+                        float *c = output + static_cast<std::size_t>(ic + ir) * N + jc + jr;
+                        ops.gemm_tile(kb, packed_a.data() + static_cast<std::size_t>(ir) * kb, b_panel, c, N,
+                                      std::min(mr, mb - ir), std::min(nr, nb - jr), pc > 0);
+                    }
+                }
+            }
+        }
+    }
+}
+} // namespace
+
+void gemm_nt(const float *input, const float *weight, int M, int K, int N, float *output, const GemmBlocking &blocking)
+{
+    if (M <= 0 || N <= 0)
+    {
+        return;
+    }
+    const KernelTable &ops = kernels();
+    const int mc = round_up(std::max(1, blocking.mc), ops.gemm_mr);
+    const int m_blocks = (M + mc - 1) / mc;
+
+    // Narrower feature blocks when there are too few (row block, feature block) pairs to go around
+    const int threads = ThreadPool::current().num_threads();
+    const int wanted_n_blocks = std::max(1, std::max(1, blocking.chunks_per_thread) * threads / m_blocks);
+    const int nc = std::max(ops.gemm_nr, std::min(round_up(std::max(1, blocking.nc), ops.gemm_nr),
+                                                  round_up((N + wanted_n_blocks - 1) / wanted_n_blocks, ops.gemm_nr)));
+    const int n_blocks = (N + nc - 1) / nc;
+
+    // Consecutive blocks share a feature block, so its weights are reused from cache across row blocks
+    const WorkCost block_cost{4.0 * (mc + nc) * K, 2.0 * mc * nc * K};
+    const std::size_t num_blocks = static_cast<std::size_t>(m_blocks) * n_blocks;
+    parallel_for(0, num_blocks, block_cost, [&](std::size_t chunk_begin, std::size_t chunk_end)
+    {
+        for (std::size_t b = chunk_begin; b < chunk_end; ++b)
+        {
+            const int m0 = static_cast<int>(b % m_blocks) * mc;
+            const int n0 = static_cast<int>(b / m_blocks) * nc;
+            gemm_block(ops, input, weight, K, N, m0, std::min(M, m0 + mc), n0, std::min(N, n0 + nc), output, blocking);
+        }
+    });
+}
+
+void gemm_nt_range(const float *input, const float *weight, int M, int K, int N, int n_begin, int n_end, float *output,
+                   const GemmBlocking &blocking)
+{
+    if (M <= 0 || n_end <= n_begin)
+    {
+        return;
+    }
+    gemm_block(kernels(), input, weight, K, N, 0, M, n_begin, n_end, output, blocking);
+}
@@ -0,0 +1,197 @@
+#include <cpu_ops/gemm_tuning.h>
+#include <cpu_ops/kernels.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// Rows the startup autotune measures at: one full prefill chunk (BatchEngineConfig::max_prefill_chunk)
+constexpr int kTuneRows = 128;
+
+// One tunable field of GemmBlocking and the values tried for it
+struct Axis
+{
+    int GemmBlocking::*field;
+    std::vector<int> values;
+};
+
+const std::vector<Axis> &axes()
+{
+    static const std::vector<Axis> all = {
+        {&GemmBlocking::mc, {48, 96, 144, 192}},
+        {&GemmBlocking::nc, {128, 256, 512, 1024}},
+        {&GemmBlocking::kc, {128, 256, 384, 512}},
+        {&GemmBlocking::chunks_per_thread, {1, 2, 4, 8}}};
+    return all;
+}
+
+bool same_blocking(const GemmBlocking &a, const GemmBlocking &b)
+{
+    return a.mc == b.mc && a.nc == b.nc && a.kc == b.kc && a.chunks_per_thread == b.chunks_per_thread;
+}
+
+double time_gemm(const std::vector<float> &input, const std::vector<float> &weight, int rows, const GemmShape &shape,
+                 const GemmBlocking &blocking, std::vector<float> &output)
+{
+    double best = 1e300;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        const auto start = Clock::now();
+        gemm_nt(input.data(), weight.data(), rows, shape.K, shape.N, output.data(), blocking);
+        best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+GemmTuning default_tuning()
+{
+    const char *path = std::getenv("MINMAX_GEMM_TUNING");
+    GemmTuning tuning({}, kernels_host_key());
+    if (path == nullptr || *path == '\0' || GemmTuning::load(path, tuning))
+    {
+        return tuning;
+    }
+
+    const char *autotune = std::getenv("MINMAX_GEMM_AUTOTUNE");
+    if (autotune == nullptr || std::strcmp(autotune, "1") != 0)
+    {
+        return tuning;
+    }
+    tuning = GemmTuning::tune(GemmTuning::model_shapes(), kTuneRows);
+    try
+    {
+        tuning.save(path);
+    }
+    catch (const std::runtime_error &)
+    {
+        // Unwritable location: the tuning still applies to this process
+    }
+    return tuning;
+}
+} // namespace
+
+GemmTuning::GemmTuning(Entries entries, std::string cpu) : entries_(std::move(entries)), cpu_(std::move(cpu))
+{
+}
+
+const GemmTuning &GemmTuning::instance()
+{
+    static const GemmTuning tuning = default_tuning();
+    return tuning;
+}
+
+std::vector<GemmShape> GemmTuning::model_shapes()
+{
+    return {{2048, 2048}, {2048, 6144}, {6144, 2048}, {2048, 151936}};
+}
+
+GemmTuning GemmTuning::tune(const std::vector<GemmShape> &shapes, int rows)
+{
+    rows = std::max(1, rows);
+    Entries entries;
+    for (const GemmShape &shape : shapes)
+    {
+        std::vector<float> weight(static_cast<std::size_t>(shape.N) * shape.K, 0.5f);
+        std::vector<float> input(static_cast<std::size_t>(rows) * shape.K, 0.25f);
+        std::vector<float> output(static_cast<std::size_t>(rows) * shape.N);
+
+        GemmBlocking best;
+        double best_ns = time_gemm(input, weight, rows, shape, best, output);
+        for (int round = 0; round < 2; ++round)
+        {
+            for (const Axis &axis : axes())
+            {
+                for (int value : axis.values)
+                {
+                    GemmBlocking trial = best;
+                    trial.*axis.field = value;
+                    if (same_blocking(trial, best))
+                        continue;
+                    // A change must win by a margin, so timing noise does not walk the blocking around
+                    const double ns = time_gemm(input, weight, rows, shape, trial, output);
+                    if (ns < best_ns * 0.97)
+                    {
+                        best_ns = ns;
+                        best = trial;
+                    }
+                }
+            }
+        }
+        entries.emplace_back(shape, best);
+    }
+    return GemmTuning(std::move(entries), kernels_host_key());
+}
+
+bool GemmTuning::load(const std::string &path, GemmTuning &out)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+
+    // "cpu <key>" followed by one "gemm <K> <N> <mc> <nc> <kc> <chunks_per_thread>" line per shape
+    std::string cpu;
+    Entries entries;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        std::string tag;
+        fields >> tag;
+        if (tag == "cpu")
+        {
+            std::getline(fields >> std::ws, cpu);
+        }
+        else if (tag == "gemm")
+        {
+            GemmShape shape{};
+            GemmBlocking blocking;
+            if (!(fields >> shape.K >> shape.N >> blocking.mc >> blocking.nc >> blocking.kc >> blocking.chunks_per_thread) ||
+                blocking.mc < 1 || blocking.nc < 1 || blocking.kc < 1 || blocking.chunks_per_thread < 1)
+                return false;
+            entries.emplace_back(shape, blocking);
+        }
+    }
+    if (cpu != kernels_host_key())
+    {
+        return false;
+    }
+
+    out = GemmTuning(std::move(entries), std::move(cpu));
+    return true;
+}
+
+void GemmTuning::save(const std::string &path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("Cannot write GEMM tuning to " + path);
+    }
+    file << "cpu " << cpu_ << "\n";
+    for (const auto &entry : entries_)
+    {
+        const GemmBlocking &b = entry.second;
+        file << "gemm " << entry.first.K << " " << entry.first.N << " " << b.mc << " " << b.nc << " " << b.kc << " "
+             << b.chunks_per_thread << "\n";
+    }
+}
+
+GemmBlocking GemmTuning::blocking(int K, int N) const
+{
+    for (const auto &entry : entries_)
+    {
+        if (entry.first.K == K && entry.first.N == N)
+            return entry.second;
+    }
+    return GemmBlocking();
+}
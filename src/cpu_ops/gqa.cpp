@@ -1,26 +1,82 @@
 #include <cpu_ops/gqa.h>
+#include <cpu_ops/kernels.h>
 #include <cpu_ops/softmax_avx2.h>
+#include <cpu_ops/thread_pool.h>
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <cmath>
-#include <immintrin.h>
-#include <omp.h>
 
-#include <vector>
-#include <cmath>
-#include <immintrin.h>
-#include <omp.h>
+namespace
+{
+// Calls body(dot, axpy) with dot and axpy over one head: the fixed-size kernels when there are
+// any, else the generic ones bound to h. body is instantiated for both, so its loops carry no check
+template <typename Body>
+void with_head_kernels(const KernelTable &ops, const HeadKernels *fixed, int h, Body &&body)
+{
+    if (fixed)
+    {
+        body([fixed](const float *a, const float *b) { return fixed->dot(a, b); },
+             [fixed](float alpha, const float *x, float *y) { fixed->axpy(alpha, x, y); });
+        return;
+    }
+    body([&ops, h](const float *a, const float *b) { return ops.dot(a, b, h); },
+         [&ops, h](float alpha, const float *x, float *y) { ops.axpy(alpha, x, y, h); });
+}
+} // namespace
 
-// Helper function for horizontal sum of AVX2 register
-inline float horizontal_sum_avx(__m256 vec)
+void gqa_forward_heads(
+    const float *query,
+    const float *key,
+    const float *value,
+    float *output,
+    int A,
+    int G,
+    int h,
+    int N,
+    int N_max,
+    float scale,
+    int head_begin,
+    int head_end,
+    const HeadKernels *head_ops)
 {
-    __m128 low = _mm256_castps256_ps128(vec);
-    __m128 high = _mm256_extractf128_ps(vec, 1);
-    low = _mm_add_ps(low, high);
-    __m128 shuf = _mm_movehdup_ps(low);
-    __m128 sums = _mm_add_ps(low, shuf);
-    shuf = _mm_movehl_ps(shuf, sums);
-    sums = _mm_add_ss(sums, shuf);
-    return _mm_cvtss_f32(sums);
+    const int heads_per_group = A / G;
+    const KernelTable &ops = kernels();
+
+    with_head_kernels(ops, head_ops, h, [&](auto dot, auto axpy)
+    {
+        for (int a = head_begin; a < head_end; a++)
+        {
+            const int g = a / heads_per_group; // each KV group serves heads_per_group query heads
+
+            // Get pointers to current head's data
+            const float *curr_query = query + a * h;
+            const float *curr_key_base = key + g * N_max * h;
+            const float *curr_value_base = value + g * N_max * h;
+            float *curr_output = output + a * h;
+
+            // Compute attention scores
+            std::vector<float> attention_scores(N);
+
+            // Phase 1: Compute Q•K^T dot products
+            for (int pos = 0; pos < N; pos++)
+            {
+                attention_scores[pos] = dot(curr_query, curr_key_base + pos * h) * scale;
+            }
+
+            // Phase 2: Apply softmax (using your optimized version)
+            softmax_avx2(attention_scores.data(), N);
+
+            // Phase 3: Compute weighted sum of values
+            std::fill(curr_output, curr_output + h, 0.0f);
+
+            // Accumulate weighted values
+            for (int pos = 0; pos < N; pos++)
+            {
+                axpy(attention_scores[pos], curr_value_base + pos * h, curr_output);
+            }
+        }
+    });
 }
 
 void optimized_gqa_forward(
@@ -33,96 +89,178 @@ void optimized_gqa_forward(
     int h,              // head dimension
     int N,              // actual sequence length (N <= N_max)
     int N_max,          // max sequence length
-    float scale         // scaling factor
-)
+    float scale,        // scaling factor
+    const HeadKernels *head_ops)
 {
-    // Calculate query heads per KV group
-    int heads_per_group = A / G;
-
-    // Precompute KV group mapping for each attention head - FIXED BUG
-    std::vector<int> head_to_group(A);
-    for (int a = 0; a < A; a++)
+    // Parallelize over attention heads when the context is long enough to pay for it
+    parallel_for(0, A, gqa_head_cost(N, h), [&](std::size_t chunk_begin, std::size_t chunk_end)
     {
-        head_to_group[a] = a / heads_per_group; // CORRECT: each KV group serves multiple query heads
-    }
+        gqa_forward_heads(query, key, value, output, A, G, h, N, N_max, scale,
+                          static_cast<int>(chunk_begin), static_cast<int>(chunk_end), head_ops);
+    });
+}
 
-// Parallelize over attention heads
-#pragma omp parallel for schedule(static)
-    for (int a = 0; a < A; a++)
-    {
-        int g = head_to_group[a];
+namespace
+{
+struct RaggedWorkItem
+{
+    int seq;
+    int group;
+    int chunk; // chunk index within the sequence
+    int begin;
+    int end;
+};
+} // namespace
 
-        // Get pointers to current head's data
-        const float *curr_query = query + a * h;
-        const float *curr_key_base = key + g * N_max * h;
-        const float *curr_value_base = value + g * N_max * h;
-        float *curr_output = output + a * h;
+void ragged_gqa_forward(
+    const float *query,
+    const float *const *key,
+    const float *const *value,
+    float *output,
+    const int *seq_lens,
+    const int *kv_strides,
+    int B,
+    int A,
+    int G,
+    int h,
+    float scale,
+    int chunk_size,
+    const HeadKernels *head_ops)
+{
+    const int heads_per_group = A / G;
 
-        // Compute attention scores using AVX2
-        std::vector<float> attention_scores(N);
+    // Reused across calls on the same thread: one call per layer per batched decode step would
+    // otherwise allocate all of these every time
+    thread_local std::vector<int> chunk_base;
+    thread_local std::vector<RaggedWorkItem> items;
+    thread_local std::vector<float> part_max;
+    thread_local std::vector<float> part_sum;
+    thread_local std::vector<float> part_acc;
 
-        // Phase 1: Compute Q•K^T dot products
-        for (int pos = 0; pos < N; pos++)
+    // Partials are indexed by (global chunk, head); chunk_base[b] is the first chunk of sequence b
+    chunk_base.assign(B + 1, 0);
+    items.clear();
+    for (int b = 0; b < B; b++)
+    {
+        const int num_chunks = (seq_lens[b] + chunk_size - 1) / chunk_size;
+        chunk_base[b + 1] = chunk_base[b] + num_chunks;
+        for (int g = 0; g < G; g++)
         {
-            const float *curr_key = curr_key_base + pos * h;
-
-            __m256 dot_sum = _mm256_setzero_ps();
-            int dim = 0;
-
-            // Process 8 elements at a time with AVX2
-            for (; dim <= h - 8; dim += 8)
+            for (int c = 0; c < num_chunks; c++)
             {
-                __m256 q_vec = _mm256_loadu_ps(curr_query + dim);
-                __m256 k_vec = _mm256_loadu_ps(curr_key + dim);
-                __m256 mul = _mm256_mul_ps(q_vec, k_vec);
-                dot_sum = _mm256_add_ps(dot_sum, mul);
+                items.push_back({b, g, c, c * chunk_size, std::min(seq_lens[b], (c + 1) * chunk_size)});
             }
+        }
+    }
 
-            // Horizontal sum of AVX2 register
-            float dot_product = horizontal_sum_avx(dot_sum);
+    const size_t total_chunks = static_cast<size_t>(chunk_base[B]);
+    part_max.resize(total_chunks * A);
+    part_sum.resize(total_chunks * A);
+    part_acc.resize(total_chunks * A * h);
+    const int num_items = static_cast<int>(items.size());
 
-            // Handle remaining elements
-            for (; dim < h; dim++)
+    // Threads from the cost model for the average item: its group's keys and values, QK and PV
+    double kv_positions = 0.0;
+    for (const RaggedWorkItem &item : items)
+    {
+        kv_positions += item.end - item.begin;
+    }
+    const double mean_len = kv_positions / std::max(1, num_items);
+    const ParallelPlan plan = CostModel::instance().plan(items.size(), WorkCost{8.0 * h * mean_len, 4.0 * h * mean_len * heads_per_group});
+
+    // Items differ in length, so every thread claims the next one until none are left
+    std::atomic<int> next_item(0);
+    const KernelTable &ops = kernels();
+    ThreadPool::current().parallel_run([&](int, int)
+    {
+        thread_local std::vector<float> scores;
+        scores.resize(static_cast<size_t>(heads_per_group) * chunk_size);
+
+        with_head_kernels(ops, head_ops, h, [&](auto dot, auto axpy)
+        {
+            for (int i = next_item.fetch_add(1, std::memory_order_relaxed); i < num_items;
+                 i = next_item.fetch_add(1, std::memory_order_relaxed))
             {
-                dot_product += curr_query[dim] * curr_key[dim];
-            }
+                const RaggedWorkItem item = items[i];
+                const int len = item.end - item.begin;
+                const size_t kv_offset = (static_cast<size_t>(item.group) * kv_strides[item.seq] + item.begin) * h;
+                const float *k_base = key[item.seq] + kv_offset;
+                const float *v_base = value[item.seq] + kv_offset;
+                const int first_head = item.group * heads_per_group;
+                const float *q_base = query + (static_cast<size_t>(item.seq) * A + first_head) * h;
 
-            attention_scores[pos] = dot_product * scale;
-        }
+                // Q.K^T: each key row is loaded once for every head of the group
+                for (int pos = 0; pos < len; pos++)
+                {
+                    const float *k = k_base + static_cast<size_t>(pos) * h;
+                    for (int j = 0; j < heads_per_group; j++)
+                    {
+                        const float *q = q_base + static_cast<size_t>(j) * h;
+                        const float dot_product = dot(q, k);
+                        scores[static_cast<size_t>(j) * chunk_size + pos] = dot_product * scale;
+                    }
+                }
 
-        // Phase 2: Apply softmax (using your optimized version)
-        softmax_avx2(attention_scores.data(), N);
+                // Unnormalized softmax of the chunk
+                const size_t part_base = static_cast<size_t>(chunk_base[item.seq] + item.chunk) * A + first_head;
+                for (int j = 0; j < heads_per_group; j++)
+                {
+                    float *s = scores.data() + static_cast<size_t>(j) * chunk_size;
+                    const float max_score = ops.max(s, len);
+                    const float sum = ops.exp_shift_sum(s, max_score, len);
 
-        // Phase 3: Compute weighted sum of values
-        // Initialize output to zero
-        for (int dim = 0; dim < h; dim++)
-        {
-            curr_output[dim] = 0.0f;
-        }
+                    part_max[part_base + j] = max_score;
+                    part_sum[part_base + j] = sum;
+                    std::fill(part_acc.begin() + (part_base + j) * h, part_acc.begin() + (part_base + j + 1) * h, 0.0f);
+                }
 
-        // Accumulate weighted values
-        for (int pos = 0; pos < N; pos++)
+                // P.V: each value row is loaded once for every head of the group
+                for (int pos = 0; pos < len; pos++)
+                {
+                    const float *v = v_base + static_cast<size_t>(pos) * h;
+                    for (int j = 0; j < heads_per_group; j++)
+                    {
+                        axpy(scores[static_cast<size_t>(j) * chunk_size + pos], v, part_acc.data() + (part_base + j) * h);
+                    }
+                }
+            }
+        });
+    }, plan.threads);
+
+    // Merge the chunk partials of every (sequence, head); each reads its sequence's partials
+    const double merge_bytes = 4.0 * h * (static_cast<double>(total_chunks) / std::max(1, B) + 1.0);
+    parallel_for(0, B * A, WorkCost{merge_bytes, merge_bytes / 2}, [&](std::size_t chunk_begin, std::size_t chunk_end)
+    {
+        for (int ba = static_cast<int>(chunk_begin); ba < static_cast<int>(chunk_end); ++ba)
         {
-            const float *curr_value = curr_value_base + pos * h;
-            float weight = attention_scores[pos];
-            __m256 weight_vec = _mm256_set1_ps(weight);
+            const int b = ba / A;
+            const int a = ba % A;
+            float *out = output + static_cast<size_t>(ba) * h;
+            std::fill(out, out + h, 0.0f);
 
-            int dim = 0;
-            // Process 8 elements at a time with AVX2
-            for (; dim <= h - 8; dim += 8)
+            const int first = chunk_base[b];
+            const int last = chunk_base[b + 1];
+            if (first == last)
             {
-                __m256 out_vec = _mm256_loadu_ps(curr_output + dim);
-                __m256 val_vec = _mm256_loadu_ps(curr_value + dim);
-                __m256 weighted = _mm256_mul_ps(weight_vec, val_vec);
-                out_vec = _mm256_add_ps(out_vec, weighted);
-                _mm256_storeu_ps(curr_output + dim, out_vec);
+                continue;
             }
 
-            // Handle remaining elements
-            for (; dim < h; dim++)
+            float global_max = part_max[static_cast<size_t>(first) * A + a];
+            for (int c = first + 1; c < last; c++)
             {
-                curr_output[dim] += weight * curr_value[dim];
+                global_max = std::max(global_max, part_max[static_cast<size_t>(c) * A + a]);
             }
+
+            float total = 0.0f;
+            for (int c = first; c < last; c++)
+            {
+                const size_t idx = static_cast<size_t>(c) * A + a;
+                const float correction = std::exp(part_max[idx] - global_max);
+                total += part_sum[idx] * correction;
+                ops.axpy(correction, part_acc.data() + idx * h, out, h);
+            }
+
+            ops.scale(out, 1.0f / total, h);
         }
-    }
-}
\ No newline at end of file
+    });
+}
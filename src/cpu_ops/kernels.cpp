@@ -0,0 +1,94 @@
+#include <cpu_ops/kernels.h>
+
+// Defined in kernels_<isa>.cpp, each built with its own instruction set flags
+extern const KernelTable scalar_kernels;
+extern const KernelTable avx2_kernels;
+#if defined(MINMAX_HAVE_AVX512)
+extern const KernelTable avx512_kernels;
+#endif
+
+namespace
+{
+bool host_runs(IsaLevel isa)
+{
+    const CpuFeatures &features = cpu_features();
+    switch (isa)
+    {
+    case IsaLevel::Avx2:
+        return features.avx2 && features.fma;
+    case IsaLevel::Avx512:
+        return features.avx512f && features.avx512dq && features.avx2 && features.fma;
+    default:
+        return true;
+    }
+}
+
+const KernelTable &select_kernels()
+{
+    for (int level = static_cast<int>(host_isa()); level > static_cast<int>(IsaLevel::Scalar); --level)
+    {
+        if (const KernelTable *table = kernels_for(static_cast<IsaLevel>(level)))
+        {
+            return *table;
+        }
+    }
+    return scalar_kernels;
+}
+} // namespace
+
+const KernelTable *kernels_for(IsaLevel isa)
+{
+    if (!host_runs(isa))
+    {
+        return nullptr;
+    }
+    switch (isa)
+    {
+    case IsaLevel::Avx2:
+        return &avx2_kernels;
+    case IsaLevel::Avx512:
+#if defined(MINMAX_HAVE_AVX512)
+        return &avx512_kernels;
+#else
+        return nullptr;
+#endif
+    default:
+        return &scalar_kernels;
+    }
+}
+
+const KernelTable &kernels()
+{
+    static const KernelTable &table = select_kernels();
+    return table;
+}
+
+const HeadKernels *head_kernels(int head_dim)
+{
+    const KernelTable &table = kernels();
+    for (int i = 0; i < table.num_head_sizes; ++i)
+    {
+        if (table.heads[i].head_dim == head_dim)
+            return &table.heads[i];
+    }
+    return nullptr;
+}
+
+FixedRmsNorm fixed_rmsnorm(int n)
+{
+    const KernelTable &table = kernels();
+    for (int i = 0; i < table.num_norm_sizes; ++i)
+    {
+        if (table.norms[i].n == n)
+            return table.norms[i].rmsnorm;
+    }
+    if (const HeadKernels *head = head_kernels(n))
+        return head->rmsnorm;
+    return nullptr;
+}
+
+std::string kernels_host_key()
+{
+    const std::string &model = cpu_features().model;
+    return (model.empty() ? std::string("unknown") : model) + " / " + isa_name(kernels().isa);
+}
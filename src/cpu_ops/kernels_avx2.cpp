@@ -0,0 +1,471 @@
+#include <cpu_ops/kernels.h>
+#include <cpu_ops/exp_avx2.h>
+#include <cpu_ops/unroll.h>
+
+#include <immintrin.h>
+#include <math.h>
+
+// Built with -mavx2 -mfma (/arch:AVX2). Only reached through avx2_kernels after the cpuid
+// check, so nothing here may be called directly, and no inline library templates are used:
+// their out-of-line copies could be picked by the linker for baseline callers.
+
+namespace
+{
+inline float hsum(__m256 v)
+{
+    __m128 low = _mm256_castps256_ps128(v);
+    __m128 high = _mm256_extractf128_ps(v, 1);
+    low = _mm_add_ps(low, high);
+    __m128 shuf = _mm_movehdup_ps(low);
+    __m128 sums = _mm_add_ps(low, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+inline float hmax(__m256 v)
+{
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_movehdup_ps(m));
+    return _mm_cvtss_f32(m);
+}
+
+inline int lowest_set_bit(unsigned mask)
+{
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return static_cast<int>(idx);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+float dot(const float *a, const float *b, std::size_t n)
+{
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    float sum = hsum(_mm256_add_ps(acc0, acc1));
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+void dot4(const float *x, const float *w0, const float *w1, const float *w2, const float *w3, std::size_t n, float *out)
+{
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+
+    std::size_t k = 0;
+    for (; k + 8 <= n; k += 8)
+    {
+        const __m256 v = _mm256_loadu_ps(x + k);
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(w0 + k), v, acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(w1 + k), v, acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(w2 + k), v, acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(w3 + k), v, acc3);
+    }
+
+    out[0] = hsum(acc0);
+    out[1] = hsum(acc1);
+    out[2] = hsum(acc2);
+    out[3] = hsum(acc3);
+
+    for (; k < n; ++k)
+    {
+        out[0] += x[k] * w0[k];
+        out[1] += x[k] * w1[k];
+        out[2] += x[k] * w2[k];
+        out[3] += x[k] * w3[k];
+    }
+}
+
+void axpy(float alpha, const float *x, float *y, std::size_t n)
+{
+    const __m256 va = _mm256_set1_ps(alpha);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    }
+    for (; i < n; ++i)
+        y[i] += alpha * x[i];
+}
+
+void scale(float *x, float alpha, std::size_t n)
+{
+    const __m256 va = _mm256_set1_ps(alpha);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), va));
+    }
+    for (; i < n; ++i)
+        x[i] *= alpha;
+}
+
+float max(const float *x, std::size_t n)
+{
+    float best = x[0];
+    std::size_t i = 0;
+    if (n >= 8)
+    {
+        __m256 vmax = _mm256_loadu_ps(x);
+        for (i = 8; i + 8 <= n; i += 8)
+        {
+            vmax = _mm256_max_ps(vmax, _mm256_loadu_ps(x + i));
+        }
+        best = hmax(vmax);
+    }
+    for (; i < n; ++i)
+        best = x[i] > best ? x[i] : best;
+    return best;
+}
+
+float exp_shift_sum(float *x, float shift, std::size_t n)
+{
+    const __m256 vshift = _mm256_set1_ps(shift);
+    __m256 vsum = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256 e = exp256_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), vshift));
+        _mm256_storeu_ps(x + i, e);
+        vsum = _mm256_add_ps(vsum, e);
+    }
+    float sum = hsum(vsum);
+    for (; i < n; ++i)
+    {
+        x[i] = expf(x[i] - shift);
+        sum += x[i];
+    }
+    return sum;
+}
+
+void add(const float *a, const float *b, float *out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    for (; i < n; ++i)
+        out[i] = a[i] + b[i];
+}
+
+void mul(const float *a, const float *b, float *out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    for (; i < n; ++i)
+        out[i] = a[i] * b[i];
+}
+
+void silu(const float *x, float *out, std::size_t n)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256 vx = _mm256_loadu_ps(x + i);
+        const __m256 vexp = exp256_ps(_mm256_sub_ps(_mm256_setzero_ps(), vx));
+        _mm256_storeu_ps(out + i, _mm256_div_ps(vx, _mm256_add_ps(one, vexp)));
+    }
+    for (; i < n; ++i)
+        out[i] = x[i] / (1.0f + expf(-x[i]));
+}
+
+void rmsnorm_row(const float *x, const float *weight, float *out, std::size_t n, float eps)
+{
+    const float mean_sq = dot(x, x, n) / static_cast<float>(n);
+    const float denom = 1.0f / sqrtf(mean_sq + eps);
+    const __m256 vdenom = _mm256_set1_ps(denom);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256 norm = _mm256_mul_ps(_mm256_loadu_ps(x + i), vdenom);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(weight + i), norm));
+    }
+    for (; i < n; ++i)
+        out[i] = weight[i] * (x[i] * denom);
+}
+
+void rotate_half(float *x, const float *sin, const float *cos, std::size_t half)
+{
+    float *x2 = x + half;
+    std::size_t i = 0;
+    for (; i + 8 <= half; i += 8)
+    {
+        const __m256 a = _mm256_loadu_ps(x + i);
+        const __m256 b = _mm256_loadu_ps(x2 + i);
+        const __m256 s = _mm256_loadu_ps(sin + i);
+        const __m256 c = _mm256_loadu_ps(cos + i);
+        _mm256_storeu_ps(x + i, _mm256_fmsub_ps(a, c, _mm256_mul_ps(b, s)));
+        _mm256_storeu_ps(x2 + i, _mm256_fmadd_ps(a, s, _mm256_mul_ps(b, c)));
+    }
+    for (; i < half; ++i)
+    {
+        const float a = x[i];
+        const float b = x2[i];
+        x[i] = a * cos[i] - b * sin[i];
+        x2[i] = a * sin[i] + b * cos[i];
+    }
+}
+
+int argmax(const float *x, int n)
+{
+    if (n <= 0)
+        return -1;
+
+    int best_idx = 0;
+    float best = x[0];
+    int i = 0;
+    if (n >= 8)
+    {
+        __m256 vmax = _mm256_loadu_ps(x);
+        __m256i vidx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i vcur = vidx;
+        const __m256i step = _mm256_set1_epi32(8);
+        for (i = 8; i + 8 <= n; i += 8)
+        {
+            vcur = _mm256_add_epi32(vcur, step);
+            const __m256 v = _mm256_loadu_ps(x + i);
+            const __m256 gt = _mm256_cmp_ps(v, vmax, _CMP_GT_OQ);
+            vmax = _mm256_blendv_ps(vmax, v, gt);
+            vidx = _mm256_blendv_epi8(vidx, vcur, _mm256_castps_si256(gt));
+        }
+
+        alignas(32) float max_arr[8];
+        alignas(32) int idx_arr[8];
+        _mm256_store_ps(max_arr, vmax);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(idx_arr), vidx);
+        best = max_arr[0];
+        best_idx = idx_arr[0];
+        for (int lane = 1; lane < 8; ++lane)
+        {
+            if (max_arr[lane] > best || (max_arr[lane] == best && idx_arr[lane] < best_idx))
+            {
+                best = max_arr[lane];
+                best_idx = idx_arr[lane];
+            }
+        }
+    }
+    for (; i < n; ++i)
+    {
+        if (x[i] > best)
+        {
+            best = x[i];
+            best_idx = i;
+        }
+    }
+    return best_idx;
+}
+
+int find_at_least(const float *x, int begin, int n, float threshold)
+{
+    const __m256 vt = _mm256_set1_ps(threshold);
+    int i = begin;
+    for (; i + 8 <= n; i += 8)
+    {
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(x + i), vt, _CMP_GE_OQ)));
+        if (mask)
+            return i + lowest_set_bit(mask);
+    }
+    for (; i < n; ++i)
+    {
+        if (x[i] >= threshold)
+            return i;
+    }
+    return n;
+}
+
+// Stores one 16-wide row of a tile, the first n columns only
+inline void store_row(float *row, __m256 lo, __m256 hi, int n, bool accumulate)
+{
+    if (n == 16)
+    {
+        if (accumulate)
+        {
+            lo = _mm256_add_ps(lo, _mm256_loadu_ps(row));
+            hi = _mm256_add_ps(hi, _mm256_loadu_ps(row + 8));
+        }
+        _mm256_storeu_ps(row, lo);
+        _mm256_storeu_ps(row + 8, hi);
+        return;
+    }
+    const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i mask_lo = _mm256_cmpgt_epi32(_mm256_set1_epi32(n), lane);
+    const __m256i mask_hi = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - 8), lane);
+    if (accumulate)
+    {
+        lo = _mm256_add_ps(lo, _mm256_maskload_ps(row, mask_lo));
+        hi = _mm256_add_ps(hi, _mm256_maskload_ps(row + 8, mask_hi));
+    }
+    _mm256_maskstore_ps(row, mask_lo, lo);
+    _mm256_maskstore_ps(row + 8, mask_hi, hi);
+}
+
+// 6 x 16 tile: 12 accumulators, two B vectors and one broadcast out of 16 ymm registers
+void gemm_tile(std::size_t kc, const float *a, const float *b, float *c, std::size_t ldc, int m, int n, bool accumulate)
+{
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+    for (std::size_t k = 0; k < kc; ++k)
+    {
+        const __m256 b0 = _mm256_loadu_ps(b);
+        const __m256 b1 = _mm256_loadu_ps(b + 8);
+        __m256 ai = _mm256_broadcast_ss(a);
+        c00 = _mm256_fmadd_ps(ai, b0, c00);
+        c01 = _mm256_fmadd_ps(ai, b1, c01);
+        ai = _mm256_broadcast_ss(a + 1);
+        c10 = _mm256_fmadd_ps(ai, b0, c10);
+        c11 = _mm256_fmadd_ps(ai, b1, c11);
+        ai = _mm256_broadcast_ss(a + 2);
+        c20 = _mm256_fmadd_ps(ai, b0, c20);
+        c21 = _mm256_fmadd_ps(ai, b1, c21);
+        ai = _mm256_broadcast_ss(a + 3);
+        c30 = _mm256_fmadd_ps(ai, b0, c30);
+        c31 = _mm256_fmadd_ps(ai, b1, c31);
+        ai = _mm256_broadcast_ss(a + 4);
+        c40 = _mm256_fmadd_ps(ai, b0, c40);
+        c41 = _mm256_fmadd_ps(ai, b1, c41);
+        ai = _mm256_broadcast_ss(a + 5);
+        c50 = _mm256_fmadd_ps(ai, b0, c50);
+        c51 = _mm256_fmadd_ps(ai, b1, c51);
+        a += 6;
+        b += 16;
+    }
+
+    const __m256 rows[6][2] = {{c00, c01}, {c10, c11}, {c20, c21}, {c30, c31}, {c40, c41}, {c50, c51}};
+    for (int i = 0; i < m; ++i)
+    {
+        store_row(c + i * ldc, rows[i][0], rows[i][1], n, accumulate);
+    }
+}
+
+float sum(const float *x, std::size_t n)
+{
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(x + i));
+        acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(x + i + 8));
+        acc2 = _mm256_add_ps(acc2, _mm256_loadu_ps(x + i + 16));
+        acc3 = _mm256_add_ps(acc3, _mm256_loadu_ps(x + i + 24));
+    }
+    float total = hsum(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+    for (; i < n; ++i)
+        total += x[i];
+    return total;
+}
+
+float fma_chains(int iterations)
+{
+    __m256 acc[8];
+    for (int j = 0; j < 8; ++j)
+        acc[j] = _mm256_set1_ps(static_cast<float>(j));
+    const __m256 a = _mm256_set1_ps(0.999f);
+    const __m256 b = _mm256_set1_ps(0.001f);
+    for (int i = 0; i < iterations; ++i)
+    {
+        for (int j = 0; j < 8; ++j)
+            acc[j] = _mm256_fmadd_ps(acc[j], a, b);
+    }
+    return hsum(_mm256_add_ps(_mm256_add_ps(acc[0], acc[1]), _mm256_add_ps(acc[6], acc[7])));
+}
+
+// Fixed-size kernels: N is a template argument, so there are no tails and no size checks
+template <int N>
+float dot_n(const float *a, const float *b)
+{
+    __m256 acc[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+    auto body = [&](int v, int slot)
+    {
+        acc[slot] = _mm256_fmadd_ps(_mm256_loadu_ps(a + 8 * v), _mm256_loadu_ps(b + 8 * v), acc[slot]);
+    };
+    for_each_vector<N, 8>(body);
+    return hsum(_mm256_add_ps(_mm256_add_ps(acc[0], acc[1]), _mm256_add_ps(acc[2], acc[3])));
+}
+
+template <int N>
+void axpy_n(float alpha, const float *x, float *y)
+{
+    const __m256 va = _mm256_set1_ps(alpha);
+    auto body = [&](int v, int)
+    {
+        _mm256_storeu_ps(y + 8 * v, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + 8 * v), _mm256_loadu_ps(y + 8 * v)));
+    };
+    for_each_vector<N, 8>(body);
+}
+
+template <int N>
+void rmsnorm_n(const float *x, const float *weight, float *out, float eps)
+{
+    // sqrtss directly: libm's sqrtf keeps a branch to its errno path
+    const float mean_sq = dot_n<N>(x, x) / static_cast<float>(N);
+    const __m256 vdenom = _mm256_set1_ps(1.0f / _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(mean_sq + eps))));
+    auto body = [&](int v, int)
+    {
+        const __m256 norm = _mm256_mul_ps(_mm256_loadu_ps(x + 8 * v), vdenom);
+        _mm256_storeu_ps(out + 8 * v, _mm256_mul_ps(_mm256_loadu_ps(weight + 8 * v), norm));
+    };
+    for_each_vector<N, 8>(body);
+}
+
+template <int HeadDim>
+void rotate_half_n(float *x, const float *sin, const float *cos)
+{
+    float *x2 = x + HeadDim / 2;
+    auto body = [&](int v, int)
+    {
+        const __m256 a = _mm256_loadu_ps(x + 8 * v);
+        const __m256 b = _mm256_loadu_ps(x2 + 8 * v);
+        const __m256 s = _mm256_loadu_ps(sin + 8 * v);
+        const __m256 c = _mm256_loadu_ps(cos + 8 * v);
+        _mm256_storeu_ps(x + 8 * v, _mm256_fmsub_ps(a, c, _mm256_mul_ps(b, s)));
+        _mm256_storeu_ps(x2 + 8 * v, _mm256_fmadd_ps(a, s, _mm256_mul_ps(b, c)));
+    };
+    for_each_vector<HeadDim / 2, 8>(body);
+}
+
+const HeadKernels heads[] = {
+    {128, rmsnorm_n<128>, rotate_half_n<128>, dot_n<128>, axpy_n<128>}};
+
+const FixedNorm norms[] = {
+    {1024, rmsnorm_n<1024>}, {2048, rmsnorm_n<2048>}, {2560, rmsnorm_n<2560>}, {4096, rmsnorm_n<4096>}, {5120, rmsnorm_n<5120>}};
+} // namespace
+
+extern const KernelTable avx2_kernels = {
+    IsaLevel::Avx2, 8,
+    dot, dot4, axpy, scale, max, exp_shift_sum,
+    add, mul, silu, rmsnorm_row, rotate_half,
+    argmax, find_at_least,
+    6, 16, gemm_tile,
+    sum, fma_chains,
+    heads, sizeof(heads) / sizeof(heads[0]),
+    norms, sizeof(norms) / sizeof(norms[0])};
@@ -0,0 +1,513 @@
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ < 13
+// Before GCC 13, avx512fintrin.h seeds masked builtins with a self-initialised _mm512_undefined_ps(),
+// so even plain intrinsics such as _mm512_max_ps warn at every inlining site. This goes before the
+// includes because the warnings are reported against the header's lines.
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include <cpu_ops/kernels.h>
+#include <cpu_ops/unroll.h>
+
+#include <immintrin.h>
+#include <math.h>
+
+// Built with AVX-512 F/DQ flags (-mavx512f -mavx512dq, /arch:AVX512) and only reached through
+// avx512_kernels after the cpuid check; the same rules as kernels_avx2.cpp apply. Tails use
+// masked loads and stores instead of scalar loops.
+
+namespace
+{
+inline __mmask16 tail_mask(std::size_t remaining)
+{
+    return static_cast<__mmask16>((1u << remaining) - 1);
+}
+
+// exp256_ps (exp_avx2.h) on 16 lanes: 2^m * exp(r) with x = m ln2 + r and a 4th order Taylor exp(r)
+inline __m512 exp512_ps(__m512 x)
+{
+    x = _mm512_min_ps(x, _mm512_set1_ps(88.3762626647949f));
+    x = _mm512_max_ps(x, _mm512_set1_ps(-88.3762626647949f));
+
+    const __m512 ln2 = _mm512_set1_ps(0.69314718055994530941723212145818f);
+    const __m512 inv_ln2 = _mm512_set1_ps(1.44269504088896340736f);
+    const __m512 m = _mm512_roundscale_ps(_mm512_fmadd_ps(x, inv_ln2, _mm512_set1_ps(0.5f)),
+                                          _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
+    const __m512 r = _mm512_fnmadd_ps(m, ln2, x);
+
+    const __m512 c1 = _mm512_set1_ps(1.0f);
+    const __m512 r2 = _mm512_mul_ps(r, r);
+    const __m512 r3 = _mm512_mul_ps(r2, r);
+    const __m512 r4 = _mm512_mul_ps(r3, r);
+    __m512 result = _mm512_fmadd_ps(r, c1, c1);
+    result = _mm512_fmadd_ps(r2, _mm512_set1_ps(0.5f), result);
+    result = _mm512_fmadd_ps(r3, _mm512_set1_ps(0.166666666666666f), result);
+    result = _mm512_fmadd_ps(r4, _mm512_set1_ps(0.041666666666666f), result);
+
+    __m512i exponent = _mm512_cvtps_epi32(m);
+    exponent = _mm512_add_epi32(exponent, _mm512_set1_epi32(127));
+    exponent = _mm512_slli_epi32(exponent, 23);
+    return _mm512_mul_ps(result, _mm512_castsi512_ps(exponent));
+}
+
+// Horizontal sum and max, halved down to one AVX lane. Written out instead of _mm512_reduce_*_ps,
+// which GCC implements with intrinsics that set off -Wmaybe-uninitialized at every call site.
+inline float hsum(__m512 v)
+{
+    __m256 half = _mm256_add_ps(_mm512_castps512_ps256(v), _mm512_extractf32x8_ps(v, 1));
+    __m128 low = _mm_add_ps(_mm256_castps256_ps128(half), _mm256_extractf128_ps(half, 1));
+    __m128 shuf = _mm_movehdup_ps(low);
+    __m128 sums = _mm_add_ps(low, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+    return _mm_cvtss_f32(sums);
+}
+
+inline float hmax(__m512 v)
+{
+    __m256 half = _mm256_max_ps(_mm512_castps512_ps256(v), _mm512_extractf32x8_ps(v, 1));
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(half), _mm256_extractf128_ps(half, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_movehdup_ps(m));
+    return _mm_cvtss_f32(m);
+}
+
+inline int lowest_set_bit(unsigned mask)
+{
+#if defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return static_cast<int>(idx);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+float dot(const float *a, const float *b, std::size_t n)
+{
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), acc1);
+    }
+    for (; i + 16 <= n; i += 16)
+    {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), acc0);
+    }
+    if (i < n)
+    {
+        const __mmask16 m = tail_mask(n - i);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i), acc1);
+    }
+    return hsum(_mm512_add_ps(acc0, acc1));
+}
+
+void dot4(const float *x, const float *w0, const float *w1, const float *w2, const float *w3, std::size_t n, float *out)
+{
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    __m512 acc2 = _mm512_setzero_ps();
+    __m512 acc3 = _mm512_setzero_ps();
+
+    std::size_t k = 0;
+    for (; k + 16 <= n; k += 16)
+    {
+        const __m512 v = _mm512_loadu_ps(x + k);
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(w0 + k), v, acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(w1 + k), v, acc1);
+        acc2 = _mm512_fmadd_ps(_mm512_loadu_ps(w2 + k), v, acc2);
+        acc3 = _mm512_fmadd_ps(_mm512_loadu_ps(w3 + k), v, acc3);
+    }
+    if (k < n)
+    {
+        const __mmask16 m = tail_mask(n - k);
+        const __m512 v = _mm512_maskz_loadu_ps(m, x + k);
+        acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, w0 + k), v, acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, w1 + k), v, acc1);
+        acc2 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, w2 + k), v, acc2);
+        acc3 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, w3 + k), v, acc3);
+    }
+
+    out[0] = hsum(acc0);
+    out[1] = hsum(acc1);
+    out[2] = hsum(acc2);
+    out[3] = hsum(acc3);
+}
+
+void axpy(float alpha, const float *x, float *y, std::size_t n)
+{
+    const __m512 va = _mm512_set1_ps(alpha);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+    }
+    if (i < n)
+    {
+        const __mmask16 m = tail_mask(n - i);
+        _mm512_mask_storeu_ps(y + i, m, _mm512_fmadd_ps(va, _mm512_maskz_loadu_ps(m, x + i), _mm512_maskz_loadu_ps(m, y + i)));
+    }
+}
+
+void scale(float *x, float alpha, std::size_t n)
+{
+    const __m512 va = _mm512_set1_ps(alpha);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm512_storeu_ps(x + i, _mm512_mul_ps(_mm512_loadu_ps(x + i), va));
+    }
+    if (i < n)
+    {
+        const __mmask16 m = tail_mask(n - i);
+        _mm512_mask_storeu_ps(x + i, m, _mm512_mul_ps(_mm512_maskz_loadu_ps(m, x + i), va));
+    }
+}
+
+float max(const float *x, std::size_t n)
+{
+    __m512 vmax = _mm512_set1_ps(x[0]);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        vmax = _mm512_max_ps(vmax, _mm512_loadu_ps(x + i));
+    }
+    if (i < n)
+    {
+        // Masked-off lanes keep the running maximum
+        vmax = _mm512_mask_max_ps(vmax, tail_mask(n - i), vmax, _mm512_maskz_loadu_ps(tail_mask(n - i), x + i));
+    }
+    return hmax(vmax);
+}
+
+float exp_shift_sum(float *x, float shift, std::size_t n)
+{
+    const __m512 vshift = _mm512_set1_ps(shift);
+    __m512 vsum = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m512 e = exp512_ps(_mm512_sub_ps(_mm512_loadu_ps(x + i), vshift));
+        _mm512_storeu_ps(x + i, e);
+        vsum = _mm512_add_ps(vsum, e);
+    }
+    if (i < n)
+    {
+        const __mmask16 m = tail_mask(n - i);
+        const __m512 e = exp512_ps(_mm512_sub_ps(_mm512_maskz_loadu_ps(m, x + i), vshift));
+        _mm512_mask_storeu_ps(x + i, m, e);
+        vsum = _mm512_mask_add_ps(vsum, m, vsum, e);
+    }
+    return hsum(vsum);
+}
+
+void add(const float *a, const float *b, float *out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm512_storeu_ps(out + i, _mm512_add_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+    }
+    if (i < n)
+    {
+        const __mmask16 m = tail_mask(n - i);
+        _mm512_mask_storeu_ps(out + i, m, _mm512_add_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i)));
+    }
+}
+
+void mul(const float *a, const float *b, float *out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i)));
+    }
+    if (i < n)
+    {
+        const __mmask16 m = tail_mask(n - i);
+        _mm512_mask_storeu_ps(out + i, m, _mm512_mul_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i)));
+    }
+}
+
+inline __m512 silu16(__m512 vx)
+{
+    const __m512 vexp = exp512_ps(_mm512_sub_ps(_mm512_setzero_ps(), vx));
+    return _mm512_div_ps(vx, _mm512_add_ps(_mm512_set1_ps(1.0f), vexp));
+}
+
+void silu(const float *x, float *out, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        _mm512_storeu_ps(out + i, silu16(_mm512_loadu_ps(x + i)));
+    }
+    if (i < n)
+    {
+        const __mmask16 m = tail_mask(n - i);
+        _mm512_mask_storeu_ps(out + i, m, silu16(_mm512_maskz_loadu_ps(m, x + i)));
+    }
+}
+
+void rmsnorm_row(const float *x, const float *weight, float *out, std::size_t n, float eps)
+{
+    const float mean_sq = dot(x, x, n) / static_cast<float>(n);
+    const __m512 vdenom = _mm512_set1_ps(1.0f / sqrtf(mean_sq + eps));
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m512 norm = _mm512_mul_ps(_mm512_loadu_ps(x + i), vdenom);
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_loadu_ps(weight + i), norm));
+    }
+    if (i < n)
+    {
+        const __mmask16 m = tail_mask(n - i);
+        const __m512 norm = _mm512_mul_ps(_mm512_maskz_loadu_ps(m, x + i), vdenom);
+        _mm512_mask_storeu_ps(out + i, m, _mm512_mul_ps(_mm512_maskz_loadu_ps(m, weight + i), norm));
+    }
+}
+
+void rotate_half(float *x, const float *sin, const float *cos, std::size_t half)
+{
+    float *x2 = x + half;
+    for (std::size_t i = 0; i < half; i += 16)
+    {
+        const __mmask16 m = half - i >= 16 ? static_cast<__mmask16>(0xffff) : tail_mask(half - i);
+        const __m512 a = _mm512_maskz_loadu_ps(m, x + i);
+        const __m512 b = _mm512_maskz_loadu_ps(m, x2 + i);
+        const __m512 s = _mm512_maskz_loadu_ps(m, sin + i);
+        const __m512 c = _mm512_maskz_loadu_ps(m, cos + i);
+        _mm512_mask_storeu_ps(x + i, m, _mm512_fmsub_ps(a, c, _mm512_mul_ps(b, s)));
+        _mm512_mask_storeu_ps(x2 + i, m, _mm512_fmadd_ps(a, s, _mm512_mul_ps(b, c)));
+    }
+}
+
+int argmax(const float *x, int n)
+{
+    if (n <= 0)
+        return -1;
+
+    int best_idx = 0;
+    float best = x[0];
+    int i = 0;
+    if (n >= 16)
+    {
+        __m512 vmax = _mm512_loadu_ps(x);
+        __m512i vidx = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        __m512i vcur = vidx;
+        const __m512i step = _mm512_set1_epi32(16);
+        for (i = 16; i + 16 <= n; i += 16)
+        {
+            vcur = _mm512_add_epi32(vcur, step);
+            const __m512 v = _mm512_loadu_ps(x + i);
+            const __mmask16 gt = _mm512_cmp_ps_mask(v, vmax, _CMP_GT_OQ);
+            vmax = _mm512_mask_blend_ps(gt, vmax, v);
+            vidx = _mm512_mask_blend_epi32(gt, vidx, vcur);
+        }
+
+        best = hmax(vmax);
+        // Lowest index among the lanes holding the maximum
+        const __mmask16 at_best = _mm512_cmp_ps_mask(vmax, _mm512_set1_ps(best), _CMP_EQ_OQ);
+        best_idx = _mm512_mask_reduce_min_epi32(at_best, vidx);
+    }
+    for (; i < n; ++i)
+    {
+        if (x[i] > best)
+        {
+            best = x[i];
+            best_idx = i;
+        }
+    }
+    return best_idx;
+}
+
+int find_at_least(const float *x, int begin, int n, float threshold)
+{
+    const __m512 vt = _mm512_set1_ps(threshold);
+    for (int i = begin; i < n; i += 16)
+    {
+        const int remaining = n - i;
+        const __mmask16 m = remaining >= 16 ? static_cast<__mmask16>(0xffff) : tail_mask(static_cast<std::size_t>(remaining));
+        const __mmask16 hits = _mm512_mask_cmp_ps_mask(m, _mm512_maskz_loadu_ps(m, x + i), vt, _CMP_GE_OQ);
+        if (hits)
+            return i + lowest_set_bit(hits);
+    }
+    return n;
+}
+
+// Stores one 32-wide row of a tile, the first n columns only
+inline void store_row(float *row, __m512 lo, __m512 hi, int n, bool accumulate)
+{
+    const __mmask16 mask_lo = n >= 16 ? static_cast<__mmask16>(0xffff) : tail_mask(static_cast<std::size_t>(n));
+    const __mmask16 mask_hi = n >= 32 ? static_cast<__mmask16>(0xffff) : n <= 16 ? static_cast<__mmask16>(0) : tail_mask(static_cast<std::size_t>(n - 16));
+    if (accumulate)
+    {
+        lo = _mm512_add_ps(lo, _mm512_maskz_loadu_ps(mask_lo, row));
+        hi = _mm512_add_ps(hi, _mm512_maskz_loadu_ps(mask_hi, row + 16));
+    }
+    _mm512_mask_storeu_ps(row, mask_lo, lo);
+    _mm512_mask_storeu_ps(row + 16, mask_hi, hi);
+}
+
+// 8 x 32 tile: 16 accumulators, two B vectors and one broadcast out of 32 zmm registers
+void gemm_tile(std::size_t kc, const float *a, const float *b, float *c, std::size_t ldc, int m, int n, bool accumulate)
+{
+    __m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps();
+    __m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+    __m512 c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+    __m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps();
+    __m512 c40 = _mm512_setzero_ps(), c41 = _mm512_setzero_ps();
+    __m512 c50 = _mm512_setzero_ps(), c51 = _mm512_setzero_ps();
+    __m512 c60 = _mm512_setzero_ps(), c61 = _mm512_setzero_ps();
+    __m512 c70 = _mm512_setzero_ps(), c71 = _mm512_setzero_ps();
+
+    for (std::size_t k = 0; k < kc; ++k)
+    {
+        const __m512 b0 = _mm512_loadu_ps(b);
+        const __m512 b1 = _mm512_loadu_ps(b + 16);
+        __m512 ai = _mm512_set1_ps(a[0]);
+        c00 = _mm512_fmadd_ps(ai, b0, c00);
+        c01 = _mm512_fmadd_ps(ai, b1, c01);
+        ai = _mm512_set1_ps(a[1]);
+        c10 = _mm512_fmadd_ps(ai, b0, c10);
+        c11 = _mm512_fmadd_ps(ai, b1, c11);
+        ai = _mm512_set1_ps(a[2]);
+        c20 = _mm512_fmadd_ps(ai, b0, c20);
+        c21 = _mm512_fmadd_ps(ai, b1, c21);
+        ai = _mm512_set1_ps(a[3]);
+        c30 = _mm512_fmadd_ps(ai, b0, c30);
+        c31 = _mm512_fmadd_ps(ai, b1, c31);
+        ai = _mm512_set1_ps(a[4]);
+        c40 = _mm512_fmadd_ps(ai, b0, c40);
+        c41 = _mm512_fmadd_ps(ai, b1, c41);
+        ai = _mm512_set1_ps(a[5]);
+        c50 = _mm512_fmadd_ps(ai, b0, c50);
+        c51 = _mm512_fmadd_ps(ai, b1, c51);
+        ai = _mm512_set1_ps(a[6]);
+        c60 = _mm512_fmadd_ps(ai, b0, c60);
+        c61 = _mm512_fmadd_ps(ai, b1, c61);
+        ai = _mm512_set1_ps(a[7]);
+        c70 = _mm512_fmadd_ps(ai, b0, c70);
+        c71 = _mm512_fmadd_ps(ai, b1, c71);
+        a += 8;
+        b += 32;
+    }
+
+    const __m512 rows[8][2] = {{c00, c01}, {c10, c11}, {c20, c21}, {c30, c31},
+                               {c40, c41}, {c50, c51}, {c60, c61}, {c70, c71}};
+    for (int i = 0; i < m; ++i)
+    {
+        store_row(c + i * ldc, rows[i][0], rows[i][1], n, accumulate);
+    }
+}
+
+float sum(const float *x, std::size_t n)
+{
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    __m512 acc2 = _mm512_setzero_ps();
+    __m512 acc3 = _mm512_setzero_ps();
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64)
+    {
+        acc0 = _mm512_add_ps(acc0, _mm512_loadu_ps(x + i));
+        acc1 = _mm512_add_ps(acc1, _mm512_loadu_ps(x + i + 16));
+        acc2 = _mm512_add_ps(acc2, _mm512_loadu_ps(x + i + 32));
+        acc3 = _mm512_add_ps(acc3, _mm512_loadu_ps(x + i + 48));
+    }
+    for (; i < n; i += 16)
+    {
+        const __mmask16 m = n - i >= 16 ? static_cast<__mmask16>(0xffff) : tail_mask(n - i);
+        acc0 = _mm512_add_ps(acc0, _mm512_maskz_loadu_ps(m, x + i));
+    }
+    return hsum(_mm512_add_ps(_mm512_add_ps(acc0, acc1), _mm512_add_ps(acc2, acc3)));
+}
+
+float fma_chains(int iterations)
+{
+    __m512 acc[8];
+    for (int j = 0; j < 8; ++j)
+        acc[j] = _mm512_set1_ps(static_cast<float>(j));
+    const __m512 a = _mm512_set1_ps(0.999f);
+    const __m512 b = _mm512_set1_ps(0.001f);
+    for (int i = 0; i < iterations; ++i)
+    {
+        for (int j = 0; j < 8; ++j)
+            acc[j] = _mm512_fmadd_ps(acc[j], a, b);
+    }
+    return hsum(_mm512_add_ps(_mm512_add_ps(acc[0], acc[1]), _mm512_add_ps(acc[6], acc[7])));
+}
+
+// Fixed-size kernels: N is a template argument, so there are no tails and no size checks
+template <int N>
+float dot_n(const float *a, const float *b)
+{
+    __m512 acc[4] = {_mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps()};
+    auto body = [&](int v, int slot)
+    {
+        acc[slot] = _mm512_fmadd_ps(_mm512_loadu_ps(a + 16 * v), _mm512_loadu_ps(b + 16 * v), acc[slot]);
+    };
+    for_each_vector<N, 16>(body);
+    return hsum(_mm512_add_ps(_mm512_add_ps(acc[0], acc[1]), _mm512_add_ps(acc[2], acc[3])));
+}
+
+template <int N>
+void axpy_n(float alpha, const float *x, float *y)
+{
+    const __m512 va = _mm512_set1_ps(alpha);
+    auto body = [&](int v, int)
+    {
+        _mm512_storeu_ps(y + 16 * v, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + 16 * v), _mm512_loadu_ps(y + 16 * v)));
+    };
+    for_each_vector<N, 16>(body);
+}
+
+template <int N>
+void rmsnorm_n(const float *x, const float *weight, float *out, float eps)
+{
+    // sqrtss directly: libm's sqrtf keeps a branch to its errno path
+    const float mean_sq = dot_n<N>(x, x) / static_cast<float>(N);
+    const __m512 vdenom = _mm512_set1_ps(1.0f / _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(mean_sq + eps))));
+    auto body = [&](int v, int)
+    {
+        const __m512 norm = _mm512_mul_ps(_mm512_loadu_ps(x + 16 * v), vdenom);
+        _mm512_storeu_ps(out + 16 * v, _mm512_mul_ps(_mm512_loadu_ps(weight + 16 * v), norm));
+    };
+    for_each_vector<N, 16>(body);
+}
+
+template <int HeadDim>
+void rotate_half_n(float *x, const float *sin, const float *cos)
+{
+    float *x2 = x + HeadDim / 2;
+    auto body = [&](int v, int)
+    {
+        const __m512 a = _mm512_loadu_ps(x + 16 * v);
+        const __m512 b = _mm512_loadu_ps(x2 + 16 * v);
+        const __m512 s = _mm512_loadu_ps(sin + 16 * v);
+        const __m512 c = _mm512_loadu_ps(cos + 16 * v);
+        _mm512_storeu_ps(x + 16 * v, _mm512_fmsub_ps(a, c, _mm512_mul_ps(b, s)));
+        _mm512_storeu_ps(x2 + 16 * v, _mm512_fmadd_ps(a, s, _mm512_mul_ps(b, c)));
+    };
+    for_each_vector<HeadDim / 2, 16>(body);
+}
+
+const HeadKernels heads[] = {
+    {128, rmsnorm_n<128>, rotate_half_n<128>, dot_n<128>, axpy_n<128>}};
+
+const FixedNorm norms[] = {
+    {1024, rmsnorm_n<1024>}, {2048, rmsnorm_n<2048>}, {2560, rmsnorm_n<2560>}, {4096, rmsnorm_n<4096>}, {5120, rmsnorm_n<5120>}};
+} // namespace
+
+extern const KernelTable avx512_kernels = {
+    IsaLevel::Avx512, 16,
+    dot, dot4, axpy, scale, max, exp_shift_sum,
+    add, mul, silu, rmsnorm_row, rotate_half,
+    argmax, find_at_least,
+    8, 32, gemm_tile,
+    sum, fma_chains,
+    heads, sizeof(heads) / sizeof(heads[0]),
+    norms, sizeof(norms) / sizeof(norms[0])};
@@ -0,0 +1,224 @@
+#include <cpu_ops/kernels.h>
+
+#include <cmath>
+
+// Portable variants at the build's baseline ISA. Reductions keep 8 partial sums so the compiler
+// can keep them in SSE registers without reassociating float math itself.
+
+namespace
+{
+constexpr int kPartials = 8;
+
+float dot(const float *a, const float *b, std::size_t n)
+{
+    float partial[kPartials] = {};
+    std::size_t i = 0;
+    for (; i + kPartials <= n; i += kPartials)
+    {
+        for (int j = 0; j < kPartials; ++j)
+            partial[j] += a[i + j] * b[i + j];
+    }
+    float sum = 0.0f;
+    for (float p : partial)
+        sum += p;
+    for (; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+void dot4(const float *x, const float *w0, const float *w1, const float *w2, const float *w3, std::size_t n, float *out)
+{
+    out[0] = dot(x, w0, n);
+    out[1] = dot(x, w1, n);
+    out[2] = dot(x, w2, n);
+    out[3] = dot(x, w3, n);
+}
+
+void axpy(float alpha, const float *x, float *y, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        y[i] += alpha * x[i];
+}
+
+void scale(float *x, float alpha, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        x[i] *= alpha;
+}
+
+float max(const float *x, std::size_t n)
+{
+    float best = x[0];
+    for (std::size_t i = 1; i < n; ++i)
+        best = x[i] > best ? x[i] : best;
+    return best;
+}
+
+float exp_shift_sum(float *x, float shift, std::size_t n)
+{
+    float sum = 0.0f;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        x[i] = std::exp(x[i] - shift);
+        sum += x[i];
+    }
+    return sum;
+}
+
+void add(const float *a, const float *b, float *out, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = a[i] + b[i];
+}
+
+void mul(const float *a, const float *b, float *out, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = a[i] * b[i];
+}
+
+void silu(const float *x, float *out, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = x[i] / (1.0f + std::exp(-x[i]));
+}
+
+void rmsnorm_row(const float *x, const float *weight, float *out, std::size_t n, float eps)
+{
+    const float mean_sq = dot(x, x, n) / static_cast<float>(n);
+    const float denom = 1.0f / std::sqrt(mean_sq + eps);
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = weight[i] * (x[i] * denom);
+}
+
+void rotate_half(float *x, const float *sin, const float *cos, std::size_t half)
+{
+    float *x2 = x + half;
+    for (std::size_t i = 0; i < half; ++i)
+    {
+        const float a = x[i];
+        const float b = x2[i];
+        x[i] = a * cos[i] - b * sin[i];
+        x2[i] = a * sin[i] + b * cos[i];
+    }
+}
+
+int argmax(const float *x, int n)
+{
+    if (n <= 0)
+        return -1;
+    int best = 0;
+    for (int i = 1; i < n; ++i)
+    {
+        if (x[i] > x[best])
+            best = i;
+    }
+    return best;
+}
+
+int find_at_least(const float *x, int begin, int n, float threshold)
+{
+    for (int i = begin; i < n; ++i)
+    {
+        if (x[i] >= threshold)
+            return i;
+    }
+    return n;
+}
+
+// 4 x 8 tile; the fixed bounds let the compiler keep the accumulators in registers
+void gemm_tile(std::size_t kc, const float *a, const float *b, float *c, std::size_t ldc, int m, int n, bool accumulate)
+{
+    constexpr int MR = 4;
+    constexpr int NR = 8;
+    float acc[MR][NR] = {};
+    for (std::size_t k = 0; k < kc; ++k)
+    {
+        for (int i = 0; i < MR; ++i)
+        {
+            for (int j = 0; j < NR; ++j)
+                acc[i][j] += a[i] * b[j];
+        }
+        a += MR;
+        b += NR;
+    }
+    for (int i = 0; i < m; ++i)
+    {
+        float *row = c + i * ldc;
+        for (int j = 0; j < n; ++j)
+            row[j] = accumulate ? row[j] + acc[i][j] : acc[i][j];
+    }
+}
+
+float sum(const float *x, std::size_t n)
+{
+    float partial[kPartials] = {};
+    std::size_t i = 0;
+    for (; i + kPartials <= n; i += kPartials)
+    {
+        for (int j = 0; j < kPartials; ++j)
+            partial[j] += x[i + j];
+    }
+    float total = 0.0f;
+    for (float p : partial)
+        total += p;
+    for (; i < n; ++i)
+        total += x[i];
+    return total;
+}
+
+float fma_chains(int iterations)
+{
+    float acc[8];
+    for (int j = 0; j < 8; ++j)
+        acc[j] = static_cast<float>(j);
+    for (int i = 0; i < iterations; ++i)
+    {
+        for (int j = 0; j < 8; ++j)
+            acc[j] = acc[j] * 0.999f + 0.001f;
+    }
+    return acc[0] + acc[7];
+}
+
+// Fixed-size kernels: the generic loops above with their length as a constant, which the
+// compiler specialises (and vectorises at the baseline ISA) without tail handling
+template <int N>
+float dot_n(const float *a, const float *b)
+{
+    return dot(a, b, N);
+}
+
+template <int N>
+void axpy_n(float alpha, const float *x, float *y)
+{
+    axpy(alpha, x, y, N);
+}
+
+template <int N>
+void rmsnorm_n(const float *x, const float *weight, float *out, float eps)
+{
+    rmsnorm_row(x, weight, out, N, eps);
+}
+
+template <int HeadDim>
+void rotate_half_n(float *x, const float *sin, const float *cos)
+{
+    rotate_half(x, sin, cos, HeadDim / 2);
+}
+
+const HeadKernels heads[] = {
+    {128, rmsnorm_n<128>, rotate_half_n<128>, dot_n<128>, axpy_n<128>}};
+
+const FixedNorm norms[] = {
+    {1024, rmsnorm_n<1024>}, {2048, rmsnorm_n<2048>}, {2560, rmsnorm_n<2560>}, {4096, rmsnorm_n<4096>}, {5120, rmsnorm_n<5120>}};
+} // namespace
+
+extern const KernelTable scalar_kernels = {
+    IsaLevel::Scalar, 1,
+    dot, dot4, axpy, scale, max, exp_shift_sum,
+    add, mul, silu, rmsnorm_row, rotate_half,
+    argmax, find_at_least,
+    4, 8, gemm_tile,
+    sum, fma_chains,
+    heads, sizeof(heads) / sizeof(heads[0]),
+    norms, sizeof(norms) / sizeof(norms[0])};
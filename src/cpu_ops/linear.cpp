@@ -1,7 +1,10 @@
 #include <cpu_ops/linear.h>
+#include <cpu_ops/gemm_tuning.h>
+#include <cpu_ops/kernels.h>
 #include <tensor/tensor.h>
 
 #include <cassert>
+#include <cstring>
 #include <stdexcept>
 
 namespace
@@ -55,6 +58,16 @@ void validate_dtype(Tensor &tensor)
 {
     assert(tensor.dtype() == DataType::F32 && "LinearOp currently supports only float32 tensors.");
 }
+
+void run_kernel(LinearKernel kernel, Tensor &input, Tensor &weight, Tensor &output)
+{
+    validate_dtype(input);
+    validate_dtype(weight);
+    validate_dtype(output);
+
+    const LinearDims dims = compute_linear_dims(input, weight);
+    linear_kernel_omp(kernel, input.data<float>(), weight.data<float>(), dims.M, dims.K, dims.N, output.data<float>());
+}
 } // namespace
 
 // Naive reference version
@@ -74,45 +87,145 @@ void linear_naive(const float *input, const float *weight, int M, int K, int N,
     }
 }
 
-void linear_avx2_omp(const float *input, const float *weight, int M, int K, int N, float *output)
+void linear_kernel_range(LinearKernel kernel, const float *input, const float *weight, int M, int K, int N, int n_begin,
+                         int n_end, float *output)
 {
-#pragma omp parallel for
-    for (int i = 0; i < M; ++i)
+    if (kernel == LinearKernel::Gemm)
     {
-        const float *in_row = input + i * K;
-        for (int j = 0; j < N; ++j)
-        {
-            const float *w_row = weight + j * K;
+        gemm_nt_range(input, weight, M, K, N, n_begin, n_end, output, GemmTuning::instance().blocking(K, N));
+        return;
+    }
+
+    const KernelTable &k = kernels();
 
-            __m256 vsum = _mm256_setzero_ps();
-            int k = 0;
-            for (; k + 8 <= K; k += 8)
+    // M input rows innermost, so each weight row (or group of four) is streamed from memory once
+    // and reused from L1 for every row (batched decode / verification)
+    int j = n_begin;
+    if (kernel == LinearKernel::Gemv4)
+    {
+        float out4[4];
+        for (; j + 4 <= n_end; j += 4)
+        {
+            const float *w_rows = weight + static_cast<size_t>(j) * K;
+            for (int i = 0; i < M; ++i)
             {
-                __m256 va = _mm256_loadu_ps(in_row + k);
-                __m256 vb = _mm256_loadu_ps(w_row + k);
-                vsum = _mm256_fmadd_ps(va, vb, vsum); // fused multiply-add
+                k.dot4(input + static_cast<size_t>(i) * K, w_rows, w_rows + K, w_rows + 2 * K, w_rows + 3 * K, K, out4);
+                std::memcpy(output + static_cast<size_t>(i) * N + j, out4, sizeof(out4));
             }
+        }
+    }
+    for (; j < n_end; ++j)
+    {
+        const float *w_row = weight + static_cast<size_t>(j) * K;
+        for (int i = 0; i < M; ++i)
+        {
+            output[static_cast<size_t>(i) * N + j] = k.dot(input + static_cast<size_t>(i) * K, w_row, K);
+        }
+    }
+}
+
+void linear_kernel_omp(LinearKernel kernel, const float *input, const float *weight, int M, int K, int N, float *output)
+{
+    if (kernel == LinearKernel::Gemm)
+    {
+        gemm_nt(input, weight, M, K, N, output, GemmTuning::instance().blocking(K, N));
+        return;
+    }
 
-            // horizontal add
-            __m128 low = _mm256_castps256_ps128(vsum);
-            __m128 high = _mm256_extractf128_ps(vsum, 1);
-            __m128 sum128 = _mm_add_ps(low, high);
-            sum128 = _mm_hadd_ps(sum128, sum128);
-            sum128 = _mm_hadd_ps(sum128, sum128);
-            float sum = _mm_cvtss_f32(sum128);
+    parallel_for(0, N, linear_cost(M, K), [&](std::size_t chunk_begin, std::size_t chunk_end)
+    {
+        linear_kernel_range(kernel, input, weight, M, K, N, static_cast<int>(chunk_begin), static_cast<int>(chunk_end), output);
+    });
+}
 
-            // Remainder
-            for (; k < K; ++k)
-                sum += in_row[k] * w_row[k];
+void linear_avx2_range(const float *input, const float *weight, int M, int K, int N, int n_begin, int n_end, float *output)
+{
+    linear_kernel_range(LinearDispatch::instance().select(M, K, N), input, weight, M, K, N, n_begin, n_end, output);
+}
 
-            output[i * N + j] = sum;
+void linear_avx2_omp(const float *input, const float *weight, int M, int K, int N, float *output)
+{
+    linear_kernel_omp(LinearDispatch::instance().select(M, K, N), input, weight, M, K, N, output);
+}
+
+void linear_avx2_domains(const float *input, const float *weight, int M, int K, int N,
+                         const std::vector<std::size_t> &bounds, float *output)
+{
+    ThreadPool &pool = ThreadPool::current();
+    if (pool.num_domains() < 2 || static_cast<int>(bounds.size()) != pool.num_domains() + 1)
+    {
+        linear_avx2_omp(input, weight, M, K, N, output);
+        return;
+    }
+
+    const std::size_t grain = CostModel::instance().plan(N, linear_cost(M, K)).grain;
+    pool.parallel_for_domains(bounds, grain, [&](std::size_t chunk_begin, std::size_t chunk_end)
+    {
+        linear_avx2_range(input, weight, M, K, N, static_cast<int>(chunk_begin), static_cast<int>(chunk_end), output);
+    });
+}
+
+void linear_avx2_column_split(const float *input, const float *const *parts, int M, int K, int N,
+                              const std::vector<std::size_t> &bounds, float *output)
+{
+    const int domains = static_cast<int>(bounds.size()) - 1;
+    if (domains == 1)
+    {
+        linear_avx2_omp(input, parts[0], M, K, N, output);
+        return;
+    }
+
+    // Each domain's input columns as a contiguous [M, width] block
+    const std::size_t rows = static_cast<std::size_t>(M);
+    std::vector<float> gathered(rows * K);
+    for (int d = 0; d < domains; ++d)
+    {
+        const std::size_t width = bounds[d + 1] - bounds[d];
+        for (std::size_t i = 0; i < rows && width > 0; ++i)
+        {
+            std::memcpy(gathered.data() + rows * bounds[d] + i * width, input + i * K + bounds[d], width * sizeof(float));
         }
     }
+
+    // Partial products, domain d's over output features [d * N, (d + 1) * N)
+    const std::size_t features = static_cast<std::size_t>(N);
+    std::vector<float> partials(domains * rows * features);
+    std::vector<std::size_t> feature_bounds(domains + 1);
+    for (int d = 0; d <= domains; ++d)
+    {
+        feature_bounds[d] = d * features;
+    }
+    const std::size_t grain = CostModel::instance().plan(features, linear_cost(M, K / domains)).grain;
+    ThreadPool::current().parallel_for_domains(feature_bounds, grain, [&](std::size_t begin, std::size_t end)
+    {
+        const std::size_t d = begin / features;
+        const int width = static_cast<int>(bounds[d + 1] - bounds[d]);
+        if (width == 0)
+            return;
+        linear_avx2_range(gathered.data() + rows * bounds[d], parts[d], M, width, N, static_cast<int>(begin - d * features),
+                          static_cast<int>(end - d * features), partials.data() + d * rows * features);
+    });
+
+    // The one cross-domain step
+    const std::size_t total = rows * features;
+    parallel_for(0, total, WorkCost{4.0 * (domains + 1), static_cast<double>(domains)}, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t j = begin; j < end; ++j)
+        {
+            float sum = partials[j];
+            for (int d = 1; d < domains; ++d)
+                sum += partials[d * total + j];
+            output[j] = sum;
+        }
+    });
 }
 
 std::unordered_map<MatmulImplType, LinearOp::ImplFunction> LinearOp::impl_registry_ = {
     {MatmulImplType::NAIVE, &LinearOp::naive_impl},
-    {MatmulImplType::AVX2, &LinearOp::avx2_impl}};
+    {MatmulImplType::AVX2, &LinearOp::avx2_impl},
+    {MatmulImplType::GEMV, &LinearOp::gemv_impl},
+    {MatmulImplType::GEMV4, &LinearOp::gemv4_impl},
+    {MatmulImplType::GEMM, &LinearOp::gemm_impl}};
 
 LinearOp::LinearOp(MatmulImplType impl_type) : impl_type_(impl_type)
 {
@@ -165,6 +278,20 @@ MatmulImplType LinearOp::resolve_impl(Tensor &input, Tensor &weight) const
 {
     const LinearDims dims = compute_linear_dims(input, weight);
 
+    // AVX2 asks for the fastest kernel for the shape; explicit kernels are taken as given
+    if (impl_type_ == MatmulImplType::AVX2)
+    {
+        switch (LinearDispatch::instance().select(dims.M, dims.K, dims.N))
+        {
+        case LinearKernel::Gemv:
+            return MatmulImplType::GEMV;
+        case LinearKernel::Gemv4:
+            return MatmulImplType::GEMV4;
+        case LinearKernel::Gemm:
+            return MatmulImplType::GEMM;
+        }
+    }
+
     if (impl_registry_.count(impl_type_))
     {
         return impl_type_;
@@ -192,3 +319,18 @@ void LinearOp::avx2_impl(Tensor &input, Tensor &weight, Tensor &output)
     const LinearDims dims = compute_linear_dims(input, weight);
     linear_avx2_omp(input.data<float>(), weight.data<float>(), dims.M, dims.K, dims.N, output.data<float>());
 }
+
+void LinearOp::gemv_impl(Tensor &input, Tensor &weight, Tensor &output)
+{
+    run_kernel(LinearKernel::Gemv, input, weight, output);
+}
+
+void LinearOp::gemv4_impl(Tensor &input, Tensor &weight, Tensor &output)
+{
+    run_kernel(LinearKernel::Gemv4, input, weight, output);
+}
+
+void LinearOp::gemm_impl(Tensor &input, Tensor &weight, Tensor &output)
+{
+    run_kernel(LinearKernel::Gemm, input, weight, output);
+}
@@ -0,0 +1,316 @@
+#include <cpu_ops/linear_dispatch.h>
+#include <cpu_ops/kernels.h>
+#include <cpu_ops/linear.h>
+#include <cpu_ops/thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// Bucket b holds row counts [kBucketRows[b - 1] + 1, kBucketRows[b]] and is timed at its top;
+// the last one takes everything from 33 rows on and is timed at 64
+constexpr int kBucketRows[] = {1, 2, 4, 8, 16, 32, 64};
+
+constexpr LinearKernel kAllKernels[] = {LinearKernel::Gemv, LinearKernel::Gemv4, LinearKernel::Gemm};
+
+constexpr int kBenchK = 1024;
+constexpr int kBenchN = 1024;
+
+// Shapes for instance() to measure, set by configure() until it runs
+struct SharedShapes
+{
+    std::mutex mutex;
+    std::vector<GemmShape> shapes;
+    bool started = false;
+};
+
+SharedShapes &shared_shapes()
+{
+    static SharedShapes shared;
+    return shared;
+}
+
+bool same_shape(const GemmShape &a, const GemmShape &b)
+{
+    return a.K == b.K && a.N == b.N;
+}
+
+// Fastest kernel per bucket for a [N, K] weight, on the current pool or on the calling thread alone
+LinearDispatch::Buckets measure_buckets(int K, int N, bool on_pool)
+{
+    std::vector<float> weight(static_cast<std::size_t>(N) * K, 0.5f);
+    const int max_rows = kBucketRows[sizeof(kBucketRows) / sizeof(kBucketRows[0]) - 1];
+    std::vector<float> input(static_cast<std::size_t>(max_rows) * K, 0.25f);
+    std::vector<float> output(static_cast<std::size_t>(max_rows) * N);
+
+    LinearDispatch::Buckets buckets;
+    int first = 1;
+    for (int rows : kBucketRows)
+    {
+        LinearKernel best = LinearKernel::Gemv;
+        double best_ns = 1e30;
+        for (LinearKernel kernel : kAllKernels)
+        {
+            // Best of three; the first pass also pulls the weight into whatever cache it fits
+            double ns = 1e30;
+            for (int pass = 0; pass < 3; ++pass)
+            {
+                const auto start = Clock::now();
+                if (on_pool)
+                    linear_kernel_omp(kernel, input.data(), weight.data(), rows, K, N, output.data());
+                else
+                    linear_kernel_range(kernel, input.data(), weight.data(), rows, K, N, 0, N, output.data());
+                ns = std::min(ns, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+            }
+            if (ns < best_ns)
+            {
+                best_ns = ns;
+                best = kernel;
+            }
+        }
+        // Neighbouring buckets with the same winner collapse into one
+        if (buckets.empty() || buckets.back().second != best)
+            buckets.emplace_back(first, best);
+        first = rows + 1;
+    }
+    return buckets;
+}
+
+LinearKernel select_bucket(const LinearDispatch::Buckets &buckets, int M)
+{
+    LinearKernel kernel = buckets.empty() ? LinearKernel::Gemv : buckets.front().second;
+    for (const auto &bucket : buckets)
+    {
+        if (bucket.first > M)
+            break;
+        kernel = bucket.second;
+    }
+    return kernel;
+}
+
+LinearDispatch default_dispatch()
+{
+    std::vector<GemmShape> shapes;
+    {
+        SharedShapes &shared = shared_shapes();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        shared.started = true;
+        shapes = shared.shapes;
+    }
+
+    // The shapes are timed across the shared pool, as the model runs them
+    ThreadPool::Scope scope(ThreadPool::instance());
+
+    const char *path = std::getenv("MINMAX_LINEAR_TABLE");
+    if (path == nullptr || *path == '\0')
+    {
+        return LinearDispatch::measure(shapes);
+    }
+
+    LinearDispatch stored({}, std::string());
+    if (LinearDispatch::load(path, stored) &&
+        std::all_of(shapes.begin(), shapes.end(), [&](const GemmShape &shape) { return stored.has_shape(shape); }))
+    {
+        return stored;
+    }
+    LinearDispatch measured = LinearDispatch::measure(shapes);
+    try
+    {
+        measured.save(path);
+    }
+    catch (const std::runtime_error &)
+    {
+        // Unwritable location: the table is still right for this process, just not remembered
+    }
+    return measured;
+}
+} // namespace
+
+const char *linear_kernel_name(LinearKernel kernel)
+{
+    switch (kernel)
+    {
+    case LinearKernel::Gemv:
+        return "gemv";
+    case LinearKernel::Gemv4:
+        return "gemv4";
+    case LinearKernel::Gemm:
+        return "gemm";
+    }
+    return "unknown";
+}
+
+LinearKernel parse_linear_kernel(const std::string &name)
+{
+    for (LinearKernel kernel : kAllKernels)
+    {
+        if (name == linear_kernel_name(kernel))
+            return kernel;
+    }
+    throw std::invalid_argument("Unknown linear kernel: " + name);
+}
+
+LinearDispatch::LinearDispatch(Buckets buckets, std::string cpu, ShapeBuckets shapes)
+    : buckets_(std::move(buckets)), shapes_(std::move(shapes)), cpu_(std::move(cpu))
+{
+    auto by_rows = [](const std::pair<int, LinearKernel> &a, const std::pair<int, LinearKernel> &b) { return a.first < b.first; };
+    std::sort(buckets_.begin(), buckets_.end(), by_rows);
+    for (auto &shape : shapes_)
+        std::sort(shape.second.begin(), shape.second.end(), by_rows);
+}
+
+bool LinearDispatch::configure(std::vector<GemmShape> shapes)
+{
+    SharedShapes &shared = shared_shapes();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    if (shared.started)
+    {
+        return false;
+    }
+    shared.shapes = std::move(shapes);
+    return true;
+}
+
+const LinearDispatch &LinearDispatch::instance()
+{
+    static const LinearDispatch dispatch = default_dispatch();
+    return dispatch;
+}
+
+LinearDispatch LinearDispatch::measure(const std::vector<GemmShape> &shapes)
+{
+    ShapeBuckets measured;
+    for (const GemmShape &shape : shapes)
+    {
+        const bool seen = std::any_of(measured.begin(), measured.end(),
+                                      [&](const std::pair<GemmShape, Buckets> &entry) { return same_shape(entry.first, shape); });
+        if (!seen)
+            measured.emplace_back(shape, measure_buckets(shape.K, shape.N, true));
+    }
+    return LinearDispatch(measure_buckets(kBenchK, kBenchN, false), kernels_host_key(), std::move(measured));
+}
+
+bool LinearDispatch::load(const std::string &path, LinearDispatch &out)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+
+    // "cpu <key>", one "rows <first> <kernel>" line per bucket of the generic table and one
+    // "shape <K> <N> <first> <kernel>" line per bucket of a measured shape
+    std::string cpu;
+    Buckets buckets;
+    ShapeBuckets shapes;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        std::string tag;
+        fields >> tag;
+        if (tag == "cpu")
+        {
+            std::getline(fields >> std::ws, cpu);
+        }
+        else if (tag == "rows")
+        {
+            int first = 0;
+            std::string name;
+            if (!(fields >> first >> name) || first < 1)
+                return false;
+            try
+            {
+                buckets.emplace_back(first, parse_linear_kernel(name));
+            }
+            catch (const std::invalid_argument &)
+            {
+                return false;
+            }
+        }
+        else if (tag == "shape")
+        {
+            GemmShape shape{};
+            int first = 0;
+            std::string name;
+            if (!(fields >> shape.K >> shape.N >> first >> name) || shape.K < 1 || shape.N < 1 || first < 1)
+                return false;
+            auto entry = std::find_if(shapes.begin(), shapes.end(),
+                                      [&](const std::pair<GemmShape, Buckets> &e) { return same_shape(e.first, shape); });
+            if (entry == shapes.end())
+                entry = shapes.insert(shapes.end(), {shape, Buckets()});
+            try
+            {
+                entry->second.emplace_back(first, parse_linear_kernel(name));
+            }
+            catch (const std::invalid_argument &)
+            {
+                return false;
+            }
+        }
+    }
+    if (cpu != kernels_host_key() || buckets.empty())
+    {
+        return false;
+    }
+
+    LinearDispatch stored(std::move(buckets), std::move(cpu), std::move(shapes));
+    if (stored.buckets_.front().first != 1)
+    {
+        return false;
+    }
+    for (const auto &shape : stored.shapes_)
+    {
+        if (shape.second.front().first != 1)
+            return false;
+    }
+    out = std::move(stored);
+    return true;
+}
+
+void LinearDispatch::save(const std::string &path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("Cannot write linear kernel table to " + path);
+    }
+    file << "cpu " << cpu_ << "\n";
+    for (const auto &bucket : buckets_)
+        file << "rows " << bucket.first << " " << linear_kernel_name(bucket.second) << "\n";
+    for (const auto &shape : shapes_)
+    {
+        for (const auto &bucket : shape.second)
+            file << "shape " << shape.first.K << " " << shape.first.N << " " << bucket.first << " "
+                 << linear_kernel_name(bucket.second) << "\n";
+    }
+}
+
+LinearKernel LinearDispatch::select(int M) const
+{
+    return select_bucket(buckets_, M);
+}
+
+LinearKernel LinearDispatch::select(int M, int K, int N) const
+{
+    for (const auto &shape : shapes_)
+    {
+        if (shape.first.K == K && shape.first.N == N)
+            return select_bucket(shape.second, M);
+    }
+    return select_bucket(buckets_, M);
+}
+
+bool LinearDispatch::has_shape(const GemmShape &shape) const
+{
+    return std::any_of(shapes_.begin(), shapes_.end(),
+                       [&](const std::pair<GemmShape, Buckets> &entry) { return same_shape(entry.first, shape); });
+}
@@ -0,0 +1,178 @@
+#include <cpu_ops/lm_head.h>
+#include <cpu_ops/cost_model.h>
+#include <cpu_ops/kernels.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+inline bool candidate_greater(const TokenCandidate &a, const TokenCandidate &b)
+{
+    return a.logit > b.logit;
+}
+
+// Running top-k over heap[0..count), a min-heap on logit
+inline void push_candidate(TokenCandidate *heap, int &count, int k, int id, float logit)
+{
+    if (count < k)
+    {
+        heap[count++] = {id, logit};
+        std::push_heap(heap, heap + count, candidate_greater);
+    }
+    else if (logit > heap[0].logit)
+    {
+        std::pop_heap(heap, heap + k, candidate_greater);
+        heap[k - 1] = {id, logit};
+        std::push_heap(heap, heap + k, candidate_greater);
+    }
+}
+
+void collect_allowed_rows(const uint64_t *allowed, int N, std::vector<int> &rows)
+{
+    rows.clear();
+    const int num_words = (N + 63) / 64;
+    for (int w = 0; w < num_words; ++w)
+    {
+        uint64_t word = allowed[w];
+        while (word)
+        {
+#if defined(_MSC_VER)
+            unsigned long bit;
+            _BitScanForward64(&bit, word);
+#else
+            const int bit = __builtin_ctzll(word);
+#endif
+            const int row = w * 64 + static_cast<int>(bit);
+            if (row >= N)
+                break;
+            rows.push_back(row);
+            word &= word - 1;
+        }
+    }
+}
+
+} // namespace
+
+int lm_head_topk_avx2_omp(const float *input, const float *weight, int K, int N, int k, TokenCandidate *out, const uint64_t *allowed)
+{
+    if (k <= 0 || N <= 0)
+    {
+        return 0;
+    }
+
+    // With a mask, work is split over the allowed rows only so threads stay balanced
+    std::vector<int> rows;
+    int num_rows = N;
+    if (allowed)
+    {
+        collect_allowed_rows(allowed, N, rows);
+        num_rows = static_cast<int>(rows.size());
+        if (num_rows == 0)
+        {
+            return 0;
+        }
+    }
+    k = std::min(k, num_rows);
+
+    // Each row streams its weights once; the cost model picks how many threads share them
+    ThreadPool &pool = ThreadPool::current();
+    const KernelTable &ops = kernels();
+    const int max_threads = CostModel::instance().plan(num_rows, WorkCost{4.0 * K, 2.0 * K}).threads;
+
+    // One top-k slot per thread, merged after the parallel region
+    std::vector<TokenCandidate> partial(static_cast<size_t>(max_threads) * k);
+    std::vector<int> partial_count(max_threads, 0);
+
+    pool.parallel_run([&](int tid, int nthreads)
+    {
+        const int begin = static_cast<int>(static_cast<long long>(num_rows) * tid / nthreads);
+        const int end = static_cast<int>(static_cast<long long>(num_rows) * (tid + 1) / nthreads);
+
+        TokenCandidate *heap = partial.data() + static_cast<size_t>(tid) * k;
+        int count = 0;
+        alignas(16) float logits[4];
+
+        if (!allowed)
+        {
+            int j = begin;
+            for (; j + 4 <= end; j += 4)
+            {
+                const float *w = weight + static_cast<size_t>(j) * K;
+                ops.dot4(input, w, w + K, w + 2 * K, w + 3 * K, K, logits);
+                for (int r = 0; r < 4; ++r)
+                {
+                    push_candidate(heap, count, k, j + r, logits[r]);
+                }
+            }
+            for (; j < end; ++j)
+            {
+                push_candidate(heap, count, k, j, ops.dot(input, weight + static_cast<size_t>(j) * K, K));
+            }
+        }
+        else
+        {
+            int i = begin;
+            for (; i + 4 <= end; i += 4)
+            {
+                const int *r = rows.data() + i;
+                ops.dot4(input,
+                         weight + static_cast<size_t>(r[0]) * K,
+                         weight + static_cast<size_t>(r[1]) * K,
+                         weight + static_cast<size_t>(r[2]) * K,
+                         weight + static_cast<size_t>(r[3]) * K,
+                         K, logits);
+                for (int t = 0; t < 4; ++t)
+                {
+                    push_candidate(heap, count, k, r[t], logits[t]);
+                }
+            }
+            for (; i < end; ++i)
+            {
+                push_candidate(heap, count, k, rows[i], ops.dot(input, weight + static_cast<size_t>(rows[i]) * K, K));
+            }
+        }
+
+        partial_count[tid] = count;
+    }, max_threads);
+
+    // Merge the per-thread lists
+    int total = 0;
+    for (int t = 0; t < max_threads; ++t)
+    {
+        const TokenCandidate *src = partial.data() + static_cast<size_t>(t) * k;
+        for (int i = 0; i < partial_count[t]; ++i)
+        {
+            partial[total++] = src[i];
+        }
+    }
+
+    const int count = std::min(k, total);
+    std::partial_sort(partial.begin(), partial.begin() + count, partial.begin() + total, candidate_greater);
+    std::copy(partial.begin(), partial.begin() + count, out);
+    return count;
+}
+
+void lm_head_masked_avx2_omp(const float *input, const float *weight, int K, int N, const uint64_t *allowed, float *output)
+{
+    std::vector<int> rows;
+    collect_allowed_rows(allowed, N, rows);
+    const int num_rows = static_cast<int>(rows.size());
+
+    std::fill(output, output + N, -INFINITY);
+
+    const KernelTable &ops = kernels();
+
+    parallel_for(0, num_rows, WorkCost{4.0 * K, 2.0 * K}, [&](std::size_t chunk_begin, std::size_t chunk_end)
+    {
+        for (int i = static_cast<int>(chunk_begin); i < static_cast<int>(chunk_end); ++i)
+        {
+            output[rows[i]] = ops.dot(input, weight + static_cast<size_t>(rows[i]) * K, K);
+        }
+    });
+}
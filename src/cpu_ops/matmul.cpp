@@ -1,5 +1,5 @@
+#include <cpu_ops/thread_pool.h>
 #include <immintrin.h>
-#include <omp.h>
 #include <string.h>
 
 // Naive matrix multiplication
@@ -65,60 +65,64 @@ void hyperOptimizedMatMul(float *A, float *B, float *C, int M, int N, int K)
     // Initialize output matrix
     memset(C, 0, M * N * sizeof(float));
 
-// Outer parallelization over M blocks
-#pragma omp parallel for schedule(dynamic)
-    for (int mm = 0; mm < M; mm += BLOCK_M)
+    // Outer parallelization over M blocks
+    const int num_blocks = (M + BLOCK_M - 1) / BLOCK_M;
+    parallel_for(0, num_blocks, 1, [&](std::size_t chunk_begin, std::size_t chunk_end)
     {
-        int m_end = (mm + BLOCK_M < M) ? mm + BLOCK_M : M;
-
-        for (int kk = 0; kk < K; kk += BLOCK_K)
+        for (int block = static_cast<int>(chunk_begin); block < static_cast<int>(chunk_end); ++block)
         {
-            int k_end = (kk + BLOCK_K < K) ? kk + BLOCK_K : K;
-            int k_block = k_end - kk;
+            int mm = block * BLOCK_M;
+            int m_end = (mm + BLOCK_M < M) ? mm + BLOCK_M : M;
 
-            for (int nn = 0; nn < N; nn += BLOCK_N)
+            for (int kk = 0; kk < K; kk += BLOCK_K)
             {
-                int n_end = (nn + BLOCK_N < N) ? nn + BLOCK_N : N;
+                int k_end = (kk + BLOCK_K < K) ? kk + BLOCK_K : K;
+                int k_block = k_end - kk;
 
-                // Process MICRO_M x MICRO_N micro-kernels
-                for (int m = mm; m < m_end; m += MICRO_M)
+                for (int nn = 0; nn < N; nn += BLOCK_N)
                 {
-                    int m_micro = (m + MICRO_M < m_end) ? MICRO_M : m_end - m;
+                    int n_end = (nn + BLOCK_N < N) ? nn + BLOCK_N : N;
 
-                    for (int n = nn; n < n_end; n += MICRO_N)
+                    // Process MICRO_M x MICRO_N micro-kernels
+                    for (int m = mm; m < m_end; m += MICRO_M)
                     {
-                        int n_micro = (n + MICRO_N < n_end) ? MICRO_N : n_end - n;
+                        int m_micro = (m + MICRO_M < m_end) ? MICRO_M : m_end - m;
 
-                        if (m_micro == MICRO_M && n_micro == MICRO_N)
-                        {
-                            // Fast path: full micro-kernel
-                            microKernel(&A[m * K + kk], &B[kk * N + n],
-                                        &C[m * N + n], k_block, K, N, N);
-                        }
-                        else
+                        for (int n = nn; n < n_end; n += MICRO_N)
                         {
-                            // Boundary case: scalar fallback
-                            for (int i = 0; i < m_micro; i++)
+                            int n_micro = (n + MICRO_N < n_end) ? MICRO_N : n_end - n;
+
+                            if (m_micro == MICRO_M && n_micro == MICRO_N)
+                            {
+                                // Fast path: full micro-kernel
+                                microKernel(&A[m * K + kk], &B[kk * N + n],
+                                            &C[m * N + n], k_block, K, N, N);
+                            }
+                            else
                             {
-                                for (int k = 0; k < k_block; k++)
+                                // Boundary case: scalar fallback
+                                for (int i = 0; i < m_micro; i++)
                                 {
-                                    float a_val = A[(m + i) * K + kk + k];
-
-                                    // Vectorized inner loop
-                                    int j = 0;
-                                    for (; j + 8 <= n_micro; j += 8)
+                                    for (int k = 0; k < k_block; k++)
                                     {
-                                        __m256 b_vec = _mm256_loadu_ps(&B[(kk + k) * N + n + j]);
-                                        __m256 c_vec = _mm256_loadu_ps(&C[(m + i) * N + n + j]);
-                                        __m256 a_vec = _mm256_set1_ps(a_val);
-                                        c_vec = _mm256_fmadd_ps(a_vec, b_vec, c_vec);
-                                        _mm256_storeu_ps(&C[(m + i) * N + n + j], c_vec);
-                                    }
-
-                                    // Scalar cleanup
-                                    for (; j < n_micro; j++)
-                                    {
-                                        C[(m + i) * N + n + j] += a_val * B[(kk + k) * N + n + j];
+                                        float a_val = A[(m + i) * K + kk + k];
+
+                                        // Vectorized inner loop
+                                        int j = 0;
+                                        for (; j + 8 <= n_micro; j += 8)
+                                        {
+                                            __m256 b_vec = _mm256_loadu_ps(&B[(kk + k) * N + n + j]);
+                                            __m256 c_vec = _mm256_loadu_ps(&C[(m + i) * N + n + j]);
+                                            __m256 a_vec = _mm256_set1_ps(a_val);
+                                            c_vec = _mm256_fmadd_ps(a_vec, b_vec, c_vec);
+                                            _mm256_storeu_ps(&C[(m + i) * N + n + j], c_vec);
+                                        }
+
+                                        // Scalar cleanup
+                                        for (; j < n_micro; j++)
+                                        {
+                                            C[(m + i) * N + n + j] += a_val * B[(kk + k) * N + n + j];
+                                        }
                                     }
                                 }
                             }
@@ -127,5 +131,5 @@ void hyperOptimizedMatMul(float *A, float *B, float *C, int M, int N, int K)
                 }
             }
         }
-    }
+    });
 }
\ No newline at end of file
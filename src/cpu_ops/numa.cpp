@@ -0,0 +1,82 @@
+#include <cpu_ops/numa.h>
+
+#include <cstring>
+#include <stdexcept>
+
+std::vector<std::size_t> numa_split(std::size_t rows, const ThreadPool &pool, std::size_t align)
+{
+    const int domains = pool.num_domains();
+    align = align > 0 ? align : 1;
+
+    std::vector<std::size_t> bounds(1, 0);
+    int threads_before = 0;
+    for (int d = 0; d < domains; ++d)
+    {
+        threads_before += pool.domain_threads(d);
+        std::size_t end = rows * threads_before / pool.num_threads();
+        end = d + 1 < domains ? (end + align / 2) / align * align : rows;
+        bounds.push_back(end < bounds.back() ? bounds.back() : (end > rows ? rows : end));
+    }
+    return bounds;
+}
+
+Tensor numa_place_rows(const Tensor &weight, const std::vector<std::size_t> &bounds, ThreadPool &pool)
+{
+    const std::vector<std::size_t> &shape = weight.shape();
+    if (shape.size() != 2 || bounds.size() < 2 || bounds.front() != 0 || bounds.back() != shape[0])
+    {
+        throw std::invalid_argument("numa_place_rows: bounds must cover the rows of a 2-D weight");
+    }
+
+    Tensor placed(weight.dtype(), shape);
+    const std::size_t row_bytes = weight.nbytes() / shape[0];
+    const char *source = static_cast<const char *>(weight.raw_data());
+    char *target = static_cast<char *>(placed.raw_data());
+
+    // A few rows per chunk so a domain's threads share its slice
+    pool.parallel_for_domains(bounds, 16, [&](std::size_t begin, std::size_t end)
+    {
+        std::memcpy(target + begin * row_bytes, source + begin * row_bytes, (end - begin) * row_bytes);
+    });
+    return placed;
+}
+
+std::vector<std::size_t> numa_domain_bounds(int domain, std::size_t begin, std::size_t end, int num_domains)
+{
+    std::vector<std::size_t> bounds(static_cast<std::size_t>(num_domains) + 1, end);
+    for (int d = 0; d <= domain; ++d)
+    {
+        bounds[d] = begin;
+    }
+    return bounds;
+}
+
+Tensor numa_place_columns(const Tensor &weight, std::size_t col_begin, std::size_t col_end, int domain, ThreadPool &pool)
+{
+    const std::vector<std::size_t> &shape = weight.shape();
+    if (shape.size() != 2 || col_begin > col_end || col_end > shape[1] || domain < 0 || domain >= pool.num_domains())
+    {
+        throw std::invalid_argument("numa_place_columns: column range or domain out of bounds");
+    }
+
+    const std::size_t rows = shape[0];
+    const std::size_t cols = col_end - col_begin;
+    Tensor placed(weight.dtype(), {rows, cols});
+    if (cols == 0)
+    {
+        return placed;
+    }
+
+    const std::size_t element = weight.nbytes() / weight.size();
+    const char *source = static_cast<const char *>(weight.raw_data());
+    char *target = static_cast<char *>(placed.raw_data());
+    pool.parallel_for_domains(numa_domain_bounds(domain, 0, rows, pool.num_domains()), 16,
+                              [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t r = begin; r < end; ++r)
+        {
+            std::memcpy(target + r * cols * element, source + (r * shape[1] + col_begin) * element, cols * element);
+        }
+    });
+    return placed;
+}
@@ -1,33 +1,25 @@
 #include <cpu_ops/rmsnorm.h>
-#include <immintrin.h>
-#include <cmath>
+#include <cpu_ops/cost_model.h>
+#include <cpu_ops/kernels.h>
 
 void rmsnorm_avx2(const float* input, const float* weight, float* output, int batch_size, int hidden_size, float eps) {
-    for (int b = 0; b < batch_size; ++b) {
-        const float* in = input + b * hidden_size;
-        float mean_sq = 0.0f;
-        int d = 0;
-        __m256 sum_vec = _mm256_setzero_ps();
-        for (; d + 8 <= hidden_size; d += 8) {
-            __m256 x = _mm256_loadu_ps(in + d);
-            sum_vec = _mm256_add_ps(sum_vec, _mm256_mul_ps(x, x));
-        }
-        alignas(32) float sum_arr[8];
-        _mm256_store_ps(sum_arr, sum_vec);
-        for (int i = 0; i < 8; ++i) mean_sq += sum_arr[i];
-        for (; d < hidden_size; ++d) mean_sq += in[d] * in[d];
-        mean_sq /= hidden_size;
-        float denom = 1.0f / std::sqrt(mean_sq + eps);
-        d = 0;
-        for (; d + 8 <= hidden_size; d += 8) {
-            __m256 x = _mm256_loadu_ps(in + d);
-            __m256 w = _mm256_loadu_ps(weight + d);
-            __m256 norm = _mm256_mul_ps(x, _mm256_set1_ps(denom));
-            __m256 out = _mm256_mul_ps(w, norm);
-            _mm256_storeu_ps(output + b * hidden_size + d, out);
-        }
-        for (; d < hidden_size; ++d) {
-            output[b * hidden_size + d] = weight[d] * in[d] * denom;
+    rmsnorm_avx2(input, weight, output, batch_size, hidden_size, eps, nullptr);
+}
+
+void rmsnorm_avx2(const float* input, const float* weight, float* output, int batch_size, int hidden_size, float eps,
+                  FixedRmsNorm fixed_row) {
+    // Rows are independent: a prefill or batched step of many rows fans out, one row does not
+    const WorkCost row_cost{8.0 * hidden_size, 4.0 * hidden_size};
+    const KernelTable& ops = kernels();
+    parallel_for(0, batch_size, row_cost, [&](std::size_t chunk_begin, std::size_t chunk_end) {
+        const std::size_t begin = chunk_begin * hidden_size;
+        const std::size_t end = chunk_end * hidden_size;
+        if (fixed_row) {
+            for (std::size_t offset = begin; offset < end; offset += hidden_size)
+                fixed_row(input + offset, weight, output + offset, eps);
+            return;
         }
-    }
+        for (std::size_t offset = begin; offset < end; offset += hidden_size)
+            ops.rmsnorm_row(input + offset, weight, output + offset, hidden_size, eps);
+    });
 }
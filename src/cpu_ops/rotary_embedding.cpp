@@ -1,5 +1,6 @@
 #include <cpu_ops/rotary_embedding.h>
-#include <immintrin.h> // AVX2 intrinsics
+#include <cpu_ops/cost_model.h>
+#include <cpu_ops/kernels.h>
 #include <cmath>
 #include <cstring>
 
@@ -8,7 +9,8 @@ RotaryEmbeddingAVX2::RotaryEmbeddingAVX2(const float* sin_cache,
                                        int max_positions,
                                        int dim,
                                        int rotary_dim)
-    : rotary_dim_(rotary_dim == 0 ? dim : rotary_dim)
+    : rotary_dim_(rotary_dim == 0 ? dim : rotary_dim),
+      head_ops_(head_kernels(rotary_dim_))
 {
     cache_ = std::make_unique<RotationCache>();
     const int rot_dim_half = rotary_dim_ / 2;
@@ -34,41 +36,20 @@ void RotaryEmbeddingAVX2::rotate(float* embeddings,
     const float* sin_ptr = &cache_->sin[position_id * rot_dim_half];
     const float* cos_ptr = &cache_->cos[position_id * rot_dim_half];
 
-    #pragma omp parallel for
-    for (int h = 0; h < num_heads; ++h) {
-        float* head = embeddings + h * head_size;
-        
-        // AVX2 processing (8 floats per register)
-        int i = 0;
-        for (; i + 8 <= rot_dim_half; i += 8) {
-            __m256 x1 = _mm256_loadu_ps(head + i);
-            __m256 x2 = _mm256_loadu_ps(head + i + rot_dim_half);
-            __m256 sin = _mm256_loadu_ps(sin_ptr + i);
-            __m256 cos = _mm256_loadu_ps(cos_ptr + i);
-            
-            __m256 x1_new = _mm256_sub_ps(
-                _mm256_mul_ps(x1, cos),
-                _mm256_mul_ps(x2, sin)
-            );
-            __m256 x2_new = _mm256_add_ps(
-                _mm256_mul_ps(x1, sin),
-                _mm256_mul_ps(x2, cos)
-            );
-            
-            _mm256_storeu_ps(head + i, x1_new);
-            _mm256_storeu_ps(head + i + rot_dim_half, x2_new);
+    // A head is only a few hundred flops, so a decode token's heads stay on one thread
+    const WorkCost head_cost{8.0 * rot_dim, 3.0 * rot_dim};
+    const KernelTable& ops = kernels();
+    const HeadKernels* fixed = head_ops_;
+    parallel_for(0, num_heads, head_cost, [&](std::size_t chunk_begin, std::size_t chunk_end) {
+        if (fixed) {
+            for (int h = static_cast<int>(chunk_begin); h < static_cast<int>(chunk_end); ++h)
+                fixed->rotate_half(embeddings + h * head_size, sin_ptr, cos_ptr);
+            return;
         }
-        
-        // Remainder processing
-        for (; i < rot_dim_half; ++i) {
-            float x1 = head[i];
-            float x2 = head[i + rot_dim_half];
-            float s = sin_ptr[i];
-            float c = cos_ptr[i];
-            head[i] = x1 * c - x2 * s;
-            head[i + rot_dim_half] = x1 * s + x2 * c;
+        for (int h = static_cast<int>(chunk_begin); h < static_cast<int>(chunk_end); ++h) {
+            ops.rotate_half(embeddings + h * head_size, sin_ptr, cos_ptr, rot_dim_half);
         }
-    }
+    });
 }
 
 void RotaryEmbeddingAVX2::precompute(float* sin_cache,
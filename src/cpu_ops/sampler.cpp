@@ -0,0 +1,293 @@
+#include <cpu_ops/sampler.h>
+#include <cpu_ops/kernels.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+// Tokens more than this many temperature-scaled logits below the best one have relative
+// probability < exp(-20) ~ 2e-9 and are never exponentiated.
+constexpr float kLogitWindow = 20.0f;
+
+inline bool candidate_greater(const TokenCandidate &a, const TokenCandidate &b)
+{
+    return a.logit > b.logit;
+}
+} // namespace
+
+int argmax_avx2(const float *arr, int size)
+{
+    return kernels().argmax(arr, size);
+}
+
+int select_topk_avx2(const float *arr, int size, int k, float floor, TokenCandidate *out)
+{
+    if (k <= 0 || size <= 0)
+    {
+        return 0;
+    }
+
+    // out[0..count) is a min-heap on logit while scanning
+    int count = 0;
+    float threshold = floor;
+
+    auto consider = [&](int idx)
+    {
+        const float v = arr[idx];
+        if (count < k)
+        {
+            if (v < floor)
+                return;
+            out[count++] = {idx, v};
+            std::push_heap(out, out + count, candidate_greater);
+            if (count == k)
+                threshold = std::max(floor, out[0].logit);
+        }
+        else if (v > out[0].logit)
+        {
+            std::pop_heap(out, out + k, candidate_greater);
+            out[k - 1] = {idx, v};
+            std::push_heap(out, out + k, candidate_greater);
+            threshold = std::max(floor, out[0].logit);
+        }
+    };
+
+    // Jump from one element at or above the current threshold to the next; the threshold only rises
+    const KernelTable &ops = kernels();
+    for (int i = ops.find_at_least(arr, 0, size, threshold); i < size; i = ops.find_at_least(arr, i + 1, size, threshold))
+    {
+        consider(i);
+    }
+
+    std::sort_heap(out, out + count, candidate_greater);
+    return count;
+}
+
+Sampler::Sampler(const SamplerConfig &config)
+{
+    set_config(config);
+}
+
+void Sampler::set_config(const SamplerConfig &config)
+{
+    if (config.top_k < 0)
+    {
+        throw std::invalid_argument("top_k must be non-negative");
+    }
+    if (config.top_p <= 0.0f || config.top_p > 1.0f)
+    {
+        throw std::invalid_argument("top_p must be in (0, 1]");
+    }
+    if (config.min_p < 0.0f || config.min_p >= 1.0f)
+    {
+        throw std::invalid_argument("min_p must be in [0, 1)");
+    }
+    if (config.repetition_penalty <= 0.0f)
+    {
+        throw std::invalid_argument("repetition_penalty must be positive");
+    }
+
+    config_ = config;
+    rng_.seed(config.seed);
+}
+
+bool Sampler::is_greedy() const noexcept
+{
+    return config_.temperature <= 0.0f || config_.top_k == 1;
+}
+
+bool Sampler::has_penalties() const noexcept
+{
+    return config_.repetition_penalty != 1.0f || config_.frequency_penalty != 0.0f || config_.presence_penalty != 0.0f;
+}
+
+float Sampler::candidate_floor(float max_logit) const
+{
+    float floor = max_logit - config_.temperature * kLogitWindow;
+    if (config_.min_p > 0.0f)
+    {
+        // p / p_max >= min_p  <=>  logit >= max_logit + T * ln(min_p)
+        floor = std::max(floor, max_logit + config_.temperature * std::log(config_.min_p));
+    }
+    return floor;
+}
+
+void Sampler::apply_penalties(float *logits, int vocab_size, const int *history, std::size_t history_len)
+{
+    std::size_t start = 0;
+    if (config_.penalty_last_n > 0 && history_len > static_cast<std::size_t>(config_.penalty_last_n))
+    {
+        start = history_len - static_cast<std::size_t>(config_.penalty_last_n);
+    }
+
+    counts_.clear();
+    for (std::size_t i = start; i < history_len; ++i)
+    {
+        if (history[i] >= 0 && history[i] < vocab_size)
+            ++counts_[history[i]];
+    }
+
+    for (const auto &[token, count] : counts_)
+    {
+        float &logit = logits[token];
+        logit = logit > 0.0f ? logit / config_.repetition_penalty : logit * config_.repetition_penalty;
+        logit -= config_.frequency_penalty * static_cast<float>(count) + config_.presence_penalty;
+    }
+}
+
+int Sampler::sample(float *logits, int vocab_size, const int *history, std::size_t history_len)
+{
+    if (vocab_size <= 0)
+    {
+        throw std::invalid_argument("vocab_size must be positive");
+    }
+
+    if (has_penalties() && history_len > 0)
+    {
+        apply_penalties(logits, vocab_size, history, history_len);
+    }
+
+    const int best = argmax_avx2(logits, vocab_size);
+    if (is_greedy())
+    {
+        return best;
+    }
+
+    const int k = config_.top_k > 0 ? std::min(config_.top_k, vocab_size) : vocab_size;
+    if (candidates_.size() < static_cast<std::size_t>(k))
+    {
+        candidates_.resize(static_cast<std::size_t>(k));
+    }
+
+    const int count = select_topk_avx2(logits, vocab_size, k, candidate_floor(logits[best]), candidates_.data());
+    return sample_candidates(candidates_.data(), count);
+}
+
+int Sampler::sample_candidates(const TokenCandidate *candidates, int count)
+{
+    if (count <= 0)
+    {
+        throw std::invalid_argument("Sampler needs at least one candidate");
+    }
+    if (is_greedy())
+    {
+        return candidates[0].id;
+    }
+
+    const float total = candidate_weights(candidates, count);
+
+    std::uniform_real_distribution<float> dist(0.0f, total);
+    float r = dist(rng_);
+    for (int i = 0; i < count; ++i)
+    {
+        r -= weights_[i];
+        if (r <= 0.0f)
+            return candidates[i].id;
+    }
+    return candidates[count - 1].id;
+}
+
+float Sampler::candidate_weights(const TokenCandidate *candidates, int &count)
+{
+    if (config_.top_k > 0)
+    {
+        count = std::min(count, config_.top_k);
+    }
+
+    const float max_logit = candidates[0].logit;
+    const float floor = candidate_floor(max_logit);
+    const float inv_temperature = 1.0f / config_.temperature;
+
+    weights_.resize(static_cast<std::size_t>(count));
+    float total = 0.0f;
+    int kept = 0;
+    for (; kept < count && candidates[kept].logit >= floor; ++kept)
+    {
+        weights_[kept] = std::exp((candidates[kept].logit - max_logit) * inv_temperature);
+        total += weights_[kept];
+    }
+
+    // Nucleus cut over the descending candidates
+    if (config_.top_p < 1.0f)
+    {
+        const float target = config_.top_p * total;
+        float cumulative = 0.0f;
+        for (int i = 0; i < kept; ++i)
+        {
+            cumulative += weights_[i];
+            if (cumulative >= target)
+            {
+                kept = i + 1;
+                break;
+            }
+        }
+        total = cumulative;
+    }
+
+    count = kept;
+    return total;
+}
+
+void Sampler::probabilities(const float *logits, int vocab_size, float *probs)
+{
+    if (vocab_size <= 0)
+    {
+        throw std::invalid_argument("vocab_size must be positive");
+    }
+
+    std::fill(probs, probs + vocab_size, 0.0f);
+
+    const int best = argmax_avx2(logits, vocab_size);
+    if (is_greedy())
+    {
+        probs[best] = 1.0f;
+        return;
+    }
+
+    const int k = config_.top_k > 0 ? std::min(config_.top_k, vocab_size) : vocab_size;
+    if (candidates_.size() < static_cast<std::size_t>(k))
+    {
+        candidates_.resize(static_cast<std::size_t>(k));
+    }
+
+    int count = select_topk_avx2(logits, vocab_size, k, candidate_floor(logits[best]), candidates_.data());
+    const float inv_total = 1.0f / candidate_weights(candidates_.data(), count);
+    for (int i = 0; i < count; ++i)
+    {
+        probs[candidates_[i].id] = weights_[i] * inv_total;
+    }
+}
+
+int Sampler::sample_probabilities(const float *probs, int vocab_size)
+{
+    float total = 0.0f;
+    for (int i = 0; i < vocab_size; ++i)
+    {
+        total += probs[i];
+    }
+    if (!(total > 0.0f))
+    {
+        throw std::invalid_argument("Cannot sample from an all-zero distribution");
+    }
+
+    float r = uniform() * total;
+    int last_nonzero = 0;
+    for (int i = 0; i < vocab_size; ++i)
+    {
+        if (probs[i] > 0.0f)
+        {
+            last_nonzero = i;
+            r -= probs[i];
+            if (r < 0.0f)
+                return i;
+        }
+    }
+    return last_nonzero;
+}
+
+float Sampler::uniform()
+{
+    return std::uniform_real_distribution<float>(0.0f, 1.0f)(rng_);
+}
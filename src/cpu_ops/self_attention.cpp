@@ -1,6 +1,10 @@
 #include <cpu_ops/self_attention.h>
+#include <cpu_ops/numa.h>
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 SelfAttention::SelfAttention(
     Tensor &_q_proj_wt,
     Tensor &_k_proj_wt,
@@ -29,8 +33,15 @@ SelfAttention::SelfAttention(
     kvcache = _kvcache;
 
     rope = new RotaryEmbeddingAVX2(sin_cache.data<float>(), cos_cache.data<float>(), sin_cache.shape()[0], head_dim);
+    head_ops = head_kernels(static_cast<int>(head_dim));
+    head_norm = fixed_rmsnorm(static_cast<int>(head_dim));
 
     scale = 1.0f / std::sqrt(static_cast<float>(head_dim));
+
+    group_split = {0, num_groups};
+    q_split = {0, num_heads * head_dim};
+    kv_split = {0, num_groups * head_dim};
+    o_parts = {o_proj_wt.data<float>()};
 }
 
 SelfAttention::~SelfAttention()
@@ -57,14 +68,43 @@ void SelfAttention::prepare()
     k_norm_wt.prefetch_async();
 }
 
+void SelfAttention::place_weights(ThreadPool &pool)
+{
+    // Whole KV groups per domain, so attention never reads another domain's keys
+    const size_t heads_per_group = num_heads / num_groups;
+    group_split = numa_split(num_groups, pool, 1);
+    const size_t domains = group_split.size() - 1;
+    q_split.resize(domains + 1);
+    kv_split.resize(domains + 1);
+    for (size_t d = 0; d <= domains; ++d)
+    {
+        q_split[d] = group_split[d] * heads_per_group * head_dim;
+        kv_split[d] = group_split[d] * head_dim;
+    }
+
+    q_proj_wt = numa_place_rows(q_proj_wt, q_split, pool);
+    k_proj_wt = numa_place_rows(k_proj_wt, kv_split, pool);
+    v_proj_wt = numa_place_rows(v_proj_wt, kv_split, pool);
+
+    o_proj_parts.clear();
+    o_parts.clear();
+    for (size_t d = 0; d < domains; ++d)
+    {
+        o_proj_parts.push_back(numa_place_columns(o_proj_wt, q_split[d], q_split[d + 1], static_cast<int>(d), pool));
+        o_parts.push_back(o_proj_parts.back().data<float>());
+    }
+    o_proj_wt = Tensor();
+    o_partials.assign(domains * embed_dim, 0.0f);
+}
+
 void SelfAttention::run(Tensor &input, size_t token_idx, Tensor &output)
 {
-    linear_avx2_omp(input.data<float>(), q_proj_wt.data<float>(), 1, embed_dim, num_heads * head_dim, query.data());
-    linear_avx2_omp(input.data<float>(), k_proj_wt.data<float>(), 1, embed_dim, num_groups * head_dim, key.data());
-    linear_avx2_omp(input.data<float>(), v_proj_wt.data<float>(), 1, embed_dim, num_groups * head_dim, value.data());
+    linear_avx2_domains(input.data<float>(), q_proj_wt.data<float>(), 1, embed_dim, num_heads * head_dim, q_split, query.data());
+    linear_avx2_domains(input.data<float>(), k_proj_wt.data<float>(), 1, embed_dim, num_groups * head_dim, kv_split, key.data());
+    linear_avx2_domains(input.data<float>(), v_proj_wt.data<float>(), 1, embed_dim, num_groups * head_dim, kv_split, value.data());
 
-    rmsnorm_avx2(query.data(), q_norm_wt.data<float>(), query.data(), num_heads, head_dim, 0.000001);
-    rmsnorm_avx2(key.data(), k_norm_wt.data<float>(), key.data(), num_groups, head_dim, 0.000001);
+    rmsnorm_avx2(query.data(), q_norm_wt.data<float>(), query.data(), num_heads, head_dim, 0.000001, head_norm);
+    rmsnorm_avx2(key.data(), k_norm_wt.data<float>(), key.data(), num_groups, head_dim, 0.000001, head_norm);
 
     rope->rotate(query.data(), num_heads, head_dim, token_idx);
     rope->rotate(key.data(), num_groups, head_dim, token_idx);
@@ -82,7 +122,199 @@ void SelfAttention::run(Tensor &input, size_t token_idx, Tensor &output)
         head_dim,
         token_idx + 1,  // Current sequence length (including current token)
         kvcache->get_max_sequence_length(),
-        scale);
+        scale,
+        head_ops);
+
+    linear_avx2_column_split(query.data(), o_parts.data(), 1, num_heads * head_dim, embed_dim, q_split, output.data<float>());
+}
+
+int SelfAttention::add_to_graph(TaskGraph &graph, const float *input, size_t token_idx, float *output, int dep)
+{
+    const int K = static_cast<int>(embed_dim);
+    const int q_dim = static_cast<int>(num_heads * head_dim);
+    const int kv_dim = static_cast<int>(num_groups * head_dim);
+    const int A = static_cast<int>(num_heads);
+    const int G = static_cast<int>(num_groups);
+    const int h = static_cast<int>(head_dim);
+    const int N = static_cast<int>(token_idx + 1);
+    const int N_max = static_cast<int>(kvcache->get_max_sequence_length());
+    const int D = static_cast<int>(group_split.size()) - 1;
+    const size_t heads_per_group = num_heads / num_groups;
+
+    float *q = query.data();
+    float *k = key.data();
+    float *v = value.data();
+    float *partials = o_partials.data();
+    const float *wq = q_proj_wt.data<float>();
+    const float *wk = k_proj_wt.data<float>();
+    const float *wv = v_proj_wt.data<float>();
+    const float *q_norm = q_norm_wt.data<float>();
+    const float *k_norm = k_norm_wt.data<float>();
+    const RotaryEmbeddingAVX2 *rotary = rope;
+    KVCache *cache = kvcache;
+    const size_t layer = layer_idx;
+    const size_t position = kvcache->get_current_token_idx();
+    const float *key_memory = kvcache->get_key_memory_ptr(layer_idx);
+    const float *value_memory = kvcache->get_value_memory_ptr(layer_idx);
+    const float attn_scale = scale;
+
+    // The KV node runs on a pool thread, where set_key/set_value throwing would end the process, so
+    // its indices are checked here on the calling thread before any node runs
+    if (kvcache->get_num_groups() < num_groups)
+    {
+        throw std::out_of_range("Group index out of range: " + std::to_string(num_groups - 1));
+    }
+    if (position >= kvcache->get_max_sequence_length() || token_idx >= kvcache->get_max_sequence_length())
+    {
+        throw std::out_of_range("Token index out of range: " + std::to_string(std::max(position, token_idx)));
+    }
+    const HeadKernels *fixed_head = head_ops;
+    const FixedRmsNorm fixed_norm = head_norm;
+
+    int active = 0;
+    for (int d = 0; d < D; ++d)
+    {
+        active += group_split[d + 1] > group_split[d] ? 1 : 0;
+    }
+
+    // One chain per domain over its own KV groups; the chains only meet in the o_proj reduction
+    std::vector<int> o_nodes;
+    for (int d = 0; d < D; ++d)
+    {
+        const size_t g0 = group_split[d];
+        const size_t g1 = group_split[d + 1];
+        if (g0 == g1)
+        {
+            continue;
+        }
+        const int groups = static_cast<int>(g1 - g0);
+        const int q0 = static_cast<int>(q_split[d]);
+        const int width = static_cast<int>(q_split[d + 1]) - q0;
+        const float *wo = o_parts[d];
+        float *target = active > 1 ? partials + d * embed_dim : output;
+
+        // The three projections only share their input, so their chunks interleave freely
+        const int q_node = graph.add(numa_domain_bounds(d, q_split[d], q_split[d + 1], D), linear_cost(1, K), [=](size_t begin, size_t end)
+        {
+            linear_avx2_range(input, wq, 1, K, q_dim, static_cast<int>(begin), static_cast<int>(end), q);
+        }, {dep});
+        const int k_node = graph.add(numa_domain_bounds(d, kv_split[d], kv_split[d + 1], D), linear_cost(1, K), [=](size_t begin, size_t end)
+        {
+            linear_avx2_range(input, wk, 1, K, kv_dim, static_cast<int>(begin), static_cast<int>(end), k);
+        }, {dep});
+        const int v_node = graph.add(numa_domain_bounds(d, kv_split[d], kv_split[d + 1], D), linear_cost(1, K), [=](size_t begin, size_t end)
+        {
+            linear_avx2_range(input, wv, 1, K, kv_dim, static_cast<int>(begin), static_cast<int>(end), v);
+        }, {dep});
+
+        const int kv_node = graph.add(numa_domain_bounds(d, 0, 1, D), 1, [=](size_t, size_t)
+        {
+            float *keys = k + g0 * h;
+            rmsnorm_avx2(keys, k_norm, keys, groups, h, 0.000001, fixed_norm);
+            rotary->rotate(keys, groups, h, static_cast<int>(token_idx));
+            for (size_t g = g0; g < g1; ++g)
+            {
+                cache->set_key(layer, g, position, k + g * h);
+                cache->set_value(layer, g, position, v + g * h);
+            }
+        }, {k_node, v_node});
+
+        // Each head chunk normalizes and rotates its own queries, then attends in place
+        const int attn_node = graph.add(numa_domain_bounds(d, g0 * heads_per_group, g1 * heads_per_group, D), gqa_head_cost(N, h),
+                                        [=](size_t begin, size_t end)
+        {
+            const int count = static_cast<int>(end - begin);
+            float *heads = q + begin * h;
+            rmsnorm_avx2(heads, q_norm, heads, count, h, 0.000001, fixed_norm);
+            rotary->rotate(heads, count, h, static_cast<int>(token_idx));
+            gqa_forward_heads(q, key_memory, value_memory, q, A, G, h, N, N_max, attn_scale,
+                              static_cast<int>(begin), static_cast<int>(end), fixed_head);
+        }, {q_node, kv_node});
+
+        // This domain's heads times its o_proj columns: a partial sum of every output feature
+        o_nodes.push_back(graph.add(numa_domain_bounds(d, 0, embed_dim, D), linear_cost(1, width), [=](size_t begin, size_t end)
+        {
+            linear_avx2_range(q + q0, wo, 1, width, K, static_cast<int>(begin), static_cast<int>(end), target);
+        }, {attn_node}));
+    }
+
+    if (active == 1)
+    {
+        return o_nodes.front();
+    }
+    return graph.add(embed_dim, WorkCost{4.0 * (D + 1), static_cast<double>(D)}, [=](size_t begin, size_t end)
+    {
+        for (size_t j = begin; j < end; ++j)
+        {
+            float sum = 0.0f;
+            for (int d = 0; d < D; ++d)
+                sum += partials[d * K + j];
+            output[j] = sum;
+        }
+    }, o_nodes);
+}
+
+void SelfAttention::run_batch(Tensor &input, const AttentionRow *rows, size_t M, Tensor &output)
+{
+    const size_t q_dim = num_heads * head_dim;
+    const size_t kv_dim = num_groups * head_dim;
+
+    if (query.size() < M * q_dim)
+        query.resize(M * q_dim);
+    if (key.size() < M * kv_dim)
+        key.resize(M * kv_dim);
+    if (value.size() < M * kv_dim)
+        value.resize(M * kv_dim);
+
+    linear_avx2_domains(input.data<float>(), q_proj_wt.data<float>(), M, embed_dim, q_dim, q_split, query.data());
+    linear_avx2_domains(input.data<float>(), k_proj_wt.data<float>(), M, embed_dim, kv_dim, kv_split, key.data());
+    linear_avx2_domains(input.data<float>(), v_proj_wt.data<float>(), M, embed_dim, kv_dim, kv_split, value.data());
+
+    rmsnorm_avx2(query.data(), q_norm_wt.data<float>(), query.data(), M * num_heads, head_dim, 0.000001, head_norm);
+    rmsnorm_avx2(key.data(), k_norm_wt.data<float>(), key.data(), M * num_groups, head_dim, 0.000001, head_norm);
+
+    // Write every row's K/V first so later rows of the same sequence can attend to earlier ones
+    for (size_t r = 0; r < M; ++r)
+    {
+        rope->rotate(query.data() + r * q_dim, num_heads, head_dim, rows[r].token_idx);
+        rope->rotate(key.data() + r * kv_dim, num_groups, head_dim, rows[r].token_idx);
+
+        for (size_t g = 0; g < num_groups; ++g)
+        {
+            rows[r].kvcache->set_key(layer_idx, g, rows[r].token_idx, key.data() + r * kv_dim + g * head_dim);
+            rows[r].kvcache->set_value(layer_idx, g, rows[r].token_idx, value.data() + r * kv_dim + g * head_dim);
+        }
+    }
+
+    // Causal: row r only sees positions <= its own token_idx. One ragged call covers every row,
+    // so threads are balanced by context length across sequences.
+    row_keys.resize(M);
+    row_values.resize(M);
+    row_lens.resize(M);
+    row_strides.resize(M);
+    for (size_t r = 0; r < M; ++r)
+    {
+        const KVCache *cache = rows[r].kvcache;
+        row_keys[r] = cache->get_key_memory_ptr(layer_idx);
+        row_values[r] = cache->get_value_memory_ptr(layer_idx);
+        row_lens[r] = static_cast<int>(rows[r].token_idx + 1);
+        row_strides[r] = static_cast<int>(cache->get_max_sequence_length());
+    }
+
+    ragged_gqa_forward(
+        query.data(),
+        row_keys.data(),
+        row_values.data(),
+        query.data(),
+        row_lens.data(),
+        row_strides.data(),
+        static_cast<int>(M),
+        static_cast<int>(num_heads),
+        static_cast<int>(num_groups),
+        static_cast<int>(head_dim),
+        scale,
+        256, // KV positions per work item
+        head_ops);
 
-    linear_avx2_omp(query.data(), o_proj_wt.data<float>(), 1, num_heads * head_dim, embed_dim, output.data<float>());
+    linear_avx2_column_split(query.data(), o_parts.data(), M, q_dim, embed_dim, q_split, output.data<float>());
 }
\ No newline at end of file
@@ -0,0 +1,367 @@
+#include <cpu_ops/task_graph.h>
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+void TaskGraph::WorkDeque::reset(long new_capacity)
+{
+    if (new_capacity > capacity)
+    {
+        buffer.reset(new std::atomic<int>[new_capacity]);
+        capacity = new_capacity;
+    }
+    top.store(0, std::memory_order_relaxed);
+    bottom.store(0, std::memory_order_relaxed);
+}
+
+void TaskGraph::WorkDeque::push(int chunk)
+{
+    const long b = bottom.load(std::memory_order_relaxed);
+    buffer[b].store(chunk, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_release);
+}
+
+int TaskGraph::WorkDeque::take()
+{
+    const long b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    long t = top.load(std::memory_order_relaxed);
+
+    if (t > b)
+    {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return -1;
+    }
+
+    int chunk = buffer[b].load(std::memory_order_relaxed);
+    if (t == b)
+    {
+        // Last entry: race any thief for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            chunk = -1;
+        }
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return chunk;
+}
+
+int TaskGraph::WorkDeque::steal()
+{
+    long t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const long b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+    {
+        return -1;
+    }
+
+    const int chunk = buffer[t].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    {
+        return -1;
+    }
+    return chunk;
+}
+
+int TaskGraph::add_node(Node node, const std::vector<int> &deps)
+{
+    const int id = static_cast<int>(nodes_.size());
+    for (int dep : deps)
+    {
+        if (dep < 0 || dep >= id)
+        {
+            throw std::invalid_argument("TaskGraph dependencies must be added before their dependents");
+        }
+    }
+
+    node.num_deps = static_cast<int>(deps.size());
+    for (int dep : deps)
+    {
+        nodes_[dep].successors.push_back(id);
+    }
+    chunk_node_.resize(chunk_begin_.size(), id);
+    nodes_.push_back(std::move(node));
+    return id;
+}
+
+void TaskGraph::add_chunks(std::size_t begin, std::size_t end, std::size_t grain)
+{
+    for (; begin < end; begin += grain)
+    {
+        chunk_begin_.push_back(begin);
+        chunk_end_.push_back(begin + grain < end ? begin + grain : end);
+    }
+}
+
+int TaskGraph::add(std::size_t size, std::size_t grain, Body body, const std::vector<int> &deps)
+{
+    Node node;
+    node.body = std::move(body);
+    node.first_chunk = static_cast<int>(chunk_begin_.size());
+    add_chunks(0, size, grain > 0 ? grain : 1);
+    // An empty range still gets one (empty) chunk so its dependents are released
+    if (size == 0)
+    {
+        chunk_begin_.push_back(0);
+        chunk_end_.push_back(0);
+    }
+    node.num_chunks = static_cast<int>(chunk_begin_.size()) - node.first_chunk;
+    return add_node(std::move(node), deps);
+}
+
+int TaskGraph::add(std::size_t size, const WorkCost &cost, Body body, const std::vector<int> &deps)
+{
+    return add(size, CostModel::instance().plan(size, cost).grain, std::move(body), deps);
+}
+
+int TaskGraph::add(std::function<void()> body, const std::vector<int> &deps)
+{
+    return add(1, 1, [body](std::size_t, std::size_t) { body(); }, deps);
+}
+
+int TaskGraph::add(const std::vector<std::size_t> &bounds, std::size_t grain, Body body, const std::vector<int> &deps)
+{
+    if (bounds.size() < 2 || !std::is_sorted(bounds.begin(), bounds.end()))
+    {
+        throw std::invalid_argument("TaskGraph domain bounds must be ascending with at least one range");
+    }
+    if (bounds.front() == bounds.back())
+    {
+        return add(0, 1, std::move(body), deps);
+    }
+
+    Node node;
+    node.body = std::move(body);
+    node.first_chunk = static_cast<int>(chunk_begin_.size());
+    for (std::size_t d = 0; d + 1 < bounds.size(); ++d)
+    {
+        node.domain_chunks.push_back(static_cast<int>(chunk_begin_.size()) - node.first_chunk);
+        add_chunks(bounds[d], bounds[d + 1], grain > 0 ? grain : 1);
+    }
+    node.num_chunks = static_cast<int>(chunk_begin_.size()) - node.first_chunk;
+    node.domain_chunks.push_back(node.num_chunks);
+    return add_node(std::move(node), deps);
+}
+
+int TaskGraph::add(const std::vector<std::size_t> &bounds, const WorkCost &cost, Body body, const std::vector<int> &deps)
+{
+    const std::size_t size = bounds.empty() ? 0 : bounds.back() - bounds.front();
+    return add(bounds, CostModel::instance().plan(size, cost).grain, std::move(body), deps);
+}
+
+void TaskGraph::clear()
+{
+    nodes_.clear();
+    chunk_node_.clear();
+    chunk_begin_.clear();
+    chunk_end_.clear();
+}
+
+void TaskGraph::run(ThreadPool &pool)
+{
+    if (nodes_.empty())
+    {
+        return;
+    }
+
+    const int num_threads = pool.num_threads();
+    if (num_deques_ < num_threads)
+    {
+        deques_.reset(new WorkDeque[num_threads]);
+        num_deques_ = num_threads;
+    }
+    const long total_chunks = static_cast<long>(chunk_node_.size());
+    for (int t = 0; t < num_deques_; ++t)
+    {
+        deques_[t].reset(total_chunks);
+    }
+
+    if (state_capacity_ < nodes_.size())
+    {
+        pending_deps_.reset(new std::atomic<int>[nodes_.size()]);
+        pending_chunks_.reset(new std::atomic<int>[nodes_.size()]);
+        state_capacity_ = nodes_.size();
+    }
+    for (std::size_t i = 0; i < nodes_.size(); ++i)
+    {
+        pending_deps_[i].store(nodes_[i].num_deps, std::memory_order_relaxed);
+        pending_chunks_[i].store(nodes_[i].num_chunks, std::memory_order_relaxed);
+    }
+    nodes_left_.store(static_cast<int>(nodes_.size()), std::memory_order_relaxed);
+
+    // Split nodes keep to their domains only if they were split for this pool's domains
+    num_domains_ = 0;
+    for (const Node &node : nodes_)
+    {
+        if (pool.num_domains() > 1 && static_cast<int>(node.domain_chunks.size()) == pool.num_domains() + 1)
+        {
+            num_domains_ = pool.num_domains();
+        }
+    }
+    if (num_domains_ > 0)
+    {
+        const std::size_t slots = nodes_.size() * num_domains_;
+        if (domain_capacity_ < slots)
+        {
+            domain_ready_.reset(new std::atomic<int>[slots]);
+            domain_next_.reset(new std::atomic<int>[slots]);
+            domain_count_.reset(new std::atomic<int>[slots]);
+            domain_capacity_ = slots;
+        }
+        for (std::size_t i = 0; i < slots; ++i)
+        {
+            domain_ready_[i].store(-1, std::memory_order_relaxed);
+            domain_next_[i].store(0, std::memory_order_relaxed);
+        }
+        for (int d = 0; d < num_domains_; ++d)
+        {
+            domain_count_[d].store(0, std::memory_order_relaxed);
+        }
+        pool_threads_ = num_threads;
+        thread_domain_.resize(num_threads);
+        for (int t = 0; t < num_threads; ++t)
+        {
+            thread_domain_[t] = pool.thread_domain(t);
+        }
+    }
+
+    // Roots start on the calling thread's deque; the others steal them from there
+    for (std::size_t i = 0; i < nodes_.size(); ++i)
+    {
+        if (nodes_[i].num_deps == 0)
+        {
+            make_ready(static_cast<int>(i), deques_[0]);
+        }
+    }
+
+    // Every domain needs its threads, however few chunks there are
+    const int max_threads = total_chunks < num_threads && num_domains_ == 0 ? static_cast<int>(total_chunks) : num_threads;
+    pool.parallel_run([this](int t, int n) { worker(t, n); }, max_threads);
+}
+
+void TaskGraph::make_ready(int node, WorkDeque &deque)
+{
+    const Node &n = nodes_[node];
+    if (num_domains_ > 0 && static_cast<int>(n.domain_chunks.size()) == num_domains_ + 1)
+    {
+        for (int d = 0; d < num_domains_; ++d)
+        {
+            if (n.domain_chunks[d + 1] > n.domain_chunks[d])
+            {
+                const int slot = domain_count_[d].fetch_add(1, std::memory_order_relaxed);
+                domain_ready_[static_cast<std::size_t>(d) * nodes_.size() + slot].store(node, std::memory_order_release);
+            }
+        }
+        return;
+    }
+
+    // Pushed last-to-first so the owner takes chunk 0 first and thieves take the far end
+    for (int c = n.num_chunks - 1; c >= 0; --c)
+    {
+        deque.push(n.first_chunk + c);
+    }
+}
+
+void TaskGraph::execute(int chunk, WorkDeque &deque)
+{
+    const int id = chunk_node_[chunk];
+    Node &node = nodes_[id];
+
+    if (chunk_begin_[chunk] < chunk_end_[chunk])
+    {
+        node.body(chunk_begin_[chunk], chunk_end_[chunk]);
+    }
+
+    if (pending_chunks_[id].fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        // Release dependents before counting the node done, so no thread sees an empty graph early
+        for (int successor : node.successors)
+        {
+            if (pending_deps_[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                make_ready(successor, deque);
+            }
+        }
+        nodes_left_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void TaskGraph::worker(int thread_index, int num_threads)
+{
+    WorkDeque &own = deques_[thread_index];
+    unsigned idle = 0;
+
+    // Split chunks stay in their domain unless some domain may have no thread in this run
+    const bool domain_local = num_domains_ > 0 && num_threads == pool_threads_;
+    std::vector<int> cursors(num_domains_, 0);
+
+    while (nodes_left_.load(std::memory_order_acquire) > 0)
+    {
+        int chunk = own.take();
+        if (chunk < 0 && domain_local)
+        {
+            const int domain = thread_domain_[thread_index];
+            chunk = claim_domain_chunk(domain, cursors[domain]);
+        }
+        for (int d = 0; chunk < 0 && !domain_local && d < num_domains_; ++d)
+        {
+            chunk = claim_domain_chunk(d, cursors[d]);
+        }
+        for (int i = 1; chunk < 0 && i < num_threads; ++i)
+        {
+            chunk = deques_[(thread_index + i) % num_threads].steal();
+        }
+
+        if (chunk >= 0)
+        {
+            execute(chunk, own);
+            idle = 0;
+        }
+        else if (++idle < 1024)
+        {
+            _mm_pause();
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+int TaskGraph::claim_domain_chunk(int domain, int &cursor)
+{
+    const std::size_t list = static_cast<std::size_t>(domain) * nodes_.size();
+    const int count = domain_count_[domain].load(std::memory_order_acquire);
+    for (int i = cursor; i < count; ++i)
+    {
+        const int id = domain_ready_[list + i].load(std::memory_order_acquire);
+        if (id < 0)
+        {
+            break; // reserved but not yet published
+        }
+
+        const Node &node = nodes_[id];
+        const int chunks = node.domain_chunks[domain + 1] - node.domain_chunks[domain];
+        std::atomic<int> &next = domain_next_[static_cast<std::size_t>(id) * num_domains_ + domain];
+        if (next.load(std::memory_order_relaxed) < chunks)
+        {
+            const int c = next.fetch_add(1, std::memory_order_relaxed);
+            if (c < chunks)
+            {
+                return node.first_chunk + node.domain_chunks[domain] + c;
+            }
+        }
+        // Skip fully claimed nodes at the front on later calls
+        if (i == cursor)
+        {
+            ++cursor;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,466 @@
+#include <cpu_ops/thread_pool.h>
+#include <cpu_ops/cpu_topology.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// Set on pool workers and on the caller while it runs its share, so nested calls run inline
+thread_local bool in_pool_task = false;
+
+// Pool bound by the innermost ThreadPool::Scope on this thread
+thread_local ThreadPool *scoped_pool = nullptr;
+
+void futex_wait(std::atomic<std::uint32_t> *word, std::uint32_t expected)
+{
+#if defined(_WIN32)
+    WaitOnAddress(reinterpret_cast<volatile VOID *>(word), &expected, sizeof(expected), INFINITE);
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)expected;
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+#endif
+}
+
+void futex_wake(std::atomic<std::uint32_t> *word)
+{
+#if defined(_WIN32)
+    WakeByAddressSingle(reinterpret_cast<PVOID>(word));
+#elif defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+int env_int(const char *name, int fallback)
+{
+    const char *value = std::getenv(name);
+    return value != nullptr && *value != '\0' ? std::atoi(value) : fallback;
+}
+
+// A CPU list (or the process mask when empty) restricted to what the process may run on
+std::vector<int> allowed_cpus(const std::string &list)
+{
+    std::vector<int> cpus = process_cpus();
+    if (list.empty())
+    {
+        return cpus;
+    }
+
+    const std::vector<int> requested = parse_cpu_list(list);
+    std::vector<int> allowed;
+    std::set_intersection(requested.begin(), requested.end(), cpus.begin(), cpus.end(), std::back_inserter(allowed));
+    if (allowed.empty())
+    {
+        throw std::invalid_argument("ThreadPool: none of the CPUs '" + list + "' is available to the process");
+    }
+    return allowed;
+}
+
+// "0-7;8-15" -> {"0-7", "8-15"}
+std::vector<std::string> cpu_groups(const std::string &cpus)
+{
+    std::vector<std::string> groups;
+    for (std::size_t begin = 0;;)
+    {
+        const std::size_t end = cpus.find(';', begin);
+        groups.push_back(cpus.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+        if (end == std::string::npos)
+            return groups;
+        begin = end + 1;
+    }
+}
+
+// CPUs in the order threads are pinned to them, and the NUMA domain of each
+struct ThreadPlacement
+{
+    std::vector<int> cpus;
+    std::vector<int> domains;
+    int cores = 0;
+};
+
+ThreadPlacement place_threads(const ThreadPoolConfig &config)
+{
+    const CpuTopology &topology = CpuTopology::instance();
+    ThreadPlacement result;
+
+    const std::vector<std::string> groups = cpu_groups(config.cpus);
+    if (groups.size() == 1)
+    {
+        // Domains are the topology's NUMA nodes, numbered in order of first use
+        const std::vector<int> allowed = allowed_cpus(config.cpus);
+        result.cpus = topology.placement(allowed);
+        result.cores = topology.num_cores(allowed);
+        std::vector<int> nodes;
+        for (int cpu : result.cpus)
+        {
+            const LogicalCpu *info = topology.find(cpu);
+            const int node = info ? info->node : 0;
+            auto it = std::find(nodes.begin(), nodes.end(), node);
+            result.domains.push_back(static_cast<int>(it - nodes.begin()));
+            if (it == nodes.end())
+                nodes.push_back(node);
+        }
+        return result;
+    }
+
+    // Every ';'-separated group is a domain of its own. Primaries of all groups come first, then
+    // siblings, each taken round-robin over the groups like placement() alternates nodes.
+    std::vector<std::vector<int>> orders;
+    std::vector<int> cores;
+    for (const std::string &group : groups)
+    {
+        const std::vector<int> allowed = allowed_cpus(group);
+        orders.push_back(topology.placement(allowed));
+        cores.push_back(topology.num_cores(allowed));
+        result.cores += cores.back();
+    }
+    for (int siblings = 0; siblings < 2; ++siblings)
+    {
+        for (std::size_t i = 0;; ++i)
+        {
+            bool any = false;
+            for (std::size_t g = 0; g < orders.size(); ++g)
+            {
+                const std::size_t begin = siblings ? static_cast<std::size_t>(cores[g]) : 0;
+                const std::size_t end = siblings ? orders[g].size() : static_cast<std::size_t>(cores[g]);
+                if (begin + i < end)
+                {
+                    result.cpus.push_back(orders[g][begin + i]);
+                    result.domains.push_back(static_cast<int>(g));
+                    any = true;
+                }
+            }
+            if (!any)
+                break;
+        }
+    }
+    return result;
+}
+
+struct SharedPoolConfig
+{
+    std::mutex mutex;
+    ThreadPoolConfig config;
+    bool started = false;
+};
+
+SharedPoolConfig &shared_pool_config()
+{
+    static SharedPoolConfig shared;
+    return shared;
+}
+
+ThreadPoolConfig start_shared_pool()
+{
+    SharedPoolConfig &shared = shared_pool_config();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    shared.started = true;
+
+    ThreadPoolConfig config = shared.config;
+    config.num_threads = env_int("MINMAX_NUM_THREADS", env_int("OMP_NUM_THREADS", config.num_threads));
+    config.pin_threads = env_int("MINMAX_PIN_THREADS", config.pin_threads ? 1 : 0) != 0;
+    config.use_smt = env_int("MINMAX_USE_SMT", config.use_smt ? 1 : 0) != 0;
+    if (const char *cpus = std::getenv("MINMAX_CPUS"))
+    {
+        config.cpus = cpus;
+    }
+    return config;
+}
+
+ThreadPoolConfig legacy_config(int num_threads, bool pin_threads, int spin_us)
+{
+    ThreadPoolConfig config;
+    config.num_threads = num_threads;
+    config.pin_threads = pin_threads;
+    config.use_smt = true;
+    config.spin_us = spin_us;
+    return config;
+}
+} // namespace
+
+ThreadPool::ThreadPool(const ThreadPoolConfig &config)
+    : num_domains_(1),
+      spin_us_(config.spin_us),
+      remaining_(0),
+      stop_(false),
+      task_(nullptr),
+      context_(nullptr),
+      active_(0)
+{
+    const ThreadPlacement placement = place_threads(config);
+
+    int num_threads = config.num_threads;
+    if (num_threads <= 0)
+    {
+        num_threads = config.use_smt ? static_cast<int>(placement.cpus.size()) : placement.cores;
+    }
+
+    // An oversubscribed pool is left to the scheduler, and so has no NUMA domains
+    domains_.assign(num_threads, 0);
+    if (config.pin_threads && num_threads <= static_cast<int>(placement.cpus.size()))
+    {
+        cpus_.assign(placement.cpus.begin(), placement.cpus.begin() + num_threads);
+        domains_.assign(placement.domains.begin(), placement.domains.begin() + num_threads);
+    }
+    num_domains_ = *std::max_element(domains_.begin(), domains_.end()) + 1;
+    domain_threads_.assign(num_domains_, 0);
+    for (int domain : domains_)
+    {
+        ++domain_threads_[domain];
+    }
+
+    const int num_workers = num_threads - 1;
+    slots_.reset(new Slot[num_workers > 0 ? num_workers : 1]);
+    workers_.reserve(num_workers);
+    for (int i = 0; i < num_workers; ++i)
+    {
+        // Worker i is thread i + 1; the first CPU stays with the caller
+        workers_.emplace_back(&ThreadPool::worker_loop, this, i, cpus_.empty() ? -1 : cpus_[i + 1]);
+    }
+}
+
+ThreadPool::ThreadPool(int num_threads, bool pin_threads, int spin_us)
+    : ThreadPool(legacy_config(num_threads, pin_threads, spin_us))
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+    stop_.store(true, std::memory_order_release);
+    for (std::size_t i = 0; i < workers_.size(); ++i)
+    {
+        slots_[i].sequence.fetch_add(1, std::memory_order_seq_cst);
+        futex_wake(&slots_[i].sequence);
+    }
+    for (std::thread &worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::instance()
+{
+    static ThreadPool pool(start_shared_pool());
+    return pool;
+}
+
+ThreadPool &ThreadPool::current()
+{
+    return scoped_pool ? *scoped_pool : instance();
+}
+
+ThreadPool::Scope::Scope(ThreadPool &pool) : previous_(scoped_pool)
+{
+    scoped_pool = &pool;
+}
+
+ThreadPool::Scope::~Scope()
+{
+    scoped_pool = previous_;
+}
+
+bool ThreadPool::configure(const ThreadPoolConfig &config)
+{
+    // Reject a bad list here rather than at first use
+    if (!config.cpus.empty())
+    {
+        for (const std::string &group : cpu_groups(config.cpus))
+        {
+            parse_cpu_list(group);
+        }
+    }
+
+    SharedPoolConfig &shared = shared_pool_config();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    if (shared.started)
+    {
+        return false;
+    }
+    shared.config = config;
+    return true;
+}
+
+std::vector<int> ThreadPool::spare_cpus() const
+{
+    std::vector<int> spare;
+    if (cpus_.empty())
+    {
+        return spare;
+    }
+    std::vector<int> used(cpus_);
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
+    const std::vector<int> all = process_cpus();
+    std::set_difference(all.begin(), all.end(), used.begin(), used.end(), std::back_inserter(spare));
+    return spare;
+}
+
+bool ThreadPool::pin_caller() const
+{
+    if (cpus_.empty())
+    {
+        return false;
+    }
+    // Pinning is a syscall; a thread that already sits on this CPU skips it
+    thread_local int pinned_cpu = -1;
+    if (pinned_cpu == cpus_[0])
+    {
+        return true;
+    }
+    if (!pin_current_thread(cpus_[0]))
+    {
+        return false;
+    }
+    pinned_cpu = cpus_[0];
+    return true;
+}
+
+void ThreadPool::run(Task task, void *context, int max_threads)
+{
+    int n = num_threads();
+    if (max_threads > 0 && max_threads < n)
+    {
+        n = max_threads;
+    }
+
+    if (n <= 1 || in_pool_task || !owner_.try_lock())
+    {
+        task(context, 0, 1);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(owner_, std::adopt_lock);
+
+    task_ = task;
+    context_ = context;
+    active_ = n;
+    remaining_.store(n - 1, std::memory_order_relaxed);
+
+    // seq_cst pairs with the worker's sleeping flag: either it sees the new sequence before it
+    // parks, or we see it parked and wake it
+    for (int i = 0; i < n - 1; ++i)
+    {
+        Slot &slot = slots_[i];
+        slot.sequence.fetch_add(1, std::memory_order_seq_cst);
+        if (slot.sleeping.load(std::memory_order_seq_cst) != 0)
+        {
+            futex_wake(&slot.sequence);
+        }
+    }
+
+    auto wait_for_workers = [this]
+    {
+        unsigned spins = 0;
+        while (remaining_.load(std::memory_order_acquire) != 0)
+        {
+            // Past a short spin, give the CPU to the workers in case they share it
+            if (++spins < 4096)
+            {
+                _mm_pause();
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    };
+
+    in_pool_task = true;
+    try
+    {
+        task(context, 0, n);
+    }
+    catch (...)
+    {
+        // Workers still use the caller's context; let them finish before unwinding
+        in_pool_task = false;
+        wait_for_workers();
+        error_ = nullptr;
+        throw;
+    }
+    in_pool_task = false;
+    wait_for_workers();
+
+    // remaining_ reached zero after every worker stored its exception, so no lock is needed
+    if (error_)
+    {
+        std::exception_ptr error = std::move(error_);
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::worker_loop(int index, int cpu)
+{
+    if (cpu >= 0)
+    {
+        pin_current_thread(cpu);
+    }
+    in_pool_task = true;
+
+    Slot &slot = slots_[index];
+    std::uint32_t seen = 0;
+    const auto spin_budget = std::chrono::microseconds(spin_us_);
+
+    while (true)
+    {
+        std::uint32_t current;
+        unsigned spins = 0;
+        auto spin_start = Clock::now();
+        while ((current = slot.sequence.load(std::memory_order_acquire)) == seen)
+        {
+            _mm_pause();
+            if ((++spins & 255) == 0 && Clock::now() - spin_start > spin_budget)
+            {
+                slot.sleeping.store(1, std::memory_order_seq_cst);
+                if (slot.sequence.load(std::memory_order_seq_cst) == seen)
+                {
+                    futex_wait(&slot.sequence, seen);
+                }
+                slot.sleeping.store(0, std::memory_order_relaxed);
+                spin_start = Clock::now();
+            }
+        }
+        seen = current;
+
+        if (stop_.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        try
+        {
+            task_(context_, index + 1, active_);
+        }
+        catch (...)
+        {
+            // Kept for run() to rethrow; letting it leave the thread would end the process
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            if (!error_)
+            {
+                error_ = std::current_exception();
+            }
+        }
+        remaining_.fetch_sub(1, std::memory_order_release);
+    }
+}
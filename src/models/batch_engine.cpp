@@ -0,0 +1,435 @@
+#include <models/batch_engine.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+
+BatchEngine::BatchEngine(Qwen3Model &model, const BatchEngineConfig &config)
+    : model_(model),
+      config_(config),
+      next_id_(0)
+{
+    if (config.max_batch_size == 0)
+    {
+        throw std::invalid_argument("max_batch_size must be positive");
+    }
+    if (config.max_sequence_length < 2 ||
+        config.max_sequence_length > static_cast<std::size_t>(model.config().max_position_embeddings))
+    {
+        throw std::invalid_argument("max_sequence_length must be in [2, max_position_embeddings]");
+    }
+    // Every decoding sequence needs its row, and prompts need room to make progress
+    if (config.max_tokens_per_step <= config.max_batch_size)
+    {
+        throw std::invalid_argument("max_tokens_per_step must exceed max_batch_size");
+    }
+    if (config.max_prefill_chunk == 0)
+    {
+        throw std::invalid_argument("max_prefill_chunk must be positive");
+    }
+    // A single sequence must always fit, otherwise nothing could make progress
+    if (config.max_kv_tokens > 0 && config.max_kv_tokens < config.max_sequence_length)
+    {
+        throw std::invalid_argument("max_kv_tokens must be 0 or at least max_sequence_length");
+    }
+    if (!config.swap_path.empty())
+    {
+        swap_ = std::make_unique<KVSwapFile>(config.swap_path);
+    }
+    active_.reserve(config.max_batch_size);
+}
+
+int BatchEngine::submit(const GenerationRequest &request)
+{
+    if (request.prompt.empty())
+    {
+        throw std::invalid_argument("Generation request needs a non-empty prompt");
+    }
+    if (request.max_new_tokens == 0)
+    {
+        throw std::invalid_argument("max_new_tokens must be positive");
+    }
+    // The cache keeps at most max_sequence_length - 1 tokens
+    if (request.prompt.size() >= config_.max_sequence_length)
+    {
+        throw std::invalid_argument("Prompt does not fit in max_sequence_length");
+    }
+    for (int token : request.prompt)
+    {
+        if (token < 0 || token >= model_.config().vocab_size)
+        {
+            throw std::out_of_range("Prompt token id out of vocabulary range");
+        }
+    }
+
+    Sequence sequence;
+    sequence.id = next_id_++;
+    sequence.request = request;
+    sequence.sampler.set_config(request.sampler);
+    sequence.history = request.prompt;
+    sequence.submitted = Clock::now();
+    queue_.push_back(std::move(sequence));
+    return queue_.back().id;
+}
+
+std::vector<StepToken> BatchEngine::step()
+{
+    std::vector<StepToken> produced;
+
+    admit();
+    if (swap_)
+    {
+        enforce_kv_budget();
+    }
+    schedule();
+    if (slices_.empty())
+    {
+        return produced;
+    }
+
+    const auto step_start = Clock::now();
+    const std::vector<float> &logits = model_.forward_rows(
+        step_tokens_.data(), step_rows_.data(), step_tokens_.size(), logit_rows_.data(), logit_rows_.size());
+
+    const std::size_t vocab_size = static_cast<std::size_t>(model_.config().vocab_size);
+    const int eos_token_id = model_.config().eos_token_id;
+    std::vector<bool> finished(active_.size(), false);
+    std::size_t logit_index = 0;
+
+    for (const Slice &slice : slices_)
+    {
+        Sequence &sequence = active_[slice.sequence];
+        const bool was_decoding = sequence.decoding();
+
+        sequence.cache->advance(slice.rows);
+        if (was_decoding)
+        {
+            ++stats_.decode_rows;
+        }
+        else
+        {
+            sequence.prefilled += slice.rows;
+            stats_.prefill_rows += slice.rows;
+            stats_.prompt_tokens += slice.rows;
+        }
+
+        if (!slice.sample)
+        {
+            continue;
+        }
+
+        // Penalties rewrite logits in place, so each sequence samples from its own copy
+        const auto row = logits.begin() + logit_index++ * vocab_size;
+        row_logits_.assign(row, row + vocab_size);
+        const int token = sequence.sampler.sample(row_logits_.data(), static_cast<int>(vocab_size),
+                                                  sequence.history.data(), sequence.history.size());
+
+        if (sequence.generated == 0)
+        {
+            ++stats_.first_tokens;
+            stats_.time_to_first_token_ms += std::chrono::duration<double, std::milli>(Clock::now() - sequence.submitted).count();
+        }
+
+        sequence.history.push_back(token);
+        sequence.pending = token;
+        ++sequence.generated;
+        ++stats_.generated_tokens;
+
+        finished[slice.sequence] = token == eos_token_id ||
+                                   sequence.generated >= sequence.request.max_new_tokens ||
+                                   sequence.cache->get_remaining_tokens() <= 1;
+        produced.push_back({sequence.id, token, finished[slice.sequence]});
+    }
+
+    ++stats_.steps;
+    stats_.max_step_ms = std::max(stats_.max_step_ms, std::chrono::duration<double, std::milli>(Clock::now() - step_start).count());
+
+    // Finished sequences leave the batch; their caches go back to the pool
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < active_.size(); ++i)
+    {
+        if (finished[i])
+        {
+            release(active_[i]);
+        }
+        else
+        {
+            if (kept != i)
+            {
+                active_[kept] = std::move(active_[i]);
+            }
+            ++kept;
+        }
+    }
+    active_.resize(kept);
+
+    return produced;
+}
+
+bool BatchEngine::cancel(int sequence_id)
+{
+    auto matches = [sequence_id](const Sequence &sequence) { return sequence.id == sequence_id; };
+
+    auto queued = std::find_if(queue_.begin(), queue_.end(), matches);
+    if (queued != queue_.end())
+    {
+        queue_.erase(queued);
+        return true;
+    }
+
+    auto swapped = std::find_if(swapped_.begin(), swapped_.end(), matches);
+    if (swapped != swapped_.end())
+    {
+        swap_->release(swapped->swap_slot);
+        swapped_.erase(swapped);
+        return true;
+    }
+
+    auto active = std::find_if(active_.begin(), active_.end(), matches);
+    if (active != active_.end())
+    {
+        release(*active);
+        active_.erase(active);
+        return true;
+    }
+    return false;
+}
+
+std::size_t BatchEngine::kv_tokens_in_use() const noexcept
+{
+    std::size_t tokens = 0;
+    for (const Sequence &sequence : active_)
+    {
+        tokens += sequence.cache->get_current_token_idx();
+    }
+    return tokens;
+}
+
+void BatchEngine::admit()
+{
+    bool from_swap = false;
+    std::size_t index = 0;
+    while (next_waiting(from_swap, index))
+    {
+        const Sequence &candidate = from_swap ? swapped_[index] : queue_[index];
+
+        // Make room by preempting strictly lower-priority sequences, never equals
+        if (active_.size() >= config_.max_batch_size || !fits_kv_budget(candidate))
+        {
+            if (!swap_ || active_.empty())
+            {
+                break;
+            }
+            const std::size_t victim = lowest_priority_active();
+            if (active_[victim].request.priority >= candidate.request.priority)
+            {
+                break;
+            }
+            preempt(victim);
+            // The victim joined swapped_, which may have moved the candidate
+            continue;
+        }
+
+        Sequence sequence;
+        if (from_swap)
+        {
+            sequence = std::move(swapped_[index]);
+            swapped_.erase(swapped_.begin() + static_cast<std::ptrdiff_t>(index));
+            sequence.cache = acquire_cache();
+            swap_->swap_in(sequence.swap_slot, *sequence.cache);
+            sequence.swap_slot = KVSwapSlot();
+            ++stats_.resumptions;
+        }
+        else
+        {
+            sequence = std::move(queue_[index]);
+            queue_.erase(queue_.begin() + static_cast<std::ptrdiff_t>(index));
+            sequence.cache = acquire_cache();
+        }
+        active_.push_back(std::move(sequence));
+    }
+}
+
+bool BatchEngine::next_waiting(bool &from_swap, std::size_t &index) const
+{
+    // Highest priority first; on ties swapped sequences resume before new ones, then by arrival
+    const Sequence *best = nullptr;
+    auto consider = [&](const Sequence &sequence, bool swapped, std::size_t i)
+    {
+        if (best == nullptr ||
+            sequence.request.priority > best->request.priority ||
+            (sequence.request.priority == best->request.priority &&
+             ((swapped && !from_swap) || (swapped == from_swap && sequence.id < best->id))))
+        {
+            best = &sequence;
+            from_swap = swapped;
+            index = i;
+        }
+    };
+
+    for (std::size_t i = 0; i < swapped_.size(); ++i)
+    {
+        consider(swapped_[i], true, i);
+    }
+    for (std::size_t i = 0; i < queue_.size(); ++i)
+    {
+        consider(queue_[i], false, i);
+    }
+    return best != nullptr;
+}
+
+std::size_t BatchEngine::lowest_priority_active() const
+{
+    // Lowest priority loses; among equals the most recent arrival, which has the least invested
+    std::size_t victim = 0;
+    for (std::size_t i = 1; i < active_.size(); ++i)
+    {
+        const GenerationRequest &request = active_[i].request;
+        const GenerationRequest &current = active_[victim].request;
+        if (request.priority < current.priority ||
+            (request.priority == current.priority && active_[i].id > active_[victim].id))
+        {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+std::size_t BatchEngine::reserved_tokens(const Sequence &sequence) const
+{
+    // Worst-case cache rows of a sequence that can never be preempted
+    return std::min(sequence.request.prompt.size() + sequence.request.max_new_tokens, config_.max_sequence_length - 1);
+}
+
+bool BatchEngine::fits_kv_budget(const Sequence &candidate) const
+{
+    if (config_.max_kv_tokens == 0)
+    {
+        return true;
+    }
+
+    if (!swap_)
+    {
+        std::size_t reserved = reserved_tokens(candidate);
+        for (const Sequence &sequence : active_)
+        {
+            reserved += reserved_tokens(sequence);
+        }
+        return reserved <= config_.max_kv_tokens;
+    }
+
+    // Current rows plus one step of growth for everyone, so a sequence that was just preempted
+    // for room is not resumed straight back into the same squeeze
+    const std::size_t needed = kv_tokens_in_use() + active_.size() + candidate.swap_slot.tokens + 1;
+    return needed <= config_.max_kv_tokens;
+}
+
+void BatchEngine::enforce_kv_budget()
+{
+    if (config_.max_kv_tokens == 0)
+    {
+        return;
+    }
+
+    // This step adds a row per decoding sequence and at least one prompt row if any is prefilling
+    while (active_.size() > 1)
+    {
+        std::size_t decoding = 0;
+        bool prefilling = false;
+        for (const Sequence &sequence : active_)
+        {
+            decoding += sequence.decoding() ? 1 : 0;
+            prefilling = prefilling || !sequence.decoding();
+        }
+        if (kv_tokens_in_use() + decoding + (prefilling ? 1 : 0) <= config_.max_kv_tokens)
+        {
+            break;
+        }
+        preempt(lowest_priority_active());
+    }
+}
+
+void BatchEngine::preempt(std::size_t index)
+{
+    Sequence sequence = std::move(active_[index]);
+    active_.erase(active_.begin() + static_cast<std::ptrdiff_t>(index));
+
+    sequence.swap_slot = swap_->swap_out(*sequence.cache);
+    release(sequence);
+    ++stats_.preemptions;
+    swapped_.push_back(std::move(sequence));
+}
+
+void BatchEngine::schedule()
+{
+    slices_.clear();
+    step_tokens_.clear();
+    step_rows_.clear();
+    logit_rows_.clear();
+
+    auto add_rows = [&](std::size_t index, const int *tokens, std::size_t count, bool sample)
+    {
+        Sequence &sequence = active_[index];
+        const std::size_t start = sequence.cache->get_current_token_idx();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            step_tokens_.push_back(tokens[i]);
+            step_rows_.push_back({sequence.cache.get(), start + i});
+        }
+        if (sample)
+        {
+            logit_rows_.push_back(step_tokens_.size() - 1);
+        }
+        slices_.push_back({index, count, sample});
+    };
+
+    // Decode rows first so in-flight sequences advance every step
+    for (std::size_t i = 0; i < active_.size(); ++i)
+    {
+        if (active_[i].decoding())
+        {
+            add_rows(i, &active_[i].pending, 1, true);
+        }
+    }
+
+    // Prompt slices fill the remaining budget in arrival order, without outgrowing max_kv_tokens
+    std::size_t budget = config_.max_tokens_per_step - step_tokens_.size();
+    if (config_.max_kv_tokens > 0)
+    {
+        const std::size_t committed = kv_tokens_in_use() + step_tokens_.size();
+        budget = std::min(budget, committed < config_.max_kv_tokens ? config_.max_kv_tokens - committed : 0);
+    }
+    for (std::size_t i = 0; i < active_.size() && budget > 0; ++i)
+    {
+        Sequence &sequence = active_[i];
+        if (sequence.decoding())
+        {
+            continue;
+        }
+
+        const std::vector<int> &prompt = sequence.request.prompt;
+        const std::size_t count = std::min({prompt.size() - sequence.prefilled, config_.max_prefill_chunk, budget});
+        const bool completes_prompt = sequence.prefilled + count == prompt.size();
+        add_rows(i, prompt.data() + sequence.prefilled, count, completes_prompt);
+        budget -= count;
+    }
+}
+
+std::unique_ptr<KVCache> BatchEngine::acquire_cache()
+{
+    if (free_caches_.empty())
+    {
+        return model_.create_kv_cache(config_.max_sequence_length);
+    }
+
+    std::unique_ptr<KVCache> cache = std::move(free_caches_.back());
+    free_caches_.pop_back();
+    cache->reset();
+    return cache;
+}
+
+void BatchEngine::release(Sequence &sequence)
+{
+    free_caches_.push_back(std::move(sequence.cache));
+}
@@ -0,0 +1,219 @@
+#include <models/layer_pipeline.h>
+
+#include <cpu_ops/decoder.h>
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+// Micro-batch indices in flight between two stages; producers wait if a stage falls this far behind
+constexpr std::size_t kQueueCapacity = 64;
+
+// The shared pool's CPUs ordered domain by domain and cut into num_stages contiguous groups
+std::vector<ThreadPoolConfig> stage_configs(const ThreadPool &shared, int num_stages)
+{
+    std::vector<ThreadPoolConfig> configs(num_stages);
+    const std::vector<int> &cpus = shared.cpus();
+    if (static_cast<int>(cpus.size()) < num_stages)
+    {
+        // Unpinned, or too few CPUs for a group each: share the threads out and leave them to the scheduler
+        for (ThreadPoolConfig &config : configs)
+        {
+            config.num_threads = std::max(1, shared.num_threads() / num_stages);
+            config.pin_threads = false;
+        }
+        return configs;
+    }
+
+    std::vector<int> order(cpus.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return shared.thread_domain(a) < shared.thread_domain(b); });
+
+    for (int s = 0; s < num_stages; ++s)
+    {
+        const std::size_t begin = cpus.size() * s / num_stages;
+        const std::size_t end = cpus.size() * (s + 1) / num_stages;
+        ThreadPoolConfig &config = configs[s];
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            config.cpus += (i > begin ? "," : "") + std::to_string(cpus[order[i]]);
+        }
+        config.num_threads = static_cast<int>(end - begin);
+        config.use_smt = true;
+    }
+    return configs;
+}
+} // namespace
+
+LayerPipeline::LayerPipeline(std::size_t num_layers, int num_stages, const ThreadPool &shared)
+{
+    if (num_layers == 0)
+    {
+        throw std::invalid_argument("LayerPipeline needs at least one layer");
+    }
+    num_stages = std::max(1, std::min(num_stages, static_cast<int>(num_layers)));
+
+    for (int s = 0; s <= num_stages; ++s)
+    {
+        layer_bounds_.push_back(num_layers * s / num_stages);
+    }
+    for (const ThreadPoolConfig &config : stage_configs(shared, num_stages))
+    {
+        pools_.push_back(std::make_unique<ThreadPool>(config));
+    }
+    for (int s = 0; s + 1 < num_stages; ++s)
+    {
+        queues_.push_back(std::make_unique<SpscQueue<std::size_t>>(kQueueCapacity));
+    }
+    for (int s = 0; s < num_stages; ++s)
+    {
+        threads_.emplace_back(&LayerPipeline::stage_loop, this, s);
+    }
+}
+
+LayerPipeline::~LayerPipeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread &thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+int LayerPipeline::layer_stage(std::size_t layer) const
+{
+    if (layer >= layer_bounds_.back())
+    {
+        throw std::out_of_range("LayerPipeline: layer index out of range");
+    }
+    return static_cast<int>(std::upper_bound(layer_bounds_.begin(), layer_bounds_.end(), layer) - layer_bounds_.begin()) - 1;
+}
+
+void LayerPipeline::run(Decoder *const *decoders, Tensor &input, const AttentionRow *rows, std::size_t count,
+                        std::size_t micro_batch, Tensor &output)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    const std::size_t hidden = input.shape().back();
+    if (micro_batch == 0)
+    {
+        const std::size_t parts = 2 * pools_.size();
+        micro_batch = std::max<std::size_t>(1, (count + parts - 1) / parts);
+    }
+    if (scratch_.size() < 2 * count * hidden)
+    {
+        scratch_.resize(2 * count * hidden);
+    }
+
+    const std::size_t num_micro_batches = (count + micro_batch - 1) / micro_batch;
+
+    // Cleared before the job is published: a stage that sees the new generation may fail at once
+    {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        error_ = nullptr;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    job_.decoders = decoders;
+    job_.input = input.data<float>();
+    job_.output = output.data<float>();
+    job_.rows = rows;
+    job_.count = count;
+    job_.hidden = hidden;
+    job_.micro_batch = micro_batch;
+    job_.num_micro_batches = num_micro_batches;
+    const std::size_t generation = ++generation_;
+    wake_.notify_all();
+
+    // The calling thread is not one of the stages' pinned threads, so it sleeps rather than
+    // polling the last stage and taking time from their cores
+    done_.wait(lock, [&] { return finished_ == generation; });
+    lock.unlock();
+
+    std::lock_guard<std::mutex> error_lock(error_mutex_);
+    if (error_)
+    {
+        std::rethrow_exception(error_);
+    }
+}
+
+void LayerPipeline::stage_loop(int stage)
+{
+    ThreadPool &pool = *pools_[stage];
+    pool.pin_caller();
+    ThreadPool::Scope scope(pool);
+
+    std::size_t seen = 0;
+    while (true)
+    {
+        std::size_t num_micro_batches = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_)
+            {
+                return;
+            }
+            seen = generation_;
+            num_micro_batches = job_.num_micro_batches;
+        }
+
+        // In order, so a sequence's earlier rows are in the KV cache before its later ones attend
+        for (std::size_t i = 0; i < num_micro_batches; ++i)
+        {
+            const std::size_t index = stage == 0 ? i : queues_[stage - 1]->pop();
+            run_micro_batch(stage, index);
+            if (stage + 1 < num_stages())
+            {
+                queues_[stage]->push(index);
+            }
+        }
+
+        if (stage + 1 == num_stages())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                finished_ = seen;
+            }
+            done_.notify_one();
+        }
+    }
+}
+
+void LayerPipeline::run_micro_batch(int stage, std::size_t index)
+{
+    const Job &job = job_;
+    const std::size_t first = index * job.micro_batch;
+    const std::size_t rows = std::min(job.micro_batch, job.count - first);
+    const std::size_t offset = first * job.hidden;
+    float *buffers[2] = {scratch_.data() + offset, scratch_.data() + job.count * job.hidden + offset};
+    const std::size_t last = layer_bounds_.back() - 1;
+
+    try
+    {
+        for (std::size_t layer = layer_bounds_[stage]; layer < layer_bounds_[stage + 1]; ++layer)
+        {
+            Tensor source(layer == 0 ? job.input + offset : buffers[(layer - 1) % 2], {rows, job.hidden}, DataType::F32);
+            Tensor target(layer == last ? job.output + offset : buffers[layer % 2], {rows, job.hidden}, DataType::F32);
+            job.decoders[layer]->run_batch(source, job.rows + first, rows, target);
+        }
+    }
+    catch (...)
+    {
+        // Keep passing the micro-batch on so run() can drain and rethrow
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_)
+        {
+            error_ = std::current_exception();
+        }
+    }
+}
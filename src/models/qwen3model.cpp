@@ -1,13 +1,20 @@
 #include <models/qwen3model.h>
 
+#include <cpu_ops/cost_model.h>
 #include <cpu_ops/decoder.h>
+#include <cpu_ops/gemm_tuning.h>
 #include <cpu_ops/linear.h>
+#include <cpu_ops/linear_dispatch.h>
+#include <cpu_ops/lm_head.h>
+#include <cpu_ops/numa.h>
 #include <cpu_ops/rmsnorm.h>
 #include <cpu_ops/rotary_embedding.h>
-#include <cpu_ops/softmax_avx2.h>
+#include <models/layer_pipeline.h>
 #include <tensor/kvcache.h>
 #include <tensor/safetensors.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <stdexcept>
 #include <string>
@@ -36,19 +43,27 @@ Qwen3Model::Qwen3Model(const Qwen3Config &config)
       hidden_state_(DataType::F32, {static_cast<std::size_t>(config.hidden_size)}),
       decoder_output_(DataType::F32, {static_cast<std::size_t>(config.hidden_size)}),
       norm_output_(DataType::F32, {static_cast<std::size_t>(config.hidden_size)}),
-      logits_buffer_(static_cast<std::size_t>(config.vocab_size), 0.0f)
+      logits_buffer_(static_cast<std::size_t>(config.vocab_size), 0.0f),
+      candidate_buffer_(1)
 {
     if (config.num_attention_heads <= 0)
     {
         throw std::invalid_argument("num_attention_heads must be positive");
     }
 
-    //TODO : is this check required 
-    if (config.hidden_size % config.num_attention_heads != 0)
+    // Qwen3 configs carry head_dim explicitly (e.g. 0.6B: hidden 1024, 16 heads of 128)
+    if (config.head_dim > 0)
     {
-        throw std::invalid_argument("hidden_size must be divisible by num_attention_heads");
+        head_dim_ = config.head_dim;
+    }
+    else
+    {
+        if (config.hidden_size % config.num_attention_heads != 0)
+        {
+            throw std::invalid_argument("hidden_size must be divisible by num_attention_heads");
+        }
+        head_dim_ = config.hidden_size / config.num_attention_heads;
     }
-    head_dim_ = config.hidden_size / config.num_attention_heads;
     if (head_dim_ % 2 != 0)
     {
         throw std::invalid_argument("head_dim must be even for rotary embeddings");
@@ -61,6 +76,35 @@ Qwen3Model::Qwen3Model(const Qwen3Config &config)
     {
         throw std::invalid_argument("vocab_size must be positive");
     }
+
+    ThreadPool::configure(config.threading);
+
+    // Calibrate the parallelism cost model now rather than inside the first token
+    CostModel::instance();
+
+    // Load or tune the GEMM blocking from this thread, outside any pool task: reached first from a
+    // prefill's linear call inside a task, the tuning's nested parallel_for would run inline and
+    // chunks per thread would be tuned for one thread
+    GemmTuning::instance();
+
+    // Measure (or load) the linear kernel tables, with buckets of their own for this config's
+    // projections (q, k/v, o, gate/up, down as K x N). A model constructed earlier has already
+    // fixed them; its shapes are the ones that get their own buckets.
+    const int q_dim = config.num_attention_heads * head_dim_;
+    const int kv_dim = config.num_key_value_heads * head_dim_;
+    LinearDispatch::configure({{config.hidden_size, q_dim},
+                               {config.hidden_size, kv_dim},
+                               {q_dim, config.hidden_size},
+                               {config.hidden_size, config.intermediate_size},
+                               {config.intermediate_size, config.hidden_size}});
+    LinearDispatch::instance();
+
+    // Norm kernel compiled for this hidden size; the decoder layers pick theirs (hidden size and
+    // head_dim) from their weights, which carry the same config
+    final_norm_row_ = fixed_rmsnorm(config.hidden_size);
+
+    // Keep weight prefetching off the cores that run the kernels
+    PrefetchManager::instance().set_affinity(ThreadPool::instance().spare_cpus());
 }
 
 Qwen3Model::~Qwen3Model() = default;
@@ -95,6 +139,21 @@ void Qwen3Model::load_weights(const std::string &safetensor_path, bool use_mmap)
     decoders_.clear();
     decoders_.reserve(static_cast<std::size_t>(config_.num_hidden_layers));
 
+    ThreadPool &pool = ThreadPool::instance();
+    const char *stages_env = std::getenv("MINMAX_PIPELINE_STAGES");
+    const int stages = stages_env != nullptr && *stages_env != '\0' ? std::atoi(stages_env) : config_.pipeline_stages;
+    pipeline_layers_.clear();
+    pipeline_.reset();
+    if (stages > 1 && config_.num_hidden_layers > 1)
+    {
+        pipeline_ = std::make_unique<LayerPipeline>(static_cast<std::size_t>(config_.num_hidden_layers), stages, pool);
+    }
+
+    // Node-local weight slices only pay off with threads on more than one node, or for a stage's own cores
+    const char *numa_env = std::getenv("MINMAX_NUMA");
+    const bool numa = numa_env != nullptr && *numa_env != '\0' ? std::atoi(numa_env) != 0 : config_.numa;
+    const bool place_numa = numa && (pipeline_ || pool.num_domains() > 1);
+
     for (int layer = 0; layer < config_.num_hidden_layers; ++layer)
     {
         const std::string prefix = "model.layers." + std::to_string(layer) + ".";
@@ -130,12 +189,18 @@ void Qwen3Model::load_weights(const std::string &safetensor_path, bool use_mmap)
             mlp_gate,
             mlp_down);
 
+        if (place_numa)
+        {
+            decoder->place_weights(pipeline_ ? pipeline_->stage_pool(pipeline_->layer_stage(static_cast<std::size_t>(layer))) : pool);
+        }
         decoder->prepare();
+        pipeline_layers_.push_back(decoder.get());
         decoders_.push_back(std::move(decoder));
     }
 
     kv_cache_->reset();
     tokens_processed_ = 0;
+    token_history_.clear();
 }
 
 void Qwen3Model::reset_cache()
@@ -144,25 +209,199 @@ void Qwen3Model::reset_cache()
     ensure_cache_initialized();
     kv_cache_->reset();
     tokens_processed_ = 0;
+    token_history_.clear();
 }
 
-void Qwen3Model::process_prompt_token(int token_id)
+void Qwen3Model::rewind(std::size_t tokens)
 {
     ensure_weights_loaded();
     ensure_cache_initialized();
-    check_token_valid(token_id);
-    ensure_position_capacity();
+    if (tokens > tokens_processed_)
+    {
+        throw std::out_of_range("Cannot rewind past the start of the sequence");
+    }
 
-    embed_token(token_id);
+    kv_cache_->truncate(kv_cache_->get_current_token_idx() - tokens);
+    tokens_processed_ -= tokens;
+    token_history_.resize(token_history_.size() - tokens);
+}
 
-    const std::size_t token_index = kv_cache_->get_current_token_idx();
-    run_decoder_stack(token_index);
+void Qwen3Model::process_prompt_token(int token_id)
+{
+    run_token(token_id);
+    commit_token(token_id);
+}
 
-    kv_cache_->advance();
-    ++tokens_processed_;
+const std::vector<float> &Qwen3Model::predict_next_token(int token_id, const VocabMask *mask)
+{
+    check_mask_valid(mask);
+    run_token(token_id);
+    apply_final_norm();
+    run_lm_head(mask);
+    commit_token(token_id);
+
+    return logits_buffer_;
+}
+
+void Qwen3Model::set_draft_layers(const std::vector<std::size_t> &layers)
+{
+    if (layers.empty())
+    {
+        throw std::invalid_argument("Draft layer set must not be empty");
+    }
+    for (std::size_t i = 0; i < layers.size(); ++i)
+    {
+        if (layers[i] >= static_cast<std::size_t>(config_.num_hidden_layers) || (i > 0 && layers[i] <= layers[i - 1]))
+        {
+            throw std::invalid_argument("Draft layers must be ascending indices below num_hidden_layers");
+        }
+    }
+    draft_layers_ = layers;
+}
+
+const std::vector<float> &Qwen3Model::predict_next_token_draft(int token_id)
+{
+    if (draft_layers_.empty())
+    {
+        throw std::runtime_error("Draft layers have not been set");
+    }
+
+    run_token(token_id, &draft_layers_);
+    apply_final_norm();
+    run_lm_head(nullptr);
+    commit_token(token_id);
+
+    return logits_buffer_;
+}
+
+int Qwen3Model::sample_next_token(int token_id, const VocabMask *mask)
+{
+    const int k = fused_top_k();
+    if (k == 0)
+    {
+        predict_next_token(token_id, mask);
+        return sampler_.sample(logits_buffer_.data(), config_.vocab_size, token_history_.data(), token_history_.size());
+    }
+
+    check_mask_valid(mask);
+    run_token(token_id);
+    apply_final_norm();
+    const int count = lm_head_topk_avx2_omp(
+        norm_output_.data<float>(),
+        embedding_weight_.data<float>(),
+        config_.hidden_size,
+        config_.vocab_size,
+        k,
+        candidate_buffer_.data(),
+        mask ? mask->words() : nullptr);
+    commit_token(token_id);
+
+    return sampler_.sample_candidates(candidate_buffer_.data(), count);
+}
+
+void Qwen3Model::process_prompt_tokens(const int *token_ids, std::size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    run_token_batch(token_ids, count);
+    commit_tokens(token_ids, count);
+}
+
+const std::vector<float> &Qwen3Model::predict_tokens(const int *token_ids, std::size_t count)
+{
+    batch_logits_.resize(count * static_cast<std::size_t>(config_.vocab_size));
+    if (count == 0)
+    {
+        return batch_logits_;
+    }
+
+    const Tensor &hidden = run_token_batch(token_ids, count);
+    compute_row_logits(hidden, nullptr, count);
+
+    commit_tokens(token_ids, count);
+    return batch_logits_;
+}
+
+std::unique_ptr<KVCache> Qwen3Model::create_kv_cache(std::size_t max_tokens) const
+{
+    if (max_tokens == 0 || max_tokens > static_cast<std::size_t>(config_.max_position_embeddings))
+    {
+        throw std::invalid_argument("KV cache length must be in [1, max_position_embeddings]");
+    }
+
+    return std::make_unique<KVCache>(
+        max_tokens,
+        static_cast<std::size_t>(head_dim_),
+        static_cast<std::size_t>(config_.num_key_value_heads),
+        static_cast<std::size_t>(config_.num_hidden_layers));
+}
+
+const std::vector<float> &Qwen3Model::forward_rows(const int *token_ids, const AttentionRow *rows, std::size_t count,
+                                                   const std::size_t *logit_rows, std::size_t num_logit_rows)
+{
+    ensure_weights_loaded();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        check_token_valid(token_ids[i]);
+        if (!rows[i].kvcache || rows[i].token_idx >= rows[i].kvcache->get_max_sequence_length())
+        {
+            throw std::out_of_range("Attention row position outside its KV cache");
+        }
+    }
+    if (!logit_rows && num_logit_rows > count)
+    {
+        throw std::out_of_range("Logit row count exceeds the number of rows");
+    }
+    for (std::size_t i = 0; logit_rows && i < num_logit_rows; ++i)
+    {
+        if (logit_rows[i] >= count)
+        {
+            throw std::out_of_range("Logit row index out of range");
+        }
+    }
+
+    batch_logits_.resize(num_logit_rows * static_cast<std::size_t>(config_.vocab_size));
+    if (count == 0)
+    {
+        return batch_logits_;
+    }
+
+    ensure_batch_capacity(count);
+    embed_tokens(token_ids, count);
+    const Tensor &hidden = run_decoder_stack_batch(rows, count);
+    if (num_logit_rows > 0)
+    {
+        compute_row_logits(hidden, logit_rows, num_logit_rows);
+    }
+    return batch_logits_;
+}
+
+void Qwen3Model::set_sampler_config(const SamplerConfig &sampler_config)
+{
+    sampler_.set_config(sampler_config);
+    candidate_buffer_.resize(static_cast<std::size_t>(std::max(fused_top_k(), 1)));
+}
+
+int Qwen3Model::fused_top_k() const noexcept
+{
+    // Penalties can reorder tokens outside the top-k, so they need the full logits
+    if (sampler_.has_penalties())
+    {
+        return 0;
+    }
+    if (sampler_.is_greedy())
+    {
+        return 1;
+    }
+
+    const int top_k = sampler_.config().top_k;
+    return top_k <= kMaxFusedTopK ? top_k : 0;
 }
 
-const std::vector<float> &Qwen3Model::predict_next_token(int token_id)
+void Qwen3Model::run_token(int token_id, const std::vector<std::size_t> *layers)
 {
     ensure_weights_loaded();
     ensure_cache_initialized();
@@ -172,14 +411,110 @@ const std::vector<float> &Qwen3Model::predict_next_token(int token_id)
     embed_token(token_id);
 
     const std::size_t token_index = kv_cache_->get_current_token_idx();
-    run_decoder_stack(token_index);
-    apply_final_norm();
-    run_lm_head();
+    run_decoder_stack(token_index, layers);
+}
+
+Tensor &Qwen3Model::run_token_batch(const int *token_ids, std::size_t count)
+{
+    ensure_weights_loaded();
+    ensure_cache_initialized();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        check_token_valid(token_ids[i]);
+    }
+
+    const std::size_t start = kv_cache_->get_current_token_idx();
+    if (start + count >= kv_cache_->get_max_sequence_length())
+    {
+        throw std::runtime_error("Exceeded maximum position embeddings");
+    }
+
+    ensure_batch_capacity(count);
+    embed_tokens(token_ids, count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        batch_rows_[i] = {kv_cache_.get(), start + i};
+    }
+
+    return run_decoder_stack_batch(batch_rows_.data(), count);
+}
+
+void Qwen3Model::embed_tokens(const int *token_ids, std::size_t count)
+{
+    const std::size_t hidden = static_cast<std::size_t>(config_.hidden_size);
+    float *dst = batch_hidden_.data<float>();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const float *src = embedding_weight_.data<float>() + hidden * static_cast<std::size_t>(token_ids[i]);
+        std::memcpy(dst + i * hidden, src, hidden * sizeof(float));
+    }
+}
+
+void Qwen3Model::compute_row_logits(const Tensor &hidden, const std::size_t *rows, std::size_t count)
+{
+    const std::size_t hidden_size = static_cast<std::size_t>(config_.hidden_size);
+    if (rows)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            rmsnorm_avx2(
+                hidden.data<float>() + rows[i] * hidden_size,
+                final_norm_weight_.data<float>(),
+                batch_norm_.data<float>() + i * hidden_size,
+                1,
+                config_.hidden_size,
+                config_.rms_norm_eps,
+                final_norm_row_);
+        }
+    }
+    else
+    {
+        rmsnorm_avx2(
+            hidden.data<float>(),
+            final_norm_weight_.data<float>(),
+            batch_norm_.data<float>(),
+            static_cast<int>(count),
+            config_.hidden_size,
+            config_.rms_norm_eps,
+            final_norm_row_);
+    }
+
+    // One pass over the lm_head weight for every row
+    linear_avx2_omp(
+        batch_norm_.data<float>(),
+        embedding_weight_.data<float>(),
+        static_cast<int>(count),
+        config_.hidden_size,
+        config_.vocab_size,
+        batch_logits_.data());
+}
+
+void Qwen3Model::commit_tokens(const int *token_ids, std::size_t count)
+{
+    kv_cache_->advance(count);
+    tokens_processed_ += count;
+    token_history_.insert(token_history_.end(), token_ids, token_ids + count);
+}
+
+void Qwen3Model::ensure_batch_capacity(std::size_t count)
+{
+    if (!batch_hidden_.shape().empty() && batch_hidden_.shape()[0] >= count)
+    {
+        return;
+    }
 
+    const std::size_t hidden = static_cast<std::size_t>(config_.hidden_size);
+    batch_hidden_ = Tensor(DataType::F32, {count, hidden});
+    batch_output_ = Tensor(DataType::F32, {count, hidden});
+    batch_norm_ = Tensor(DataType::F32, {count, hidden});
+    batch_rows_.resize(count);
+}
+
+void Qwen3Model::commit_token(int token_id)
+{
     kv_cache_->advance();
     ++tokens_processed_;
-
-    return logits_buffer_;
+    token_history_.push_back(token_id);
 }
 
 void Qwen3Model::ensure_weights_loaded() const
@@ -230,14 +565,20 @@ void Qwen3Model::embed_token(int token_id)
     std::memcpy(dst, src, hidden * sizeof(float));
 }
 
-void Qwen3Model::run_decoder_stack(std::size_t token_index)
+void Qwen3Model::run_decoder_stack(std::size_t token_index, const std::vector<std::size_t> *layers)
 {
+    // This thread is the pool's thread 0 for every kernel of the token; keep it on its reserved CPU
+    ThreadPool::instance().pin_caller();
+
     Tensor *current_input = &hidden_state_;
     Tensor *current_output = &decoder_output_;
 
-    for (auto &decoder : decoders_)
+    // Every layer, or only the given subset (self-speculative drafting)
+    const std::size_t num_layers = layers ? layers->size() : decoders_.size();
+    for (std::size_t i = 0; i < num_layers; ++i)
     {
-        decoder->run(*current_input, token_index, *current_output);
+        Decoder &decoder = *decoders_[layers ? (*layers)[i] : i];
+        decoder.run(*current_input, token_index, *current_output);
         std::swap(current_input, current_output);
     }
 
@@ -247,6 +588,29 @@ void Qwen3Model::run_decoder_stack(std::size_t token_index)
     }
 }
 
+Tensor &Qwen3Model::run_decoder_stack_batch(const AttentionRow *rows, std::size_t count)
+{
+    ThreadPool::instance().pin_caller();
+
+    // Ping-pong between the two batch buffers and return whichever holds the last layer's output
+    if (pipeline_ && count > 1)
+    {
+        pipeline_->run(pipeline_layers_.data(), batch_hidden_, rows, count, config_.pipeline_micro_batch, batch_output_);
+        return batch_output_;
+    }
+
+    Tensor *current_input = &batch_hidden_;
+    Tensor *current_output = &batch_output_;
+
+    for (auto &decoder : decoders_)
+    {
+        decoder->run_batch(*current_input, rows, count, *current_output);
+        std::swap(current_input, current_output);
+    }
+
+    return *current_input;
+}
+
 void Qwen3Model::apply_final_norm()
 {
     rmsnorm_avx2(
@@ -255,11 +619,40 @@ void Qwen3Model::apply_final_norm()
         norm_output_.data<float>(),
         1,
         config_.hidden_size,
-        config_.rms_norm_eps);
+        config_.rms_norm_eps,
+        final_norm_row_);
+}
+
+void Qwen3Model::check_mask_valid(const VocabMask *mask) const
+{
+    if (!mask)
+    {
+        return;
+    }
+    if (mask->vocab_size() != config_.vocab_size)
+    {
+        throw std::invalid_argument("Vocabulary mask size does not match vocab_size");
+    }
+    if (mask->count() == 0)
+    {
+        throw std::invalid_argument("Vocabulary mask does not allow any token");
+    }
 }
 
-void Qwen3Model::run_lm_head()
+void Qwen3Model::run_lm_head(const VocabMask *mask)
 {
+    if (mask)
+    {
+        lm_head_masked_avx2_omp(
+            norm_output_.data<float>(),
+            embedding_weight_.data<float>(),
+            config_.hidden_size,
+            config_.vocab_size,
+            mask->words(),
+            logits_buffer_.data());
+        return;
+    }
+
     linear_avx2_omp(
         norm_output_.data<float>(),
         embedding_weight_.data<float>(),
@@ -267,8 +660,5 @@ void Qwen3Model::run_lm_head()
         config_.hidden_size,
         config_.vocab_size,
         logits_buffer_.data());
-    
-        //TODO : give option to set temperature
-    softmax_avx2(logits_buffer_.data(), config_.vocab_size);
 }
 
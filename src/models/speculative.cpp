@@ -0,0 +1,314 @@
+#include <models/speculative.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+// Draws the next draft token. Stochastic drafts record the distribution they were drawn from.
+int draw_draft_token(Sampler &sampler, const std::vector<float> &logits, int vocab_size, std::vector<float> &probs)
+{
+    if (sampler.is_greedy())
+    {
+        return argmax_avx2(logits.data(), vocab_size);
+    }
+
+    const std::size_t offset = probs.size();
+    probs.resize(offset + static_cast<std::size_t>(vocab_size));
+    sampler.probabilities(logits.data(), vocab_size, probs.data() + offset);
+    return sampler.sample_probabilities(probs.data() + offset, vocab_size);
+}
+} // namespace
+
+DraftModelDrafter::DraftModelDrafter(Qwen3Model &draft, const SamplerConfig &sampler_config)
+    : draft_(draft),
+      sampler_(sampler_config)
+{
+}
+
+void DraftModelDrafter::begin(const std::vector<int> &context)
+{
+    draft_.reset_cache();
+    draft_.process_prompt_tokens(context.data(), context.size());
+}
+
+std::size_t DraftModelDrafter::propose(int pending, std::size_t max_tokens, std::vector<int> &tokens, std::vector<float> &probs)
+{
+    const int vocab_size = draft_.config().vocab_size;
+
+    // Feeding a proposal needs one position, and accept() may need one more for the last one
+    max_tokens = std::min(max_tokens, draft_.remaining_positions() > 0 ? draft_.remaining_positions() - 1 : 0);
+
+    int token = pending;
+    for (std::size_t i = 0; i < max_tokens; ++i)
+    {
+        token = draw_draft_token(sampler_, draft_.predict_next_token(token), vocab_size, probs);
+        tokens.push_back(token);
+    }
+    return max_tokens;
+}
+
+void DraftModelDrafter::accept(int pending, const int *tokens, std::size_t proposed, std::size_t accepted)
+{
+    // propose() fed pending and d1..d(proposed-1); the context now ends at d(accepted)
+    if (proposed == 0)
+    {
+        draft_.process_prompt_token(pending);
+    }
+    else if (accepted == proposed)
+    {
+        draft_.process_prompt_token(tokens[proposed - 1]);
+    }
+    else
+    {
+        draft_.rewind(proposed - 1 - accepted);
+    }
+}
+
+SelfSpeculativeDrafter::SelfSpeculativeDrafter(Qwen3Model &model, const std::vector<std::size_t> &draft_layers,
+                                               const SamplerConfig &sampler_config)
+    : model_(model),
+      sampler_(sampler_config)
+{
+    model_.set_draft_layers(draft_layers);
+}
+
+void SelfSpeculativeDrafter::begin(const std::vector<int> & /*context*/)
+{
+}
+
+std::size_t SelfSpeculativeDrafter::propose(int pending, std::size_t max_tokens, std::vector<int> &tokens, std::vector<float> &probs)
+{
+    const int vocab_size = model_.config().vocab_size;
+    max_tokens = std::min(max_tokens, model_.remaining_positions());
+
+    int token = pending;
+    for (std::size_t i = 0; i < max_tokens; ++i)
+    {
+        token = draw_draft_token(sampler_, model_.predict_next_token_draft(token), vocab_size, probs);
+        tokens.push_back(token);
+    }
+
+    // The verify pass rewrites these positions in every layer
+    model_.rewind(max_tokens);
+    return max_tokens;
+}
+
+void SelfSpeculativeDrafter::accept(int /*pending*/, const int * /*tokens*/, std::size_t /*proposed*/, std::size_t /*accepted*/)
+{
+}
+
+std::vector<std::size_t> SelfSpeculativeDrafter::strided_layers(int num_layers, int stride)
+{
+    if (stride <= 0)
+    {
+        throw std::invalid_argument("Layer stride must be positive");
+    }
+
+    std::vector<std::size_t> layers;
+    for (int layer = 0; layer < num_layers; layer += stride)
+    {
+        layers.push_back(static_cast<std::size_t>(layer));
+    }
+    return layers;
+}
+
+std::vector<std::size_t> SelfSpeculativeDrafter::leading_layers(int num_layers, int count)
+{
+    if (count <= 0 || count > num_layers)
+    {
+        throw std::invalid_argument("Leading layer count must be in [1, num_layers]");
+    }
+
+    std::vector<std::size_t> layers(static_cast<std::size_t>(count));
+    for (int layer = 0; layer < count; ++layer)
+    {
+        layers[layer] = static_cast<std::size_t>(layer);
+    }
+    return layers;
+}
+
+PromptLookupDrafter::PromptLookupDrafter(std::size_t max_ngram, std::size_t min_ngram)
+    : max_ngram_(max_ngram),
+      min_ngram_(min_ngram)
+{
+    if (min_ngram == 0 || max_ngram < min_ngram)
+    {
+        throw std::invalid_argument("PromptLookupDrafter needs 0 < min_ngram <= max_ngram");
+    }
+}
+
+void PromptLookupDrafter::begin(const std::vector<int> &context)
+{
+    context_ = context;
+}
+
+std::size_t PromptLookupDrafter::propose(int pending, std::size_t max_tokens, std::vector<int> &tokens, std::vector<float> & /*probs*/)
+{
+    context_.push_back(pending);
+    const std::size_t size = context_.size();
+
+    std::size_t proposed = 0;
+    for (std::size_t n = std::min(max_ngram_, size - 1); n >= min_ngram_ && proposed == 0; --n)
+    {
+        const int *suffix = context_.data() + size - n;
+
+        // Most recent match first; the match must end before the suffix so a continuation exists
+        for (std::size_t start = size - n; start-- > 0;)
+        {
+            if (std::equal(suffix, suffix + n, context_.data() + start))
+            {
+                const std::size_t continuation = start + n;
+                proposed = std::min(max_tokens, size - continuation);
+                tokens.insert(tokens.end(), context_.begin() + continuation, context_.begin() + continuation + proposed);
+                break;
+            }
+        }
+    }
+
+    context_.pop_back();
+    return proposed;
+}
+
+void PromptLookupDrafter::accept(int pending, const int *tokens, std::size_t /*proposed*/, std::size_t accepted)
+{
+    context_.push_back(pending);
+    context_.insert(context_.end(), tokens, tokens + accepted);
+}
+
+SpeculativeDecoder::SpeculativeDecoder(Qwen3Model &target, Drafter &drafter, std::size_t num_draft_tokens,
+                                       const SamplerConfig &sampler_config)
+    : target_(target),
+      drafter_(drafter),
+      num_draft_tokens_(num_draft_tokens),
+      sampler_(sampler_config)
+{
+    if (sampler_.has_penalties())
+    {
+        // Penalties make p depend on the unverified draft, which breaks the acceptance test
+        throw std::invalid_argument("Speculative decoding does not support repetition penalties");
+    }
+}
+
+std::vector<int> SpeculativeDecoder::generate(const std::vector<int> &prompt, std::size_t max_new_tokens)
+{
+    if (prompt.empty())
+    {
+        throw std::invalid_argument("Speculative decoding needs a non-empty prompt");
+    }
+
+    stats_ = SpeculativeStats();
+    std::vector<int> output;
+
+    const std::vector<int> context(prompt.begin(), prompt.end() - 1);
+    target_.reset_cache();
+    target_.process_prompt_tokens(context.data(), context.size());
+    drafter_.begin(context);
+
+    const std::size_t vocab_size = static_cast<std::size_t>(target_.config().vocab_size);
+    const int eos_token_id = target_.config().eos_token_id;
+    int pending = prompt.back();
+
+    while (output.size() < max_new_tokens && target_.remaining_positions() > 0)
+    {
+        // The verify pass appends pending plus every proposal to the target cache
+        const std::size_t budget = std::min({num_draft_tokens_,
+                                             max_new_tokens - output.size() - 1,
+                                             target_.remaining_positions() - 1});
+
+        draft_tokens_.clear();
+        draft_probs_.clear();
+        const std::size_t proposed = budget > 0 ? drafter_.propose(pending, budget, draft_tokens_, draft_probs_) : 0;
+        if (!draft_probs_.empty() && draft_probs_.size() != proposed * vocab_size)
+        {
+            throw std::runtime_error("Draft distributions do not match the target vocabulary");
+        }
+
+        verify_tokens_.assign(1, pending);
+        verify_tokens_.insert(verify_tokens_.end(), draft_tokens_.begin(), draft_tokens_.begin() + proposed);
+        const std::vector<float> &logits = target_.predict_tokens(verify_tokens_.data(), verify_tokens_.size());
+
+        int next_token = 0;
+        const std::size_t accepted = verify(proposed, logits.data(), next_token);
+
+        // Keep pending and the accepted drafts; the corrected token becomes the next pending one
+        target_.rewind(proposed - accepted);
+        drafter_.accept(pending, draft_tokens_.data(), proposed, accepted);
+
+        ++stats_.rounds;
+        stats_.drafted_tokens += proposed;
+        stats_.accepted_tokens += accepted;
+
+        bool finished = false;
+        for (std::size_t i = 0; i <= accepted && !finished; ++i)
+        {
+            const int token = i < accepted ? draft_tokens_[i] : next_token;
+            output.push_back(token);
+            finished = token == eos_token_id;
+        }
+        if (finished)
+        {
+            break;
+        }
+        pending = next_token;
+    }
+
+    stats_.generated_tokens = output.size();
+    return output;
+}
+
+std::size_t SpeculativeDecoder::verify(std::size_t proposed, const float *target_logits, int &next_token)
+{
+    const int vocab_size = target_.config().vocab_size;
+    target_probs_.resize(static_cast<std::size_t>(vocab_size));
+    float *p = target_probs_.data();
+
+    for (std::size_t i = 0; i < proposed; ++i)
+    {
+        sampler_.probabilities(target_logits + i * vocab_size, vocab_size, p);
+
+        const int token = draft_tokens_[i];
+        const float *q = draft_probs_.empty() ? nullptr : draft_probs_.data() + i * vocab_size;
+        const float q_token = q ? q[token] : 1.0f;
+
+        if (q_token > 0.0f && sampler_.uniform() * q_token < p[token])
+        {
+            continue;
+        }
+
+        // Rejected: resample from the residual max(0, p - q)
+        if (q)
+        {
+            for (int v = 0; v < vocab_size; ++v)
+            {
+                p[v] = std::max(0.0f, p[v] - q[v]);
+            }
+        }
+        else
+        {
+            p[token] = 0.0f;
+        }
+
+        float residual_mass = 0.0f;
+        for (int v = 0; v < vocab_size; ++v)
+        {
+            residual_mass += p[v];
+        }
+        if (residual_mass > 0.0f)
+        {
+            next_token = sampler_.sample_probabilities(p, vocab_size);
+        }
+        else
+        {
+            // p <= q everywhere only through rounding; fall back to the target distribution
+            sampler_.probabilities(target_logits + i * vocab_size, vocab_size, p);
+            next_token = sampler_.sample_probabilities(p, vocab_size);
+        }
+        return i;
+    }
+
+    // Every draft accepted: the last row gives a bonus token
+    sampler_.probabilities(target_logits + proposed * vocab_size, vocab_size, p);
+    next_token = sampler_.sample_probabilities(p, vocab_size);
+    return proposed;
+}
@@ -0,0 +1,741 @@
+#include <server/inference_server.h>
+#include <server/json_fields.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <afunix.h>
+#include <windows.h>
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+#if defined(_WIN32)
+using NativeSocket = SOCKET;
+const NativeSocket kInvalidSocket = INVALID_SOCKET;
+
+void close_socket(NativeSocket socket) { closesocket(socket); }
+void shutdown_socket(NativeSocket socket) { shutdown(socket, SD_BOTH); }
+void remove_file(const std::string &path) { DeleteFileA(path.c_str()); }
+#else
+using NativeSocket = int;
+const NativeSocket kInvalidSocket = -1;
+
+void close_socket(NativeSocket socket) { ::close(socket); }
+void shutdown_socket(NativeSocket socket) { ::shutdown(socket, SHUT_RDWR); }
+void remove_file(const std::string &path) { ::unlink(path.c_str()); }
+#endif
+
+#if defined(MSG_NOSIGNAL)
+const int kSendFlags = MSG_NOSIGNAL; // a vanished client must not raise SIGPIPE
+#else
+const int kSendFlags = 0;
+#endif
+
+constexpr std::size_t kMaxHeaderBytes = 64 * 1024;
+constexpr std::size_t kMaxBodyBytes = 4 * 1024 * 1024;
+
+using Clock = std::chrono::steady_clock;
+
+NativeSocket native(std::intptr_t socket)
+{
+    return static_cast<NativeSocket>(socket);
+}
+
+std::intptr_t handle(NativeSocket socket)
+{
+    return static_cast<std::intptr_t>(socket);
+}
+
+bool send_all(std::intptr_t socket, const char *data, std::size_t size)
+{
+    while (size > 0)
+    {
+        const int request = static_cast<int>(std::min<std::size_t>(size, 1 << 20));
+        const auto sent = ::send(native(socket), data, request, kSendFlags);
+        if (sent <= 0)
+        {
+#if !defined(_WIN32)
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+#endif
+            return false;
+        }
+        data += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+bool send_all(std::intptr_t socket, const std::string &data)
+{
+    return send_all(socket, data.data(), data.size());
+}
+
+const char *status_reason(int status)
+{
+    switch (status)
+    {
+    case 200:
+        return "OK";
+    case 400:
+        return "Bad Request";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 413:
+        return "Payload Too Large";
+    case 503:
+        return "Service Unavailable";
+    default:
+        return "Internal Server Error";
+    }
+}
+
+bool send_response(std::intptr_t socket, int status, const std::string &body)
+{
+    std::ostringstream response;
+    response << "HTTP/1.1 " << status << " " << status_reason(status) << "\r\n"
+             << "Content-Type: application/json\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << body;
+    return send_all(socket, response.str());
+}
+
+bool send_chunk(std::intptr_t socket, const std::string &data)
+{
+    char size[32];
+    std::snprintf(size, sizeof(size), "%zx\r\n", data.size());
+    return send_all(socket, std::string(size) + data + "\r\n");
+}
+
+std::string error_body(const std::string &message)
+{
+    return "{\"error\": \"" + json_escape(message) + "\"}";
+}
+
+struct HttpRequest
+{
+    std::string method;
+    std::string path;
+    std::string body;
+};
+
+// Reads one request; returns an HTTP status other than 200 when it cannot be parsed
+int read_request(std::intptr_t socket, HttpRequest &request)
+{
+    std::string data;
+    std::size_t header_end = std::string::npos;
+    char buffer[4096];
+
+    while (header_end == std::string::npos)
+    {
+        if (data.size() > kMaxHeaderBytes)
+        {
+            return 413;
+        }
+        const auto received = ::recv(native(socket), buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            return 400;
+        }
+        data.append(buffer, static_cast<std::size_t>(received));
+        header_end = data.find("\r\n\r\n");
+    }
+
+    std::istringstream head(data.substr(0, header_end));
+    head >> request.method >> request.path;
+
+    std::size_t content_length = 0;
+    std::string line;
+    std::getline(head, line);
+    while (std::getline(head, line))
+    {
+        std::string lower(line);
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (lower.compare(0, 15, "content-length:") == 0)
+        {
+            content_length = static_cast<std::size_t>(std::strtoull(line.c_str() + 15, nullptr, 10));
+        }
+    }
+    if (content_length > kMaxBodyBytes)
+    {
+        return 413;
+    }
+
+    request.body = data.substr(header_end + 4);
+    while (request.body.size() < content_length)
+    {
+        const auto received = ::recv(native(socket), buffer, sizeof(buffer), 0);
+        if (received <= 0)
+        {
+            return 400;
+        }
+        request.body.append(buffer, static_cast<std::size_t>(received));
+    }
+    request.body.resize(content_length);
+    return 200;
+}
+
+double elapsed_ms(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+} // namespace
+
+InferenceServer::InferenceServer(Qwen3Model &model, const InferenceServerConfig &config, const BpeTokenizer *tokenizer)
+    : model_(model),
+      config_(config),
+      tokenizer_(tokenizer),
+      listener_(handle(kInvalidSocket)),
+      running_(false),
+      active_(0),
+      queued_(0),
+      swapped_(0)
+{
+    if (config.max_connections == 0)
+    {
+        throw std::invalid_argument("max_connections must be positive");
+    }
+    // Validates the engine settings before anything is bound
+    engine_ = std::make_unique<BatchEngine>(model_, config_.engine);
+
+#if defined(_WIN32)
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+    {
+        throw std::runtime_error("WSAStartup failed");
+    }
+#endif
+}
+
+InferenceServer::~InferenceServer()
+{
+    stop();
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+void InferenceServer::start()
+{
+    if (running_)
+    {
+        return;
+    }
+
+    const std::string &listen_on = config_.listen;
+    NativeSocket listener = kInvalidSocket;
+
+    if (listen_on.compare(0, 5, "unix:") == 0)
+    {
+        unix_path_ = listen_on.substr(5);
+        sockaddr_un address = {};
+        if (unix_path_.empty() || unix_path_.size() >= sizeof(address.sun_path))
+        {
+            throw std::invalid_argument("Invalid unix socket path: " + unix_path_);
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, unix_path_.c_str(), unix_path_.size() + 1);
+
+        listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener == kInvalidSocket)
+        {
+            throw std::runtime_error("Failed to create unix socket");
+        }
+        // A stale socket file from an earlier run would make bind fail
+        remove_file(unix_path_);
+        if (::bind(listener, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            close_socket(listener);
+            throw std::runtime_error("Failed to bind unix socket: " + unix_path_);
+        }
+        endpoint_ = listen_on;
+    }
+    else
+    {
+        const std::size_t colon = listen_on.rfind(':');
+        if (colon == std::string::npos)
+        {
+            throw std::invalid_argument("Listen address must be host:port or unix:/path, got: " + listen_on);
+        }
+        const std::string host = listen_on.substr(0, colon);
+        const std::string port = listen_on.substr(colon + 1);
+
+        addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        addrinfo *resolved = nullptr;
+        if (::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &resolved) != 0 || resolved == nullptr)
+        {
+            throw std::runtime_error("Failed to resolve listen address: " + listen_on);
+        }
+
+        listener = ::socket(resolved->ai_family, resolved->ai_socktype, resolved->ai_protocol);
+        if (listener == kInvalidSocket)
+        {
+            ::freeaddrinfo(resolved);
+            throw std::runtime_error("Failed to create TCP socket");
+        }
+#if !defined(_WIN32)
+        const int reuse = 1;
+        ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+        const int bound = ::bind(listener, resolved->ai_addr, static_cast<int>(resolved->ai_addrlen));
+        ::freeaddrinfo(resolved);
+        if (bound != 0)
+        {
+            close_socket(listener);
+            throw std::runtime_error("Failed to bind " + listen_on);
+        }
+
+        // Report the real port when 0 asked the OS to choose
+        sockaddr_storage local = {};
+        socklen_t length = sizeof(local);
+        std::string actual_port = port;
+        if (::getsockname(listener, reinterpret_cast<sockaddr *>(&local), &length) == 0)
+        {
+            const unsigned short network_port = local.ss_family == AF_INET6
+                                                    ? reinterpret_cast<const sockaddr_in6 *>(&local)->sin6_port
+                                                    : reinterpret_cast<const sockaddr_in *>(&local)->sin_port;
+            actual_port = std::to_string(ntohs(network_port));
+        }
+        endpoint_ = host + ":" + actual_port;
+    }
+
+    if (::listen(listener, SOMAXCONN) != 0)
+    {
+        close_socket(listener);
+        throw std::runtime_error("Failed to listen on " + listen_on);
+    }
+
+    listener_ = handle(listener);
+    running_ = true;
+    engine_thread_ = std::thread(&InferenceServer::engine_loop, this);
+    accept_thread_ = std::thread(&InferenceServer::accept_loop, this);
+}
+
+void InferenceServer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(submit_mutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+    }
+    submit_ready_.notify_all();
+
+    // Unblock accept(): shutdown is enough on POSIX, Windows needs the socket closed
+    shutdown_socket(native(listener_));
+#if defined(_WIN32)
+    close_socket(native(listener_));
+#endif
+    accept_thread_.join();
+#if !defined(_WIN32)
+    close_socket(native(listener_));
+#endif
+    listener_ = handle(kInvalidSocket);
+
+    // The engine thread fails every open stream on exit, which releases waiting connections
+    engine_thread_.join();
+    reap_connections(true);
+
+    if (!unix_path_.empty())
+    {
+        remove_file(unix_path_);
+    }
+}
+
+void InferenceServer::accept_loop()
+{
+    const bool tcp = unix_path_.empty();
+    while (running_)
+    {
+        const NativeSocket client = ::accept(native(listener_), nullptr, nullptr);
+        if (client == kInvalidSocket)
+        {
+            if (!running_)
+            {
+                break;
+            }
+            continue;
+        }
+
+        if (tcp)
+        {
+            // Every streamed token is a small write that must leave immediately
+            const int no_delay = 1;
+            ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&no_delay), sizeof(no_delay));
+        }
+
+        reap_connections(false);
+
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        if (connections_.size() >= config_.max_connections)
+        {
+            send_response(handle(client), 503, error_body("Too many connections"));
+            close_socket(client);
+            continue;
+        }
+
+        connections_.emplace_back();
+        Connection &connection = connections_.back();
+        connection.socket = handle(client);
+        connection.thread = std::thread(&InferenceServer::serve, this, std::ref(connection));
+    }
+}
+
+void InferenceServer::serve(Connection &connection)
+{
+    HttpRequest request;
+    const int status = read_request(connection.socket, request);
+
+    if (status != 200)
+    {
+        send_response(connection.socket, status, error_body("Malformed request"));
+    }
+    else if (request.path == "/generate")
+    {
+        if (request.method == "POST")
+        {
+            handle_generate(connection.socket, request.body);
+        }
+        else
+        {
+            send_response(connection.socket, 405, error_body("Use POST /generate"));
+        }
+    }
+    else if (request.path == "/health")
+    {
+        handle_health(connection.socket);
+    }
+    else
+    {
+        send_response(connection.socket, 404, error_body("Unknown path: " + request.path));
+    }
+
+    // Every response says "Connection: close", so end it now for clients that read to EOF; the
+    // socket itself is closed by reap_connections once this thread has been joined
+    shutdown_socket(native(connection.socket));
+    connection.done = true;
+}
+
+void InferenceServer::handle_generate(std::intptr_t socket, const std::string &body)
+{
+    GenerationRequest request;
+    try
+    {
+        std::size_t text_pos = 0;
+        if (tokenizer_ != nullptr && json_value(body, "text", text_pos))
+        {
+            request.prompt = tokenizer_->encode(json_string(body, "text"));
+        }
+        else
+        {
+            request.prompt = json_int_array(body, "prompt");
+        }
+        json_number(body, "max_new_tokens", request.max_new_tokens);
+        json_number(body, "priority", request.priority);
+        json_number(body, "temperature", request.sampler.temperature);
+        json_number(body, "top_k", request.sampler.top_k);
+        json_number(body, "top_p", request.sampler.top_p);
+        json_number(body, "min_p", request.sampler.min_p);
+        json_number(body, "repetition_penalty", request.sampler.repetition_penalty);
+        json_number(body, "frequency_penalty", request.sampler.frequency_penalty);
+        json_number(body, "presence_penalty", request.sampler.presence_penalty);
+        json_number(body, "seed", request.sampler.seed);
+    }
+    catch (const std::exception &ex)
+    {
+        send_response(socket, 400, error_body(ex.what()));
+        return;
+    }
+
+    const auto start = Clock::now();
+    auto stream = std::make_shared<Stream>();
+    {
+        std::lock_guard<std::mutex> lock(submit_mutex_);
+        if (!running_)
+        {
+            send_response(socket, 503, error_body("Server is stopping"));
+            return;
+        }
+        submissions_.push_back({std::move(request), stream});
+    }
+    submit_ready_.notify_one();
+
+    std::unique_ptr<StreamingDetokenizer> detokenizer;
+    if (tokenizer_ != nullptr)
+    {
+        detokenizer = std::make_unique<StreamingDetokenizer>(*tokenizer_, true);
+    }
+
+    bool headers_sent = false;
+    std::size_t generated = 0;
+    double time_to_first_token_ms = 0.0;
+    std::vector<int> tokens;
+
+    while (true)
+    {
+        bool finished = false;
+        std::string error;
+        {
+            std::unique_lock<std::mutex> lock(stream->mutex);
+            stream->ready.wait(lock, [&] { return !stream->tokens.empty() || stream->finished || !stream->error.empty(); });
+            tokens.assign(stream->tokens.begin(), stream->tokens.end());
+            stream->tokens.clear();
+            finished = stream->finished;
+            error = stream->error;
+        }
+
+        // Rejections by the engine arrive before any token and still get a proper status
+        if (!headers_sent)
+        {
+            if (!error.empty() && tokens.empty())
+            {
+                send_response(socket, 400, error_body(error));
+                return;
+            }
+            const std::string headers = "HTTP/1.1 200 OK\r\n"
+                                        "Content-Type: application/x-ndjson\r\n"
+                                        "Transfer-Encoding: chunked\r\n"
+                                        "Cache-Control: no-cache\r\n"
+                                        "Connection: close\r\n\r\n";
+            if (!send_all(socket, headers))
+            {
+                stream->cancelled = true;
+                return;
+            }
+            headers_sent = true;
+            time_to_first_token_ms = elapsed_ms(start);
+        }
+
+        // Tokens that piled up while the client was being written to go out as one chunk
+        std::string chunk;
+        for (std::size_t i = 0; i < tokens.size(); ++i)
+        {
+            chunk += "{\"token\": " + std::to_string(tokens[i]);
+            if (detokenizer)
+            {
+                std::string text = detokenizer->push(tokens[i]);
+                if (finished && i + 1 == tokens.size())
+                {
+                    text += detokenizer->flush();
+                }
+                chunk += ", \"text\": \"" + json_escape(text) + "\"";
+            }
+            chunk += "}\n";
+        }
+        generated += tokens.size();
+
+        if (!error.empty())
+        {
+            chunk += error_body(error) + "\n";
+        }
+        else if (finished)
+        {
+            std::ostringstream done;
+            done << "{\"done\": true, \"generated\": " << generated
+                 << ", \"time_to_first_token_ms\": " << time_to_first_token_ms
+                 << ", \"total_ms\": " << elapsed_ms(start) << "}\n";
+            chunk += done.str();
+        }
+
+        if (!chunk.empty() && !send_chunk(socket, chunk))
+        {
+            // The client went away; the engine thread drops the sequence on its next pass
+            stream->cancelled = true;
+            submit_ready_.notify_one();
+            return;
+        }
+        if (finished || !error.empty())
+        {
+            send_all(socket, "0\r\n\r\n");
+            return;
+        }
+    }
+}
+
+void InferenceServer::handle_health(std::intptr_t socket)
+{
+    std::size_t connections = 0;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        connections = connections_.size();
+    }
+
+    std::ostringstream body;
+    body << "{\"status\": \"ok\", \"active\": " << active_.load()
+         << ", \"queued\": " << queued_.load()
+         << ", \"swapped\": " << swapped_.load()
+         << ", \"connections\": " << connections << "}";
+    send_response(socket, 200, body.str());
+}
+
+void InferenceServer::engine_loop()
+{
+    std::vector<Submission> incoming;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(submit_mutex_);
+            submit_ready_.wait(lock, [&] { return !running_ || !submissions_.empty() || engine_->has_work(); });
+            if (!running_)
+            {
+                break;
+            }
+            incoming.swap(submissions_);
+        }
+
+        for (Submission &submission : incoming)
+        {
+            try
+            {
+                const int id = engine_->submit(submission.request);
+                streams_[id] = std::move(submission.stream);
+            }
+            catch (const std::exception &ex)
+            {
+                std::lock_guard<std::mutex> lock(submission.stream->mutex);
+                submission.stream->error = ex.what();
+                submission.stream->ready.notify_one();
+            }
+        }
+        incoming.clear();
+
+        for (auto it = streams_.begin(); it != streams_.end();)
+        {
+            if (it->second->cancelled)
+            {
+                engine_->cancel(it->first);
+                it = streams_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        if (engine_->has_work())
+        {
+            std::vector<StepToken> produced;
+            try
+            {
+                produced = engine_->step();
+            }
+            catch (const std::exception &ex)
+            {
+                // The engine's state is unknown after a failed step, so start over with a fresh one
+                fail_streams(ex.what());
+                engine_ = std::make_unique<BatchEngine>(model_, config_.engine);
+            }
+
+            for (const StepToken &token : produced)
+            {
+                auto it = streams_.find(token.sequence_id);
+                if (it == streams_.end())
+                {
+                    continue;
+                }
+
+                Stream &stream = *it->second;
+                {
+                    std::lock_guard<std::mutex> lock(stream.mutex);
+                    stream.tokens.push_back(token.token);
+                    stream.finished = token.finished;
+                }
+                stream.ready.notify_one();
+                if (token.finished)
+                {
+                    streams_.erase(it);
+                }
+            }
+        }
+
+        active_ = engine_->active_count();
+        queued_ = engine_->queued_count();
+        swapped_ = engine_->swapped_count();
+    }
+
+    fail_streams("Server is stopping");
+    std::lock_guard<std::mutex> lock(submit_mutex_);
+    for (Submission &submission : submissions_)
+    {
+        std::lock_guard<std::mutex> stream_lock(submission.stream->mutex);
+        submission.stream->error = "Server is stopping";
+        submission.stream->ready.notify_one();
+    }
+    submissions_.clear();
+}
+
+void InferenceServer::fail_streams(const std::string &error)
+{
+    for (auto &entry : streams_)
+    {
+        Stream &stream = *entry.second;
+        {
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            stream.error = error;
+        }
+        stream.ready.notify_one();
+    }
+    streams_.clear();
+}
+
+void InferenceServer::reap_connections(bool all)
+{
+    // Join outside the lock: connection threads take it themselves for /health
+    std::list<Connection> finished;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (auto it = connections_.begin(); it != connections_.end();)
+        {
+            auto next = std::next(it);
+            if (all && !it->done)
+            {
+                // Wakes a connection still blocked reading its request
+                shutdown_socket(native(it->socket));
+            }
+            if (all || it->done)
+            {
+                finished.splice(finished.end(), connections_, it);
+            }
+            it = next;
+        }
+    }
+
+    for (Connection &connection : finished)
+    {
+        connection.thread.join();
+        close_socket(native(connection.socket));
+    }
+}
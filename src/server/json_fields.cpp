@@ -0,0 +1,190 @@
+#include <server/json_fields.h>
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+
+namespace
+{
+void append_utf8(std::uint32_t cp, std::string &out)
+{
+    if (cp < 0x80)
+    {
+        out += static_cast<char>(cp);
+    }
+    else if (cp < 0x800)
+    {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000)
+    {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+} // namespace
+
+std::string json_escape(const std::string &text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char code[8];
+                std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+                escaped += code;
+            }
+            else
+            {
+                escaped += c;
+            }
+        }
+    }
+    return escaped;
+}
+
+bool json_value(const std::string &body, const char *key, std::size_t &pos)
+{
+    const std::string quoted = std::string("\"") + key + "\"";
+    std::size_t at = body.find(quoted);
+    while (at != std::string::npos)
+    {
+        pos = at + quoted.size();
+        while (pos < body.size() && std::isspace(static_cast<unsigned char>(body[pos])))
+        {
+            ++pos;
+        }
+        if (pos < body.size() && body[pos] == ':')
+        {
+            ++pos;
+            while (pos < body.size() && std::isspace(static_cast<unsigned char>(body[pos])))
+            {
+                ++pos;
+            }
+            return true;
+        }
+        at = body.find(quoted, at + 1);
+    }
+    return false;
+}
+
+std::string json_string(const std::string &body, const char *key)
+{
+    std::size_t pos = 0;
+    if (!json_value(body, key, pos) || body[pos] != '"')
+    {
+        throw std::invalid_argument(std::string("Expected a string for \"") + key + "\"");
+    }
+
+    auto hex4 = [&](std::size_t at)
+    {
+        if (at + 4 > body.size())
+        {
+            throw std::invalid_argument(std::string("Truncated escape in \"") + key + "\"");
+        }
+        return static_cast<std::uint32_t>(std::strtoul(body.substr(at, 4).c_str(), nullptr, 16));
+    };
+
+    std::string out;
+    for (++pos; pos < body.size() && body[pos] != '"'; ++pos)
+    {
+        if (body[pos] != '\\' || pos + 1 >= body.size())
+        {
+            out += body[pos];
+            continue;
+        }
+        switch (body[++pos])
+        {
+        case 'n':
+            out += '\n';
+            break;
+        case 'r':
+            out += '\r';
+            break;
+        case 't':
+            out += '\t';
+            break;
+        case 'b':
+            out += '\b';
+            break;
+        case 'f':
+            out += '\f';
+            break;
+        case 'u':
+        {
+            std::uint32_t cp = hex4(pos + 1);
+            pos += 4;
+            if (cp >= 0xD800 && cp <= 0xDBFF && body.compare(pos + 1, 2, "\\u") == 0)
+            {
+                const std::uint32_t low = hex4(pos + 3);
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                pos += 6;
+            }
+            append_utf8(cp, out);
+            break;
+        }
+        default:
+            out += body[pos]; // \" \\ \/
+        }
+    }
+    if (pos >= body.size())
+    {
+        throw std::invalid_argument(std::string("Unterminated string for \"") + key + "\"");
+    }
+    return out;
+}
+
+std::vector<int> json_int_array(const std::string &body, const char *key)
+{
+    std::size_t pos = 0;
+    if (!json_value(body, key, pos) || body[pos] != '[')
+    {
+        throw std::invalid_argument(std::string("Expected an array of token ids for \"") + key + "\"");
+    }
+
+    std::vector<int> values;
+    const char *cursor = body.c_str() + pos + 1;
+    while (true)
+    {
+        while (std::isspace(static_cast<unsigned char>(*cursor)) || *cursor == ',')
+        {
+            ++cursor;
+        }
+        if (*cursor == ']')
+        {
+            return values;
+        }
+
+        char *end = nullptr;
+        const long value = std::strtol(cursor, &end, 10);
+        if (end == cursor)
+        {
+            throw std::invalid_argument(std::string("Malformed array for \"") + key + "\"");
+        }
+        values.push_back(static_cast<int>(value));
+        cursor = end;
+    }
+}
@@ -0,0 +1,242 @@
+#include <tensor/kv_swap.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#include <chrono>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double elapsed_ms(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+std::uint64_t slot_bytes(const KVCache &cache, std::size_t tokens)
+{
+    return 2ull * cache.get_num_layers() * cache.get_num_groups() * tokens * cache.get_head_dim() * sizeof(float);
+}
+} // namespace
+
+KVSwapFile::KVSwapFile(const std::string &path)
+    : path_(path),
+      file_end_(0)
+{
+#if defined(_WIN32)
+    handle_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                          FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+    if (handle_ == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("Failed to create KV swap file: " + path);
+    }
+#else
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd_ < 0)
+    {
+        throw std::runtime_error("Failed to create KV swap file: " + path + " (" + std::strerror(errno) + ")");
+    }
+    // Only the descriptor keeps the file alive
+    ::unlink(path.c_str());
+#endif
+}
+
+KVSwapFile::~KVSwapFile()
+{
+#if defined(_WIN32)
+    if (handle_ != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(handle_);
+    }
+#else
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+#endif
+}
+
+KVSwapSlot KVSwapFile::swap_out(const KVCache &cache)
+{
+    const auto start = Clock::now();
+
+    KVSwapSlot slot;
+    slot.tokens = cache.get_current_token_idx();
+    slot.bytes = slot_bytes(cache, slot.tokens);
+    slot.offset = slot.bytes > 0 ? allocate(slot.bytes) : 0;
+
+    // Rows of one (layer, group) are contiguous in the cache, so each is a single write
+    const std::size_t rows_bytes = slot.tokens * cache.get_head_dim() * sizeof(float);
+    std::uint64_t offset = slot.offset;
+    for (std::size_t layer = 0; layer < cache.get_num_layers() && rows_bytes > 0; ++layer)
+    {
+        for (std::size_t group = 0; group < cache.get_num_groups(); ++group)
+        {
+            write_at(cache.get_key_memory_ptr(layer, group), rows_bytes, offset);
+            offset += rows_bytes;
+            write_at(cache.get_value_memory_ptr(layer, group), rows_bytes, offset);
+            offset += rows_bytes;
+        }
+    }
+
+    ++stats_.swap_outs;
+    stats_.bytes_out += slot.bytes;
+    stats_.swap_out_ms += elapsed_ms(start);
+    return slot;
+}
+
+void KVSwapFile::swap_in(const KVSwapSlot &slot, KVCache &cache)
+{
+    if (slot.bytes != slot_bytes(cache, slot.tokens) || slot.tokens >= cache.get_max_sequence_length())
+    {
+        throw std::invalid_argument("KV swap slot does not match the cache shape");
+    }
+
+    const auto start = Clock::now();
+
+    const std::size_t rows_bytes = slot.tokens * cache.get_head_dim() * sizeof(float);
+    std::uint64_t offset = slot.offset;
+    for (std::size_t layer = 0; layer < cache.get_num_layers() && rows_bytes > 0; ++layer)
+    {
+        for (std::size_t group = 0; group < cache.get_num_groups(); ++group)
+        {
+            read_at(cache.get_key_memory_ptr(layer, group), rows_bytes, offset);
+            offset += rows_bytes;
+            read_at(cache.get_value_memory_ptr(layer, group), rows_bytes, offset);
+            offset += rows_bytes;
+        }
+    }
+
+    cache.reset();
+    if (slot.tokens > 0)
+    {
+        cache.advance(slot.tokens);
+    }
+    release(slot);
+
+    ++stats_.swap_ins;
+    stats_.bytes_in += slot.bytes;
+    stats_.swap_in_ms += elapsed_ms(start);
+}
+
+void KVSwapFile::release(const KVSwapSlot &slot)
+{
+    if (slot.bytes == 0)
+    {
+        return;
+    }
+
+    // Insert and merge with adjacent free extents
+    auto it = free_extents_.emplace(slot.offset, slot.bytes).first;
+    auto next = std::next(it);
+    if (next != free_extents_.end() && it->first + it->second == next->first)
+    {
+        it->second += next->second;
+        free_extents_.erase(next);
+    }
+    if (it != free_extents_.begin())
+    {
+        auto prev = std::prev(it);
+        if (prev->first + prev->second == it->first)
+        {
+            prev->second += it->second;
+            free_extents_.erase(it);
+        }
+    }
+}
+
+std::uint64_t KVSwapFile::allocate(std::uint64_t bytes)
+{
+    for (auto it = free_extents_.begin(); it != free_extents_.end(); ++it)
+    {
+        if (it->second >= bytes)
+        {
+            const std::uint64_t offset = it->first;
+            const std::uint64_t remaining = it->second - bytes;
+            free_extents_.erase(it);
+            if (remaining > 0)
+            {
+                free_extents_.emplace(offset + bytes, remaining);
+            }
+            return offset;
+        }
+    }
+
+    const std::uint64_t offset = file_end_;
+    file_end_ += bytes;
+    return offset;
+}
+
+void KVSwapFile::write_at(const void *data, std::size_t bytes, std::uint64_t offset)
+{
+    const char *src = static_cast<const char *>(data);
+    while (bytes > 0)
+    {
+#if defined(_WIN32)
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFull);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD written = 0;
+        const DWORD request = static_cast<DWORD>(bytes > 0x40000000u ? 0x40000000u : bytes);
+        if (!WriteFile(handle_, src, request, &written, &overlapped) || written == 0)
+        {
+            throw std::runtime_error("KV swap write failed: " + path_);
+        }
+#else
+        const ssize_t written = ::pwrite(fd_, src, bytes, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            throw std::runtime_error("KV swap write failed: " + path_ + " (" + std::strerror(errno) + ")");
+        }
+#endif
+        src += written;
+        bytes -= static_cast<std::size_t>(written);
+        offset += static_cast<std::uint64_t>(written);
+    }
+}
+
+void KVSwapFile::read_at(void *data, std::size_t bytes, std::uint64_t offset)
+{
+    char *dst = static_cast<char *>(data);
+    while (bytes > 0)
+    {
+#if defined(_WIN32)
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFull);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD read = 0;
+        const DWORD request = static_cast<DWORD>(bytes > 0x40000000u ? 0x40000000u : bytes);
+        if (!ReadFile(handle_, dst, request, &read, &overlapped) || read == 0)
+        {
+            throw std::runtime_error("KV swap read failed: " + path_);
+        }
+#else
+        const ssize_t read = ::pread(fd_, dst, bytes, static_cast<off_t>(offset));
+        if (read < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (read <= 0)
+        {
+            throw std::runtime_error("KV swap read failed: " + path_ + " (" + std::strerror(errno) + ")");
+        }
+#endif
+        dst += read;
+        bytes -= static_cast<std::size_t>(read);
+        offset += static_cast<std::uint64_t>(read);
+    }
+}
@@ -89,6 +89,18 @@ const float *KVCache::get_value_memory_ptr(size_t layer, size_t group) const
     return value_cache_ + get_value_offset(layer, group, 0);
 }
 
+float *KVCache::get_key_memory_ptr(size_t layer, size_t group)
+{
+    check_indices(layer, group);
+    return key_cache_ + get_key_offset(layer, group, 0);
+}
+
+float *KVCache::get_value_memory_ptr(size_t layer, size_t group)
+{
+    check_indices(layer, group);
+    return value_cache_ + get_value_offset(layer, group, 0);
+}
+
 const float *KVCache::get_full_key_cache_ptr() const
 {
     return key_cache_;
@@ -186,11 +198,30 @@ void KVCache::advance()
     current_token_idx_++;
 }
 
+void KVCache::advance(size_t count)
+{
+    if (current_token_idx_ + count > max_sequence_length_ - 1)
+    {
+        throw std::runtime_error("Token limit reached: " + std::to_string(max_sequence_length_));
+    }
+    current_token_idx_ += count;
+}
+
 void KVCache::reset()
 {
     current_token_idx_ = 0;
 }
 
+void KVCache::truncate(size_t token_count)
+{
+    if (token_count > current_token_idx_)
+    {
+        throw std::out_of_range("Cannot truncate KV cache to " + std::to_string(token_count) +
+                                " tokens, only " + std::to_string(current_token_idx_) + " cached");
+    }
+    current_token_idx_ = token_count;
+}
+
 size_t KVCache::get_current_token_idx() const
 {
     return current_token_idx_;
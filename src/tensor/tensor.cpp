@@ -42,6 +42,18 @@ void PrefetchManager::stop()
         worker_thread_.join();
 }
 
+void PrefetchManager::set_affinity(const std::vector<int> &cpus)
+{
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus)
+    {
+        if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8))
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+    }
+    if (mask != 0 && worker_thread_.joinable())
+        SetThreadAffinityMask(worker_thread_.native_handle(), mask);
+}
+
 void PrefetchManager::worker_loop()
 {
     while (running_.load())
@@ -0,0 +1,950 @@
+#include <tokenizer/bpe_tokenizer.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+const char kReplacement[] = "\xEF\xBF\xBD"; // U+FFFD
+
+/*
+Minimal pull parser over a tokenizer.json buffer; callers walk the parts they need and skip the
+rest. Strings are unescaped to UTF-8, including surrogate pairs.
+*/
+class JsonReader
+{
+public:
+    explicit JsonReader(const std::string &text)
+        : begin_(text.data()), pos_(text.data()), end_(text.data() + text.size())
+    {
+    }
+
+    char peek()
+    {
+        skip_whitespace();
+        return pos_ < end_ ? *pos_ : '\0';
+    }
+
+    bool consume(char c)
+    {
+        if (peek() == c)
+        {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c)
+    {
+        if (!consume(c))
+        {
+            fail(std::string("expected '") + c + "'");
+        }
+    }
+
+    template <typename OnKey>
+    void object(OnKey on_key)
+    {
+        expect('{');
+        if (consume('}'))
+        {
+            return;
+        }
+        do
+        {
+            const std::string key = string();
+            expect(':');
+            on_key(key);
+        } while (consume(','));
+        expect('}');
+    }
+
+    template <typename OnItem>
+    void array(OnItem on_item)
+    {
+        expect('[');
+        if (consume(']'))
+        {
+            return;
+        }
+        do
+        {
+            on_item();
+        } while (consume(','));
+        expect(']');
+    }
+
+    std::string string()
+    {
+        expect('"');
+        std::string out;
+        while (pos_ < end_ && *pos_ != '"')
+        {
+            const char c = *pos_++;
+            if (c != '\\')
+            {
+                out += c;
+                continue;
+            }
+            if (pos_ >= end_)
+            {
+                break;
+            }
+            switch (*pos_++)
+            {
+            case '"':
+                out += '"';
+                break;
+            case '\\':
+                out += '\\';
+                break;
+            case '/':
+                out += '/';
+                break;
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u':
+            {
+                std::uint32_t cp = hex4();
+                if (cp >= 0xD800 && cp <= 0xDBFF && end_ - pos_ >= 6 && pos_[0] == '\\' && pos_[1] == 'u')
+                {
+                    pos_ += 2;
+                    const std::uint32_t low = hex4();
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(cp, out);
+                break;
+            }
+            default:
+                fail("bad escape");
+            }
+        }
+        expect('"');
+        return out;
+    }
+
+    long long integer()
+    {
+        skip_whitespace();
+        char *end = nullptr;
+        const long long value = std::strtoll(pos_, &end, 10);
+        if (end == pos_)
+        {
+            fail("expected an integer");
+        }
+        pos_ = end;
+        return value;
+    }
+
+    bool boolean()
+    {
+        skip_whitespace();
+        if (end_ - pos_ >= 4 && std::equal(pos_, pos_ + 4, "true"))
+        {
+            pos_ += 4;
+            return true;
+        }
+        if (end_ - pos_ >= 5 && std::equal(pos_, pos_ + 5, "false"))
+        {
+            pos_ += 5;
+            return false;
+        }
+        fail("expected a boolean");
+        return false;
+    }
+
+    void skip()
+    {
+        switch (peek())
+        {
+        case '{':
+            object([this](const std::string &) { skip(); });
+            break;
+        case '[':
+            array([this] { skip(); });
+            break;
+        case '"':
+            string();
+            break;
+        default:
+            // Numbers and literals
+            while (pos_ < end_ && *pos_ != ',' && *pos_ != '}' && *pos_ != ']' &&
+                   *pos_ != ' ' && *pos_ != '\n' && *pos_ != '\r' && *pos_ != '\t')
+            {
+                ++pos_;
+            }
+        }
+    }
+
+    static void append_utf8(std::uint32_t cp, std::string &out)
+    {
+        if (cp < 0x80)
+        {
+            out += static_cast<char>(cp);
+        }
+        else if (cp < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+private:
+    void skip_whitespace()
+    {
+        while (pos_ < end_ && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '\r' || *pos_ == '\t'))
+        {
+            ++pos_;
+        }
+    }
+
+    std::uint32_t hex4()
+    {
+        if (end_ - pos_ < 4)
+        {
+            fail("truncated \\u escape");
+        }
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            const char c = *pos_++;
+            value <<= 4;
+            if (c >= '0' && c <= '9')
+                value |= static_cast<std::uint32_t>(c - '0');
+            else if (c >= 'a' && c <= 'f')
+                value |= static_cast<std::uint32_t>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F')
+                value |= static_cast<std::uint32_t>(c - 'A' + 10);
+            else
+                fail("bad \\u escape");
+        }
+        return value;
+    }
+
+    [[noreturn]] void fail(const std::string &what) const
+    {
+        throw std::runtime_error("Malformed tokenizer.json at offset " + std::to_string(pos_ - begin_) + ": " + what);
+    }
+
+    const char *begin_;
+    const char *pos_;
+    const char *end_;
+};
+
+// Decodes one code point at pos; invalid bytes decode as U+FFFD with length 1
+std::uint32_t next_codepoint(const std::string &text, std::size_t pos, std::size_t &length)
+{
+    const unsigned char lead = static_cast<unsigned char>(text[pos]);
+    std::size_t expected = 0;
+    std::uint32_t cp = 0;
+    if (lead < 0x80)
+    {
+        length = 1;
+        return lead;
+    }
+    else if (lead >= 0xC2 && lead <= 0xDF)
+    {
+        expected = 2;
+        cp = lead & 0x1F;
+    }
+    else if (lead >= 0xE0 && lead <= 0xEF)
+    {
+        expected = 3;
+        cp = lead & 0x0F;
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4)
+    {
+        expected = 4;
+        cp = lead & 0x07;
+    }
+
+    if (expected == 0 || pos + expected > text.size())
+    {
+        length = 1;
+        return 0xFFFD;
+    }
+    for (std::size_t i = 1; i < expected; ++i)
+    {
+        const unsigned char c = static_cast<unsigned char>(text[pos + i]);
+        if ((c & 0xC0) != 0x80)
+        {
+            length = 1;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (c & 0x3F);
+    }
+    length = expected;
+    return cp;
+}
+
+/*
+Appends the valid UTF-8 in bytes to out, replacing invalid sequences with U+FFFD. Unless final,
+stops in front of a trailing sequence that is incomplete but could still become valid, and
+returns the number of bytes consumed.
+*/
+std::size_t append_valid_utf8(const std::string &bytes, std::string &out, bool final)
+{
+    std::size_t pos = 0;
+    while (pos < bytes.size())
+    {
+        const unsigned char lead = static_cast<unsigned char>(bytes[pos]);
+        if (lead < 0x80)
+        {
+            out += static_cast<char>(lead);
+            ++pos;
+            continue;
+        }
+
+        std::size_t expected = 0;
+        unsigned char low = 0x80, high = 0xBF; // allowed range of the second byte
+        if (lead >= 0xC2 && lead <= 0xDF)
+            expected = 2;
+        else if (lead >= 0xE0 && lead <= 0xEF)
+        {
+            expected = 3;
+            low = lead == 0xE0 ? 0xA0 : 0x80; // overlong
+            high = lead == 0xED ? 0x9F : 0xBF; // surrogates
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4)
+        {
+            expected = 4;
+            low = lead == 0xF0 ? 0x90 : 0x80;
+            high = lead == 0xF4 ? 0x8F : 0xBF;
+        }
+
+        if (expected == 0)
+        {
+            out += kReplacement;
+            ++pos;
+            continue;
+        }
+
+        std::size_t valid = 1;
+        while (valid < expected && pos + valid < bytes.size())
+        {
+            const unsigned char c = static_cast<unsigned char>(bytes[pos + valid]);
+            const bool ok = valid == 1 ? (c >= low && c <= high) : (c & 0xC0) == 0x80;
+            if (!ok)
+            {
+                break;
+            }
+            ++valid;
+        }
+
+        if (valid == expected)
+        {
+            out.append(bytes, pos, expected);
+            pos += expected;
+        }
+        else if (pos + valid == bytes.size() && !final)
+        {
+            break; // wait for the rest of the character
+        }
+        else
+        {
+            out += kReplacement;
+            pos += valid;
+        }
+    }
+    return pos;
+}
+
+bool is_whitespace(std::uint32_t cp)
+{
+    return cp == ' ' || (cp >= 0x09 && cp <= 0x0D) || cp == 0x85 || cp == 0xA0 || cp == 0x1680 ||
+           (cp >= 0x2000 && cp <= 0x200A) || cp == 0x2028 || cp == 0x2029 || cp == 0x202F ||
+           cp == 0x205F || cp == 0x3000;
+}
+
+bool is_number(std::uint32_t cp)
+{
+    if (cp < 0x80)
+    {
+        return cp >= '0' && cp <= '9';
+    }
+    return cp == 0xB2 || cp == 0xB3 || cp == 0xB9 || (cp >= 0xBC && cp <= 0xBE) ||
+           (cp >= 0x0660 && cp <= 0x0669) || (cp >= 0x06F0 && cp <= 0x06F9) ||
+           (cp >= 0x0966 && cp <= 0x096F) || (cp >= 0x2070 && cp <= 0x2079 && cp != 0x2071) ||
+           (cp >= 0x2080 && cp <= 0x2089) || (cp >= 0x2150 && cp <= 0x2189) ||
+           (cp >= 0x2460 && cp <= 0x249B) || (cp >= 0x24EA && cp <= 0x24FF) ||
+           (cp >= 0x2776 && cp <= 0x2793) || cp == 0x3007 || (cp >= 0x3021 && cp <= 0x3029) ||
+           (cp >= 0xFF10 && cp <= 0xFF19);
+}
+
+bool is_letter(std::uint32_t cp)
+{
+    if (cp < 0x80)
+    {
+        return (cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z');
+    }
+    if (cp < 0x100)
+    {
+        return cp == 0xAA || cp == 0xB5 || cp == 0xBA || (cp >= 0xC0 && cp != 0xD7 && cp != 0xF7);
+    }
+    if (is_whitespace(cp) || is_number(cp))
+    {
+        return false;
+    }
+    // Combining marks, punctuation and symbol blocks; everything else is treated as a letter
+    return !((cp >= 0x0300 && cp <= 0x036F) || cp == 0x037E || cp == 0x0387 ||
+             cp == 0x060C || cp == 0x061B || cp == 0x061F || (cp >= 0x066A && cp <= 0x066D) || cp == 0x06D4 ||
+             cp == 0x0964 || cp == 0x0965 ||
+             (cp >= 0x2000 && cp <= 0x2BFF) || (cp >= 0x2E00 && cp <= 0x2E7F) ||
+             (cp >= 0x3000 && cp <= 0x3004) || (cp >= 0x3008 && cp <= 0x3020) || cp == 0x3030 || cp == 0x303D ||
+             (cp >= 0xD800 && cp <= 0xF8FF) || (cp >= 0xFE10 && cp <= 0xFE1F) || (cp >= 0xFE30 && cp <= 0xFE6F) ||
+             (cp >= 0xFF00 && cp <= 0xFF20) || (cp >= 0xFF3B && cp <= 0xFF40) || (cp >= 0xFF5B && cp <= 0xFF65) ||
+             (cp >= 0xFFE0 && cp <= 0xFFFF) || (cp >= 0x1F000 && cp <= 0x1FAFF) || cp >= 0xE0000);
+}
+
+// GPT-2 byte-level alphabet: printable bytes map to themselves, the rest to U+0100 onwards
+void build_byte_decoder(int (&decoder)[324])
+{
+    std::fill(std::begin(decoder), std::end(decoder), -1);
+    int next = 256;
+    for (int b = 0; b < 256; ++b)
+    {
+        const bool printable = (b >= 33 && b <= 126) || (b >= 161 && b <= 172) || (b >= 174 && b <= 255);
+        decoder[printable ? b : next++] = b;
+    }
+}
+
+// Undoes the byte-level mapping of a vocabulary string; strings outside the alphabet stay as-is
+std::string byte_level_to_bytes(const std::string &token, const int (&decoder)[324])
+{
+    std::string bytes;
+    bytes.reserve(token.size());
+    for (std::size_t pos = 0; pos < token.size();)
+    {
+        std::size_t length = 0;
+        const std::uint32_t cp = next_codepoint(token, pos, length);
+        if (cp >= 324 || decoder[cp] < 0)
+        {
+            return token;
+        }
+        bytes += static_cast<char>(decoder[cp]);
+        pos += length;
+    }
+    return bytes;
+}
+
+std::uint64_t pair_key(int left, int right)
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(left)) << 32) | static_cast<std::uint32_t>(right);
+}
+} // namespace
+
+void BpeTokenizer::load(const std::string &tokenizer_json_path)
+{
+    std::ifstream file(tokenizer_json_path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open tokenizer file: " + tokenizer_json_path);
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    load_from_string(buffer.str());
+}
+
+void BpeTokenizer::load_from_string(const std::string &tokenizer_json)
+{
+    int byte_decoder[324];
+    build_byte_decoder(byte_decoder);
+
+    std::unordered_map<std::string, int> vocab;
+    std::vector<std::pair<std::string, std::string>> merge_pairs;
+    std::vector<AddedToken> added;
+    std::string model_type = "BPE";
+
+    JsonReader reader(tokenizer_json);
+    reader.object([&](const std::string &key)
+    {
+        if (key == "added_tokens")
+        {
+            reader.array([&]
+            {
+                AddedToken token{-1, std::string(), false};
+                reader.object([&](const std::string &field)
+                {
+                    if (field == "id")
+                        token.id = static_cast<int>(reader.integer());
+                    else if (field == "content")
+                        token.content = reader.string();
+                    else if (field == "special")
+                        token.special = reader.boolean();
+                    else
+                        reader.skip();
+                });
+                added.push_back(std::move(token));
+            });
+        }
+        else if (key == "model")
+        {
+            reader.object([&](const std::string &field)
+            {
+                if (field == "type")
+                {
+                    model_type = reader.string();
+                }
+                else if (field == "vocab")
+                {
+                    reader.object([&](const std::string &token)
+                    {
+                        vocab[byte_level_to_bytes(token, byte_decoder)] = static_cast<int>(reader.integer());
+                    });
+                }
+                else if (field == "merges")
+                {
+                    // "a b" strings in older files, ["a", "b"] pairs in newer ones
+                    reader.array([&]
+                    {
+                        std::string left, right;
+                        if (reader.peek() == '"')
+                        {
+                            const std::string merge = reader.string();
+                            const std::size_t space = merge.find(' ');
+                            if (space == std::string::npos)
+                            {
+                                throw std::runtime_error("Malformed merge in tokenizer.json: " + merge);
+                            }
+                            left = merge.substr(0, space);
+                            right = merge.substr(space + 1);
+                        }
+                        else
+                        {
+                            int part = 0;
+                            reader.array([&] { (part++ == 0 ? left : right) = reader.string(); });
+                        }
+                        merge_pairs.emplace_back(byte_level_to_bytes(left, byte_decoder), byte_level_to_bytes(right, byte_decoder));
+                    });
+                }
+                else
+                {
+                    reader.skip();
+                }
+            });
+        }
+        else
+        {
+            reader.skip();
+        }
+    });
+
+    if (model_type != "BPE")
+    {
+        throw std::runtime_error("Unsupported tokenizer model type: " + model_type);
+    }
+    if (vocab.empty())
+    {
+        throw std::runtime_error("tokenizer.json has no model.vocab");
+    }
+
+    int max_id = -1;
+    for (const auto &entry : vocab)
+    {
+        max_id = std::max(max_id, entry.second);
+    }
+    for (const AddedToken &token : added)
+    {
+        max_id = std::max(max_id, token.id);
+    }
+
+    id_to_bytes_.assign(static_cast<std::size_t>(max_id) + 1, std::string());
+    special_.assign(id_to_bytes_.size(), false);
+    for (const auto &entry : vocab)
+    {
+        if (entry.second < 0)
+        {
+            throw std::runtime_error("Negative token id in tokenizer.json");
+        }
+        id_to_bytes_[entry.second] = entry.first;
+    }
+    bytes_to_id_ = std::move(vocab);
+
+    std::fill(std::begin(byte_ids_), std::end(byte_ids_), -1);
+    for (int b = 0; b < 256; ++b)
+    {
+        auto it = bytes_to_id_.find(std::string(1, static_cast<char>(b)));
+        if (it != bytes_to_id_.end())
+        {
+            byte_ids_[b] = it->second;
+        }
+    }
+
+    merges_.clear();
+    merges_.reserve(merge_pairs.size());
+    for (std::size_t rank = 0; rank < merge_pairs.size(); ++rank)
+    {
+        const auto &pair = merge_pairs[rank];
+        auto left = bytes_to_id_.find(pair.first);
+        auto right = bytes_to_id_.find(pair.second);
+        auto merged = bytes_to_id_.find(pair.first + pair.second);
+        if (left == bytes_to_id_.end() || right == bytes_to_id_.end() || merged == bytes_to_id_.end())
+        {
+            throw std::runtime_error("tokenizer.json merge refers to a token missing from the vocab");
+        }
+        // The first occurrence of a pair wins, as in the reference implementation
+        merges_.emplace(pair_key(left->second, right->second), Merge{static_cast<int>(rank), merged->second});
+    }
+
+    added_tokens_.clear();
+    for (AddedToken &token : added)
+    {
+        if (token.id < 0 || token.content.empty())
+        {
+            continue;
+        }
+        id_to_bytes_[token.id] = token.content;
+        special_[token.id] = token.special;
+        added_tokens_.push_back(std::move(token));
+    }
+    std::stable_sort(added_tokens_.begin(), added_tokens_.end(),
+                     [](const AddedToken &a, const AddedToken &b) { return a.content.size() > b.content.size(); });
+}
+
+std::vector<int> BpeTokenizer::encode(const std::string &text, bool parse_special) const
+{
+    std::vector<int> ids;
+    ids.reserve(text.size() / 3 + 1);
+
+    auto encode_segment = [&](std::size_t begin, std::size_t end)
+    {
+        if (begin == end)
+        {
+            return;
+        }
+        for (const std::string &word : pre_tokenize(text.substr(begin, end - begin)))
+        {
+            encode_word(word, ids);
+        }
+    };
+
+    std::size_t segment = 0;
+    std::size_t pos = 0;
+    while (pos < text.size())
+    {
+        const AddedToken *match = nullptr;
+        for (const AddedToken &token : added_tokens_)
+        {
+            if (text[pos] == token.content[0] && (parse_special || !token.special) &&
+                text.compare(pos, token.content.size(), token.content) == 0)
+            {
+                match = &token;
+                break;
+            }
+        }
+
+        if (match == nullptr)
+        {
+            ++pos;
+            continue;
+        }
+        encode_segment(segment, pos);
+        ids.push_back(match->id);
+        pos += match->content.size();
+        segment = pos;
+    }
+    encode_segment(segment, text.size());
+
+    return ids;
+}
+
+void BpeTokenizer::encode_word(const std::string &word, std::vector<int> &ids) const
+{
+    // Symbols form a linked list so a merge unlinks its right half in O(1); removed ones get id -1
+    struct Symbol
+    {
+        int id;
+        int prev;
+        int next;
+    };
+    std::vector<Symbol> symbols;
+    symbols.reserve(word.size());
+    for (unsigned char byte : word)
+    {
+        if (byte_ids_[byte] < 0)
+        {
+            throw std::runtime_error("Tokenizer vocab has no token for byte " + std::to_string(byte));
+        }
+        const int index = static_cast<int>(symbols.size());
+        symbols.push_back({byte_ids_[byte], index - 1, index + 1});
+    }
+    if (symbols.empty())
+    {
+        return;
+    }
+    symbols.back().next = -1;
+
+    // Adjacent pairs that have a merge, lowest rank first and leftmost among equal ranks. Entries
+    // go stale when either side merges first; the ids they were pushed with tell them apart.
+    struct Candidate
+    {
+        int rank;
+        int left;
+        int right;
+        int left_id;
+        int right_id;
+        int merged;
+
+        bool operator>(const Candidate &other) const
+        {
+            return rank != other.rank ? rank > other.rank : left > other.left;
+        }
+    };
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> queue;
+    auto push_pair = [&](int left)
+    {
+        if (left < 0 || symbols[left].next < 0)
+        {
+            return;
+        }
+        const int right = symbols[left].next;
+        auto it = merges_.find(pair_key(symbols[left].id, symbols[right].id));
+        if (it != merges_.end())
+        {
+            queue.push({it->second.rank, left, right, symbols[left].id, symbols[right].id, it->second.merged});
+        }
+    };
+    for (int i = 0; i + 1 < static_cast<int>(symbols.size()); ++i)
+    {
+        push_pair(i);
+    }
+
+    while (!queue.empty())
+    {
+        const Candidate top = queue.top();
+        queue.pop();
+        Symbol &left = symbols[top.left];
+        Symbol &right = symbols[top.right];
+        if (left.id != top.left_id || right.id != top.right_id || left.next != top.right)
+        {
+            continue;
+        }
+        left.id = top.merged;
+        left.next = right.next;
+        if (right.next >= 0)
+        {
+            symbols[right.next].prev = top.left;
+        }
+        right.id = -1;
+        push_pair(left.prev);
+        push_pair(top.left);
+    }
+
+    for (int i = 0; i >= 0; i = symbols[i].next)
+    {
+        ids.push_back(symbols[i].id);
+    }
+}
+
+std::string BpeTokenizer::decode(const int *ids, std::size_t count, bool skip_special) const
+{
+    std::string bytes;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (skip_special && is_special(ids[i]))
+        {
+            continue;
+        }
+        bytes += token_bytes(ids[i]);
+    }
+
+    std::string text;
+    text.reserve(bytes.size());
+    append_valid_utf8(bytes, text, true);
+    return text;
+}
+
+const std::string &BpeTokenizer::token_bytes(int id) const
+{
+    if (id < 0 || static_cast<std::size_t>(id) >= id_to_bytes_.size())
+    {
+        throw std::out_of_range("Token id out of tokenizer range");
+    }
+    return id_to_bytes_[id];
+}
+
+int BpeTokenizer::token_to_id(const std::string &token) const
+{
+    for (const AddedToken &added : added_tokens_)
+    {
+        if (added.content == token)
+        {
+            return added.id;
+        }
+    }
+    auto it = bytes_to_id_.find(token);
+    return it != bytes_to_id_.end() ? it->second : -1;
+}
+
+bool BpeTokenizer::is_special(int id) const
+{
+    return id >= 0 && static_cast<std::size_t>(id) < special_.size() && special_[id];
+}
+
+std::vector<std::string> BpeTokenizer::pre_tokenize(const std::string &text)
+{
+    // Code points with their byte offsets; offsets[n] is the end of the text
+    std::vector<std::uint32_t> cps;
+    std::vector<std::size_t> offsets;
+    cps.reserve(text.size());
+    offsets.reserve(text.size() + 1);
+    for (std::size_t pos = 0; pos < text.size();)
+    {
+        std::size_t length = 0;
+        cps.push_back(next_codepoint(text, pos, length));
+        offsets.push_back(pos);
+        pos += length;
+    }
+    offsets.push_back(text.size());
+
+    const std::size_t n = cps.size();
+    auto letter = [&](std::size_t i) { return i < n && is_letter(cps[i]); };
+    auto number = [&](std::size_t i) { return i < n && is_number(cps[i]); };
+    auto space = [&](std::size_t i) { return i < n && is_whitespace(cps[i]); };
+    auto newline = [&](std::size_t i) { return i < n && (cps[i] == '\r' || cps[i] == '\n'); };
+    auto other = [&](std::size_t i) { return i < n && !is_whitespace(cps[i]) && !is_letter(cps[i]) && !is_number(cps[i]); };
+    auto lower = [&](std::size_t i) { return i < n && cps[i] < 0x80 ? static_cast<char>(std::tolower(static_cast<int>(cps[i]))) : '\0'; };
+
+    std::vector<std::string> words;
+    std::size_t i = 0;
+    while (i < n)
+    {
+        std::size_t end = i;
+
+        // (?i:'s|'t|'re|'ve|'m|'ll|'d)
+        if (cps[i] == '\'')
+        {
+            const char a = lower(i + 1);
+            const char b = lower(i + 2);
+            if (a == 's' || a == 't' || a == 'm' || a == 'd')
+                end = i + 2;
+            else if ((a == 'r' && b == 'e') || (a == 'v' && b == 'e') || (a == 'l' && b == 'l'))
+                end = i + 3;
+        }
+
+        // [^\r\n\p{L}\p{N}]?\p{L}+
+        if (end == i && (letter(i) || (!newline(i) && !number(i) && letter(i + 1))))
+        {
+            end = letter(i) ? i + 1 : i + 2;
+            while (letter(end))
+            {
+                ++end;
+            }
+        }
+
+        // \p{N}
+        if (end == i && number(i))
+        {
+            end = i + 1;
+        }
+
+        // ' ?[^\s\p{L}\p{N}]+[\r\n]*'
+        if (end == i)
+        {
+            const std::size_t start = cps[i] == ' ' && other(i + 1) ? i + 1 : i;
+            if (other(start))
+            {
+                end = start;
+                while (other(end))
+                {
+                    ++end;
+                }
+                while (newline(end))
+                {
+                    ++end;
+                }
+            }
+        }
+
+        // \s*[\r\n]+ | \s+(?!\S) | \s+
+        if (end == i && space(i))
+        {
+            std::size_t run = i;
+            std::size_t last_newline = n;
+            while (space(run))
+            {
+                if (newline(run))
+                {
+                    last_newline = run;
+                }
+                ++run;
+            }
+
+            if (last_newline != n)
+                end = last_newline + 1;
+            else if (run == n || run - i == 1)
+                end = run;
+            else
+                end = run - 1; // leave one space to prefix the next word
+        }
+
+        if (end == i)
+        {
+            end = i + 1;
+        }
+        words.emplace_back(text, offsets[i], offsets[end] - offsets[i]);
+        i = end;
+    }
+    return words;
+}
+
+StreamingDetokenizer::StreamingDetokenizer(const BpeTokenizer &tokenizer, bool skip_special)
+    : tokenizer_(tokenizer),
+      skip_special_(skip_special)
+{
+}
+
+std::string StreamingDetokenizer::push(int id)
+{
+    if (skip_special_ && tokenizer_.is_special(id))
+    {
+        return std::string();
+    }
+
+    pending_ += tokenizer_.token_bytes(id);
+    std::string text;
+    const std::size_t consumed = append_valid_utf8(pending_, text, false);
+    pending_.erase(0, consumed);
+    return text;
+}
+
+std::string StreamingDetokenizer::flush()
+{
+    std::string text;
+    append_valid_utf8(pending_, text, true);
+    pending_.clear();
+    return text;
+}
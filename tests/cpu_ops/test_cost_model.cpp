@@ -0,0 +1,90 @@
+#include <cpu_ops/cost_model.h>
+#include <cpu_ops/elemwise_add.h>
+#include <cpu_ops/elemwise_mul.h>
+#include <cpu_ops/rmsnorm.h>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static bool check(bool condition, const char *what)
+{
+    if (!condition)
+        std::cerr << "FAILED: " << what << "\n";
+    return condition;
+}
+
+int main()
+{
+    bool pass = true;
+
+    // A 16-thread machine: 2 us dispatch, 10 GB/s per core saturating at 60 GB/s, 50 GFLOP/s per core
+    const CostModel model(2000.0, 10.0, 60.0, 50.0, 16);
+    const WorkCost add_block{96.0, 8.0};
+
+    const ParallelPlan tiny = model.plan(2048 / 8, add_block);
+    pass &= check(tiny.threads == 1 && tiny.grain == 256, "2048-float add stays on the calling thread");
+
+    const ParallelPlan large = model.plan(64 * 6144 / 8, add_block);
+    pass &= check(large.threads > 1, "64 rows of 6144 floats fan out");
+    pass &= check(large.threads <= 8, "bandwidth-bound add stops adding threads once memory saturates");
+    pass &= check(large.grain * large.threads * 4 >= 64 * 6144 / 8, "chunks cover the range");
+
+    // Compute-bound work keeps scaling past memory saturation
+    const ParallelPlan projection = model.plan(151936, WorkCost{4.0 * 1024, 2.0 * 1024 * 64});
+    pass &= check(projection.threads == 16, "compute-bound range uses every thread");
+
+    pass &= check(model.plan(1, WorkCost{1e9, 1e9}).threads == 1, "a single item never fans out");
+    pass &= check(model.predict_ns(1000, add_block, 4) < model.predict_ns(1000, add_block, 1) + model.dispatch_ns(),
+                  "prediction includes dispatch only once");
+
+    // Calibrated figures for this machine
+    const CostModel &calibrated = CostModel::instance();
+    std::cout << "Calibrated: dispatch " << calibrated.dispatch_ns() << " ns, core " << calibrated.core_bytes_per_ns()
+              << " GB/s, all " << calibrated.total_bytes_per_ns() << " GB/s, core " << calibrated.core_flops_per_ns()
+              << " GFLOP/s, " << calibrated.max_threads() << " threads\n";
+    pass &= check(calibrated.core_bytes_per_ns() > 0.0 && calibrated.core_flops_per_ns() > 0.0, "calibration is positive");
+
+    // Kernels give the same results whichever plan they get
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for (int rows : {1, 3, 257})
+    {
+        const int hidden = 6144 + 5;
+        std::vector<float> a(static_cast<size_t>(rows) * hidden), b(a.size()), weight(hidden), out(a.size());
+        for (auto &x : a)
+            x = dist(gen);
+        for (auto &x : b)
+            x = dist(gen);
+        for (auto &x : weight)
+            x = dist(gen);
+
+        elemwise_add_avx2_omp(a.data(), b.data(), out.data(), rows, hidden);
+        bool ok = true;
+        for (size_t i = 0; i < a.size(); ++i)
+            ok &= out[i] == a[i] + b[i];
+        elemwise_mul_avx2(a.data(), b.data(), out.data(), rows, hidden);
+        for (size_t i = 0; i < a.size(); ++i)
+            ok &= out[i] == a[i] * b[i];
+
+        rmsnorm_avx2(a.data(), weight.data(), out.data(), rows, hidden, 1e-6f);
+        for (int r = 0; r < rows; ++r)
+        {
+            double mean_sq = 0.0;
+            for (int d = 0; d < hidden; ++d)
+                mean_sq += double(a[r * hidden + d]) * a[r * hidden + d];
+            const double denom = 1.0 / std::sqrt(mean_sq / hidden + 1e-6);
+            for (int d = 0; d < hidden; ++d)
+                ok &= std::fabs(out[r * hidden + d] - weight[d] * a[r * hidden + d] * denom) < 1e-4;
+        }
+        pass &= check(ok, "add, mul and rmsnorm match the reference");
+    }
+
+    if (pass)
+    {
+        std::cout << "Cost model test passed!\n";
+        return 0;
+    }
+    std::cout << "Cost model test failed!\n";
+    return 1;
+}
@@ -0,0 +1,95 @@
+#include <cpu_ops/cpu_topology.h>
+#include <cpu_ops/thread_pool.h>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+static bool check(bool condition, const char *what)
+{
+    if (!condition)
+        std::cerr << "FAILED: " << what << "\n";
+    return condition;
+}
+
+static bool throws(const char *list)
+{
+    try
+    {
+        parse_cpu_list(list);
+    }
+    catch (const std::invalid_argument &)
+    {
+        return true;
+    }
+    return false;
+}
+
+int main()
+{
+    bool pass = true;
+
+    pass &= check(parse_cpu_list("0-3,8, 10-11") == std::vector<int>({0, 1, 2, 3, 8, 10, 11}), "ranges and singles");
+    pass &= check(parse_cpu_list("5,1-2,2") == std::vector<int>({1, 2, 5}), "sorted without duplicates");
+    pass &= check(throws("") && throws("3-1") && throws("1,,2") && throws("a") && throws("0-") && throws("1,") &&
+                      throws("100000"),
+                  "malformed lists are rejected");
+
+    // 2 nodes x 2 cores x 2 hyperthreads, Linux-style numbering: siblings are cpu and cpu + 4
+    std::vector<LogicalCpu> cpus;
+    for (int id = 0; id < 8; ++id)
+        cpus.push_back({id, id % 4, id % 4 / 2, id % 4 / 2});
+    const CpuTopology topology(cpus);
+
+    pass &= check(topology.num_nodes() == 2, "two nodes");
+    pass &= check(topology.num_cores({0, 1, 2, 3, 4, 5, 6, 7}) == 4, "four cores");
+    pass &= check(topology.num_cores({0, 4}) == 1, "siblings share a core");
+    pass &= check(topology.find(6) != nullptr && topology.find(6)->core == 2 && topology.find(9) == nullptr, "find");
+
+    const std::vector<int> order = topology.placement({0, 1, 2, 3, 4, 5, 6, 7});
+    pass &= check(order == std::vector<int>({0, 2, 1, 3, 4, 5, 6, 7}), "one per core alternating nodes, then siblings");
+    pass &= check(topology.placement({4, 1, 5}) == std::vector<int>({1, 4, 5}), "restricted set keeps one per core first");
+    pass &= check(topology.placement({0, 12}) == std::vector<int>({0, 12}), "unknown CPUs count as their own core");
+
+    // This machine
+    const CpuTopology &machine = CpuTopology::instance();
+    const std::vector<int> allowed = process_cpus();
+    pass &= check(!machine.cpus().empty() && !allowed.empty(), "detection finds CPUs");
+    std::cout << "Detected " << machine.cpus().size() << " logical CPUs, " << machine.num_cores(allowed)
+              << " usable cores, " << machine.num_nodes() << " NUMA nodes\n";
+
+    // A pool sized by the topology: one thread per core, pinned, leaving the rest spare
+    ThreadPoolConfig config;
+    ThreadPool pool(config);
+    pass &= check(pool.num_threads() == machine.num_cores(allowed), "default pool has one thread per core");
+    pass &= check(pool.cpus().size() == static_cast<size_t>(pool.num_threads()), "every thread has a CPU");
+    const std::vector<int> spare = pool.spare_cpus();
+    for (int cpu : pool.cpus())
+        pass &= check(std::find(spare.begin(), spare.end(), cpu) == spare.end(), "spare CPUs exclude compute CPUs");
+    pass &= check(pool.cpus().size() + spare.size() == allowed.size(), "compute and spare CPUs cover the process");
+
+    config.cpus = std::to_string(allowed.front());
+    config.num_threads = 3;
+    ThreadPool oversubscribed(config);
+    pass &= check(oversubscribed.num_threads() == 3 && oversubscribed.cpus().empty(), "oversubscribed pool is unpinned");
+
+    config.cpus = "4000";
+    bool rejected = false;
+    try
+    {
+        ThreadPool unavailable(config);
+    }
+    catch (const std::invalid_argument &)
+    {
+        rejected = true;
+    }
+    pass &= check(rejected, "a CPU list outside the process mask is rejected");
+
+    if (pass)
+    {
+        std::cout << "CPU topology test passed!\n";
+        return 0;
+    }
+    std::cout << "CPU topology test failed!\n";
+    return 1;
+}
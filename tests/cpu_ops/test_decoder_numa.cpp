@@ -0,0 +1,213 @@
+#include <cpu_ops/cpu_topology.h>
+#include <cpu_ops/decoder.h>
+#include <cpu_ops/rotary_embedding.h>
+#include <cpu_ops/thread_pool.h>
+#include <tensor/kvcache.h>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t kEmbed = 64;
+constexpr std::size_t kHeads = 4;
+constexpr std::size_t kGroups = 2;
+constexpr std::size_t kHeadDim = 16;
+constexpr std::size_t kUp = 128;
+constexpr std::size_t kMaxTokens = 32;
+
+// One layer's weights, shared by every Decoder built from them
+struct LayerWeights
+{
+    std::vector<float> input_norm, q, k, v, o, q_norm, k_norm, post_norm, up, gate, down;
+    std::vector<float> sin, cos;
+
+    explicit LayerWeights(std::mt19937 &gen)
+    {
+        std::normal_distribution<float> noise(0.0f, 0.2f);
+        auto fill = [&](std::vector<float> &w, std::size_t size, float base)
+        {
+            w.resize(size);
+            for (float &x : w)
+                x = base + noise(gen);
+        };
+        fill(input_norm, kEmbed, 1.0f);
+        fill(q, kHeads * kHeadDim * kEmbed, 0.0f);
+        fill(k, kGroups * kHeadDim * kEmbed, 0.0f);
+        fill(v, kGroups * kHeadDim * kEmbed, 0.0f);
+        fill(o, kEmbed * kHeads * kHeadDim, 0.0f);
+        fill(q_norm, kHeadDim, 1.0f);
+        fill(k_norm, kHeadDim, 1.0f);
+        fill(post_norm, kEmbed, 1.0f);
+        fill(up, kUp * kEmbed, 0.0f);
+        fill(gate, kUp * kEmbed, 0.0f);
+        fill(down, kEmbed * kUp, 0.0f);
+        sin.resize(kMaxTokens * kHeadDim / 2);
+        cos.resize(sin.size());
+        RotaryEmbeddingAVX2::precompute(sin.data(), cos.data(), kMaxTokens, kHeadDim, 1000000.0f);
+    }
+};
+
+// A Decoder over views of weights (the constructor takes its tensors over)
+struct Layer
+{
+    Tensor sin, cos;
+    KVCache cache;
+    std::unique_ptr<Decoder> decoder;
+
+    explicit Layer(LayerWeights &w)
+        : sin(w.sin.data(), {kMaxTokens, kHeadDim / 2}, DataType::F32),
+          cos(w.cos.data(), {kMaxTokens, kHeadDim / 2}, DataType::F32),
+          cache(kMaxTokens, kHeadDim, kGroups, 1)
+    {
+        auto view = [](std::vector<float> &data, std::vector<std::size_t> shape)
+        {
+            return Tensor(data.data(), shape, DataType::F32);
+        };
+        Tensor input_norm = view(w.input_norm, {kEmbed});
+        Tensor q = view(w.q, {kHeads * kHeadDim, kEmbed});
+        Tensor k = view(w.k, {kGroups * kHeadDim, kEmbed});
+        Tensor v = view(w.v, {kGroups * kHeadDim, kEmbed});
+        Tensor o = view(w.o, {kEmbed, kHeads * kHeadDim});
+        Tensor q_norm = view(w.q_norm, {kHeadDim});
+        Tensor k_norm = view(w.k_norm, {kHeadDim});
+        Tensor post_norm = view(w.post_norm, {kEmbed});
+        Tensor up = view(w.up, {kUp, kEmbed});
+        Tensor gate = view(w.gate, {kUp, kEmbed});
+        Tensor down = view(w.down, {kEmbed, kUp});
+        decoder = std::make_unique<Decoder>(input_norm, q, k, v, o, q_norm, k_norm, sin, cos, 0, &cache,
+                                            post_norm, up, gate, down);
+    }
+};
+
+bool close(const Tensor &a, const Tensor &b)
+{
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        const float x = a.data<float>()[i], y = b.data<float>()[i];
+        if (std::fabs(x - y) > 1e-4f * (1.0f + std::fabs(x)))
+            return false;
+    }
+    return true;
+}
+} // namespace
+
+int main()
+{
+    bool pass = true;
+
+    // The same two CPUs as one domain and as two emulated ones
+    const std::vector<int> cpus = process_cpus();
+    const std::string first = std::to_string(cpus[0]);
+    const std::string second = std::to_string(cpus.size() > 1 ? cpus[1] : cpus[0]);
+    ThreadPoolConfig config;
+    config.cpus = first + "," + second;
+    ThreadPool one_domain(config);
+    config.cpus = first + ";" + second;
+    ThreadPool two_domains(config);
+    if (one_domain.num_domains() != 1 || two_domains.num_domains() != 2)
+    {
+        std::cerr << "Expected pools of one and two domains\n";
+        return 1;
+    }
+
+    std::mt19937 gen(5);
+    LayerWeights weights(gen);
+    Layer reference(weights);
+    Layer split(weights);
+    {
+        // Attention split by KV group, the MLP by intermediate column, reduced after o_proj and down_proj
+        ThreadPool::Scope scope(two_domains);
+        split.decoder->place_weights(two_domains);
+    }
+    reference.decoder->prepare();
+    split.decoder->prepare();
+
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    // Single-token graph path, several positions so attention reads earlier KV rows
+    std::size_t position = 0;
+    for (; position < 6; ++position)
+    {
+        Tensor input(DataType::F32, {kEmbed});
+        for (std::size_t i = 0; i < kEmbed; ++i)
+            input.data<float>()[i] = dist(gen);
+        Tensor expected(DataType::F32, {kEmbed}), actual(DataType::F32, {kEmbed});
+        {
+            ThreadPool::Scope scope(one_domain);
+            reference.decoder->run(input, position, expected);
+        }
+        {
+            ThreadPool::Scope scope(two_domains);
+            split.decoder->run(input, position, actual);
+        }
+        reference.cache.advance();
+        split.cache.advance();
+        if (!close(expected, actual))
+        {
+            std::cerr << "Token path differs at position " << position << "\n";
+            pass = false;
+        }
+    }
+
+    // Batched path: three rows continuing the same sequence
+    {
+        const std::size_t M = 3;
+        Tensor input(DataType::F32, {M, kEmbed});
+        for (std::size_t i = 0; i < input.size(); ++i)
+            input.data<float>()[i] = dist(gen);
+        Tensor expected(DataType::F32, {M, kEmbed}), actual(DataType::F32, {M, kEmbed});
+        std::vector<AttentionRow> reference_rows, split_rows;
+        for (std::size_t r = 0; r < M; ++r)
+        {
+            reference_rows.push_back({&reference.cache, position + r});
+            split_rows.push_back({&split.cache, position + r});
+        }
+        {
+            ThreadPool::Scope scope(one_domain);
+            reference.decoder->run_batch(input, reference_rows.data(), M, expected);
+        }
+        {
+            ThreadPool::Scope scope(two_domains);
+            split.decoder->run_batch(input, split_rows.data(), M, actual);
+        }
+        if (!close(expected, actual))
+        {
+            std::cerr << "Batch path differs\n";
+            pass = false;
+        }
+    }
+
+    // A position past the cache reaches the caller as an exception rather than failing on a pool
+    // thread inside the task graph
+    {
+        Tensor input(DataType::F32, {kEmbed}), output(DataType::F32, {kEmbed});
+        bool threw = false;
+        try
+        {
+            ThreadPool::Scope scope(two_domains);
+            split.decoder->run(input, kMaxTokens, output);
+        }
+        catch (const std::out_of_range &)
+        {
+            threw = true;
+        }
+        if (!threw)
+        {
+            std::cerr << "Position past the KV cache did not throw\n";
+            pass = false;
+        }
+    }
+
+    if (pass)
+    {
+        std::cout << "Decoder NUMA test passed!\n";
+        return 0;
+    }
+    std::cout << "Decoder NUMA test failed!\n";
+    return 1;
+}
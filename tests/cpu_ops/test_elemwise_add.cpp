@@ -29,6 +29,8 @@ int main() {
 
     constexpr int num_iters = 100;
 
+    warm_up_cpu_ops();
+
     auto start = std::chrono::high_resolution_clock::now();
     std::vector<float> ref;
     for (int i = 0; i < num_iters; ++i) {
@@ -30,6 +30,8 @@ int main() {
 
     constexpr int num_iters = 100;
 
+    warm_up_cpu_ops();
+
     // Naive reference timing
     auto start = std::chrono::high_resolution_clock::now();
     std::vector<float> ref;
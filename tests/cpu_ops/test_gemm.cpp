@@ -0,0 +1,140 @@
+#include <cpu_ops/gemm.h>
+#include <cpu_ops/gemm_tuning.h>
+#include <cpu_ops/kernels.h>
+#include <cpu_ops/linear.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+float max_diff(const std::vector<float> &a, const std::vector<float> &b)
+{
+    float diff = 0.0f;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        diff = std::max(diff, std::abs(a[i] - b[i]));
+    return diff;
+}
+
+// gemm_nt and gemm_nt_range against linear_naive for one shape and blocking
+bool check_shape(int M, int K, int N, const GemmBlocking &blocking, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> input(static_cast<std::size_t>(M) * K);
+    std::vector<float> weight(static_cast<std::size_t>(N) * K);
+    for (float &x : input)
+        x = dist(rng);
+    for (float &x : weight)
+        x = dist(rng);
+
+    std::vector<float> want(static_cast<std::size_t>(M) * N);
+    linear_naive(input.data(), weight.data(), M, K, N, want.data());
+
+    // Stale output must be overwritten, not accumulated into
+    std::vector<float> got(want.size(), 100.0f);
+    gemm_nt(input.data(), weight.data(), M, K, N, got.data(), blocking);
+
+    std::vector<float> got_range(want.size(), 100.0f);
+    const int split = N / 3;
+    gemm_nt_range(input.data(), weight.data(), M, K, N, 0, split, got_range.data(), blocking);
+    gemm_nt_range(input.data(), weight.data(), M, K, N, split, N, got_range.data(), blocking);
+
+    const float tol = 1e-4f * std::sqrt(static_cast<float>(K) + 1.0f);
+    const float diff = std::max(max_diff(got, want), max_diff(got_range, want));
+    if (diff > tol)
+    {
+        std::cerr << "M=" << M << " K=" << K << " N=" << N << " blocking " << blocking.mc << "x" << blocking.nc
+                  << "x" << blocking.kc << ": max diff " << diff << "\n";
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+int main()
+{
+    const KernelTable &ops = kernels();
+    std::cout << "GEMM tile " << ops.gemm_mr << "x" << ops.gemm_nr << " (" << isa_name(ops.isa) << ")\n";
+
+    std::mt19937 rng(11);
+    bool pass = true;
+
+    // Shapes that leave partial tiles in M and N and a partial kc block in K
+    const GemmBlocking small{8, 32, 24};
+    for (int M : {1, 5, 16, 23})
+    {
+        for (int K : {1, 7, 50})
+        {
+            for (int N : {1, 9, 17, 70})
+                pass &= check_shape(M, K, N, small, rng);
+        }
+    }
+    pass &= check_shape(37, 300, 130, GemmBlocking(), rng);
+    pass &= check_shape(64, 512, 96, GemmBlocking{16, 64, 128}, rng);
+
+    // The thread split only changes which block runs where
+    for (int chunks : {1, 3, 8})
+        pass &= check_shape(40, 64, 200, GemmBlocking{16, 256, 32, chunks}, rng);
+
+    // A tuned entry applies to its shape only, and survives a round trip through a file
+    const GemmTuning tuned = GemmTuning::tune({{64, 96}}, 24);
+    const GemmBlocking picked = tuned.blocking(64, 96);
+    const GemmBlocking other = tuned.blocking(64, 97);
+    pass &= check_shape(24, 64, 96, picked, rng);
+    if (other.mc != GemmBlocking().mc || other.nc != GemmBlocking().nc || other.kc != GemmBlocking().kc)
+    {
+        std::cerr << "Untuned shape did not get the default blocking\n";
+        pass = false;
+    }
+    const std::string path = "test_gemm.tuning";
+    tuned.save(path);
+    GemmTuning loaded({}, std::string());
+    if (!GemmTuning::load(path, loaded) || loaded.entries().size() != 1 || loaded.blocking(64, 96).kc != picked.kc ||
+        loaded.blocking(64, 96).chunks_per_thread != picked.chunks_per_thread)
+    {
+        std::cerr << "Saved GEMM tuning did not load back\n";
+        pass = false;
+    }
+    {
+        std::ofstream file(path);
+        file << "cpu some other cpu / avx2\ngemm 64 96 8 8 8 1\n";
+    }
+    if (GemmTuning::load(path, loaded))
+    {
+        std::cerr << "GEMM tuning of another CPU was loaded\n";
+        pass = false;
+    }
+    std::remove(path.c_str());
+
+    // linear_avx2_omp agrees whichever kernel the dispatch table picks for the row count
+    for (int M : {4, 15, 16, 40})
+    {
+        const int K = 96;
+        const int N = 75;
+        std::vector<float> input(static_cast<std::size_t>(M) * K), weight(static_cast<std::size_t>(N) * K);
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+        for (float &x : input)
+            x = dist(rng);
+        for (float &x : weight)
+            x = dist(rng);
+        std::vector<float> want(static_cast<std::size_t>(M) * N), got(want.size());
+        linear_naive(input.data(), weight.data(), M, K, N, want.data());
+        linear_avx2_omp(input.data(), weight.data(), M, K, N, got.data());
+        if (max_diff(got, want) > 1e-3f)
+        {
+            std::cerr << "linear_avx2_omp differs from linear_naive for M=" << M << "\n";
+            pass = false;
+        }
+    }
+
+    if (pass)
+    {
+        std::cout << "GEMM test passed!" << std::endl;
+        return 0;
+    }
+    std::cout << "GEMM test failed!" << std::endl;
+    return 1;
+}
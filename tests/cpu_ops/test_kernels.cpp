@@ -0,0 +1,250 @@
+#include <cpu_ops/kernels.h>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <random>
+#include <vector>
+
+namespace
+{
+bool close(float a, float b, float tol)
+{
+    return std::abs(a - b) <= tol * (1.0f + std::abs(b));
+}
+
+bool all_close(const std::vector<float> &a, const std::vector<float> &b, float tol)
+{
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        if (!close(a[i], b[i], tol))
+            return false;
+    }
+    return true;
+}
+
+// Every kernel of `table` against the scalar reference, for a length that exercises the tails
+bool check_table(const KernelTable &table, const KernelTable &ref, std::size_t n, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+    auto random_vector = [&](std::size_t size)
+    {
+        std::vector<float> v(size);
+        for (float &x : v)
+            x = dist(rng);
+        return v;
+    };
+
+    const std::vector<float> a = random_vector(n);
+    const std::vector<float> b = random_vector(n);
+    const std::vector<float> w = random_vector(4 * n);
+    bool pass = true;
+    auto expect = [&](bool ok, const char *kernel)
+    {
+        if (!ok)
+        {
+            std::cerr << isa_name(table.isa) << " " << kernel << " differs from scalar for n = " << n << "\n";
+            pass = false;
+        }
+    };
+
+    expect(close(table.dot(a.data(), b.data(), n), ref.dot(a.data(), b.data(), n), 1e-4f), "dot");
+
+    float got4[4], want4[4];
+    table.dot4(a.data(), w.data(), w.data() + n, w.data() + 2 * n, w.data() + 3 * n, n, got4);
+    ref.dot4(a.data(), w.data(), w.data() + n, w.data() + 2 * n, w.data() + 3 * n, n, want4);
+    bool dot4_ok = true;
+    for (int r = 0; r < 4; ++r)
+        dot4_ok &= close(got4[r], want4[r], 1e-4f);
+    expect(dot4_ok, "dot4");
+
+    std::vector<float> got(b), want(b);
+    table.axpy(0.5f, a.data(), got.data(), n);
+    ref.axpy(0.5f, a.data(), want.data(), n);
+    expect(all_close(got, want, 1e-5f), "axpy");
+
+    got = a;
+    want = a;
+    table.scale(got.data(), -1.5f, n);
+    ref.scale(want.data(), -1.5f, n);
+    expect(all_close(got, want, 1e-6f), "scale");
+
+    expect(table.max(a.data(), n) == ref.max(a.data(), n), "max");
+
+    got = a;
+    want = a;
+    const float shift = ref.max(a.data(), n);
+    const float got_sum = table.exp_shift_sum(got.data(), shift, n);
+    const float want_sum = ref.exp_shift_sum(want.data(), shift, n);
+    expect(all_close(got, want, 1e-4f) && close(got_sum, want_sum, 1e-4f), "exp_shift_sum");
+
+    got.assign(n, 0.0f);
+    want.assign(n, 0.0f);
+    table.add(a.data(), b.data(), got.data(), n);
+    ref.add(a.data(), b.data(), want.data(), n);
+    expect(all_close(got, want, 0.0f), "add");
+    table.mul(a.data(), b.data(), got.data(), n);
+    ref.mul(a.data(), b.data(), want.data(), n);
+    expect(all_close(got, want, 0.0f), "mul");
+    table.silu(a.data(), got.data(), n);
+    ref.silu(a.data(), want.data(), n);
+    expect(all_close(got, want, 1e-4f), "silu");
+    table.rmsnorm_row(a.data(), b.data(), got.data(), n, 1e-6f);
+    ref.rmsnorm_row(a.data(), b.data(), want.data(), n, 1e-6f);
+    expect(all_close(got, want, 1e-5f), "rmsnorm_row");
+
+    // rotate_half on a 2 * half row with unit-circle sines and cosines
+    const std::size_t half = n / 2;
+    std::vector<float> sin(half), cos(half);
+    for (std::size_t i = 0; i < half; ++i)
+    {
+        sin[i] = std::sin(0.1f * i);
+        cos[i] = std::cos(0.1f * i);
+    }
+    got = a;
+    want = a;
+    table.rotate_half(got.data(), sin.data(), cos.data(), half);
+    ref.rotate_half(want.data(), sin.data(), cos.data(), half);
+    expect(all_close(got, want, 1e-5f), "rotate_half");
+
+    // argmax keeps the first of equal maxima
+    std::vector<float> ties(a);
+    if (n > 3)
+    {
+        ties[n - 1] = 10.0f;
+        ties[n / 3] = 10.0f;
+    }
+    expect(table.argmax(ties.data(), static_cast<int>(n)) == ref.argmax(ties.data(), static_cast<int>(n)), "argmax");
+
+    bool find_ok = true;
+    const int size = static_cast<int>(n);
+    for (int begin = 0; begin <= size; begin += 3)
+    {
+        find_ok &= table.find_at_least(a.data(), begin, size, 1.5f) == ref.find_at_least(a.data(), begin, size, 1.5f);
+    }
+    find_ok &= table.find_at_least(a.data(), 0, size, 100.0f) == size;
+    expect(find_ok, "find_at_least");
+
+    expect(close(table.sum(a.data(), n), ref.sum(a.data(), n), 1e-4f), "sum");
+    return pass;
+}
+
+// The fixed-size kernels of `table` against the generic kernels of the scalar table
+bool check_fixed(const KernelTable &table, const KernelTable &ref, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+    auto random_vector = [&](std::size_t size)
+    {
+        std::vector<float> v(size);
+        for (float &x : v)
+            x = dist(rng);
+        return v;
+    };
+    bool pass = true;
+    auto expect = [&](bool ok, const char *kernel, int size)
+    {
+        if (!ok)
+        {
+            std::cerr << isa_name(table.isa) << " fixed " << kernel << " differs from scalar for " << size << "\n";
+            pass = false;
+        }
+    };
+
+    for (int i = 0; i < table.num_head_sizes; ++i)
+    {
+        const HeadKernels &head = table.heads[i];
+        const std::size_t h = static_cast<std::size_t>(head.head_dim);
+        const std::vector<float> a = random_vector(h);
+        const std::vector<float> b = random_vector(h);
+        expect(close(head.dot(a.data(), b.data()), ref.dot(a.data(), b.data(), h), 1e-4f), "dot", head.head_dim);
+
+        std::vector<float> got(b), want(b);
+        head.axpy(0.5f, a.data(), got.data());
+        ref.axpy(0.5f, a.data(), want.data(), h);
+        expect(all_close(got, want, 1e-5f), "axpy", head.head_dim);
+
+        head.rmsnorm(a.data(), b.data(), got.data(), 1e-6f);
+        ref.rmsnorm_row(a.data(), b.data(), want.data(), h, 1e-6f);
+        expect(all_close(got, want, 1e-5f), "rmsnorm", head.head_dim);
+
+        const std::vector<float> sin = random_vector(h / 2);
+        const std::vector<float> cos = random_vector(h / 2);
+        got = a;
+        want = a;
+        head.rotate_half(got.data(), sin.data(), cos.data());
+        ref.rotate_half(want.data(), sin.data(), cos.data(), h / 2);
+        expect(all_close(got, want, 1e-5f), "rotate_half", head.head_dim);
+    }
+
+    for (int i = 0; i < table.num_norm_sizes; ++i)
+    {
+        const FixedNorm &norm = table.norms[i];
+        const std::size_t n = static_cast<std::size_t>(norm.n);
+        const std::vector<float> x = random_vector(n);
+        const std::vector<float> w = random_vector(n);
+        std::vector<float> got(n), want(n);
+        norm.rmsnorm(x.data(), w.data(), got.data(), 1e-6f);
+        ref.rmsnorm_row(x.data(), w.data(), want.data(), n, 1e-6f);
+        expect(all_close(got, want, 1e-5f), "rmsnorm", norm.n);
+    }
+    return pass;
+}
+} // namespace
+
+int main()
+{
+    bool pass = true;
+    const KernelTable *scalar = kernels_for(IsaLevel::Scalar);
+    if (scalar == nullptr || scalar->isa != IsaLevel::Scalar)
+    {
+        std::cerr << "Scalar kernels must always be available\n";
+        return 1;
+    }
+
+    // The selected table is the widest one the host supports, within MINMAX_ISA
+    const KernelTable &selected = kernels();
+    pass &= selected.isa <= host_isa();
+    pass &= kernels_for(selected.isa) == &selected;
+    std::cout << "CPU: " << cpu_features().model << "\n";
+    std::cout << "Kernels: " << isa_name(selected.isa) << " (" << selected.lanes << " lanes)\n";
+
+    // Every variant this host runs agrees with the scalar one; lengths cover tail-only and mixed blocks
+    std::mt19937 rng(7);
+    for (IsaLevel isa : {IsaLevel::Scalar, IsaLevel::Avx2, IsaLevel::Avx512})
+    {
+        const KernelTable *table = kernels_for(isa);
+        if (table == nullptr)
+        {
+            std::cout << isa_name(isa) << ": not available, skipped\n";
+            continue;
+        }
+        for (std::size_t n : {1, 7, 8, 15, 17, 33, 128, 1000})
+        {
+            pass &= check_table(*table, *scalar, n, rng);
+        }
+        pass &= check_fixed(*table, *scalar, rng);
+    }
+
+    // Qwen3 sizes are specialised on every table; other sizes fall back to the generic kernels
+    pass &= head_kernels(128) != nullptr && fixed_rmsnorm(128) == head_kernels(128)->rmsnorm;
+    pass &= fixed_rmsnorm(2048) != nullptr && fixed_rmsnorm(6144) == nullptr && head_kernels(96) == nullptr;
+
+    // ISA names round-trip, and unknown ones are rejected
+    pass &= parse_isa("avx2") == IsaLevel::Avx2 && parse_isa(isa_name(IsaLevel::Avx512)) == IsaLevel::Avx512;
+    try
+    {
+        parse_isa("sse9");
+        std::cerr << "Unknown ISA name was accepted\n";
+        pass = false;
+    }
+    catch (const std::invalid_argument &)
+    {
+    }
+
+    if (pass)
+    {
+        std::cout << "Kernels test passed!" << std::endl;
+        return 0;
+    }
+    std::cout << "Kernels test failed!" << std::endl;
+    return 1;
+}
@@ -31,6 +31,8 @@ int main()
     for (int i = 0; i < K * N; ++i)
         B[i] = dist(gen);
 
+    warm_up_cpu_ops();
+
     // Test 1: Correctness check
     std::cout << "Running correctness test...\n";
     linear_naive(A, B, M, K, N, C_naive);
@@ -0,0 +1,115 @@
+#include <cpu_ops/kernels.h>
+#include <cpu_ops/linear.h>
+#include <cpu_ops/linear_dispatch.h>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+int main()
+{
+    bool pass = true;
+    auto expect = [&](bool ok, const char *what)
+    {
+        if (!ok)
+        {
+            std::cerr << what << "\n";
+            pass = false;
+        }
+    };
+
+    // Buckets are looked up by their first row count, in any order given
+    const LinearDispatch table({{9, LinearKernel::Gemm}, {1, LinearKernel::Gemv}, {2, LinearKernel::Gemv4}},
+                               kernels_host_key());
+    expect(table.select(1) == LinearKernel::Gemv, "1 row should use gemv");
+    expect(table.select(2) == LinearKernel::Gemv4 && table.select(8) == LinearKernel::Gemv4, "2..8 rows should use gemv4");
+    expect(table.select(9) == LinearKernel::Gemm && table.select(4096) == LinearKernel::Gemm, "9+ rows should use gemm");
+
+    // A measured shape uses its own buckets; other shapes fall back to the generic table
+    const LinearDispatch shaped({{1, LinearKernel::Gemv}, {9, LinearKernel::Gemm}}, kernels_host_key(),
+                                {{GemmShape{2048, 6144}, {{1, LinearKernel::Gemv}, {33, LinearKernel::Gemm}}}});
+    expect(shaped.has_shape({2048, 6144}) && !shaped.has_shape({6144, 2048}), "has_shape");
+    expect(shaped.select(16, 2048, 6144) == LinearKernel::Gemv && shaped.select(33, 2048, 6144) == LinearKernel::Gemm,
+           "measured shape should use its own buckets");
+    expect(shaped.select(16, 6144, 2048) == LinearKernel::Gemm, "other shapes should use the generic table");
+
+    // Round trip through a file; a table from another CPU is not loaded
+    const std::string path = "test_linear_dispatch.table";
+    table.save(path);
+    LinearDispatch loaded({}, std::string());
+    expect(LinearDispatch::load(path, loaded) && loaded.buckets() == table.buckets(), "saved table did not load back");
+    shaped.save(path);
+    expect(LinearDispatch::load(path, loaded) && loaded.buckets() == shaped.buckets() && loaded.shapes().size() == 1 &&
+               loaded.shapes()[0].second == shaped.shapes()[0].second && loaded.has_shape({2048, 6144}),
+           "saved shape buckets did not load back");
+    {
+        std::ofstream file(path);
+        file << "cpu some other cpu / avx2\nrows 1 gemm\n";
+    }
+    expect(!LinearDispatch::load(path, loaded), "table of another CPU was loaded");
+    std::remove(path.c_str());
+
+    expect(parse_linear_kernel("gemv4") == LinearKernel::Gemv4, "gemv4 should parse");
+    try
+    {
+        parse_linear_kernel("gemm2");
+        expect(false, "unknown kernel name was accepted");
+    }
+    catch (const std::invalid_argument &)
+    {
+    }
+
+    // The host table covers every row count, and every kernel computes the same product
+    const LinearDispatch &host = LinearDispatch::instance();
+    std::cout << "Linear kernels on " << host.cpu() << ":";
+    for (const auto &bucket : host.buckets())
+        std::cout << " " << bucket.first << "+ " << linear_kernel_name(bucket.second);
+    std::cout << "\n";
+    expect(!host.buckets().empty() && host.buckets().front().first == 1, "host table does not start at one row");
+
+    // Shapes are measured on the current pool and start at one row as well
+    const LinearDispatch measured = LinearDispatch::measure({{256, 384}, {256, 384}});
+    expect(measured.shapes().size() == 1 && measured.has_shape({256, 384}) &&
+               measured.shapes()[0].second.front().first == 1,
+           "measured shape table is missing or does not start at one row");
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for (int M : {1, 3, 20})
+    {
+        const int K = 70;
+        const int N = 45;
+        std::vector<float> input(static_cast<std::size_t>(M) * K), weight(static_cast<std::size_t>(N) * K);
+        for (float &x : input)
+            x = dist(rng);
+        for (float &x : weight)
+            x = dist(rng);
+        std::vector<float> want(static_cast<std::size_t>(M) * N);
+        linear_naive(input.data(), weight.data(), M, K, N, want.data());
+
+        for (LinearKernel kernel : {LinearKernel::Gemv, LinearKernel::Gemv4, LinearKernel::Gemm})
+        {
+            std::vector<float> got(want.size());
+            linear_kernel_omp(kernel, input.data(), weight.data(), M, K, N, got.data());
+            float diff = 0.0f;
+            for (std::size_t i = 0; i < got.size(); ++i)
+                diff = std::max(diff, std::abs(got[i] - want[i]));
+            if (diff > 1e-4f)
+            {
+                std::cerr << linear_kernel_name(kernel) << " differs from linear_naive for M = " << M << ": " << diff << "\n";
+                pass = false;
+            }
+        }
+    }
+
+    if (pass)
+    {
+        std::cout << "Linear dispatch test passed!" << std::endl;
+        return 0;
+    }
+    std::cout << "Linear dispatch test failed!" << std::endl;
+    return 1;
+}
@@ -0,0 +1,152 @@
+#include <cpu_ops/lm_head.h>
+#include <cpu_ops/linear.h>
+#include <cpu_ops/sampler.h>
+#include <cpu_ops/vocab_mask.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../test_utils.cpp"
+
+static bool check_topk(const std::vector<float> &input, const std::vector<float> &weight, int K, int N, int k,
+                       const VocabMask *mask = nullptr)
+{
+    std::vector<float> logits(N);
+    linear_naive(input.data(), weight.data(), 1, K, N, logits.data());
+
+    std::vector<int> order;
+    for (int i = 0; i < N; ++i)
+        if (!mask || mask->allowed(i))
+            order.push_back(i);
+    const int expected = std::min(k, static_cast<int>(order.size()));
+    std::partial_sort(order.begin(), order.begin() + expected, order.end(),
+                      [&](int a, int b) { return logits[a] > logits[b]; });
+
+    std::vector<TokenCandidate> out(k);
+    const int count = lm_head_topk_avx2_omp(input.data(), weight.data(), K, N, k, out.data(), mask ? mask->words() : nullptr);
+    if (count != expected)
+    {
+        std::cerr << "lm_head top-k returned " << count << " candidates, expected " << expected << "\n";
+        return false;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        if (std::fabs(logits[order[i]] - out[i].logit) > 1e-3f || std::fabs(logits[out[i].id] - out[i].logit) > 1e-3f)
+        {
+            std::cerr << "lm_head top-k mismatch at rank " << i << " (K=" << K << ", N=" << N << ", k=" << k << ")\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    bool pass = true;
+
+    // Odd shapes exercise the 4-row and K remainders
+    {
+        const int K = 37;
+        const int N = 1023;
+        std::vector<float> input(K), weight(static_cast<size_t>(N) * K);
+        for (auto &x : input)
+            x = dist(gen);
+        for (auto &x : weight)
+            x = dist(gen);
+        pass &= check_topk(input, weight, K, N, 1);
+        pass &= check_topk(input, weight, K, N, 10);
+        pass &= check_topk(input, weight, K, 3, 10);
+
+        // Masked top-k only considers allowed rows
+        VocabMask mask(N);
+        for (int id : {5, 64, 65, 700, 1022})
+            mask.allow(id);
+        pass &= check_topk(input, weight, K, N, 1, &mask);
+        pass &= check_topk(input, weight, K, N, 3, &mask);
+        pass &= check_topk(input, weight, K, N, 10, &mask);
+
+        VocabMask all(N, true);
+        if (all.count() != static_cast<size_t>(N))
+        {
+            std::cerr << "VocabMask allow-all count " << all.count() << ", expected " << N << "\n";
+            pass = false;
+        }
+        pass &= check_topk(input, weight, K, N, 10, &all);
+
+        // Masked full logits: allowed rows match, others are -inf
+        std::vector<float> ref(N), masked(N);
+        linear_naive(input.data(), weight.data(), 1, K, N, ref.data());
+        lm_head_masked_avx2_omp(input.data(), weight.data(), K, N, mask.words(), masked.data());
+        for (int i = 0; i < N; ++i)
+        {
+            const bool ok = mask.allowed(i) ? std::fabs(ref[i] - masked[i]) <= 1e-3f : std::isinf(masked[i]) && masked[i] < 0;
+            if (!ok)
+            {
+                std::cerr << "Masked lm_head mismatch at row " << i << "\n";
+                pass = false;
+                break;
+            }
+        }
+    }
+
+    // Qwen3 lm_head shape
+    const int K = 2048;
+    const int N = 151936;
+    std::vector<float> input(K), weight(static_cast<size_t>(N) * K);
+    for (auto &x : input)
+        x = dist(gen);
+    for (auto &x : weight)
+        x = dist(gen);
+    pass &= check_topk(input, weight, K, N, 1);
+    pass &= check_topk(input, weight, K, N, 40);
+
+    constexpr int iters = 10;
+    std::vector<float> logits(N);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+    {
+        linear_avx2_omp(input.data(), weight.data(), 1, K, N, logits.data());
+        volatile int token = argmax_avx2(logits.data(), N);
+        (void)token;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const double unfused_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / static_cast<double>(iters);
+
+    std::vector<TokenCandidate> out(40);
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+    {
+        lm_head_topk_avx2_omp(input.data(), weight.data(), K, N, 1, out.data());
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const double fused_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / static_cast<double>(iters);
+
+    // Constrained step: a handful of allowed tokens
+    VocabMask sparse(N);
+    for (int id = 1000; id < N; id += N / 16)
+        sparse.allow(id);
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+    {
+        lm_head_topk_avx2_omp(input.data(), weight.data(), K, N, 1, out.data(), sparse.words());
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const double masked_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / static_cast<double>(iters);
+    pass &= check_topk(input, weight, K, N, 4, &sparse);
+
+    std::cout << "GEMV + argmax Latency: " << unfused_us << " us\n";
+    std::cout << "Fused lm_head argmax Latency: " << fused_us << " us\n";
+    std::cout << "Fused lm_head argmax (" << sparse.count() << " allowed tokens) Latency: " << masked_us << " us\n";
+
+    if (pass)
+    {
+        std::cout << "lm_head top-k test passed!\n";
+        return 0;
+    }
+    std::cerr << "lm_head top-k test failed!\n";
+    return 1;
+}
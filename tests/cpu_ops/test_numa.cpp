@@ -0,0 +1,210 @@
+#include <cpu_ops/cpu_topology.h>
+#include <cpu_ops/linear.h>
+#include <cpu_ops/numa.h>
+#include <cpu_ops/task_graph.h>
+#include <cpu_ops/thread_pool.h>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static bool check(bool condition, const char *what)
+{
+    if (!condition)
+        std::cerr << "FAILED: " << what << "\n";
+    return condition;
+}
+
+// Records which threads ran the chunks of each domain's range
+struct DomainLog
+{
+    std::mutex mutex;
+    std::vector<std::set<std::thread::id>> threads;
+    std::vector<int> hits;
+
+    DomainLog(std::size_t size, int domains) : threads(domains), hits(size, 0) {}
+
+    void record(const std::vector<std::size_t> &bounds, std::size_t begin, std::size_t end)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t d = 0; d + 1 < bounds.size(); ++d)
+        {
+            if (begin >= bounds[d] && begin < bounds[d + 1])
+                threads[d].insert(std::this_thread::get_id());
+        }
+        for (std::size_t i = begin; i < end; ++i)
+            ++hits[i];
+    }
+
+    bool disjoint() const
+    {
+        for (std::size_t a = 0; a < threads.size(); ++a)
+            for (std::size_t b = a + 1; b < threads.size(); ++b)
+                for (const auto &id : threads[a])
+                    if (threads[b].count(id))
+                        return false;
+        return true;
+    }
+
+    bool covered() const
+    {
+        for (int h : hits)
+            if (h != 1)
+                return false;
+        return true;
+    }
+};
+
+int main()
+{
+    bool pass = true;
+
+    // Two emulated domains from CPU groups, on whatever CPUs this machine has
+    const std::vector<int> cpus = process_cpus();
+    const int second = cpus.size() > 1 ? cpus[1] : cpus[0];
+    ThreadPoolConfig config;
+    config.cpus = std::to_string(cpus[0]) + ";" + std::to_string(second);
+    pass &= check(ThreadPool::configure(config), "configure before first use");
+
+    ThreadPool &pool = ThreadPool::instance();
+    pass &= check(!ThreadPool::configure(ThreadPoolConfig()), "configure after first use is refused");
+    pass &= check(pool.num_domains() == 2 && pool.num_threads() == 2, "one thread in each of two domains");
+    pass &= check(pool.thread_domain(0) == 0 && pool.thread_domain(1) == 1, "threads alternate domains");
+
+    const std::vector<std::size_t> split = numa_split(1000, pool);
+    pass &= check(split.size() == 3 && split[0] == 0 && split[2] == 1000 && split[1] % 8 == 0, "split covers the rows");
+    pass &= check(split[1] >= 496 && split[1] <= 504, "split follows thread counts");
+    pass &= check(numa_split(5, pool).back() == 5, "small splits still cover the rows");
+
+    // parallel_for_domains keeps each range on its domain's threads
+    {
+        DomainLog log(1000, 2);
+        pool.parallel_for_domains(split, 7, [&](std::size_t begin, std::size_t end) { log.record(split, begin, end); });
+        pass &= check(log.covered(), "parallel_for_domains covers the range once");
+        pass &= check(log.disjoint(), "parallel_for_domains keeps domains apart");
+    }
+
+    // So do split TaskGraph nodes, alongside ordinary ones
+    {
+        TaskGraph graph;
+        DomainLog log(1000, 2);
+        std::vector<int> after(1000, 0);
+        const int first = graph.add(split, 5, [&](std::size_t begin, std::size_t end) { log.record(split, begin, end); });
+        const int second_node = graph.add(1000, 64, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+                after[i] = log.hits[i];
+        }, {first});
+        graph.add(std::vector<std::size_t>{0, 0, 0}, 4, [&](std::size_t, std::size_t) { pass = false; }, {second_node});
+        for (int repeat = 0; repeat < 50; ++repeat)
+        {
+            graph.run(pool);
+        }
+        pass &= check(log.disjoint(), "split graph node keeps domains apart");
+        bool ordered = true;
+        for (int a : after)
+            ordered &= a == 50;
+        pass &= check(ordered, "dependents of a split node wait for every domain");
+
+        // A single-range node on a two-domain pool is scheduled normally
+        TaskGraph plain;
+        std::vector<int> hits(100, 0);
+        plain.add(std::vector<std::size_t>{0, 100}, 3, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; ++i)
+                ++hits[i];
+        });
+        plain.run(pool);
+        bool once = true;
+        for (int h : hits)
+            once &= h == 1;
+        pass &= check(once, "unsplit bounds node runs once");
+    }
+
+    // Placed weights hold the same values and give the same projections
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    const int K = 96, N = 200;
+    for (int M : {1, 3})
+    {
+        Tensor weight(DataType::F32, {static_cast<std::size_t>(N), static_cast<std::size_t>(K)});
+        for (std::size_t i = 0; i < weight.size(); ++i)
+            weight.data<float>()[i] = dist(gen);
+        std::vector<float> input(static_cast<std::size_t>(M) * K), expected(static_cast<std::size_t>(M) * N), actual(expected.size());
+        for (auto &x : input)
+            x = dist(gen);
+
+        const std::vector<std::size_t> bounds = numa_split(N, pool);
+        Tensor placed = numa_place_rows(weight, bounds, pool);
+        bool same = placed.shape() == weight.shape() && placed.raw_data() != weight.raw_data();
+        for (std::size_t i = 0; i < weight.size(); ++i)
+            same &= placed.data<float>()[i] == weight.data<float>()[i];
+        pass &= check(same, "placed copy matches the weight");
+
+        linear_avx2_range(input.data(), weight.data<float>(), M, K, N, 0, N, expected.data());
+        linear_avx2_domains(input.data(), placed.data<float>(), M, K, N, bounds, actual.data());
+        pass &= check(actual == expected, "domain-split linear matches");
+        linear_avx2_domains(input.data(), placed.data<float>(), M, K, N, {0, static_cast<std::size_t>(N)}, actual.data());
+        pass &= check(actual == expected, "unsplit bounds fall back to the plain linear");
+
+        // Tensor-parallel: each domain multiplies its slice of the input columns, partials are summed
+        const std::vector<std::size_t> columns = numa_split(K, pool);
+        std::vector<Tensor> parts;
+        std::vector<const float *> part_ptrs;
+        bool sliced = true;
+        for (int d = 0; d < 2; ++d)
+        {
+            parts.push_back(numa_place_columns(weight, columns[d], columns[d + 1], d, pool));
+            part_ptrs.push_back(parts.back().data<float>());
+            const std::size_t width = columns[d + 1] - columns[d];
+            sliced &= parts.back().shape() == std::vector<std::size_t>{static_cast<std::size_t>(N), width};
+            for (std::size_t r = 0; r < static_cast<std::size_t>(N); ++r)
+                for (std::size_t c = 0; c < width; ++c)
+                    sliced &= part_ptrs[d][r * width + c] == weight.data<float>()[r * K + columns[d] + c];
+        }
+        pass &= check(sliced, "column slices match the weight");
+
+        linear_avx2_column_split(input.data(), part_ptrs.data(), M, K, N, columns, actual.data());
+        bool close = true;
+        for (std::size_t i = 0; i < expected.size(); ++i)
+            close &= std::fabs(actual[i] - expected[i]) <= 1e-4f * (1.0f + std::fabs(expected[i]));
+        pass &= check(close, "column-split linear matches");
+
+        // A domain without columns contributes nothing
+        Tensor empty = numa_place_columns(weight, 0, 0, 0, pool);
+        const float *all_to_second[] = {empty.data<float>(), weight.data<float>()};
+        linear_avx2_column_split(input.data(), all_to_second, M, K, N, {0, 0, static_cast<std::size_t>(K)}, actual.data());
+        close = true;
+        for (std::size_t i = 0; i < expected.size(); ++i)
+            close &= std::fabs(actual[i] - expected[i]) <= 1e-4f * (1.0f + std::fabs(expected[i]));
+        pass &= check(close, "empty column slice is skipped");
+    }
+
+    // Bounds that hand a whole range to one domain
+    const std::vector<std::size_t> only_second = numa_domain_bounds(1, 10, 30, 3);
+    pass &= check(only_second == std::vector<std::size_t>{10, 10, 30, 30}, "domain bounds give the range to one domain");
+    bool rejected = false;
+    try
+    {
+        Tensor weight(DataType::F32, {4, 4});
+        numa_place_columns(weight, 2, 5, 0, pool);
+    }
+    catch (const std::invalid_argument &)
+    {
+        rejected = true;
+    }
+    pass &= check(rejected, "column range past the weight is rejected");
+
+    if (pass)
+    {
+        std::cout << "NUMA test passed!\n";
+        return 0;
+    }
+    std::cout << "NUMA test failed!\n";
+    return 1;
+}
@@ -48,6 +48,8 @@ int main()
     // More accurate timing: nanoseconds and multiple iterations
     constexpr int num_iters = 10000;
 
+    warm_up_cpu_ops();
+
     // Naive reference timing
     auto start = std::chrono::high_resolution_clock::now();
     std::vector<float> ref;
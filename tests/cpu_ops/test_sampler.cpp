@@ -0,0 +1,173 @@
+#include <cpu_ops/sampler.h>
+#include <cpu_ops/softmax_avx2.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+#include "../test_utils.cpp"
+
+int main()
+{
+    constexpr int N = 151936;
+    std::vector<float> logits(N);
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+    for (auto &x : logits)
+        x = dist(rng);
+
+    bool pass = true;
+
+    // argmax matches std::max_element, including an odd-sized tail
+    for (int size : {1, 7, 8, 9, 1000, N})
+    {
+        const int ref = static_cast<int>(std::max_element(logits.begin(), logits.begin() + size) - logits.begin());
+        const int got = argmax_avx2(logits.data(), size);
+        if (ref != got)
+        {
+            std::cerr << "argmax mismatch for size " << size << ": " << ref << " vs " << got << "\n";
+            pass = false;
+        }
+    }
+
+    // top-k selection matches a sorted reference
+    const int k = 40;
+    std::vector<TokenCandidate> topk(k);
+    const int count = select_topk_avx2(logits.data(), N, k, -INFINITY, topk.data());
+    std::vector<float> sorted(logits);
+    std::partial_sort(sorted.begin(), sorted.begin() + k, sorted.end(), std::greater<float>());
+    if (count != k)
+    {
+        std::cerr << "top-k returned " << count << " candidates, expected " << k << "\n";
+        pass = false;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        if (topk[i].logit != sorted[i] || logits[topk[i].id] != topk[i].logit)
+        {
+            std::cerr << "top-k mismatch at rank " << i << "\n";
+            pass = false;
+            break;
+        }
+    }
+
+    // floor limits the candidates
+    const int above = select_topk_avx2(logits.data(), N, k, sorted[9], topk.data());
+    if (above != 10)
+    {
+        std::cerr << "floor selection returned " << above << " candidates, expected 10\n";
+        pass = false;
+    }
+
+    // Greedy sampling is argmax
+    Sampler greedy;
+    std::vector<float> work(logits);
+    const int greedy_token = greedy.sample(work.data(), N, nullptr, 0);
+    if (greedy_token != argmax_avx2(logits.data(), N))
+    {
+        std::cerr << "greedy sample is not argmax\n";
+        pass = false;
+    }
+
+    // Repetition penalty pushes a seen token off the top
+    SamplerConfig penalty_config;
+    penalty_config.presence_penalty = 100.0f;
+    Sampler penalized(penalty_config);
+    work = logits;
+    if (penalized.sample(work.data(), N, &greedy_token, 1) == greedy_token)
+    {
+        std::cerr << "presence penalty did not change the greedy token\n";
+        pass = false;
+    }
+
+    // Stochastic top-k only returns top-k tokens
+    SamplerConfig topk_config;
+    topk_config.temperature = 5.0f;
+    topk_config.top_k = 3;
+    topk_config.seed = 7;
+    Sampler topk_sampler(topk_config);
+    std::set<int> allowed = {topk[0].id, topk[1].id, topk[2].id};
+    std::set<int> seen;
+    for (int i = 0; i < 200; ++i)
+    {
+        work = logits;
+        const int token = topk_sampler.sample(work.data(), N, nullptr, 0);
+        seen.insert(token);
+        if (!allowed.count(token))
+        {
+            std::cerr << "top-k sampler returned token outside the top 3\n";
+            pass = false;
+            break;
+        }
+    }
+    if (seen.size() < 2)
+    {
+        std::cerr << "top-k sampler at high temperature never explored\n";
+        pass = false;
+    }
+
+    // Sampled frequencies follow the softmax on a small vocabulary
+    std::vector<float> small = {2.0f, 1.0f, 0.0f, -1.0f};
+    std::vector<float> probs(small);
+    softmax_avx2(probs.data(), static_cast<int>(probs.size()));
+    SamplerConfig full_config;
+    full_config.temperature = 1.0f;
+    full_config.seed = 3;
+    Sampler full(full_config);
+    std::vector<int> hist(small.size(), 0);
+    const int draws = 20000;
+    for (int i = 0; i < draws; ++i)
+    {
+        std::vector<float> w(small);
+        ++hist[full.sample(w.data(), static_cast<int>(w.size()), nullptr, 0)];
+    }
+    for (size_t i = 0; i < small.size(); ++i)
+    {
+        const float freq = static_cast<float>(hist[i]) / draws;
+        if (std::fabs(freq - probs[i]) > 0.02f)
+        {
+            std::cerr << "sampled frequency " << freq << " deviates from softmax " << probs[i] << "\n";
+            pass = false;
+        }
+    }
+
+    // Latency: softmax + max_element vs sampler
+    constexpr int iters = 20;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+    {
+        work = logits;
+        softmax_avx2(work.data(), N);
+        volatile auto it = std::max_element(work.begin(), work.end());
+        (void)it;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const double ref_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / static_cast<double>(iters);
+
+    SamplerConfig bench_config;
+    bench_config.temperature = 0.8f;
+    bench_config.top_k = 40;
+    bench_config.top_p = 0.95f;
+    Sampler bench(bench_config);
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iters; ++i)
+    {
+        work = logits;
+        volatile int token = bench.sample(work.data(), N, nullptr, 0);
+        (void)token;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    const double sampler_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / static_cast<double>(iters);
+
+    std::cout << "Softmax + argmax Latency: " << ref_us << " us\n";
+    std::cout << "Sampler (top-k 40, top-p 0.95) Latency: " << sampler_us << " us\n";
+
+    if (pass)
+    {
+        std::cout << "Sampler test passed!\n";
+        return 0;
+    }
+    std::cerr << "Sampler test failed!\n";
+    return 1;
+}
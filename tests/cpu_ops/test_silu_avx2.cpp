@@ -21,6 +21,8 @@ int main() {
     std::uniform_real_distribution<float> dist(-10, 10);
     for (size_t i = 0; i < N; ++i) x[i] = dist(rng);
 
+    warm_up_cpu_ops();
+
     // Reference timing (average over num_iters)
     long long ref_total_time = 0;
     for (int iter = 0; iter < num_iters; ++iter) {
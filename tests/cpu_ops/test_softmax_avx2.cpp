@@ -27,6 +27,8 @@ int main() {
     std::uniform_real_distribution<float> dist(-10, 10);
     for (size_t i = 0; i < N; ++i) x[i] = dist(rng);
 
+    warm_up_cpu_ops();
+
     // Reference timing
     auto start = std::chrono::high_resolution_clock::now();
     softmax_ref(x.data(), ref.data(), N);
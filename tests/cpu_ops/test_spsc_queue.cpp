@@ -0,0 +1,88 @@
+#include <cpu_ops/spsc_queue.h>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+int main()
+{
+    bool pass = true;
+
+    // Capacity rounds up, and a full or empty ring refuses instead of blocking
+    {
+        SpscQueue<int> queue(5);
+        pass &= queue.capacity() == 8;
+        int value = 0;
+        pass &= !queue.try_pop(value);
+        for (int i = 0; i < 8; ++i)
+            pass &= queue.try_push(i);
+        pass &= !queue.try_push(8);
+        for (int i = 0; i < 8; ++i)
+            pass &= queue.try_pop(value) && value == i;
+        pass &= !queue.try_pop(value);
+        if (!pass)
+            std::cerr << "Single-threaded push/pop failed\n";
+    }
+
+    // Many wrap-arounds of a small ring between two threads keep order and lose nothing
+    {
+        const int count = 200000;
+        SpscQueue<int> queue(4);
+        std::thread producer([&]
+        {
+            for (int i = 0; i < count; ++i)
+                queue.push(i);
+        });
+        bool ordered = true;
+        for (int i = 0; i < count; ++i)
+            ordered &= queue.pop() == i;
+        producer.join();
+        if (!ordered)
+        {
+            std::cerr << "Items arrived out of order\n";
+            pass = false;
+        }
+    }
+
+    // A chain of queues, as between pipeline stages
+    {
+        const int count = 10000;
+        const int stages = 3;
+        std::vector<std::unique_ptr<SpscQueue<int>>> queues;
+        for (int s = 0; s <= stages; ++s)
+            queues.push_back(std::make_unique<SpscQueue<int>>(16));
+        std::vector<std::thread> threads;
+        for (int s = 0; s < stages; ++s)
+        {
+            threads.emplace_back([&, s]
+            {
+                for (int i = 0; i < count; ++i)
+                    queues[s + 1]->push(queues[s]->pop() + 1);
+            });
+        }
+        bool ordered = true;
+        std::thread feeder([&]
+        {
+            for (int i = 0; i < count; ++i)
+                queues[0]->push(i);
+        });
+        for (int i = 0; i < count; ++i)
+            ordered &= queues[stages]->pop() == i + stages;
+        feeder.join();
+        for (auto &t : threads)
+            t.join();
+        if (!ordered)
+        {
+            std::cerr << "Pipeline chain reordered or changed items\n";
+            pass = false;
+        }
+    }
+
+    if (pass)
+    {
+        std::cout << "SPSC queue test passed!\n";
+        return 0;
+    }
+    std::cout << "SPSC queue test failed!\n";
+    return 1;
+}
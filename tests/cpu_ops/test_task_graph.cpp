@@ -0,0 +1,118 @@
+#include <cpu_ops/task_graph.h>
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Random DAG: every node checks that all of its dependencies finished before any of its chunks
+static bool check_random_graph(TaskGraph &graph, ThreadPool &pool, std::mt19937 &gen, int num_nodes)
+{
+    std::vector<std::atomic<int>> done(num_nodes);
+    std::vector<std::atomic<int>> visits(num_nodes * 64);
+    std::vector<std::vector<int>> deps(num_nodes);
+    std::vector<std::size_t> sizes(num_nodes);
+    std::atomic<bool> order_ok(true);
+
+    graph.clear();
+    for (int i = 0; i < num_nodes; ++i)
+    {
+        done[i] = 0;
+        sizes[i] = gen() % 64;
+        for (std::size_t j = 0; j < 64; ++j)
+            visits[i * 64 + j] = 0;
+
+        std::vector<int> &d = deps[i];
+        for (int k = 0; k < 3 && i > 0; ++k)
+            d.push_back(static_cast<int>(gen() % i));
+        while (d.size() < 3)
+            d.push_back(-1);
+
+        auto body = [&, i](std::size_t begin, std::size_t end)
+        {
+            for (int dep : deps[i])
+                if (dep >= 0 && done[dep] != static_cast<int>(sizes[dep]))
+                    order_ok = false;
+            for (std::size_t j = begin; j < end; ++j)
+            {
+                visits[i * 64 + j].fetch_add(1);
+                done[i].fetch_add(1);
+            }
+        };
+        const std::size_t grain = 1 + gen() % 8;
+        if (d[0] < 0)
+            graph.add(sizes[i], grain, body);
+        else
+            graph.add(sizes[i], grain, body, {d[0], d[1], d[2]});
+    }
+    graph.run(pool);
+
+    bool ok = order_ok;
+    for (int i = 0; i < num_nodes; ++i)
+        for (std::size_t j = 0; j < 64; ++j)
+            ok &= visits[i * 64 + j] == (j < sizes[i] ? 1 : 0);
+    if (!ok)
+        std::cerr << "Random graph of " << num_nodes << " nodes ran out of order or missed chunks\n";
+    return ok;
+}
+
+int main()
+{
+    bool pass = true;
+    ThreadPool pool(4, false);
+    TaskGraph graph;
+
+    // Diamond: a -> (b, c) -> d
+    {
+        std::vector<int> trace;
+        std::atomic<int> b_chunks(0);
+        const int a = graph.add([&] { trace.push_back(0); });
+        const int b = graph.add(100, 10, [&](std::size_t begin, std::size_t end) { b_chunks += static_cast<int>(end - begin); }, {a});
+        const int c = graph.add([&] { trace.push_back(2); }, {a});
+        graph.add([&] { trace.push_back(b_chunks.load() == 100 ? 3 : -1); }, {b, c});
+        graph.run(pool);
+        if (trace != std::vector<int>({0, 2, 3}))
+        {
+            std::cerr << "Diamond graph ran out of order\n";
+            pass = false;
+        }
+    }
+
+    // Empty ranges still release their dependents
+    {
+        graph.clear();
+        bool ran = false;
+        const int empty = graph.add(0, 4, [](std::size_t, std::size_t) {});
+        graph.add([&] { ran = true; }, {empty});
+        graph.run(pool);
+        pass &= ran;
+    }
+
+    std::mt19937 gen(7);
+    for (int rep = 0; rep < 200; ++rep)
+        pass &= check_random_graph(graph, pool, gen, 1 + static_cast<int>(gen() % 40));
+
+    // Same graph on the shared pool, and rebuilt many times with reused buffers
+    for (int rep = 0; rep < 20; ++rep)
+        pass &= check_random_graph(graph, ThreadPool::instance(), gen, 30);
+
+    bool threw = false;
+    try
+    {
+        graph.clear();
+        graph.add([] {}, {0});
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    pass &= threw;
+
+    if (pass)
+    {
+        std::cout << "Task graph test passed!\n";
+        return 0;
+    }
+    std::cout << "Task graph test failed!\n";
+    return 1;
+}
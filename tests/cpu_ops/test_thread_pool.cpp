@@ -0,0 +1,233 @@
+#include <cpu_ops/thread_pool.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Every index of [begin, end) must be visited exactly once
+static bool check_coverage(ThreadPool &pool, std::size_t begin, std::size_t end, std::size_t grain)
+{
+    std::vector<std::atomic<int>> visits(end);
+    for (auto &v : visits)
+        v = 0;
+
+    pool.parallel_for(begin, end, grain, [&](std::size_t chunk_begin, std::size_t chunk_end)
+    {
+        for (std::size_t i = chunk_begin; i < chunk_end; ++i)
+            visits[i].fetch_add(1, std::memory_order_relaxed);
+    });
+
+    for (std::size_t i = 0; i < end; ++i)
+    {
+        if (visits[i] != (i >= begin ? 1 : 0))
+        {
+            std::cerr << "parallel_for visited index " << i << " " << visits[i] << " times (range " << begin << ".." << end
+                      << ", grain " << grain << ")\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    bool pass = true;
+    ThreadPool pool(4, false);
+
+    pass &= check_coverage(pool, 0, 1, 1);
+    pass &= check_coverage(pool, 0, 1000, 1);
+    pass &= check_coverage(pool, 3, 1000, 7);
+    pass &= check_coverage(pool, 0, 100, 1000);
+    pass &= check_coverage(pool, 5, 5, 1);
+
+    // parallel_run hands out distinct thread indices
+    {
+        std::vector<std::atomic<int>> seen(pool.num_threads());
+        for (auto &s : seen)
+            s = 0;
+        int reported = 0;
+        pool.parallel_run([&](int t, int n)
+        {
+            seen[t].fetch_add(1);
+            if (t == 0)
+                reported = n;
+        });
+        for (int t = 0; t < reported; ++t)
+            pass &= seen[t] == 1;
+        if (reported != pool.num_threads())
+        {
+            std::cerr << "parallel_run used " << reported << " of " << pool.num_threads() << " threads\n";
+            pass = false;
+        }
+    }
+
+    // Nested calls run inline instead of deadlocking on the busy pool
+    {
+        std::atomic<int> total(0);
+        pool.parallel_for(0, 8, 1, [&](std::size_t, std::size_t)
+        {
+            pool.parallel_for(0, 100, 10, [&](std::size_t chunk_begin, std::size_t chunk_end)
+            {
+                total.fetch_add(static_cast<int>(chunk_end - chunk_begin));
+            });
+        });
+        if (total != 800)
+        {
+            std::cerr << "Nested parallel_for covered " << total << " of 800 indices\n";
+            pass = false;
+        }
+    }
+
+    // Concurrent callers: one owns the pool, the other falls back to running inline
+    {
+        std::atomic<long long> sums[2];
+        sums[0] = 0;
+        sums[1] = 0;
+        std::vector<std::thread> callers;
+        for (int c = 0; c < 2; ++c)
+        {
+            callers.emplace_back([&, c]
+            {
+                for (int rep = 0; rep < 200; ++rep)
+                {
+                    pool.parallel_for(0, 1000, 50, [&](std::size_t chunk_begin, std::size_t chunk_end)
+                    {
+                        long long local = 0;
+                        for (std::size_t i = chunk_begin; i < chunk_end; ++i)
+                            local += static_cast<long long>(i);
+                        sums[c].fetch_add(local);
+                    });
+                }
+            });
+        }
+        for (auto &t : callers)
+            t.join();
+        for (int c = 0; c < 2; ++c)
+        {
+            if (sums[c] != 200LL * 999 * 1000 / 2)
+            {
+                std::cerr << "Concurrent caller " << c << " got a wrong sum\n";
+                pass = false;
+            }
+        }
+    }
+
+    // A Scope routes the free parallel_for of its thread to its pool, and only while it lives
+    {
+        bool bound = &ThreadPool::current() == &ThreadPool::instance();
+        {
+            ThreadPool::Scope scope(pool);
+            bound &= &ThreadPool::current() == &pool;
+            std::thread other([&] { bound &= &ThreadPool::current() == &ThreadPool::instance(); });
+            other.join();
+            {
+                ThreadPool inner(2, false);
+                ThreadPool::Scope nested(inner);
+                bound &= &ThreadPool::current() == &inner;
+            }
+            bound &= &ThreadPool::current() == &pool;
+        }
+        bound &= &ThreadPool::current() == &ThreadPool::instance();
+        if (!bound)
+        {
+            std::cerr << "ThreadPool::Scope did not bind the expected pool\n";
+            pass = false;
+        }
+    }
+
+    // Exceptions from the calling thread's share propagate after the workers finish
+    {
+        bool caught = false;
+        try
+        {
+            pool.parallel_run([](int t, int)
+            {
+                if (t == 0)
+                    throw std::runtime_error("task failed");
+            });
+        }
+        catch (const std::runtime_error &)
+        {
+            caught = true;
+        }
+        pass &= caught;
+        pass &= check_coverage(pool, 0, 1000, 1);
+    }
+
+    // The calling thread can pin itself to the CPU the pool reserves for it; an unpinned pool has none
+    {
+        ThreadPool pinned(2, true);
+        bool pinned_ok = false;
+        std::thread([&]
+        {
+            // The second call finds the thread already pinned
+            const bool expected = !pinned.cpus().empty();
+            pinned_ok = pinned.pin_caller() == expected && pinned.pin_caller() == expected;
+        }).join();
+        if (!pinned_ok || pool.pin_caller())
+        {
+            std::cerr << "pin_caller did not match the pools' pinning\n";
+            pass = false;
+        }
+    }
+
+    // Exceptions on a worker are caught there and rethrown by the caller, and the pool stays usable
+    {
+        bool caught = false;
+        try
+        {
+            pool.parallel_run([](int t, int)
+            {
+                if (t == 1)
+                    throw std::runtime_error("worker failed");
+            });
+        }
+        catch (const std::runtime_error &)
+        {
+            caught = true;
+        }
+        pass &= caught;
+        pass &= check_coverage(pool, 0, 1000, 1);
+
+        bool rethrown = false;
+        try
+        {
+            pool.parallel_run([](int, int) {});
+        }
+        catch (...)
+        {
+            rethrown = true;
+        }
+        if (!caught || rethrown)
+        {
+            std::cerr << "Worker exception was not rethrown exactly once\n";
+            pass = false;
+        }
+    }
+
+    // Dispatch overhead of back-to-back empty tasks, as between the kernels of one token, on a
+    // pool that does not oversubscribe the machine
+    {
+        ThreadPool sized(0, false);
+        const int reps = 100000;
+        std::atomic<int> sink(0);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int rep = 0; rep < reps; ++rep)
+        {
+            sized.parallel_run([&](int t, int) { sink.fetch_add(t, std::memory_order_relaxed); });
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count() / reps;
+        std::cout << "Dispatch overhead (" << sized.num_threads() << " threads): " << ns << " ns per call\n";
+    }
+
+    if (pass)
+    {
+        std::cout << "Thread pool test passed!\n";
+        return 0;
+    }
+    std::cout << "Thread pool test failed!\n";
+    return 1;
+}
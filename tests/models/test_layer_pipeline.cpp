@@ -0,0 +1,237 @@
+#include <cpu_ops/decoder.h>
+#include <cpu_ops/rotary_embedding.h>
+#include <cpu_ops/thread_pool.h>
+#include <models/layer_pipeline.h>
+#include <tensor/kvcache.h>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+constexpr std::size_t kLayers = 4;
+constexpr std::size_t kEmbed = 64;
+constexpr std::size_t kHeads = 4;
+constexpr std::size_t kGroups = 2;
+constexpr std::size_t kHeadDim = 16;
+constexpr std::size_t kUp = 128;
+constexpr std::size_t kMaxTokens = 32;
+
+// One layer's weights, shared by the layer of every stack built from them
+struct LayerWeights
+{
+    std::vector<float> input_norm, q, k, v, o, q_norm, k_norm, post_norm, up, gate, down;
+
+    explicit LayerWeights(std::mt19937 &gen)
+    {
+        std::normal_distribution<float> noise(0.0f, 0.2f);
+        auto fill = [&](std::vector<float> &w, std::size_t size, float base)
+        {
+            w.resize(size);
+            for (float &x : w)
+                x = base + noise(gen);
+        };
+        fill(input_norm, kEmbed, 1.0f);
+        fill(q, kHeads * kHeadDim * kEmbed, 0.0f);
+        fill(k, kGroups * kHeadDim * kEmbed, 0.0f);
+        fill(v, kGroups * kHeadDim * kEmbed, 0.0f);
+        fill(o, kEmbed * kHeads * kHeadDim, 0.0f);
+        fill(q_norm, kHeadDim, 1.0f);
+        fill(k_norm, kHeadDim, 1.0f);
+        fill(post_norm, kEmbed, 1.0f);
+        fill(up, kUp * kEmbed, 0.0f);
+        fill(gate, kUp * kEmbed, 0.0f);
+        fill(down, kEmbed * kUp, 0.0f);
+    }
+};
+
+// A decoder stack over views of the weights (the Decoder constructor takes its tensors over) with
+// the KV caches of two sequences
+struct Stack
+{
+    std::vector<float> sin_data, cos_data;
+    Tensor sin, cos;
+    KVCache first, second;
+    std::vector<std::unique_ptr<Decoder>> decoders;
+    std::vector<Decoder *> layers;
+
+    explicit Stack(std::vector<LayerWeights> &weights)
+        : sin_data(kMaxTokens * kHeadDim / 2), cos_data(kMaxTokens * kHeadDim / 2),
+          sin(sin_data.data(), {kMaxTokens, kHeadDim / 2}, DataType::F32),
+          cos(cos_data.data(), {kMaxTokens, kHeadDim / 2}, DataType::F32),
+          first(kMaxTokens, kHeadDim, kGroups, kLayers), second(kMaxTokens, kHeadDim, kGroups, kLayers)
+    {
+        RotaryEmbeddingAVX2::precompute(sin_data.data(), cos_data.data(), kMaxTokens, kHeadDim, 1000000.0f);
+        auto view = [](std::vector<float> &data, std::vector<std::size_t> shape)
+        {
+            return Tensor(data.data(), shape, DataType::F32);
+        };
+        for (std::size_t layer = 0; layer < kLayers; ++layer)
+        {
+            LayerWeights &w = weights[layer];
+            Tensor input_norm = view(w.input_norm, {kEmbed});
+            Tensor q = view(w.q, {kHeads * kHeadDim, kEmbed});
+            Tensor k = view(w.k, {kGroups * kHeadDim, kEmbed});
+            Tensor v = view(w.v, {kGroups * kHeadDim, kEmbed});
+            Tensor o = view(w.o, {kEmbed, kHeads * kHeadDim});
+            Tensor q_norm = view(w.q_norm, {kHeadDim});
+            Tensor k_norm = view(w.k_norm, {kHeadDim});
+            Tensor post_norm = view(w.post_norm, {kEmbed});
+            Tensor up = view(w.up, {kUp, kEmbed});
+            Tensor gate = view(w.gate, {kUp, kEmbed});
+            Tensor down = view(w.down, {kEmbed, kUp});
+            decoders.push_back(std::make_unique<Decoder>(input_norm, q, k, v, o, q_norm, k_norm, sin, cos, layer,
+                                                         &first, post_norm, up, gate, down));
+            layers.push_back(decoders.back().get());
+        }
+    }
+
+    // Every layer's run_batch in turn on the calling thread's pool
+    void run_sequential(Tensor &input, const AttentionRow *rows, std::size_t count, Tensor &output)
+    {
+        Tensor buffers[2] = {Tensor(DataType::F32, {count, kEmbed}), Tensor(DataType::F32, {count, kEmbed})};
+        for (std::size_t layer = 0; layer < kLayers; ++layer)
+        {
+            Tensor &source = layer == 0 ? input : buffers[(layer - 1) % 2];
+            Tensor &target = layer + 1 == kLayers ? output : buffers[layer % 2];
+            layers[layer]->run_batch(source, rows, count, target);
+        }
+    }
+};
+
+// Rows for `count` consecutive positions of cache, starting at position
+void add_rows(std::vector<AttentionRow> &rows, KVCache &cache, std::size_t position, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        rows.push_back({&cache, position + i});
+    }
+}
+
+Tensor random_input(std::mt19937 &gen, std::size_t count)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    Tensor input(DataType::F32, {count, kEmbed});
+    for (std::size_t i = 0; i < input.size(); ++i)
+        input.data<float>()[i] = dist(gen);
+    return input;
+}
+
+bool close(const Tensor &a, const Tensor &b)
+{
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        const float x = a.data<float>()[i], y = b.data<float>()[i];
+        if (std::fabs(x - y) > 1e-4f * (1.0f + std::fabs(x)))
+            return false;
+    }
+    return true;
+}
+} // namespace
+
+int main()
+{
+    bool pass = true;
+
+    std::mt19937 gen(11);
+    std::vector<LayerWeights> weights;
+    for (std::size_t layer = 0; layer < kLayers; ++layer)
+        weights.emplace_back(gen);
+    Stack reference(weights);
+    Stack pipelined(weights);
+
+    LayerPipeline pipeline(kLayers, 3, ThreadPool::instance());
+    if (pipeline.num_stages() != 3 || pipeline.stage_begin(1) != 1 || pipeline.stage_begin(2) != 2 ||
+        pipeline.layer_stage(3) != 2)
+    {
+        std::cerr << "Unexpected stage split\n";
+        return 1;
+    }
+
+    // Two prefills and then two steps of both sequences. Micro-batches of 3 rows cut the first
+    // sequence's prompt in three, so later micro-batches attend to KV rows written by earlier ones.
+    struct Step
+    {
+        std::size_t first_position, first_count, second_position, second_count, micro_batch;
+    };
+    const Step steps[] = {{0, 7, 0, 4, 3}, {7, 1, 4, 1, 1}, {8, 2, 5, 3, 0}};
+    for (const Step &step : steps)
+    {
+        std::vector<AttentionRow> reference_rows, pipelined_rows;
+        add_rows(reference_rows, reference.first, step.first_position, step.first_count);
+        add_rows(reference_rows, reference.second, step.second_position, step.second_count);
+        add_rows(pipelined_rows, pipelined.first, step.first_position, step.first_count);
+        add_rows(pipelined_rows, pipelined.second, step.second_position, step.second_count);
+        const std::size_t count = reference_rows.size();
+
+        Tensor input = random_input(gen, count);
+        Tensor expected(DataType::F32, {count, kEmbed}), actual(DataType::F32, {count, kEmbed});
+        reference.run_sequential(input, reference_rows.data(), count, expected);
+        pipeline.run(pipelined.layers.data(), input, pipelined_rows.data(), count, step.micro_batch, actual);
+        if (!close(expected, actual))
+        {
+            std::cerr << "Pipelined output differs at position " << step.first_position << "\n";
+            pass = false;
+        }
+    }
+
+    // A cache with a single layer makes every stage after the first throw; run() must rethrow each
+    // time and leave the pipeline usable
+    KVCache short_cache(kMaxTokens, kHeadDim, kGroups, 1);
+    for (int attempt = 0; attempt < 20; ++attempt)
+    {
+        std::vector<AttentionRow> rows;
+        add_rows(rows, short_cache, 0, 4);
+        Tensor input = random_input(gen, rows.size());
+        Tensor output(DataType::F32, {rows.size(), kEmbed});
+        bool threw = false;
+        try
+        {
+            pipeline.run(pipelined.layers.data(), input, rows.data(), rows.size(), 1, output);
+        }
+        catch (const std::out_of_range &)
+        {
+            threw = true;
+        }
+        if (!threw)
+        {
+            std::cerr << "Failing stage was not rethrown on attempt " << attempt << "\n";
+            pass = false;
+            break;
+        }
+    }
+
+    {
+        std::vector<AttentionRow> reference_rows, pipelined_rows;
+        add_rows(reference_rows, reference.first, 10, 2);
+        add_rows(pipelined_rows, pipelined.first, 10, 2);
+        Tensor input = random_input(gen, 2);
+        Tensor expected(DataType::F32, {2, kEmbed}), actual(DataType::F32, {2, kEmbed});
+        reference.run_sequential(input, reference_rows.data(), 2, expected);
+        try
+        {
+            pipeline.run(pipelined.layers.data(), input, pipelined_rows.data(), 2, 1, actual);
+            if (!close(expected, actual))
+            {
+                std::cerr << "Pipelined output differs after a failed run\n";
+                pass = false;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Run after a failed one threw: " << e.what() << "\n";
+            pass = false;
+        }
+    }
+
+    if (pass)
+    {
+        std::cout << "Layer pipeline test passed!\n";
+        return 0;
+    }
+    std::cout << "Layer pipeline test failed!\n";
+    return 1;
+}
@@ -0,0 +1,91 @@
+#include <models/speculative.h>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+// Proposals for context + pending from a fresh drafter
+std::vector<int> propose(PromptLookupDrafter &drafter, const std::vector<int> &context, int pending, std::size_t max_tokens)
+{
+    drafter.begin(context);
+    std::vector<int> tokens;
+    std::vector<float> probs;
+    const std::size_t proposed = drafter.propose(pending, max_tokens, tokens, probs);
+    if (proposed != tokens.size() || !probs.empty())
+        tokens.push_back(-1); // Makes the comparison below fail
+    return tokens;
+}
+
+bool expect(const char *name, const std::vector<int> &got, const std::vector<int> &want)
+{
+    if (got == want)
+        return true;
+    std::cerr << name << ": got";
+    for (int token : got)
+        std::cerr << " " << token;
+    std::cerr << ", want";
+    for (int token : want)
+        std::cerr << " " << token;
+    std::cerr << "\n";
+    return false;
+}
+} // namespace
+
+int main()
+{
+    bool pass = true;
+    PromptLookupDrafter drafter(3, 1);
+
+    // The trailing token never occurred before
+    pass &= expect("No match", propose(drafter, {1, 2, 3}, 4, 4), {});
+
+    // [2, 3] follows 5 earlier and is preferred over the more recent unigram match of 3
+    pass &= expect("Longest n-gram", propose(drafter, {5, 2, 3, 9, 7, 3, 8, 2}, 3, 2), {9, 7});
+
+    // [1, 2] occurs twice; the later occurrence wins
+    pass &= expect("Most recent match", propose(drafter, {1, 2, 10, 1, 2, 20, 1}, 2, 1), {20});
+
+    // Only three tokens follow the match, fewer than asked for
+    pass &= expect("End of history", propose(drafter, {4, 5, 6, 4}, 5, 8), {6, 4, 5});
+
+    // A match shorter than min_ngram is not used
+    {
+        PromptLookupDrafter bigrams(3, 2);
+        pass &= expect("Below min_ngram", propose(bigrams, {7, 8, 9}, 7, 4), {});
+    }
+
+    // Accepted tokens extend the history the next lookup searches
+    {
+        drafter.begin({1, 2, 3});
+        const int accepted[] = {1, 2};
+        drafter.accept(4, accepted, 2, 2);
+        std::vector<int> tokens;
+        std::vector<float> probs;
+        drafter.propose(3, 4, tokens, probs);
+        pass &= expect("After accept", tokens, {4, 1, 2, 3});
+    }
+
+    bool threw = false;
+    try
+    {
+        PromptLookupDrafter invalid(1, 2);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    if (!threw)
+    {
+        std::cerr << "min_ngram > max_ngram was accepted\n";
+        pass = false;
+    }
+
+    if (pass)
+    {
+        std::cout << "Prompt lookup test passed!\n";
+        return 0;
+    }
+    std::cout << "Prompt lookup test failed!\n";
+    return 1;
+}
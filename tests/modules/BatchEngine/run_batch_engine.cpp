@@ -0,0 +1,139 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <models/batch_engine.h>
+
+namespace
+{
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " <model.safetensors> <prompt_tokens.txt> <max_new_tokens> <max_batch_size> [num_requests] [max_tokens_per_step] [max_prefill_chunk] [max_sequence_length] [max_kv_tokens] [swap_file]\n";
+}
+
+std::vector<int> load_prompt_tokens(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open prompt file: " + path);
+    }
+
+    std::vector<int> tokens;
+    std::string token_str;
+    while (std::getline(file, token_str, ','))
+    {
+        std::stringstream token_stream(token_str);
+        int token = 0;
+        if (token_stream >> token)
+        {
+            tokens.push_back(token);
+        }
+    }
+    return tokens;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    using Clock = std::chrono::steady_clock;
+
+    if (argc < 5 || argc > 11)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const std::size_t max_new_tokens = static_cast<std::size_t>(std::stoul(argv[3]));
+
+    BatchEngineConfig engine_config;
+    engine_config.max_batch_size = static_cast<std::size_t>(std::stoul(argv[4]));
+    const std::size_t num_requests = argc > 5 ? static_cast<std::size_t>(std::stoul(argv[5])) : engine_config.max_batch_size;
+    if (argc > 6)
+        engine_config.max_tokens_per_step = static_cast<std::size_t>(std::stoul(argv[6]));
+    if (argc > 7)
+        engine_config.max_prefill_chunk = static_cast<std::size_t>(std::stoul(argv[7]));
+    if (argc > 8)
+        engine_config.max_sequence_length = static_cast<std::size_t>(std::stoul(argv[8]));
+    if (argc > 9)
+        engine_config.max_kv_tokens = static_cast<std::size_t>(std::stoul(argv[9]));
+    if (argc > 10)
+        engine_config.swap_path = argv[10];
+
+    try
+    {
+        GenerationRequest request;
+        request.prompt = load_prompt_tokens(argv[2]);
+        request.max_new_tokens = max_new_tokens;
+
+        Qwen3Model model;
+        model.load_weights(argv[1], true);
+
+        BatchEngine engine(model, engine_config);
+
+        // Stagger arrivals: half the requests are queued up front, the rest join one per step
+        // at a higher priority so they can preempt when a swap file is given
+        const std::size_t initial = (num_requests + 1) / 2;
+        for (std::size_t i = 0; i < initial; ++i)
+        {
+            engine.submit(request);
+        }
+
+        std::size_t submitted = initial;
+        std::size_t completed = 0;
+
+        const auto start = Clock::now();
+        while (engine.has_work() || submitted < num_requests)
+        {
+            if (submitted < num_requests)
+            {
+                GenerationRequest urgent = request;
+                urgent.priority = 1;
+                engine.submit(urgent);
+                ++submitted;
+            }
+
+            for (const StepToken &token : engine.step())
+            {
+                completed += token.finished ? 1 : 0;
+            }
+        }
+        const auto end = Clock::now();
+
+        const BatchEngineStats &stats = engine.stats();
+        const KVSwapStats swap = engine.swap_stats();
+        const double total_s = std::chrono::duration<double>(end - start).count();
+
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Metrics:\n";
+        std::cout << "  Completed requests: " << completed << "\n";
+        std::cout << "  Prompt tokens: " << stats.prompt_tokens << ", generated tokens: " << stats.generated_tokens << "\n";
+        std::cout << "  Steps: " << stats.steps << ", mean batch size: " << stats.mean_batch_size() << "\n";
+        std::cout << "  Prefill rows: " << stats.prefill_rows << ", decode rows: " << stats.decode_rows << "\n";
+        std::cout << "  Mean time to first token: " << stats.mean_time_to_first_token_ms() << " ms\n";
+        std::cout << "  Total time: " << total_s << " s, slowest step: " << stats.max_step_ms << " ms\n";
+        std::cout << "  Aggregate generation throughput: "
+                  << (total_s > 0.0 ? static_cast<double>(stats.generated_tokens) / total_s : 0.0) << " tokens/s\n";
+        std::cout << "  Preemptions: " << stats.preemptions << ", resumptions: " << stats.resumptions << "\n";
+        if (swap.swap_outs > 0)
+        {
+            std::cout << "  Swap out: " << swap.swap_outs << " x " << swap.mean_swap_out_ms() << " ms, "
+                      << swap.swap_out_mb_per_s() << " MB/s\n";
+            std::cout << "  Swap in: " << swap.swap_ins << " x " << swap.mean_swap_in_ms() << " ms, "
+                      << swap.swap_in_mb_per_s() << " MB/s\n";
+        }
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
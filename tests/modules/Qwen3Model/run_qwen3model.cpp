@@ -15,12 +15,14 @@
 #endif
 
 #include <models/qwen3model.h>
+#include <tokenizer/bpe_tokenizer.h>
 
 namespace
 {
 void print_usage(const char *program)
 {
-    std::cerr << "Usage: " << program << " <model.safetensors> <prompt_tokens.txt> <max_new_tokens>\n";
+    std::cerr << "Usage: " << program << " <model.safetensors> <prompt_tokens.txt> <max_new_tokens> [temperature] [top_k] [top_p] [seed] [tokenizer.json]\n"
+              << "  With tokenizer.json the prompt file holds plain text and the output is decoded.\n";
 }
 
 std::string read_file_to_string(const std::string &path)
@@ -64,12 +66,6 @@ std::vector<int> load_prompt_tokens(const std::string &path)
     return tokens;
 }
 
-int greedy_argmax(const std::vector<float> &probabilities)
-{
-    const auto it = std::max_element(probabilities.begin(), probabilities.end());
-    return static_cast<int>(std::distance(probabilities.begin(), it));
-}
-
 std::size_t current_memory_usage()
 {
 #if defined(_WIN32)
@@ -95,7 +91,7 @@ int main(int argc, char **argv)
 {
     using Clock = std::chrono::steady_clock;
 
-    if (argc != 4)
+    if (argc < 4 || argc > 9)
     {
         print_usage(argv[0]);
         return 1;
@@ -105,15 +101,43 @@ int main(int argc, char **argv)
     const std::string prompt_tokens_path = argv[2];
     const std::size_t max_new_tokens = static_cast<std::size_t>(std::stoul(argv[3]));
 
+    // Defaults to greedy decoding
+    SamplerConfig sampler_config;
+    if (argc > 4)
+        sampler_config.temperature = std::stof(argv[4]);
+    if (argc > 5)
+        sampler_config.top_k = std::stoi(argv[5]);
+    if (argc > 6)
+        sampler_config.top_p = std::stof(argv[6]);
+    if (argc > 7)
+        sampler_config.seed = std::stoull(argv[7]);
+    const std::string tokenizer_path = argc > 8 ? argv[8] : "";
+
     try
     {
-        const auto prompt_tokens = load_prompt_tokens(prompt_tokens_path);
+        BpeTokenizer tokenizer;
+        std::vector<int> prompt_tokens;
+        double tokenize_us = 0.0;
+        if (tokenizer_path.empty())
+        {
+            prompt_tokens = load_prompt_tokens(prompt_tokens_path);
+        }
+        else
+        {
+            tokenizer.load(tokenizer_path);
+            const std::string prompt_text = read_file_to_string(prompt_tokens_path);
+            const auto tokenize_start = Clock::now();
+            prompt_tokens = tokenizer.encode(prompt_text);
+            tokenize_us = std::chrono::duration<double, std::micro>(Clock::now() - tokenize_start).count();
+        }
+        StreamingDetokenizer detokenizer(tokenizer, true);
 
         const auto load_start = Clock::now();
         const auto memory_before_load = current_memory_usage();
         Qwen3Config config;
         Qwen3Model model(config);
         model.load_weights(safetensor_path, true);
+        model.set_sampler_config(sampler_config);
         const auto load_end = Clock::now();
         const auto load_duration = load_end - load_start;
         const auto memory_after_load = current_memory_usage();
@@ -152,13 +176,19 @@ int main(int argc, char **argv)
             }
 
             const auto generation_start = Clock::now();
-            std::cout << "Generated tokens:";
+            std::cout << (tokenizer_path.empty() ? "Generated tokens:" : "Generated text: ");
             for (std::size_t step = 0; step < max_new_tokens; ++step)
             {
-                const auto &probabilities = model.predict_next_token(current_token);
-                const int next_token = greedy_argmax(probabilities);
+                const int next_token = model.sample_next_token(current_token);
                 generated_tokens.push_back(next_token);
-                std::cout << next_token << " ";
+                if (tokenizer_path.empty())
+                {
+                    std::cout << next_token << " ";
+                }
+                else
+                {
+                    std::cout << detokenizer.push(next_token) << std::flush;
+                }
 
                 if (next_token == config.eos_token_id)
                 {
@@ -167,6 +197,10 @@ int main(int argc, char **argv)
 
                 current_token = next_token;
             }
+            if (!tokenizer_path.empty())
+            {
+                std::cout << detokenizer.flush();
+            }
             std::cout << "\n";
             const auto generation_end = Clock::now();
             generation_duration = generation_end - generation_start;
@@ -192,6 +226,10 @@ int main(int argc, char **argv)
         std::cout << std::fixed << std::setprecision(3);
         std::cout << "Metrics:\n";
         std::cout << "  Model load time: " << load_ms << " ms\n";
+        if (!tokenizer_path.empty())
+        {
+            std::cout << "  Tokenization: " << prompt_tokens.size() << " tokens in " << tokenize_us << " us\n";
+        }
 #if defined(_WIN32)
         std::cout << "  Memory after load: " << bytes_to_megabytes(memory_after_load) << " MB";
         if (load_memory_delta > 0)
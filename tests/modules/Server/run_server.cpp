@@ -0,0 +1,83 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <server/inference_server.h>
+
+namespace
+{
+std::atomic<bool> stop_requested(false);
+
+void on_signal(int)
+{
+    stop_requested = true;
+}
+
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " <model.safetensors> [listen=127.0.0.1:8080 | unix:/path.sock] [max_batch_size] [max_sequence_length] [max_kv_tokens] [swap_file] [tokenizer.json]\n";
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2 || argc > 8)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    InferenceServerConfig server_config;
+    if (argc > 2)
+        server_config.listen = argv[2];
+    if (argc > 3)
+        server_config.engine.max_batch_size = static_cast<std::size_t>(std::stoul(argv[3]));
+    if (argc > 4)
+        server_config.engine.max_sequence_length = static_cast<std::size_t>(std::stoul(argv[4]));
+    if (argc > 5)
+        server_config.engine.max_kv_tokens = static_cast<std::size_t>(std::stoul(argv[5]));
+    if (argc > 6)
+        server_config.engine.swap_path = argv[6];
+    const std::string tokenizer_path = argc > 7 ? argv[7] : "";
+
+    try
+    {
+        // Weights are mapped once and shared by every request for the life of the process
+        Qwen3Model model;
+        model.load_weights(argv[1], true);
+
+        // With a tokenizer, requests may send "text" and streamed tokens carry their text
+        BpeTokenizer tokenizer;
+        if (!tokenizer_path.empty())
+        {
+            tokenizer.load(tokenizer_path);
+        }
+
+        InferenceServer server(model, server_config, tokenizer_path.empty() ? nullptr : &tokenizer);
+        server.start();
+        std::cout << "Listening on " << server.endpoint() << "\n"
+                  << "  POST /generate {\"prompt\": [ids] | \"text\": \"...\", \"max_new_tokens\": n}, GET /health\n";
+
+        std::signal(SIGINT, on_signal);
+        std::signal(SIGTERM, on_signal);
+        while (!stop_requested)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        std::cout << "Shutting down\n";
+        server.stop();
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <models/speculative.h>
+
+namespace
+{
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program
+              << " <target.safetensors> <draft.safetensors | lookup | stride:N | first:N> <prompt_tokens.txt> <max_new_tokens> [num_draft_tokens] [temperature] [top_k] [top_p] [seed]\n"
+              << "  'lookup' drafts by matching n-grams against the prompt and history instead of running a draft model\n"
+              << "  'stride:N' / 'first:N' draft with every N-th / the first N layers of the target itself\n";
+}
+
+std::vector<int> load_prompt_tokens(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        throw std::runtime_error("Failed to open prompt file: " + path);
+    }
+
+    std::vector<int> tokens;
+    std::string token_str;
+    while (std::getline(file, token_str, ','))
+    {
+        std::stringstream token_stream(token_str);
+        int token = 0;
+        if (token_stream >> token)
+        {
+            tokens.push_back(token);
+        }
+    }
+    return tokens;
+}
+
+// Qwen3-0.6B: same vocabulary as the 1.7B target, so it can serve as its draft model
+Qwen3Config draft_config()
+{
+    Qwen3Config config;
+    config.hidden_size = 1024;
+    config.intermediate_size = 3072;
+    config.head_dim = 128;
+    return config;
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    using Clock = std::chrono::steady_clock;
+
+    if (argc < 5 || argc > 10)
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const std::size_t max_new_tokens = static_cast<std::size_t>(std::stoul(argv[4]));
+    const std::size_t num_draft_tokens = argc > 5 ? static_cast<std::size_t>(std::stoul(argv[5])) : 4;
+
+    SamplerConfig sampler_config;
+    if (argc > 6)
+        sampler_config.temperature = std::stof(argv[6]);
+    if (argc > 7)
+        sampler_config.top_k = std::stoi(argv[7]);
+    if (argc > 8)
+        sampler_config.top_p = std::stof(argv[8]);
+    if (argc > 9)
+        sampler_config.seed = std::stoull(argv[9]);
+
+    try
+    {
+        const auto prompt_tokens = load_prompt_tokens(argv[3]);
+
+        Qwen3Model target;
+        target.load_weights(argv[1], true);
+        target.set_sampler_config(sampler_config);
+
+        const std::string draft_source = argv[2];
+        std::unique_ptr<Qwen3Model> draft;
+        std::unique_ptr<Drafter> drafter;
+        const int num_layers = target.config().num_hidden_layers;
+        if (draft_source == "lookup")
+        {
+            drafter = std::make_unique<PromptLookupDrafter>();
+        }
+        else if (draft_source.rfind("stride:", 0) == 0)
+        {
+            drafter = std::make_unique<SelfSpeculativeDrafter>(
+                target, SelfSpeculativeDrafter::strided_layers(num_layers, std::stoi(draft_source.substr(7))), sampler_config);
+        }
+        else if (draft_source.rfind("first:", 0) == 0)
+        {
+            drafter = std::make_unique<SelfSpeculativeDrafter>(
+                target, SelfSpeculativeDrafter::leading_layers(num_layers, std::stoi(draft_source.substr(6))), sampler_config);
+        }
+        else
+        {
+            draft = std::make_unique<Qwen3Model>(draft_config());
+            draft->load_weights(draft_source, true);
+            drafter = std::make_unique<DraftModelDrafter>(*draft, sampler_config);
+        }
+
+        // Plain decoding with the target as the baseline
+        const auto baseline_start = Clock::now();
+        target.reset_cache();
+        target.process_prompt_tokens(prompt_tokens.data(), prompt_tokens.size() - 1);
+        std::vector<int> baseline;
+        int current_token = prompt_tokens.back();
+        while (baseline.size() < max_new_tokens)
+        {
+            current_token = target.sample_next_token(current_token);
+            baseline.push_back(current_token);
+            if (current_token == target.config().eos_token_id)
+                break;
+        }
+        const auto baseline_end = Clock::now();
+
+        SpeculativeDecoder decoder(target, *drafter, num_draft_tokens, sampler_config);
+
+        const auto speculative_start = Clock::now();
+        const std::vector<int> generated = decoder.generate(prompt_tokens, max_new_tokens);
+        const auto speculative_end = Clock::now();
+
+        std::cout << "Generated tokens:";
+        for (int token : generated)
+        {
+            std::cout << token << " ";
+        }
+        std::cout << "\n";
+
+        const double baseline_ms = std::chrono::duration<double, std::milli>(baseline_end - baseline_start).count();
+        const double speculative_ms = std::chrono::duration<double, std::milli>(speculative_end - speculative_start).count();
+        const SpeculativeStats &stats = decoder.stats();
+
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Metrics:\n";
+        std::cout << "  Baseline (prefill + decode): " << baseline_ms << " ms for " << baseline.size() << " tokens\n";
+        std::cout << "  Speculative (prefill + decode): " << speculative_ms << " ms for " << generated.size() << " tokens\n";
+        std::cout << "  Rounds: " << stats.rounds << ", tokens per round: " << stats.tokens_per_round() << "\n";
+        std::cout << "  Draft acceptance: " << stats.accepted_tokens << "/" << stats.drafted_tokens
+                  << " (" << 100.0 * stats.acceptance_rate() << "%)\n";
+        if (sampler_config.temperature <= 0.0f)
+        {
+            std::cout << "  Matches greedy baseline: " << (generated == baseline ? "yes" : "no") << "\n";
+        }
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,376 @@
+#include <server/inference_server.h>
+#include <server/json_fields.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+#if defined(_WIN32)
+using NativeSocket = SOCKET;
+const NativeSocket kInvalidSocket = INVALID_SOCKET;
+void close_socket(NativeSocket socket) { closesocket(socket); }
+#else
+using NativeSocket = int;
+const NativeSocket kInvalidSocket = -1;
+void close_socket(NativeSocket socket) { ::close(socket); }
+#endif
+
+Qwen3Config tiny_config()
+{
+    Qwen3Config config;
+    config.hidden_size = 64;
+    config.intermediate_size = 128;
+    config.max_position_embeddings = 256;
+    config.num_attention_heads = 4;
+    config.num_hidden_layers = 2;
+    config.num_key_value_heads = 2;
+    config.head_dim = 16;
+    config.vocab_size = 300;
+    config.eos_token_id = -1; // generation always runs to max_new_tokens
+    config.threading.num_threads = 2;
+    return config;
+}
+
+// Writes random weights for config as a safetensors file
+void write_tiny_model(const Qwen3Config &config, const std::string &path)
+{
+    const int H = config.hidden_size, I = config.intermediate_size, D = config.head_dim;
+    const int A = config.num_attention_heads, G = config.num_key_value_heads;
+
+    struct Entry
+    {
+        std::string name;
+        std::vector<int> shape;
+        float base;
+    };
+    std::vector<Entry> entries = {{"model.embed_tokens.weight", {config.vocab_size, H}, 0.0f},
+                                  {"model.norm.weight", {H}, 1.0f}};
+    for (int layer = 0; layer < config.num_hidden_layers; ++layer)
+    {
+        const std::string prefix = "model.layers." + std::to_string(layer) + ".";
+        entries.push_back({prefix + "input_layernorm.weight", {H}, 1.0f});
+        entries.push_back({prefix + "post_attention_layernorm.weight", {H}, 1.0f});
+        entries.push_back({prefix + "self_attn.q_proj.weight", {A * D, H}, 0.0f});
+        entries.push_back({prefix + "self_attn.k_proj.weight", {G * D, H}, 0.0f});
+        entries.push_back({prefix + "self_attn.v_proj.weight", {G * D, H}, 0.0f});
+        entries.push_back({prefix + "self_attn.o_proj.weight", {H, A * D}, 0.0f});
+        entries.push_back({prefix + "self_attn.q_norm.weight", {D}, 1.0f});
+        entries.push_back({prefix + "self_attn.k_norm.weight", {D}, 1.0f});
+        entries.push_back({prefix + "mlp.up_proj.weight", {I, H}, 0.0f});
+        entries.push_back({prefix + "mlp.gate_proj.weight", {I, H}, 0.0f});
+        entries.push_back({prefix + "mlp.down_proj.weight", {H, I}, 0.0f});
+    }
+
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, 0.2f);
+    std::ostringstream header;
+    std::vector<float> data;
+    header << "{";
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        std::size_t count = 1;
+        for (int dim : entries[i].shape)
+            count *= static_cast<std::size_t>(dim);
+        const std::size_t begin = data.size() * sizeof(float);
+        for (std::size_t j = 0; j < count; ++j)
+            data.push_back(entries[i].base + noise(rng));
+
+        header << (i ? ", " : "") << "\"" << entries[i].name << "\": {\"dtype\": \"F32\", \"shape\": [";
+        for (std::size_t d = 0; d < entries[i].shape.size(); ++d)
+            header << (d ? ", " : "") << entries[i].shape[d];
+        header << "], \"data_offsets\": [" << begin << ", " << data.size() * sizeof(float) << "]}";
+    }
+    header << "}";
+
+    const std::string text = header.str();
+    const std::uint64_t length = text.size();
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+    file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size() * sizeof(float)));
+}
+
+struct HttpResponse
+{
+    int status = 0;
+    std::string body; // de-chunked
+};
+
+NativeSocket connect_to(const std::string &endpoint)
+{
+    const std::size_t colon = endpoint.rfind(':');
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *resolved = nullptr;
+    if (::getaddrinfo(endpoint.substr(0, colon).c_str(), endpoint.substr(colon + 1).c_str(), &hints, &resolved) != 0)
+        throw std::runtime_error("Cannot resolve " + endpoint);
+    const NativeSocket client = ::socket(resolved->ai_family, resolved->ai_socktype, resolved->ai_protocol);
+    const bool connected = client != kInvalidSocket &&
+                           ::connect(client, resolved->ai_addr, static_cast<int>(resolved->ai_addrlen)) == 0;
+    ::freeaddrinfo(resolved);
+    if (!connected)
+        throw std::runtime_error("Cannot connect to " + endpoint);
+    return client;
+}
+
+void send_request(NativeSocket client, const std::string &method, const std::string &path, const std::string &body)
+{
+    const std::string request = method + " " + path + " HTTP/1.1\r\nHost: localhost\r\nContent-Length: " +
+                                std::to_string(body.size()) + "\r\n\r\n" + body;
+    ::send(client, request.data(), static_cast<int>(request.size()), 0);
+}
+
+// One request on a fresh connection, read until the server closes it
+HttpResponse request(const std::string &endpoint, const std::string &method, const std::string &path,
+                     const std::string &body = std::string())
+{
+    const NativeSocket client = connect_to(endpoint);
+    send_request(client, method, path, body);
+
+    std::string raw;
+    char buffer[4096];
+    int received = 0;
+    while ((received = static_cast<int>(::recv(client, buffer, sizeof(buffer), 0))) > 0)
+        raw.append(buffer, static_cast<std::size_t>(received));
+    close_socket(client);
+
+    HttpResponse response;
+    const std::size_t header_end = raw.find("\r\n\r\n");
+    if (header_end == std::string::npos)
+        return response;
+    response.status = std::atoi(raw.c_str() + raw.find(' ') + 1);
+    std::string payload = raw.substr(header_end + 4);
+    if (raw.find("Transfer-Encoding: chunked") >= header_end)
+    {
+        response.body = payload;
+        return response;
+    }
+    for (std::size_t pos = 0; pos < payload.size();)
+    {
+        const std::size_t line_end = payload.find("\r\n", pos);
+        const std::size_t size = std::strtoul(payload.c_str() + pos, nullptr, 16);
+        if (line_end == std::string::npos || size == 0)
+            break;
+        response.body += payload.substr(line_end + 2, size);
+        pos = line_end + 2 + size + 2;
+    }
+    return response;
+}
+
+bool check(bool condition, const char *what)
+{
+    if (!condition)
+        std::cerr << what << "\n";
+    return condition;
+}
+
+template <typename Fn>
+bool throws(Fn fn)
+{
+    try
+    {
+        fn();
+    }
+    catch (const std::invalid_argument &)
+    {
+        return true;
+    }
+    return false;
+}
+
+bool test_json_fields()
+{
+    bool pass = true;
+
+    pass &= check(json_escape("a\"b\\c\nd\x01") == "a\\\"b\\\\c\\nd\\u0001", "json_escape");
+
+    // A key that only appears as a value is skipped; whitespace around ':' is allowed
+    std::size_t pos = 0;
+    const std::string body = "{\"text\": \"prompt\", \"prompt\" :  [1, 2,3 ], \"max_new_tokens\": 7, \"top_p\": 0.5}";
+    pass &= check(json_value(body, "prompt", pos) && body[pos] == '[', "json_value skips a key used as a value");
+    pass &= check(!json_value(body, "seed", pos), "json_value finds an absent key");
+    pass &= check(json_int_array(body, "prompt") == std::vector<int>({1, 2, 3}), "json_int_array");
+    pass &= check(json_string(body, "text") == "prompt", "json_string");
+
+    std::size_t max_new_tokens = 0;
+    float top_p = 1.0f;
+    int seed = 42;
+    json_number(body, "max_new_tokens", max_new_tokens);
+    json_number(body, "top_p", top_p);
+    json_number(body, "seed", seed);
+    pass &= check(max_new_tokens == 7 && top_p == 0.5f && seed == 42, "json_number");
+
+    // Escapes, a BMP code point and a surrogate pair decode to UTF-8
+    const std::string escaped = "{\"text\": \"q\\\"\\\\\\/\\n\\t\\u00e9\\ud83d\\ude00\"}";
+    pass &= check(json_string(escaped, "text") == "q\"\\/\n\t\xc3\xa9\xf0\x9f\x98\x80", "json_string escapes");
+    pass &= check(json_string("{\"text\": \"" + json_escape("a\"\n\x02") + "\"}", "text") == "a\"\n\x02",
+                  "json_escape round trip");
+
+    pass &= check(throws([] { json_string("{\"text\": \"open", "text"); }), "Unterminated string accepted");
+    pass &= check(throws([] { json_string("{\"text\": \"\\u12\"}", "text"); }), "Truncated escape accepted");
+    pass &= check(throws([] { json_string("{\"text\": 5}", "text"); }), "Number accepted as a string");
+    pass &= check(throws([] { json_int_array("{\"prompt\": [1, x]}", "prompt"); }), "Malformed array accepted");
+    pass &= check(throws([] { json_int_array("{\"prompt\": 1}", "prompt"); }), "Scalar accepted as an array");
+    pass &= check(throws([] { json_int_array("{}", "prompt"); }), "Missing array accepted");
+    pass &= check(throws([] { std::size_t n = 0; json_number("{\"n\": -1}", "n", n); }), "Negative unsigned accepted");
+    pass &= check(throws([] { int n = 0; json_number("{\"n\": \"x\"}", "n", n); }), "String accepted as a number");
+
+    if (!pass)
+        std::cerr << "JSON field parsing failed\n";
+    return pass;
+}
+
+bool test_server(Qwen3Model &model)
+{
+    bool pass = true;
+
+    // Greedy reference straight from the model
+    const std::vector<int> prompt = {3, 17, 42, 8};
+    const std::size_t max_new_tokens = 6;
+    std::vector<int> expected;
+    model.reset_cache();
+    model.process_prompt_tokens(prompt.data(), prompt.size() - 1);
+    int token = prompt.back();
+    for (std::size_t i = 0; i < max_new_tokens; ++i)
+    {
+        token = model.sample_next_token(token);
+        expected.push_back(token);
+    }
+
+    InferenceServerConfig config;
+    config.listen = "127.0.0.1:0";
+    config.engine.max_batch_size = 2;
+    config.engine.max_sequence_length = 64;
+    config.engine.max_tokens_per_step = 16;
+    InferenceServer server(model, config);
+    server.start();
+    const std::string endpoint = server.endpoint();
+
+    // Streamed round trip: one {"token": id} line per token, then the summary line
+    {
+        const HttpResponse response = request(endpoint, "POST", "/generate",
+                                              "{\"prompt\": [3, 17, 42, 8], \"max_new_tokens\": 6, \"temperature\": 0}");
+        std::vector<int> tokens;
+        std::string done;
+        std::istringstream lines(response.body);
+        std::string line;
+        while (std::getline(lines, line))
+        {
+            if (line.compare(0, 10, "{\"token\": ") == 0)
+                tokens.push_back(std::atoi(line.c_str() + 10));
+            else
+                done = line;
+        }
+        pass &= check(response.status == 200, "Generate did not return 200");
+        pass &= check(tokens == expected, "Streamed tokens differ from the model's greedy output");
+        pass &= check(done.find("\"done\": true") != std::string::npos &&
+                          done.find("\"generated\": 6") != std::string::npos,
+                      "Missing or wrong done line");
+    }
+
+    {
+        const HttpResponse response = request(endpoint, "GET", "/health");
+        pass &= check(response.status == 200 && response.body.find("\"status\": \"ok\"") != std::string::npos,
+                      "Health check failed");
+    }
+
+    // Error paths: each is rejected with a status and a JSON error before any streaming starts
+    const std::pair<std::string, std::string> bad_bodies[] = {
+        {"not json", "Body without a prompt"},
+        {"{\"max_new_tokens\": 4}", "Missing prompt"},
+        {"{\"prompt\": [1, x], \"max_new_tokens\": 4}", "Malformed prompt"},
+        {"{\"prompt\": [1, 2], \"max_new_tokens\": \"four\"}", "Non-numeric max_new_tokens"},
+        {"{\"prompt\": [1, 2]}", "Missing max_new_tokens (rejected by the engine)"},
+        {"{\"prompt\": [], \"max_new_tokens\": 4}", "Empty prompt (rejected by the engine)"},
+        {"{\"prompt\": [1, 100000], \"max_new_tokens\": 4}", "Token id out of range"}};
+    for (const auto &bad : bad_bodies)
+    {
+        const HttpResponse response = request(endpoint, "POST", "/generate", bad.first);
+        if (response.status != 400 || response.body.find("\"error\": ") == std::string::npos)
+        {
+            std::cerr << bad.second << ": status " << response.status << ", body " << response.body << "\n";
+            pass = false;
+        }
+    }
+    pass &= check(request(endpoint, "GET", "/generate").status == 405, "GET /generate was not 405");
+    pass &= check(request(endpoint, "GET", "/missing").status == 404, "Unknown path was not 404");
+
+    // A client that disconnects mid-stream leaves nothing running behind it
+    {
+        const NativeSocket client = connect_to(endpoint);
+        send_request(client, "POST", "/generate", "{\"prompt\": [5, 6], \"max_new_tokens\": 60}");
+        char buffer[64];
+        ::recv(client, buffer, sizeof(buffer), 0);
+        close_socket(client);
+
+        bool idle = false;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!idle && std::chrono::steady_clock::now() < deadline)
+        {
+            const std::string health = request(endpoint, "GET", "/health").body;
+            idle = health.find("\"active\": 0, \"queued\": 0") != std::string::npos;
+            if (!idle)
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        pass &= check(idle, "Disconnected stream was not cancelled");
+    }
+
+    server.stop();
+    if (!pass)
+        std::cerr << "Loopback server test failed\n";
+    return pass;
+}
+} // namespace
+
+int main()
+{
+    bool pass = test_json_fields();
+
+    const Qwen3Config config = tiny_config();
+    const std::string path = (std::filesystem::temp_directory_path() / "minmax_test_server.safetensors").string();
+    try
+    {
+        write_tiny_model(config, path);
+        Qwen3Model model(config);
+        model.load_weights(path);
+        pass &= test_server(model);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "Error: " << ex.what() << "\n";
+        pass = false;
+    }
+    std::filesystem::remove(path);
+
+    if (pass)
+    {
+        std::cout << "Inference server test passed!\n";
+        return 0;
+    }
+    std::cout << "Inference server test failed!\n";
+    return 1;
+}
@@ -2,6 +2,7 @@
 #include <cassert>
 #include <vector>
 #include <cstring>
+#include <stdexcept>
 #include <tensor/kvcache.h>
 
 // Helper to compare two float arrays
@@ -91,6 +92,33 @@ int main()
     assert(float_array_equal(keys[0], &key_data[0], head_dim));
     assert(float_array_equal(keys[1], &key_data2[0], head_dim));
 
+    // Truncate back to the first token and overwrite the rolled-back position
+    cache.advance();
+    assert(cache.get_current_token_idx() == 2);
+    cache.truncate(1);
+    assert(cache.get_current_token_idx() == 1);
+    assert(cache.get_remaining_tokens() == max_seq_len - 1);
+    cache.set_current_key(0, key_data);
+    assert(float_array_equal(cache.get_key_at(0, 0, 1), &key_data[0], head_dim));
+    assert(float_array_equal(cache.get_key_at(0, 0, 0), &key_data[0], head_dim));
+
+    // Truncating beyond the cached length is rejected
+    bool threw = false;
+    try
+    {
+        cache.truncate(5);
+    }
+    catch (const std::out_of_range &)
+    {
+        threw = true;
+    }
+    if (!threw)
+    {
+        std::cerr << "truncate past the cached length did not throw" << std::endl;
+        return 1;
+    }
+    assert(cache.get_current_token_idx() == 1);
+
     // Reset and check
     cache.reset();
     assert(cache.get_current_token_idx() == 0);
@@ -0,0 +1,192 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <tokenizer/bpe_tokenizer.h>
+
+// GPT-2 byte-level alphabet, as used by the vocab strings of tokenizer.json
+unsigned byte_to_unicode(int b)
+{
+    int next = 256;
+    for (int i = 0; i < 256; ++i)
+    {
+        const bool printable = (i >= 33 && i <= 126) || (i >= 161 && i <= 172) || (i >= 174 && i <= 255);
+        if (i == b)
+            return printable ? static_cast<unsigned>(i) : static_cast<unsigned>(next);
+        if (!printable)
+            ++next;
+    }
+    return 0;
+}
+
+// JSON string literal of a byte-level token; non-ASCII goes through \u escapes
+std::string json_token(const std::string &bytes)
+{
+    std::string out = "\"";
+    for (unsigned char b : bytes)
+    {
+        const unsigned cp = byte_to_unicode(b);
+        if (cp < 0x80 && cp != '"' && cp != '\\')
+        {
+            out += static_cast<char>(cp);
+        }
+        else
+        {
+            char escape[16];
+            std::snprintf(escape, sizeof(escape), "\\u%04X", cp);
+            out += escape;
+        }
+    }
+    return out + "\"";
+}
+
+/*
+Vocab: ids 0-255 are the single bytes, 256+ the merged tokens below. Merges mix the "a b" and
+["a", "b"] encodings; "o Ġ" exists to prove merges never cross pre-token boundaries.
+*/
+std::string build_tokenizer_json()
+{
+    const std::vector<std::pair<std::string, std::string>> merges = {
+        {"h", "e"}, {"l", "l"}, {"he", "ll"}, {"hell", "o"}, {" ", "t"}, {" t", "he"},
+        {"o", " "}, {" ", "w"}, {"o", "r"}, {" w", "or"}, {"l", "d"}, {" wor", "ld"}};
+
+    std::string json = "{\"version\": \"1.0\", \"truncation\": null, \"added_tokens\": [";
+    json += "{\"id\": 300, \"content\": \"<|endoftext|>\", \"single_word\": false, \"special\": true},";
+    json += "{\"id\": 301, \"content\": \"<|im_start|>\", \"special\": true},";
+    json += "{\"id\": 302, \"content\": \"<|im_end|>\", \"special\": true},";
+    json += "{\"id\": 303, \"content\": \"<think>\", \"special\": false}],";
+    json += "\"normalizer\": {\"type\": \"NFC\"}, \"model\": {\"type\": \"BPE\", \"dropout\": null, \"vocab\": {";
+    for (int b = 0; b < 256; ++b)
+    {
+        json += json_token(std::string(1, static_cast<char>(b))) + ": " + std::to_string(b) + ", ";
+    }
+    for (std::size_t i = 0; i < merges.size(); ++i)
+    {
+        json += json_token(merges[i].first + merges[i].second) + ": " + std::to_string(256 + i);
+        json += i + 1 < merges.size() ? ", " : "}, \"merges\": [";
+    }
+    for (std::size_t i = 0; i < merges.size(); ++i)
+    {
+        const std::string left = json_token(merges[i].first);
+        const std::string right = json_token(merges[i].second);
+        if (i % 2 == 0)
+            json += left.substr(0, left.size() - 1) + " " + right.substr(1);
+        else
+            json += "[" + left + ", " + right + "]";
+        json += i + 1 < merges.size() ? ", " : "]}}";
+    }
+    return json;
+}
+
+bool check(bool condition, const std::string &what)
+{
+    if (!condition)
+        std::cout << "FAILED: " << what << "\n";
+    return condition;
+}
+
+int main()
+{
+    BpeTokenizer tokenizer;
+    tokenizer.load_from_string(build_tokenizer_json());
+
+    bool ok = true;
+    ok &= check(tokenizer.vocab_size() == 304, "vocab size");
+
+    // Merges apply by rank within words, never across them
+    ok &= check(tokenizer.encode("hello world") == std::vector<int>({259, 267}), "encode 'hello world'");
+    ok &= check(tokenizer.encode("hello the") == std::vector<int>({259, 261}), "encode 'hello the'");
+    ok &= check(tokenizer.encode("hellor") == std::vector<int>({259, 'r'}), "encode 'hellor' (hell+o outranks o+r)");
+    ok &= check(tokenizer.encode("lllll") == std::vector<int>({257, 257, 'l'}), "encode 'lllll' (leftmost pair first)");
+    ok &= check(tokenizer.encode("hellllo") == std::vector<int>({258, 257, 'o'}), "encode 'hellllo'");
+    ok &= check(tokenizer.token_to_id("hello") == 259 && tokenizer.token_to_id(" world") == 267, "token_to_id");
+
+    // A long run of one letter is a single pre-token; merging must stay near-linear in its length
+    {
+        const std::string run(1 << 20, 'l');
+        const auto start = std::chrono::steady_clock::now();
+        const std::vector<int> run_ids = tokenizer.encode(run);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ok &= check(run_ids == std::vector<int>(run.size() / 2, 257), "encode a 1 MB run of 'l'");
+        ok &= check(seconds < 5.0, "encode a 1 MB run of 'l' in under 5 s (took " + std::to_string(seconds) + " s)");
+    }
+
+    // Pre-tokenizer follows the Qwen2 split regex
+    const std::vector<std::string> words = BpeTokenizer::pre_tokenize("Hello, world! I'm 42\n\n  ok");
+    ok &= check(words == std::vector<std::string>({"Hello", ",", " world", "!", " I", "'m", " ", "4", "2", "\n\n", " ", " ok"}),
+                "pre_tokenize mixed text");
+    ok &= check(BpeTokenizer::pre_tokenize("x ...\nfoo   \n") == std::vector<std::string>({"x", " ...\n", "foo", "   \n"}),
+                "pre_tokenize punctuation and trailing newline");
+    ok &= check(BpeTokenizer::pre_tokenize("a  ") == std::vector<std::string>({"a", "  "}), "pre_tokenize trailing spaces");
+    // A single punctuation character prefixes the following letters, as with " word"
+    ok &= check(BpeTokenizer::pre_tokenize("\xE4\xBD\xA0\xE5\xA5\xBD\xEF\xBC\x8C\xE4\xB8\x96\xE7\x95\x8C\xEF\xBC\x81") ==
+                    std::vector<std::string>({"\xE4\xBD\xA0\xE5\xA5\xBD", "\xEF\xBC\x8C\xE4\xB8\x96\xE7\x95\x8C", "\xEF\xBC\x81"}),
+                "pre_tokenize CJK with fullwidth punctuation");
+    ok &= check(BpeTokenizer::pre_tokenize("HE'LL don't") == std::vector<std::string>({"HE", "'LL", " don", "'t"}),
+                "pre_tokenize contractions");
+
+    // Round trips, including multi-byte characters and control whitespace
+    const std::vector<std::string> samples = {
+        "hello world", "  leading and trailing  ", "tabs\tand\r\nCRLF\n\n\n", "caf\xC3\xA9 na\xC3\xAFve",
+        "emoji \xF0\x9F\x98\x80!", "\xE4\xBD\xA0\xE5\xA5\xBD\xEF\xBC\x8C\xE4\xB8\x96\xE7\x95\x8C", "x=1+2; // done",
+        ""};
+    for (const std::string &sample : samples)
+    {
+        ok &= check(tokenizer.decode(tokenizer.encode(sample)) == sample, "round trip '" + sample + "'");
+    }
+
+    // Added tokens
+    const std::string chat = "<|im_start|>user\nhello<|im_end|><think>";
+    const std::vector<int> chat_ids = tokenizer.encode(chat);
+    ok &= check(chat_ids.front() == 301 && chat_ids[chat_ids.size() - 2] == 302 && chat_ids.back() == 303, "special tokens split out");
+    ok &= check(tokenizer.decode(chat_ids) == chat, "special tokens round trip");
+    ok &= check(tokenizer.decode(chat_ids, true) == "user\nhello<think>", "skip_special decode");
+    const std::vector<int> plain_ids = tokenizer.encode(chat, false);
+    bool has_special = false;
+    for (int id : plain_ids)
+        has_special = has_special || tokenizer.is_special(id);
+    ok &= check(!has_special && plain_ids.back() == 303 && tokenizer.decode(plain_ids) == chat, "parse_special=false");
+
+    // Streaming detokenization holds back partial characters
+    StreamingDetokenizer stream(tokenizer);
+    const std::vector<int> emoji = tokenizer.encode("\xF0\x9F\x98\x80");
+    ok &= check(emoji.size() == 4, "emoji is four byte tokens");
+    std::string streamed;
+    for (std::size_t i = 0; i < emoji.size(); ++i)
+    {
+        const std::string piece = stream.push(emoji[i]);
+        ok &= check(i + 1 < emoji.size() ? piece.empty() : piece == "\xF0\x9F\x98\x80", "emoji held back until complete");
+        streamed += piece;
+    }
+    for (int id : tokenizer.encode(" caf\xC3\xA9 hello"))
+        streamed += stream.push(id);
+    streamed += stream.flush();
+    ok &= check(streamed == "\xF0\x9F\x98\x80 caf\xC3\xA9 hello", "streamed text");
+
+    stream.push(0xF0);
+    ok &= check(stream.flush() == "\xEF\xBF\xBD", "dangling lead byte flushes as U+FFFD");
+    const int invalid[] = {0xFF, 'a'};
+    ok &= check(tokenizer.decode(invalid, 2) == "\xEF\xBF\xBD" "a", "invalid byte decodes as U+FFFD");
+
+    bool threw = false;
+    try
+    {
+        BpeTokenizer broken;
+        broken.load_from_string("{\"model\": {\"type\": \"BPE\", \"vocab\": {\"a\": 0,");
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    ok &= check(threw, "malformed json throws");
+
+    if (!ok)
+    {
+        std::cout << "BPE tokenizer test failed!\n";
+        return 1;
+    }
+    std::cout << "BPE tokenizer test passed!\n";
+    return 0;
+}